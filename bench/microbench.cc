@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "triton/driver/buffer.h"
+#include "triton/driver/context.h"
+#include "triton/driver/device.h"
+#include "triton/driver/stream.h"
+#include "triton/runtime/function.h"
+#include "triton/tools/bench.hpp"
+
+// Microbenchmarks of the compiler and of the host runtime.
+// Everything runs on the host device, so no GPU is needed.
+// Results are printed as one JSON object per line:
+//   {"bench": ..., "name": ..., "value": ..., "unit": ...}
+// usage: triton-microbench [triton-source-dir]
+
+namespace drv = triton::driver;
+namespace rt = triton::runtime;
+
+namespace {
+
+/* ------------------------- */
+/*          Utils            */
+/* ------------------------- */
+
+void report(const std::string& bench, const std::string& name, double value, const std::string& unit) {
+  std::printf("{\"bench\": \"%s\", \"name\": \"%s\", \"value\": %.3f, \"unit\": \"%s\"}\n",
+              bench.c_str(), name.c_str(), value, unit.c_str());
+  std::fflush(stdout);
+}
+
+void report_error(const std::string& bench, const std::string& name, const std::string& what) {
+  std::string msg = what.substr(0, what.find('\n'));
+  std::replace(msg.begin(), msg.end(), '"', '\'');
+  std::replace(msg.begin(), msg.end(), '\\', '/');
+  std::printf("{\"bench\": \"%s\", \"name\": \"%s\", \"error\": \"%s\"}\n",
+              bench.c_str(), name.c_str(), msg.c_str());
+  std::fflush(stdout);
+}
+
+std::string read_file(const std::string& path) {
+  std::ifstream ifs(path);
+  if(!ifs)
+    throw std::runtime_error("could not open " + path);
+  std::stringstream ss;
+  ss << ifs.rdbuf();
+  return ss.str();
+}
+
+// median wall-clock time (ns) of `repeat` calls to `fn`
+double median_ns(const std::function<void()>& fn, size_t repeat) {
+  triton::tools::timer tmr;
+  std::vector<double> times;
+  for(size_t i = 0; i < repeat; i++){
+    tmr.start();
+    fn();
+    times.push_back(tmr.get().count());
+  }
+  std::sort(times.begin(), times.end());
+  return times[times.size() / 2];
+}
+
+/* ------------------------- */
+/*     Compiler kernels      */
+/* ------------------------- */
+
+// kernels of python/triton/ops, with tile sizes small
+// enough to keep host code generation fast
+struct kernel_case {
+  std::string name;
+  std::string path;
+  std::unordered_map<std::string, std::string> defines;
+};
+
+std::vector<kernel_case> ops_kernels(const std::string& root) {
+  std::string ops = root + "/python/triton/ops/";
+  std::unordered_map<std::string, std::string> bsmm = {
+    {"TYPE", "float"}, {"BLOCK", "16"}, {"TK", "16"}, {"STRIDE_AM", "lda"}, {"STRIDE_AK", "1"},
+    {"STRIDE_BN", "1"}, {"STRIDE_BK", "ldb"}, {"STRIDE_CM", "ldc"}, {"STRIDE_CN", "1"}};
+  auto with = [](std::unordered_map<std::string, std::string> base,
+                 const std::unordered_map<std::string, std::string>& extra) {
+    for(const auto& x: extra)
+      base[x.first] = x.second;
+    return base;
+  };
+  return {
+    {"matmul", ops + "matmul.c",
+      {{"TYPE", "float"}, {"TM", "32"}, {"TN", "32"}, {"TK", "8"}, {"SPLITK", "1"}, {"IS_TK_DIV_K", "1"},
+       {"STRIDE_AM", "lda"}, {"STRIDE_AK", "1"}, {"STRIDE_BK", "ldb"}, {"STRIDE_BN", "1"},
+       {"LDA_POW2_DIV", "8"}, {"LDB_POW2_DIV", "8"}, {"LDC_POW2_DIV", "8"}}},
+    {"conv", ops + "conv.c",
+      {{"TYPE", "float"}, {"TM", "32"}, {"TN", "32"}, {"TK", "8"}, {"TZ", "1"},
+       {"HH", "16"}, {"WW", "16"}, {"PP", "14"}, {"QQ", "14"}, {"SS", "3"}, {"RR", "3"}}},
+    {"cross_entropy", ops + "cross_entropy.c",
+      {{"TYPE", "float"}, {"TILE", "1024"}, {"INFINITY", "F32_INFINITY"}, {"N_COLS_MULT", "8"}}},
+    {"blocksparse_sdd", ops + "blocksparse/matmul.c",
+      with(bsmm, {{"TM", "16"}, {"TN", "16"}, {"TMN", "256"}, {"TZ", "1"}, {"SDD", "1"}, {"NAME", "sdd_kernel"}})},
+    {"blocksparse_dsd", ops + "blocksparse/matmul.c",
+      with(bsmm, {{"TM", "16"}, {"TN", "32"}, {"STRIDE_AM", "16"}, {"DSD", "1"}, {"NAME", "dsd_kernel"}})},
+    {"blocksparse_dds", ops + "blocksparse/matmul.c",
+      with(bsmm, {{"TM", "32"}, {"TN", "16"}, {"STRIDE_BK", "16"}, {"DDS", "1"}, {"NAME", "dds_kernel"}})},
+    {"blocksparse_softmax", ops + "blocksparse/softmax.c",
+      {{"TYPE", "float"}, {"TM", "1"}, {"TN", "256"}, {"BLOCK", "16"}, {"INFINITY", "F32_INFINITY"}}},
+  };
+}
+
+// time to parse and generate Triton-IR
+void bench_src_to_ir(const std::vector<kernel_case>& cases, size_t repeat) {
+  for(const kernel_case& c: cases){
+    try{
+      rt::options_t opt;
+      opt.defines = c.defines;
+      opt.num_warps = 1;
+      std::string src = read_file(c.path);
+      double ns = median_ns([&]() { rt::kernel::src_to_ir(src, opt); }, repeat);
+      report("src_to_ir", c.name, ns, "ns");
+    }
+    catch(const std::exception& e){
+      report_error("src_to_ir", c.name, e.what());
+    }
+  }
+}
+
+// time of each compilation pass and of the whole pipeline,
+// as well as the shared memory footprint vs. its lower bound
+// and the number of barriers inserted and removed
+void bench_ir_to_bin(drv::device* dev, const std::vector<kernel_case>& cases, size_t repeat) {
+  for(const kernel_case& c: cases){
+    try{
+      rt::options_t opt;
+      opt.defines = c.defines;
+      opt.num_warps = 1;
+      std::string src = read_file(c.path);
+      rt::kernel::pass_times_t pass_times;
+      rt::kernel::stats_t stats;
+      std::vector<double> totals;
+      triton::tools::timer tmr;
+      for(size_t i = 0; i < repeat; i++){
+        // passes modify the module in-place
+        std::shared_ptr<triton::ir::module> ir = rt::kernel::src_to_ir(src, opt);
+        tmr.start();
+        rt::kernel::ir_to_bin(*ir, dev, opt, &pass_times, &stats);
+        totals.push_back(tmr.get().count());
+      }
+      for(const auto& x: pass_times)
+        report("ir_to_bin", c.name + "/" + x.first, x.second / repeat, "ns");
+      std::sort(totals.begin(), totals.end());
+      report("ir_to_bin", c.name, totals[totals.size() / 2], "ns");
+      report("shared_mem", c.name, stats.shared_mem, "bytes");
+      report("shared_mem", c.name + "/lower_bound", stats.shared_mem_lower_bound, "bytes");
+      report("barriers", c.name + "/inserted", stats.barriers_inserted, "count");
+      report("barriers", c.name + "/removed", stats.barriers_removed, "count");
+    }
+    catch(const std::exception& e){
+      report_error("ir_to_bin", c.name, e.what());
+    }
+  }
+}
+
+/* ------------------------- */
+/*       Host runtime        */
+/* ------------------------- */
+
+const char* add_src =
+R"(
+__global__ void add(float *X __noalias __readonly __aligned(16),
+                    float *Y __noalias __readonly __aligned(16),
+                    float *Z __noalias __aligned(16),
+                    int N) {
+  int off[BLOCK] = get_program_id(0) * BLOCK + 0 ... BLOCK;
+  bool check[BLOCK] = off < N;
+  float *px[BLOCK] = X + off;
+  float *py[BLOCK] = Y + off;
+  float *pz[BLOCK] = Z + off;
+  *? (check)pz = *? (check)px + *? (check)py;
+}
+)";
+
+std::string add_args(drv::buffer* x, drv::buffer* y, drv::buffer* z, int N) {
+  std::stringstream oss;
+  rt::add_arg(oss, (uint64_t)x->hst()->data);
+  rt::add_arg(oss, (uint64_t)y->hst()->data);
+  rt::add_arg(oss, (uint64_t)z->hst()->data);
+  rt::add_arg(oss, N);
+  return oss.str();
+}
+
+rt::options_t add_options(int block) {
+  rt::options_t opt;
+  opt.defines["BLOCK"] = std::to_string(block);
+  opt.num_warps = 1;
+  return opt;
+}
+
+// fixed cost of host_stream::enqueue, split per launch and per program.
+// all programs are masked out (N = 0) so only dispatch is measured
+void bench_launch(drv::device* dev, drv::context* ctx, drv::stream* stream) {
+  std::unique_ptr<drv::buffer> buf(drv::buffer::create(ctx, 1024));
+  rt::kernel add(add_src, add_options(16), dev);
+  std::string args = add_args(&*buf, &*buf, &*buf, 0);
+  for(size_t grid: {1, 16, 256, 4096}){
+    size_t repeat = std::max<size_t>(10, 40960 / grid);
+    double ns = median_ns([&]() { add(args, stream, {grid, 1, 1}); stream->synchronize(); }, repeat);
+    report("launch", "grid=" + std::to_string(grid), ns, "ns/launch");
+    report("launch", "grid=" + std::to_string(grid), ns / grid, "ns/program");
+  }
+}
+
+// cost of finding the tuned kernel once the cache is warm
+void bench_autotune_lookup(drv::device* dev, drv::context* ctx, drv::stream* stream) {
+  int N = 4096;
+  std::unique_ptr<drv::buffer> buf(drv::buffer::create(ctx, N * sizeof(float)));
+  std::vector<rt::config> confs = {{{{"BLOCK", "256"}}, 1}, {{{"BLOCK", "1024"}}, 1}};
+  rt::function add(add_src, add_options(256), dev, confs, {"N"});
+  std::string args = add_args(&*buf, &*buf, &*buf, N);
+  auto grid = [N](const rt::options_t& x) {
+    return rt::kernel::grid_t{(size_t)(N + x.D<int>("BLOCK") - 1) / x.D<int>("BLOCK")};
+  };
+  // compile and tune
+  add(args, grid, stream);
+  stream->synchronize();
+  size_t repeat = 100000;
+  triton::tools::timer tmr;
+  tmr.start();
+  for(size_t i = 0; i < repeat; i++)
+    add.autotune(args, grid, stream);
+  report("autotune_lookup", "add", (double)tmr.get().count() / repeat, "ns");
+}
+
+// end-to-end throughput of an element-wise kernel
+void bench_throughput(drv::device* dev, drv::context* ctx, drv::stream* stream) {
+  int N = 1 << 22;
+  std::unique_ptr<drv::buffer> x(drv::buffer::create(ctx, N * sizeof(float)));
+  std::unique_ptr<drv::buffer> y(drv::buffer::create(ctx, N * sizeof(float)));
+  std::unique_ptr<drv::buffer> z(drv::buffer::create(ctx, N * sizeof(float)));
+  std::vector<float> hx(N, 1), hy(N, 2);
+  stream->write(&*x, true, 0, hx);
+  stream->write(&*y, true, 0, hy);
+  for(int block: {256, 1024, 4096}){
+    rt::kernel add(add_src, add_options(block), dev);
+    std::string args = add_args(&*x, &*y, &*z, N);
+    size_t grid = (N + block - 1) / block;
+    double ns = median_ns([&]() { add(args, stream, {grid, 1, 1}); stream->synchronize(); }, 10);
+    report("throughput", "add/BLOCK=" + std::to_string(block), 3. * N * sizeof(float) / ns, "GB/s");
+  }
+}
+
+}
+
+int main(int argc, char** argv) {
+  std::string root = argc > 1 ? argv[1] : TRITON_SOURCE_DIR;
+  drv::host_device dev;
+  drv::host_context ctx(&dev);
+  drv::host_stream stream;
+  std::vector<kernel_case> cases = ops_kernels(root);
+  bench_src_to_ir(cases, 20);
+  bench_ir_to_bin(&dev, cases, 3);
+  bench_launch(&dev, &ctx, &stream);
+  bench_autotune_lookup(&dev, &ctx, &stream);
+  bench_throughput(&dev, &ctx, &stream);
+  return 0;
+}
@@ -30,12 +30,18 @@ public:
   bool has_offset(const data_layout *x)    const { return offsets_.find(x) != offsets_.end(); }
   unsigned offset(const data_layout *x)    const { return offsets_.at(x); }
   unsigned allocated_size()        const { return allocated_size_; }
+  // largest total size of simultaneously live buffers
+  unsigned lower_bound()           const { return lower_bound_; }
   // run
   void run(ir::module& mod);
 
+private:
+  static unsigned alignment(shared_layout *x);
+
 private:
   std::map<const data_layout*, unsigned> offsets_;
   size_t allocated_size_;
+  size_t lower_bound_;
   // dependences
   liveness *liveness_;
 };
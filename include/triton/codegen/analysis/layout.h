@@ -152,7 +152,8 @@ public:
                 const std::vector<unsigned>& shapes,
                 const std::vector<ir::value *> &values_,
                 ir::type *ty,
-                analysis::align* align);
+                analysis::align* align,
+                target *tgt);
   void accept(layout_visitor* vst) { vst->visit_layout_shared(this); }
   // accessors
   size_t get_size()                         { return size_; }
@@ -186,6 +187,8 @@ private:
   // graph creation
   void connect(ir::value *x, ir::value *y);
   void make_graph(ir::instruction *i);
+  bool is_consistent(const std::vector<ir::value*>& values);
+  void split(ir::module &mod);
 
   void init_hmma_tile(data_layout& layouts);
   void init_scanline_tile(data_layout &layouts);
@@ -204,6 +207,7 @@ public:
   data_layout* get(ir::value *v)                              { return get(layout_of(v));}
   std::map<size_t, data_layout*> &get_all()                   { return layouts_; }
   size_t tmp(ir::instruction* i)                              { return tmp_.at((ir::value*)i);}
+  bool has_tmp(ir::instruction* i)                            { return tmp_.find((ir::value*)i) != tmp_.end();}
 
   // execution
   void run(ir::module &mod);
@@ -1,6 +1,7 @@
 #ifndef TDL_INCLUDE_IR_CODEGEN_LIVENESS_H
 #define TDL_INCLUDE_IR_CODEGEN_LIVENESS_H
 
+#include <climits>
 #include <map>
 #include <set>
 #include <vector>
@@ -34,22 +35,46 @@ struct segment {
     return start <= idx && idx < end;
   }
 
-  bool intersect(const segment &Other){
-    return contains(Other.start) || Other.contains(start);
+  bool intersect(const segment &Other) const {
+    return start < Other.end && Other.start < end;
+  }
+};
+
+// sorted union of disjoint segments
+struct live_range {
+  std::vector<segment> segments;
+
+  slot_index start() const {
+    return segments.empty() ? INT32_MAX : segments.front().start;
+  }
+
+  bool contains(slot_index idx) const {
+    for(const segment& s: segments)
+      if(s.contains(idx))
+        return true;
+    return false;
+  }
+
+  bool intersect(const live_range &Other) const {
+    for(const segment& s: segments)
+    for(const segment& o: Other.segments)
+      if(s.intersect(o))
+        return true;
+    return false;
   }
 };
 
 
 class liveness {
 private:
-  typedef std::map<shared_layout*, segment>    intervals_map_t;
+  typedef std::map<shared_layout*, live_range> intervals_map_t;
 
 public:
   // constructor
   liveness(layouts *l): layouts_(l){ }
   // accessors
   const intervals_map_t& get()  const { return intervals_; }
-  segment get(shared_layout* v)  const { return intervals_.at(v); }
+  const live_range& get(shared_layout* v)  const { return intervals_.at(v); }
   // run
   void run(ir::module &mod);
 
@@ -4,6 +4,7 @@
 #define _TRITON_SELECTION_GENERATOR_H_
 
 #include "triton/ir/visitor.h"
+#include "triton/ir/instructions.h"
 #include "triton/codegen/analysis/layout.h"
 #include <functional>
 
@@ -79,6 +80,11 @@ private:
   void init_idx(ir::value *x);
   Instruction* add_barrier();
   Value* shared_off(const std::vector<unsigned>& shapes, const std::vector<int>& order, indices_t idx);
+  const distributed_axis& axis_of(ir::value *v, unsigned k);
+  Value* emit_math(ir::math_inst::op_t op, Value *x);
+  Value* emit_bf16_to_f32(Value *x);
+  Value* emit_f32_to_bf16(Value *x);
+  Value* emit_atomic_rmw(ir::atomic_rmw_inst::op_t op, Value *ptr, Value *val, Value *msk, bool has_ret);
   void finalize_shared_layout(analysis::shared_layout*);
   void finalize_function(ir::function*);
   void finalize_phi_node(ir::phi_node*);
@@ -94,7 +100,8 @@ public:
             analysis::allocation *alloc,
             analysis::swizzle *swizzle,
             target *tgt,
-            unsigned num_warps);
+            unsigned num_warps,
+            bool fast_math = true);
 
   void visit_value(ir::value* v);
   void visit_phi_node(ir::phi_node*);
@@ -112,6 +119,7 @@ public:
   void visit_store_inst(ir::store_inst*);
   void visit_unmasked_store_inst(ir::unmasked_store_inst*);
   void visit_masked_store_inst(ir::masked_store_inst*);
+  void visit_prefetch_inst(ir::prefetch_inst*);
   void visit_reshape_inst(ir::reshape_inst*);
   void visit_splat_inst(ir::splat_inst*);
   void visit_broadcast_inst(ir::broadcast_inst*);
@@ -122,15 +130,17 @@ public:
   void visit_get_num_program_inst(ir::get_num_program_inst*);
   void visit_atomic_cas_inst(ir::atomic_cas_inst*);
   void visit_atomic_exch_inst(ir::atomic_exch_inst*);
-  void visit_atomic_add_inst(ir::atomic_add_inst*);
+  void visit_atomic_rmw_inst(ir::atomic_rmw_inst*);
   void visit_mma884(ir::dot_inst*, ir::value *A, ir::value *B, ir::value *D, unsigned NK);
   void visit_mma16816(ir::dot_inst*, ir::value *A, ir::value *B, ir::value *D, unsigned NK);
   void visit_fmadot(ir::dot_inst*, ir::value *A, ir::value *B, ir::value *D, unsigned NK, Type *c_ty, Function *f_mul_add);
   void visit_dot_inst(ir::dot_inst*);
   void visit_trans_inst(ir::trans_inst*);
   void visit_sqrt_inst(ir::sqrt_inst*);
+  void visit_math_inst(ir::math_inst*);
   void visit_reduce1d_inst(ir::reduce_inst*, std::function<Value*(Value*,Value*)>, Value*);
   void visit_reducend_inst(ir::reduce_inst*, std::function<Value*(Value*,Value*)>, Value*);
+  void visit_reducend_copy_inst(ir::reduce_inst*, std::function<Value*(Value*,Value*)>);
   void visit_reduce_inst(ir::reduce_inst*);
   void visit_select_inst(ir::select_inst*);
   void visit_recoalesce_inst(ir::recoalesce_inst*);
@@ -164,13 +174,14 @@ private:
 
   analysis::axes *a_axes_;
   analysis::swizzle *swizzle_;
-  std::map<unsigned, distributed_axis> axes_;
+  std::map<analysis::data_layout*, std::map<unsigned, distributed_axis>> axes_;
   target *tgt_;
   analysis::layouts *layouts_;
   analysis::align *alignment_;
   analysis::allocation *alloc_;
   Value *shmem_;
   unsigned num_warps_;
+  bool fast_math_;
   std::set<ir::value*> seen_;
 
   std::map<analysis::data_layout*, Value*> offset_a_m_;
@@ -71,7 +71,7 @@ public:
 
 class nvidia_cu_target: public target {
 public:
-  nvidia_cu_target(int sm): target(true), sm_(sm){}
+  nvidia_cu_target(int sm, int ptx): target(true), sm_(sm), ptx_(ptx){}
   void set_kernel(Builder& builder, LLVMContext &ctx, Module *module, Function* fn);
   Instruction* add_barrier(Module *module, Builder& builder);
   Instruction* add_memfence(Module *module, Builder& builder);
@@ -80,10 +80,12 @@ public:
   Value* get_block_id(Module *module, Builder& builder, unsigned ax);
   Value* get_num_blocks(Module *module, Builder& builder, unsigned ax);
   int sm() { return sm_; }
+  int ptx() { return ptx_; }
   unsigned guaranteed_alignment() { return 16; }
 
 private:
   int sm_;
+  int ptx_;
 };
 
 class cpu_target: public target {
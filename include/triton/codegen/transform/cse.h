@@ -0,0 +1,57 @@
+#ifndef TDL_INCLUDE_CODEGEN_OPTIMIZE_CSE_PASS_H
+#define TDL_INCLUDE_CODEGEN_OPTIMIZE_CSE_PASS_H
+
+#include <map>
+#include <tuple>
+#include <string>
+#include <vector>
+
+namespace triton {
+
+namespace ir {
+  class module;
+  class function;
+  class value;
+  class type;
+  class instruction;
+  class basic_block;
+}
+
+namespace codegen{
+
+namespace analysis{
+  class axes;
+  class layouts;
+}
+
+namespace transform{
+
+// Dominator-scoped value numbering: a pure instruction is replaced by an
+// identical one (same opcode, type, operands and metadata) that dominates it.
+// Tiles are only merged when they already share axes and layout, so that
+// the rewrite never couples layouts that disassociate kept apart.
+class cse {
+  typedef std::tuple<unsigned, std::string, ir::type*, std::vector<ir::value*>,
+                     std::map<unsigned, unsigned>> key_t;
+
+private:
+  key_t get_key(ir::instruction *i);
+  bool is_compatible(ir::instruction *x, ir::instruction *y);
+  void run(ir::function *fn);
+
+public:
+  // no side effects and no dependence on memory
+  static bool is_pure(ir::instruction *i);
+  cse(analysis::axes *axes, analysis::layouts *layouts): axes_(axes), layouts_(layouts) {}
+  void run(ir::module &mod);
+
+private:
+  analysis::axes *axes_;
+  analysis::layouts *layouts_;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef TDL_INCLUDE_CODEGEN_OPTIMIZE_LICM_H
+#define TDL_INCLUDE_CODEGEN_OPTIMIZE_LICM_H
+
+#include <map>
+#include <set>
+#include <vector>
+
+namespace triton {
+
+namespace ir {
+  class module;
+  class function;
+  class instruction;
+  class basic_block;
+}
+
+namespace codegen{
+namespace transform{
+
+// Loop-invariant code motion: pure instructions whose operands are all
+// defined outside of a natural loop (address arithmetic, splat, broadcast,
+// make_range, ...) are hoisted into the unique block that enters the loop.
+// No pre-header is created, so the loop shape expected by pipeline is kept.
+class licm {
+  struct loop_t {
+    ir::basic_block *header;
+    std::set<ir::basic_block*> blocks;
+  };
+
+private:
+  static bool is_hoistable(ir::instruction *i);
+  std::vector<loop_t> get_loops(ir::function *fn, const std::map<ir::basic_block*, ir::basic_block*> &idom);
+  void run(ir::function *fn);
+
+public:
+  licm() {}
+  void run(ir::module &mod);
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef TDL_INCLUDE_CODEGEN_OPTIMIZE_MASKS_H
+#define TDL_INCLUDE_CODEGEN_OPTIMIZE_MASKS_H
+
+#include <map>
+#include <cstdint>
+
+namespace triton {
+
+namespace ir {
+  class module;
+  class value;
+  class cmp_inst;
+  class basic_block;
+  class builder;
+}
+
+namespace codegen{
+
+namespace analysis{
+  class align;
+}
+
+namespace transform{
+
+// Static mask elimination.
+// Comparisons between a tile of the form splat(a) + [lo, hi] and a splat
+// are uniform across the tile when the distance between the two scalars
+// is a known multiple that no offset can straddle (e.g. `0 ... TK < K`
+// with K a multiple of TK); they are replaced by a single scalar comparison.
+// Masks that are then provably true -- from dominating branches, loop
+// guards and divisibility -- are dropped from loads, stores and selects.
+class masks {
+private:
+  struct range_t {
+    ir::value *base;  // scalar, nullptr stands for 0
+    int64_t lo;
+    int64_t hi;
+  };
+  typedef std::map<ir::basic_block*, ir::basic_block*> idom_map_t;
+
+  bool get_range(ir::value *v, range_t &result);
+  uint64_t get_multiple(ir::value *v);
+  ir::value* uniformize(ir::cmp_inst *x, ir::builder &builder);
+  bool lower_bound(ir::value *v, ir::basic_block *block, int64_t &result);
+  bool is_true(ir::value *v, ir::basic_block *block);
+
+public:
+  masks(analysis::align *align): align_(align) {}
+  void run(ir::module &mod);
+
+private:
+  analysis::align *align_;
+  idom_map_t idoms_;
+};
+
+}
+}
+}
+
+#endif
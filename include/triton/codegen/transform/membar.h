@@ -15,6 +15,8 @@ namespace ir {
   class masked_load_async_inst;
   class value;
   class builder;
+  class function;
+  class barrier_inst;
 }
 
 namespace codegen{
@@ -34,24 +36,35 @@ class membar {
 private:
   typedef std::pair<unsigned, unsigned> interval_t;
   typedef std::set<ir::value*> val_set_t;
-  typedef std::vector<ir::value*> val_vec_t;
+  // asynchronous copies in flight -> number of groups committed after them
+  typedef std::map<ir::value*, int> async_map_t;
 
 private:
   bool intersect(const val_set_t &X, const val_set_t &Y);
-  int group_of(triton::ir::value *i, std::vector<triton::ir::value *> &async_write);
+  int groups_after(ir::value* v, const async_map_t& async_write, std::set<ir::value*>& seen);
+  void add_async(async_map_t& async_write, ir::value* v, int n);
   val_set_t intersect_with(const val_set_t& as, const val_set_t& bs);
-  void transfer(ir::basic_block *block, val_vec_t &async_write, val_set_t &sync_write, val_set_t &sync_read,
-                std::set<triton::ir::value *> &safe_war, bool &inserted, ir::builder &builder);
+  bool is_other_half(ir::value* write, ir::value* read, const std::set<ir::value*>& safe_war);
+  void transfer(ir::basic_block *block, async_map_t &async_write, val_set_t &sync_write, val_set_t &sync_read,
+                std::set<triton::ir::value *> &safe_war, bool &conflict, ir::builder *builder);
+  bool solve(ir::function *fn, std::set<ir::value*>& safe_war, ir::builder *builder);
 
 public:
   membar(analysis::liveness *liveness, analysis::layouts *layouts, analysis::allocation *alloc):
     liveness_(liveness), layouts_(layouts), alloc_(alloc) {}
   void run(ir::module &mod);
+  // statistics of the last run
+  size_t num_inserted() const { return num_inserted_; }
+  size_t num_removed() const { return num_removed_; }
 
 private:
   analysis::liveness *liveness_;
   analysis::layouts *layouts_;
   analysis::allocation *alloc_;
+  // barriers inserted to synchronize regular (non-async) accesses
+  std::vector<ir::barrier_inst*> inserted_;
+  size_t num_inserted_ = 0;
+  size_t num_removed_ = 0;
 };
 
 
@@ -0,0 +1,47 @@
+#ifndef TDL_INCLUDE_CODEGEN_OPTIMIZE_PERSISTENT_H
+#define TDL_INCLUDE_CODEGEN_OPTIMIZE_PERSISTENT_H
+
+namespace triton {
+
+namespace ir {
+  class module;
+  class function;
+}
+
+namespace codegen{
+namespace transform{
+
+class tile_order;
+
+// Persistent execution.
+// The kernel is launched with about as many programs as can be resident
+// at once, and each of them loops over the tiles of the original grid.
+// The original grid is passed through hidden arguments appended to the
+// signature, in this order:
+//   int32 grid0, int32 grid1, int32 grid2, int32 num_programs, int32* counter
+// get_program_id and get_num_programs are replaced by the coordinates of
+// the current tile and by the original grid. Tiles are either strided by
+// `num_programs` (static) or pulled from `*counter` (dynamic), which must
+// be zero at launch and is reset to zero by the last program.
+// Tiles of axes 0 and 1 are visited in the order given by `order`.
+class persistent {
+public:
+  static const unsigned num_hidden_args = 5;
+
+private:
+  void run(ir::module &mod, ir::function *fn);
+
+public:
+  persistent(tile_order *order, bool dynamic): order_(order), dynamic_(dynamic) {}
+  void run(ir::module &mod);
+
+private:
+  tile_order *order_;
+  bool dynamic_;
+};
+
+}
+}
+}
+
+#endif
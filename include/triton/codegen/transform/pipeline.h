@@ -12,13 +12,25 @@ namespace triton {
 namespace codegen {
 namespace transform {
 
+// Software pipelining of the loads of single-block loops, i.e., of
+// innermost loops; outer loops of a nest are left alone. Every tile load
+// whose address changes across iterations is pipelined, not only the
+// operands of `dot`, including at the default of two stages.
+// Loads are issued `num_stages - 1` iterations ahead of their use and
+// carried through the loop in phi nodes. Operands of `dot` are at most
+// double-buffered since they are staged in shared memory. When
+// `emit_prefetch` is set, loads are left in place and a prefetch of the
+// addresses used `num_stages - 1` iterations later is emitted instead.
 class pipeline {
 public:
-  pipeline(bool has_copy_async): has_copy_async_(has_copy_async) {}
+  pipeline(bool has_copy_async, int num_stages = 2, bool emit_prefetch = false)
+    : has_copy_async_(has_copy_async), num_stages_(num_stages), emit_prefetch_(emit_prefetch) {}
   void run(ir::module &module);
 
 private:
   bool has_copy_async_;
+  int num_stages_;
+  bool emit_prefetch_;
 };
 
 } // namespace transform
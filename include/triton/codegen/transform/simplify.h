@@ -0,0 +1,56 @@
+#ifndef TDL_INCLUDE_CODEGEN_OPTIMIZE_SIMPLIFY_H
+#define TDL_INCLUDE_CODEGEN_OPTIMIZE_SIMPLIFY_H
+
+namespace triton {
+
+namespace ir {
+  class module;
+  class value;
+  class constant;
+  class instruction;
+  class binary_operator;
+  class cmp_inst;
+  class cast_inst;
+  class select_inst;
+  class builder;
+}
+
+namespace codegen{
+
+namespace analysis{
+  class align;
+}
+
+namespace transform{
+
+// Constant folding and algebraic simplification.
+// Element-wise operations on splats are performed once on the scalar and
+// the result is splat instead, constant scalars are folded, and identities
+// (x + 0, x * 1, x % m when x is known to be a multiple of m, ...) are
+// removed. Dead instructions are left for dce.
+class simplify {
+private:
+  ir::value* get_scalar(ir::value *v);
+  ir::constant* get_constant(ir::value *v);
+  bool is_multiple_of(ir::value *v, ir::value *m);
+  ir::value* splat_like(ir::value *v, ir::instruction *i, ir::builder &builder);
+  ir::value* simplify_binop(ir::binary_operator *x, ir::builder &builder);
+  ir::value* simplify_cmp(ir::cmp_inst *x, ir::builder &builder);
+  ir::value* simplify_cast(ir::cast_inst *x, ir::builder &builder);
+  ir::value* simplify_select(ir::select_inst *x, ir::builder &builder);
+  ir::value* simplify_retile(ir::instruction *x, ir::builder &builder);
+  ir::value* simplify_inst(ir::instruction *x, ir::builder &builder);
+
+public:
+  simplify(analysis::align *align): align_(align) {}
+  void run(ir::module &mod);
+
+private:
+  analysis::align *align_;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef TDL_INCLUDE_CODEGEN_OPTIMIZE_TILE_ORDER_H
+#define TDL_INCLUDE_CODEGEN_OPTIMIZE_TILE_ORDER_H
+
+#include <array>
+
+namespace triton {
+
+namespace ir {
+  class module;
+  class function;
+  class value;
+  class builder;
+}
+
+namespace codegen{
+namespace transform{
+
+// Order in which the tiles of axes 0 and 1 of the grid are visited.
+// Tiles are visited in bands of `group_size` rows along axis 0:
+//   none:    no bands, axis 0 varies fastest
+//   grouped: axis 0 varies fastest within a band
+//   morton:  Z-order curve within each `group_size` square of a band
+//   hilbert: Hilbert curve within each `group_size` square of a band
+// Squares cut by the edges of the grid fall back to `grouped`.
+// Curves require `group_size` to be a power of two (0 means 8).
+//
+// As a pass, remaps get_program_id(0) and get_program_id(1) of regular
+// launches. The grid is then passed through three hidden arguments
+// appended to the signature (int32 grid0, grid1, grid2), which also
+// replace get_num_programs.
+class tile_order {
+public:
+  enum kind_t {
+    NONE,
+    GROUPED,
+    MORTON,
+    HILBERT
+  };
+
+  static const unsigned num_hidden_args = 3;
+
+private:
+  std::array<ir::value*, 2> get_curve_ids(ir::builder &builder, ir::value *lane);
+  void run(ir::module &mod, ir::function *fn);
+
+public:
+  tile_order(kind_t kind, unsigned group_size);
+  // ids along axes 0 and 1 of the `idx`-th tile of a grid0 x grid1 grid
+  std::array<ir::value*, 2> get_tile_ids(ir::builder &builder, ir::value *idx,
+                                         ir::value *grid0, ir::value *grid1);
+  void run(ir::module &mod);
+
+private:
+  kind_t kind_;
+  unsigned group_size_;
+  unsigned log2_group_size_;
+};
+
+}
+}
+}
+
+#endif
@@ -12,10 +12,8 @@ namespace driver
 {
 
 class context: public polymorphic_resource<CUcontext, host_context_t>{
-protected:
-  static std::string get_cache_path();
-
 public:
+  static std::string get_cache_path();
   context(driver::device *dev, CUcontext cu, bool take_ownership);
   context(driver::device *dev, host_context_t hst, bool take_ownership);
   driver::device* device() const;
@@ -64,6 +64,7 @@ public:
   size_t current_mem_clock() const;
   size_t max_threads_per_block() const;
   size_t max_shared_memory() const;
+  size_t multiprocessor_count() const;
   size_t max_sm_clock() const;
   size_t max_mem_clock() const;
   void set_max_clock();
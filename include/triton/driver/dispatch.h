@@ -88,11 +88,13 @@ public:
   static CUresult cuMemcpyHtoD_v2(CUdeviceptr dstDevice, const void *srcHost, size_t ByteCount);
   static CUresult cuInit(unsigned int Flags);
   static CUresult cuEventRecord(CUevent hEvent, CUstream hStream);
+  static CUresult cuEventSynchronize(CUevent hEvent);
   static CUresult cuCtxCreate_v2(CUcontext *pctx, unsigned int flags, CUdevice dev);
   static CUresult cuCtxPushCurrent_v2(CUcontext ctx);
   static CUresult cuCtxPopCurrent_v2(CUcontext *pctx);
   static CUresult cuModuleGetFunction(CUfunction *hfunc, CUmodule hmod, const char *name);
   static CUresult cuStreamSynchronize(CUstream hStream);
+  static CUresult cuStreamWaitEvent(CUstream hStream, CUevent hEvent, unsigned int Flags);
   static CUresult cuStreamGetCtx(CUstream hStream, CUcontext* pctx);
   static CUresult cuStreamDestroy_v2(CUstream hStream);
   static CUresult cuEventDestroy_v2(CUevent hEvent);
@@ -103,6 +105,7 @@ public:
   static CUresult cuFuncGetAttribute(int* pi, CUfunction_attribute attrib, CUfunction hfunc);
   static CUresult cuFuncSetAttribute(CUfunction hfunc, CUfunction_attribute attrib, int  value);
   static CUresult cuFuncSetCacheConfig (CUfunction hfunc, CUfunc_cache config);
+  static CUresult cuOccupancyMaxActiveBlocksPerMultiprocessor(int* numBlocks, CUfunction func, int blockSize, size_t dynamicSMemSize);
   // NVML
   static nvmlReturn_t nvmlDeviceGetHandleByPciBusId_v2( const char* pciBusId, nvmlDevice_t* device);
   static nvmlReturn_t nvmlDeviceGetClockInfo(nvmlDevice_t device, nvmlClockType_t type, unsigned int *clock);
@@ -151,9 +154,11 @@ private:
   static void* cuMemcpyHtoD_v2_;
   static void* cuInit_;
   static void* cuEventRecord_;
+  static void* cuEventSynchronize_;
   static void* cuCtxCreate_v2_;
   static void* cuModuleGetFunction_;
   static void* cuStreamSynchronize_;
+  static void* cuStreamWaitEvent_;
   static void* cuStreamDestroy_v2_;
   static void* cuStreamGetCtx_;
   static void* cuEventDestroy_v2_;
@@ -166,6 +171,7 @@ private:
   static void* cuFuncGetAttribute_;
   static void* cuFuncSetAttribute_;
   static void* cuFuncSetCacheConfig_;
+  static void* cuOccupancyMaxActiveBlocksPerMultiprocessor_;
   // NVML
   static void* nvmlInit_v2_;
   static void* nvmlDeviceGetHandleByPciBusId_v2_;
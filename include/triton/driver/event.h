@@ -0,0 +1,47 @@
+#pragma once
+
+#ifndef _TRITON_DRIVER_EVENT_H_
+#define _TRITON_DRIVER_EVENT_H_
+
+#include "triton/driver/handle.h"
+
+namespace triton
+{
+
+namespace driver
+{
+
+// Base
+class event: public polymorphic_resource<CUevent, host_event_t> {
+public:
+  event(CUevent, bool has_ownership);
+  event(host_event_t, bool has_ownership);
+  // factory
+  static driver::event* create(backend_t backend);
+  // blocks until the work captured by the last record is done
+  virtual void synchronize() = 0;
+  // milliseconds between this event and `end`, both completed
+  virtual float elapsed_time(driver::event* end) = 0;
+};
+
+// Host
+class host_event: public event {
+public:
+  host_event();
+  void synchronize();
+  float elapsed_time(driver::event* end);
+};
+
+// CUDA
+class cu_event: public event {
+public:
+  cu_event();
+  void synchronize();
+  float elapsed_time(driver::event* end);
+};
+
+}
+
+}
+
+#endif
@@ -5,26 +5,15 @@
 
 #include <memory>
 #include <map>
+#include <set>
+#include <chrono>
+#include <future>
 #include <iostream>
 #include <functional>
 #include <type_traits>
 #include "triton/driver/dispatch.h"
-#include "llvm/ExecutionEngine/JITSymbol.h"
-#include "llvm/ExecutionEngine/Orc/CompileUtils.h"
-#include "llvm/ExecutionEngine/Orc/Core.h"
-#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
-#include "llvm/ExecutionEngine/Orc/IRCompileLayer.h"
-#include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
-#include "llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h"
-#include "llvm/ExecutionEngine/SectionMemoryManager.h"
 #include "triton/tools/thread_pool.h"
 
-namespace llvm
-{
-class ExecutionEngine;
-class Function;
-}
-
 namespace triton
 {
 
@@ -36,6 +25,8 @@ enum backend_t {
   Host
 };
 
+class host_profiler;
+
 // Host handles
 struct host_platform_t{
 
@@ -50,27 +41,32 @@ struct host_context_t{
 };
 
 struct host_stream_t{
+  // executes operations in order
   std::shared_ptr<ThreadPool> pool;
   std::shared_ptr<std::vector<std::future<void>>> futures;
-  std::vector<std::shared_ptr<char*>> args;
+  // executes the programs of a launch (null when single-threaded)
+  std::shared_ptr<ThreadPool> workers;
+  size_t num_threads = 1;
+  // records the launches when set
+  std::shared_ptr<host_profiler> profiler;
+};
+
+struct host_event_t{
+  // time at which the work captured by the last record completed
+  std::shared_future<std::chrono::high_resolution_clock::time_point> time;
 };
 
 struct host_module_t{
-  std::string error;
-  llvm::ExecutionEngine* engine;
-  std::map<std::string, llvm::Function*> functions;
-  void(*fn)(char**, int32_t, int32_t, int32_t);
-  llvm::orc::ExecutionSession* ES;
-  llvm::orc::RTDyldObjectLinkingLayer* ObjectLayer;
-  llvm::orc::IRCompileLayer* CompileLayer;
-  llvm::DataLayout* DL;
-  llvm::orc::MangleAndInterner* Mangle;
-  llvm::orc::ThreadSafeContext* Ctx;
-  llvm::orc::JITDylib *MainJD;
+  typedef void(*entry_t)(char**, int32_t, int32_t, int32_t);
+  std::set<std::string> functions;
+  std::shared_future<entry_t> fn;
+  // keeps the code of `fn` linked while referenced,
+  // e.g. by launches still queued on a stream
+  std::shared_ptr<void> lease;
 };
 
 struct host_function_t{
-  llvm::Function* fn;
+  std::string name;
 };
 
 struct host_buffer_t{
@@ -37,7 +37,9 @@ protected:
 public:
   module(CUmodule mod, bool has_ownership);
   module(host_module_t mod, bool has_ownership);
-  static module* create(driver::device* device, std::unique_ptr<llvm::Module> src);
+  // host modules are only linked by the JIT when `load` is set;
+  // ahead-of-time compilation just needs their objects
+  static module* create(driver::device* device, std::unique_ptr<llvm::Module> src, bool load = true);
   void compile_llvm_module(std::unique_ptr<llvm::Module> module, const std::string& triple,
                            const std::string &proc, std::string layout,
                            llvm::SmallVectorImpl<char> &buffer,
@@ -53,8 +55,17 @@ protected:
 // CPU
 class host_module: public module{
 public:
-  host_module(std::unique_ptr<llvm::Module> module);
+  host_module(std::unique_ptr<llvm::Module> module, bool load = true);
   std::unique_ptr<buffer> symbol(const char * name) const;
+  // name of the `(char** args, int32 pid0, int32 pid1, int32 pid2)` entry point
+  std::string entry() const;
+  // relocatable object file that defines the entry point,
+  // for `cpu` and `features` (those of the JIT when empty)
+  std::string object(const std::string& cpu = "", const std::string& features = "") const;
+
+private:
+  std::string key_;
+  std::string bitcode_;
 };
 
 // CUDA
@@ -65,6 +76,7 @@ class cu_module: public module {
 public:
   cu_module(driver::device* device, std::unique_ptr<llvm::Module> module);
   cu_module(driver::device* device, const std::string& source);
+  static int ptx_version();
   std::unique_ptr<buffer> symbol(const char * name) const;
   std::string llir() const { return llir_; }
   const std::string& ptx() const { return ptx_; }
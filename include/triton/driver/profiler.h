@@ -0,0 +1,92 @@
+#pragma once
+
+#ifndef _TRITON_DRIVER_PROFILER_H_
+#define _TRITON_DRIVER_PROFILER_H_
+
+#include <array>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace triton
+{
+
+namespace driver
+{
+
+// Records the launches of the host streams it is attached to
+// (see host_stream::set_profiler). Times are in nanoseconds
+// since the creation of the profiler
+class host_profiler {
+public:
+  typedef std::chrono::steady_clock clock;
+
+  struct program_t {
+    std::array<int32_t, 3> id;
+    size_t worker;
+    int64_t start;
+    int64_t end;
+  };
+
+  struct launch_t {
+    std::string name;
+    size_t stream;
+    std::array<size_t, 3> grid;
+    size_t num_threads;
+    // host_stream::enqueue was called
+    int64_t enqueued;
+    // the in-order worker started/finished the launch
+    int64_t start;
+    int64_t end;
+    // indexed by linearized program id
+    std::vector<program_t> programs;
+  };
+
+  struct worker_stats_t {
+    size_t num_programs;
+    int64_t busy;
+    int64_t idle;
+  };
+
+  struct launch_stats_t {
+    int64_t queue_delay;
+    int64_t duration;
+    // program durations
+    int64_t min;
+    int64_t max;
+    double mean;
+    // histogram[i] counts programs that took [2^i, 2^(i+1)) ns
+    std::vector<size_t> histogram;
+    std::vector<worker_stats_t> workers;
+    // busiest worker over mean worker busy time (1 is balanced)
+    double imbalance;
+  };
+
+public:
+  host_profiler();
+  int64_t now() const;
+  // small id for `stream`, stable for the lifetime of the profiler
+  size_t stream_id(const void* stream);
+  void record(launch_t&& launch);
+  std::vector<launch_t> launches() const;
+  void clear();
+  static launch_stats_t stats(const launch_t& launch);
+  // Trace Event Format, for chrome://tracing or Perfetto
+  std::string chrome_trace() const;
+  // launches and their stats
+  std::string json() const;
+
+private:
+  clock::time_point epoch_;
+  mutable std::mutex mutex_;
+  std::map<const void*, size_t> streams_;
+  std::vector<launch_t> launches_;
+};
+
+}
+
+}
+
+#endif
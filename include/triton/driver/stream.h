@@ -8,6 +8,7 @@
 #include "triton/driver/device.h"
 #include "triton/driver/handle.h"
 #include "triton/driver/buffer.h"
+#include "triton/driver/profiler.h"
 
 namespace triton
 {
@@ -32,6 +33,10 @@ public:
   virtual void enqueue(driver::kernel* kernel, std::array<size_t, 3> grid, std::array<size_t, 3> block, void* args, size_t args_size, size_t shared_mem = 0) = 0;
   virtual void write(driver::buffer* buf, bool blocking, std::size_t offset, std::size_t size, void const* ptr) = 0;
   virtual void read(driver::buffer* buf, bool blocking, std::size_t offset, std::size_t size, void* ptr) = 0;
+  // captures all the work enqueued so far in `ev`
+  virtual void record(driver::event* ev) = 0;
+  // work enqueued from now on waits for the last capture of `ev`
+  virtual void wait(driver::event* ev) = 0;
   // template helpers
   template<class T> void write(driver::buffer* buf, bool blocking, std::size_t offset, std::vector<T> const & x)
   { write(buf, blocking, offset, x.size()*sizeof(T), x.data()); }
@@ -42,11 +47,17 @@ public:
 // Host
 class host_stream: public stream {
 public:
-  host_stream();
+  // the programs of each launch are split across `num_threads` workers
+  host_stream(size_t num_threads = 1);
+  size_t num_threads() const;
+  // launches enqueued from now on are recorded by `profiler` (if not null)
+  void set_profiler(std::shared_ptr<host_profiler> profiler);
   void synchronize();
   void enqueue(driver::kernel* kernel, std::array<size_t, 3> grid, std::array<size_t, 3> block, void* args, size_t args_size, size_t shared_mem);
   void write(driver::buffer* buf, bool blocking, std::size_t offset, std::size_t size, void const* ptr);
   void read(driver::buffer* buf, bool blocking, std::size_t offset, std::size_t size, void* ptr);
+  void record(driver::event* ev);
+  void wait(driver::event* ev);
 };
 
 // CUDA
@@ -58,6 +69,8 @@ public:
   void enqueue(driver::kernel* kernel, std::array<size_t, 3> grid, std::array<size_t, 3> block, void* args, size_t args_size, size_t shared_mem);
   void write(driver::buffer* buf, bool blocking, std::size_t offset, std::size_t size, void const* ptr);
   void read(driver::buffer* buf, bool blocking, std::size_t offset, std::size_t size, void* ptr);
+  void record(driver::event* ev);
+  void wait(driver::event* ev);
 };
 
 
@@ -46,6 +46,7 @@ public:
   type *get_int32_ty();
   type *get_int64_ty();
   type *get_half_ty();
+  type *get_bf16_ty();
   type *get_float_ty();
   type *get_double_ty();
   // Insert
@@ -128,6 +129,7 @@ public:
   value *create_store(value *ptr, value *val, const std::string &name = "");
   value *create_masked_load(value *arg, value *mask, value *false_value, const std::string &name = "");
   value *create_masked_store(value *ptr, value *val, value *mask, const std::string &name = "");
+  value *create_prefetch(value *ptr, const std::string &name = "");
   // Tile instruction
   value *create_splat(value *arg, const type::tile_shapes_t &shapes, const std::string &name = "");
   value *create_reshape(value *arg, const type::tile_shapes_t &shapes, const std::string &name = "");
@@ -137,12 +139,13 @@ public:
   value *create_get_num_program(unsigned axis, const std::string &name = "");
   value *create_atomic_cas(value *ptr, value *cmp, value *val, const std::string &name = "");
   value *create_atomic_exch(value *ptr, value *val, const std::string &name = "");
-  value *create_atomic_add(value *ptr, value *val, value *msk, const std::string &name = "");
+  value *create_atomic_rmw(atomic_rmw_inst::op_t op, value *ptr, value *val, value *msk, const std::string &name = "");
   value *create_exp(value* arg, const std::string &name = "");
   value *create_log(value* arg, const std::string &name = "");
   value *create_dot(value *A, value *B, value *C, const std::string &name = "");
   value *create_trans(value *A, const std::vector<int> &perm = {}, const std::string &name = "");
   value *create_sqrt(value *A, const std::string &name = "");
+  value *create_math(math_inst::op_t op, value *arg, const std::string &name = "");
   value *create_reduce(value *A, reduce_inst::op_t op, unsigned axis, const std::string &name = "");
   value *create_select(value *pred, value *if_value, value *else_value, const std::string &name = "");
   // Intrinsics
@@ -23,7 +23,7 @@ public:
 
 public:
   // primitive types
-  type void_ty, label_ty, half_ty, float_ty, double_ty;
+  type void_ty, label_ty, half_ty, bf16_ty, float_ty, double_ty;
   // derived types
   integer_type int1_ty, int8_ty, int16_ty, int32_ty, int64_ty, int128_ty;
   // Pointer types
@@ -116,6 +116,7 @@ enum value_id_t: unsigned {
   INST_MASKED_LOAD_ASYNC,
   INST_UNMASKED_STORE,
   INST_MASKED_STORE,
+  INST_PREFETCH,
   // retile
   INST_RESHAPE,
   INST_SPLAT,
@@ -127,10 +128,11 @@ enum value_id_t: unsigned {
   // atomics
   INST_ATOMIC_CAS,
   INST_ATOMIC_EXCH,
-  INST_ATOMIC_ADD,
+  INST_ATOMIC_RMW,
   // math
   INST_EXP,
   INST_LOG,
+  INST_MATH,
   // array arithmetic
   INST_TRANS,
   INST_REDUCE,
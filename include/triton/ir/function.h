@@ -71,8 +71,8 @@ public:
       case writeonly: return ".writeonly";
       case noalias: return ".noalias";
       case aligned: return ".aligned(" + std::to_string(value_) + ")";
-      case multiple_of: return ".readonly";
-      case retune: return ".retunr";
+      case multiple_of: return ".multiple_of(" + std::to_string(value_) + ")";
+      case retune: return ".retune";
       default: break;
     }
     assert(false);
@@ -104,12 +104,15 @@ public:
   // accessors
   const args_t &args() { return args_; }
   function_type* get_fn_type() { return fn_ty_; }
+  // appends an argument to the signature
+  argument* add_arg(type *ty, const std::string &name);
 
   // factory methods
   static function *create(function_type *ty, linkage_types_t linkage,
                           const std::string &name, module *mod);
   // blocks
   const blocks_t &blocks() { return blocks_; }
+  // inserts (or moves) `block` before `next`
   void insert_block(basic_block* block, basic_block *next = nullptr);
 
   // attributes
@@ -61,11 +61,12 @@ public:
   void set_metadata(ir::metadata::kind_t kind,
                     unsigned value)                           { metadatas_[kind] = value;}
   unsigned get_metadata(ir::metadata::kind_t kind)            { return metadatas_[kind];}
+  const std::map<ir::metadata::kind_t, unsigned>& get_metadatas() const { return metadatas_; }
   // cloning
   ir::instruction* clone() {
     ir::instruction* res = clone_impl();
-//    for(auto it = op_begin(); it != op_end(); it++)
-//      (*it)->add_use(res);
+    for(auto it = res->op_begin(); it != res->op_end(); it++)
+      (*it)->add_use(res);
     res->parent_ = nullptr;
     res->users_.clear();
     return res;
@@ -436,7 +437,7 @@ public:
 // masked load async
 class masked_load_async_inst: public load_inst {
 private:
-  std::string repr_impl() const { return "masked_load_async_async"; }
+  std::string repr_impl() const { return "masked_load_async"; }
   masked_load_async_inst(value *ptr, value *mask, value *false_value,
                    const std::string &name, instruction *next);
 
@@ -452,15 +453,42 @@ public:
   _TRITON_DEFINE_ACCEPT(masked_load_async_inst)
 };
 
-class atomic_add_inst: public io_inst {
+// prefetch
+class prefetch_inst: public io_inst {
 private:
-  atomic_add_inst(value *ptr, value *val, value *msk, const std::string &name = "", instruction *next = nullptr);
-  std::string repr_impl() const { return "atomic_add"; }
-  _TRITON_DEFINE_CLONE(atomic_add_inst)
-  _TRITON_DEFINE_ACCEPT(atomic_add_inst)
+  prefetch_inst(value *ptr, const std::string &name, instruction *next);
+  std::string repr_impl() const { return "prefetch"; }
+  _TRITON_DEFINE_CLONE(prefetch_inst)
+  _TRITON_DEFINE_ACCEPT(prefetch_inst)
 
 public:
-  static instruction* create(value *ptr, value *val, value *msk, const std::string &name = "", instruction *next = nullptr);
+  // factory method
+  static prefetch_inst* create(value *ptr, const std::string &name = "",
+                               instruction *next = nullptr);
+};
+
+// atomic read-modify-write
+class atomic_rmw_inst: public io_inst {
+public:
+  enum op_t{
+    ADD, FADD, MAX, MIN, UMAX, UMIN,
+    FMAX, FMIN, XCHG, AND, OR
+  };
+
+private:
+  atomic_rmw_inst(op_t op, value *ptr, value *val, value *msk, const std::string &name = "", instruction *next = nullptr);
+  std::string repr_impl() const { return "atomic_rmw(" + to_str(op_) + ")"; }
+  _TRITON_DEFINE_CLONE(atomic_rmw_inst)
+  _TRITON_DEFINE_ACCEPT(atomic_rmw_inst)
+
+public:
+  static instruction* create(op_t op, value *ptr, value *val, value *msk, const std::string &name = "", instruction *next = nullptr);
+  static std::string to_str(op_t op);
+  op_t get_op() const { return op_; }
+  value *get_mask_operand() { return get_operand(2); }
+
+private:
+  op_t op_;
 };
 
 
@@ -690,7 +718,7 @@ public:
 
 private:
   trans_inst(value *arg, const std::vector<int>& perm, const std::string& name, instruction* next);
-  std::string repr_impl() const { return "trans"; }
+  std::string repr_impl() const;
 
 public:
   static instruction* create(value *arg, const std::vector<int> &perm = {}, const std::string &name = "", instruction *next = nullptr);
@@ -712,6 +740,28 @@ public:
   _TRITON_DEFINE_ACCEPT(sqrt_inst)
 };
 
+class math_inst: public builtin_inst {
+public:
+  enum op_t{
+    TANH, ERF, SIGMOID,
+    SIN, COS, RSQRT
+  };
+
+private:
+  math_inst(value *arg, op_t op, const std::string& name, instruction* next);
+  std::string repr_impl() const { return "math(" + to_str(op_) + ")"; }
+  _TRITON_DEFINE_CLONE(math_inst)
+  _TRITON_DEFINE_ACCEPT(math_inst)
+
+public:
+  static instruction* create(value *arg, op_t op, const std::string &name = "", instruction *next = nullptr);
+  static std::string to_str(op_t op);
+  op_t get_op() const { return op_; }
+
+private:
+  op_t op_;
+};
+
 class reduce_inst: public builtin_inst {
 public:
   enum op_t{
@@ -721,16 +771,16 @@ public:
 
 private:
   static type* get_res_type(value *arg, unsigned axis);
-  static std::string to_str(op_t op);
 
 private:
   reduce_inst(value* arg, op_t op, unsigned axis, const std::string& name, instruction* next);
-  std::string repr_impl() const { return "reduce"; }
+  std::string repr_impl() const { return "reduce(" + to_str(op_) + ", " + std::to_string(axis_) + ")"; }
   _TRITON_DEFINE_CLONE(reduce_inst)
   _TRITON_DEFINE_ACCEPT(reduce_inst)
 
 public:
   static instruction* create(value *arg, op_t op, unsigned axis, const std::string &name = "", instruction *next = nullptr);
+  static std::string to_str(op_t op);
   unsigned get_axis() const { return axis_; }
   op_t get_op() const { return op_; }
 
@@ -808,7 +858,7 @@ public:
 class async_wait_inst: public instruction{
 private:
   async_wait_inst(context &ctx, int N, const std::string &name, instruction *next);
-  std::string repr_impl() const { return "async_wait_group " + std::to_string(N_) ; }
+  std::string repr_impl() const { return "async_wait_group(" + std::to_string(N_) + ")"; }
   _TRITON_DEFINE_CLONE(async_wait_inst)
   _TRITON_DEFINE_ACCEPT(async_wait_inst)
 
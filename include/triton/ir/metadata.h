@@ -3,6 +3,8 @@
 #ifndef _TRITON_IR_METADATA_H_
 #define _TRITON_IR_METADATA_H_
 
+#include <string>
+
 namespace triton{
 namespace ir{
 
@@ -19,6 +21,7 @@ private:
 
 public:
   static metadata* get(kind_t kind, unsigned value);
+  static std::string repr(kind_t kind);
 
 private:
   kind_t kind_;
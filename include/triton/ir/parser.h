@@ -0,0 +1,88 @@
+#pragma once
+
+#ifndef _TRITON_IR_PARSER_H_
+#define _TRITON_IR_PARSER_H_
+
+#include <istream>
+#include <map>
+#include <string>
+#include <vector>
+#include "triton/ir/metadata.h"
+#include "triton/ir/function.h"
+
+namespace triton{
+namespace ir{
+
+class module;
+class type;
+class value;
+class basic_block;
+class instruction;
+class function_type;
+
+/* Loader */
+// Rebuilds a module from a flat, name-based description of its content.
+// Instructions may reference values defined later in the function; they
+// are materialized in dependency order once the whole function is known.
+// Shared by the textual parser and the binary deserializer.
+class loader {
+public:
+  struct operand_t {
+    enum kind_t { VALUE, BLOCK, GLOBAL, CONSTANT, UNDEF, RANGE };
+    kind_t kind;
+    std::string name;   // VALUE, BLOCK, GLOBAL
+    type *ty;           // CONSTANT, UNDEF, RANGE
+    uint64_t ival;      // CONSTANT of integer type
+    double fval;        // CONSTANT of floating-point type
+  };
+
+  struct inst_t {
+    std::string name;
+    std::string repr;   // as returned by instruction::repr()
+    type *ty;
+    std::vector<operand_t> ops;
+    std::vector<std::pair<metadata::kind_t, unsigned>> metadatas;
+  };
+
+private:
+  struct record_t {
+    inst_t desc;
+    basic_block *block;
+    instruction *inst;
+    bool visiting;
+  };
+
+  value *get_value(const std::string &name);
+  value *get_operand(const operand_t &op);
+  basic_block *get_block(const std::string &name);
+  instruction *materialize(record_t &rec);
+  instruction *create(const inst_t &desc, const std::vector<value*> &ops);
+
+public:
+  loader(module &mod);
+  void add_global(type *elt_ty, const std::string &name, unsigned size);
+  void begin_function(const std::string &name, function_type *ty,
+                      const std::vector<std::string> &arg_names,
+                      const std::vector<std::vector<attribute>> &arg_attrs);
+  void add_block(const std::string &name);
+  void add_inst(const inst_t &inst);
+  void end_function();
+
+private:
+  module &mod_;
+  function *fn_;
+  std::map<std::string, value*> globals_;
+  std::map<std::string, value*> values_;
+  std::map<std::string, basic_block*> blocks_;
+  std::map<std::string, size_t> defs_;
+  std::map<type*, value*> ranges_;
+  std::vector<record_t> records_;
+};
+
+// reads the textual form emitted by ir::print
+void parse(std::istream &is, module &mod);
+
+}
+}
+
+#endif
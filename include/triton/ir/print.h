@@ -3,12 +3,30 @@
 #ifndef _TRITON_IR_PRINT_H_
 #define _TRITON_IR_PRINT_H_
 
+#include <map>
+#include <set>
 #include "builder.h"
 
 namespace triton{
 namespace ir{
 
 class module;
+class function;
+class value;
+
+// unique, printable names for the values and blocks of a function.
+// unnamed values are numbered; the IR itself is left untouched
+class name_table {
+public:
+  name_table(function *fn);
+  const std::string& get(value *v) const { return names_.at(v); }
+
+private:
+  void add(value *v, std::set<std::string> &used, unsigned &cnt);
+
+private:
+  std::map<value*, std::string> names_;
+};
 
 void print(module &mod, std::ostream& os);
 
@@ -0,0 +1,22 @@
+#pragma once
+
+#ifndef _TRITON_IR_SERIALIZE_H_
+#define _TRITON_IR_SERIALIZE_H_
+
+#include <istream>
+#include <ostream>
+
+namespace triton{
+namespace ir{
+
+class module;
+
+// compact binary form of a module. strings and types are interned
+// in tables and integers are LEB128-encoded
+void serialize(module &mod, std::ostream &os);
+void deserialize(std::istream &is, module &mod);
+
+}
+}
+
+#endif
@@ -30,20 +30,21 @@ public:
     // primitive types
     VoidTyID = 0,    ///<  0: type with no size
     HalfTyID,        ///<  1: 16-bit floating point type
-    FloatTyID,       ///<  2: 32-bit floating point type
-    DoubleTyID,      ///<  3: 64-bit floating point type
-    X86_FP80TyID,    ///<  4: 80-bit floating point type (X87)
-    FP128TyID,       ///<  5: 128-bit floating point type (112-bit mantissa)
-    PPC_FP128TyID,   ///<  6: 128-bit floating point type (two 64-bits, PowerPC)
-    LabelTyID,       ///<  7: Labels
-    MetadataTyID,    ///<  8: Metadata
-    TokenTyID,       ///<  9: Token
+    BF16TyID,        ///<  2: 16-bit floating point type (8-bit mantissa)
+    FloatTyID,       ///<  3: 32-bit floating point type
+    DoubleTyID,      ///<  4: 64-bit floating point type
+    X86_FP80TyID,    ///<  5: 80-bit floating point type (X87)
+    FP128TyID,       ///<  6: 128-bit floating point type (112-bit mantissa)
+    PPC_FP128TyID,   ///<  7: 128-bit floating point type (two 64-bits, PowerPC)
+    LabelTyID,       ///<  8: Labels
+    MetadataTyID,    ///<  9: Metadata
+    TokenTyID,       ///< 10: Token
     // derived types
-    IntegerTyID,     ///< 10: Arbitrary bit width integers
-    FunctionTyID,    ///< 11: Functions
-    PointerTyID,     ///< 12: Pointers
-    StructTyID,      ///< 13: Struct
-    TileTyID,        ///< 14: Tile
+    IntegerTyID,     ///< 11: Arbitrary bit width integers
+    FunctionTyID,    ///< 12: Functions
+    PointerTyID,     ///< 13: Pointers
+    StructTyID,      ///< 14: Struct
+    TileTyID,        ///< 15: Tile
   };
 
 public:
@@ -73,6 +74,7 @@ public:
   // primitive predicates
   bool is_void_ty() const               { return id_ == VoidTyID; }
   bool is_half_ty() const               { return id_ == HalfTyID; }
+  bool is_bf16_ty() const               { return id_ == BF16TyID; }
   bool is_float_ty() const              { return id_ == FloatTyID; }
   bool is_double_ty() const             { return id_ == DoubleTyID; }
   bool is_label_ty()  const             { return id_ == LabelTyID;}
@@ -97,6 +99,7 @@ public:
   static type *get_label_ty(context &ctx);
   // half
   static type *get_half_ty(context &ctx);
+  static type *get_bf16_ty(context &ctx);
   static type *get_float_ty(context &ctx);
   static type *get_double_ty(context &ctx);
   // integer types
@@ -121,10 +124,18 @@ public:
     return res;
   }
 
+  std::string pointer_repr() const {
+    std::string res = get_pointer_element_ty()->repr();
+    if(unsigned addr_space = get_pointer_address_space())
+      res += " addrspace(" + std::to_string(addr_space) + ")";
+    return res + "*";
+  }
+
   std::string repr() const {
     switch(id_) {
       case VoidTyID: return "void";
       case HalfTyID: return "f16";
+      case BF16TyID: return "bf16";
       case FloatTyID: return "f32";
       case DoubleTyID: return "f64";
       case X86_FP80TyID: return "f80";
@@ -135,7 +146,7 @@ public:
       case TokenTyID: return "tok";
       case IntegerTyID: return "i" + std::to_string(get_integer_bitwidth());
       case FunctionTyID: return "fn";
-      case PointerTyID: return get_pointer_element_ty()->repr() + "*";
+      case PointerTyID: return pointer_repr();
       case StructTyID: return "struct";
       case TileTyID: return tile_repr();
       default: break;
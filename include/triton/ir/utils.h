@@ -4,6 +4,7 @@
 #define _TRITON_IR_CFG_H_
 
 #include <vector>
+#include <map>
 #include <functional>
 
 namespace triton{
@@ -18,6 +19,9 @@ class value;
 class cfg {
 public:
   static std::vector<basic_block *> reverse_post_order(function* fn);
+  // immediate dominator of each block reachable from the entry (which maps to nullptr)
+  static std::map<basic_block*, basic_block*> immediate_dominators(function* fn);
+  static bool dominates(const std::map<basic_block*, basic_block*>& idom, basic_block* x, basic_block* y);
 };
 
 void for_each_instruction(ir::module& mod, const std::function<void(triton::ir::instruction*)> &fn);
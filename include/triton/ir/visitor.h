@@ -41,6 +41,7 @@ class unmasked_load_inst;
 class masked_load_inst;
 class unmasked_store_inst;
 class masked_store_inst;
+class prefetch_inst;
 
 class retile_inst;
 class reshape_inst;
@@ -55,10 +56,11 @@ class get_program_id_inst;
 class get_num_program_inst;
 class atomic_cas_inst;
 class atomic_exch_inst;
-class atomic_add_inst;
+class atomic_rmw_inst;
 class dot_inst;
 class trans_inst;
 class sqrt_inst;
+class math_inst;
 class reduce_inst;
 class select_inst;
 
@@ -118,6 +120,7 @@ public:
   virtual void visit_masked_load_inst(masked_load_inst*) = 0;
   virtual void visit_unmasked_store_inst(unmasked_store_inst*) = 0;
   virtual void visit_masked_store_inst(masked_store_inst*) = 0;
+  virtual void visit_prefetch_inst(prefetch_inst*) = 0;
 
   virtual void visit_exp_inst(exp_inst*) = 0;
   virtual void visit_log_inst(log_inst*) = 0;
@@ -131,10 +134,11 @@ public:
   virtual void visit_get_num_program_inst(get_num_program_inst*) = 0;
   virtual void visit_atomic_cas_inst(atomic_cas_inst*) = 0;
   virtual void visit_atomic_exch_inst(atomic_exch_inst*) = 0;
-  virtual void visit_atomic_add_inst(atomic_add_inst*) = 0;
+  virtual void visit_atomic_rmw_inst(atomic_rmw_inst*) = 0;
   virtual void visit_dot_inst(dot_inst*) = 0;
   virtual void visit_trans_inst(trans_inst*) = 0;
   virtual void visit_sqrt_inst(sqrt_inst*) = 0;
+  virtual void visit_math_inst(math_inst*) = 0;
   virtual void visit_reduce_inst(reduce_inst*) = 0;
   virtual void visit_select_inst(select_inst*) = 0;
 
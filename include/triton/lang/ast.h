@@ -519,7 +519,9 @@ public:
   Expr* Designator() { return designator_; }
   const std::string& Name() const { return tok_->str_; }
   ::FuncType* FuncType() { return designator_->Type()->ToFunc(); }
+  bool IsAtomicRMW() const;
   virtual void TypeChecking();
+  void AtomicRMWTypeChecking();
 
 protected:
   FuncCall(Expr* designator, const ArgList& args)
@@ -112,6 +112,7 @@ public:
     INT,
     LONG,
     HALF,
+    BF16,
     FLOAT,
     DOUBLE,
     SIGNED,
@@ -169,6 +170,12 @@ public:
     EXP,
     LOG,
     SQRTF,
+    TANH,
+    ERF,
+    SIGMOID,
+    SIN,
+    COS,
+    RSQRT,
     // KEYWORD END
 
     IDENTIFIER,
@@ -59,6 +59,7 @@ enum {
   T_STRUCT_UNION = 0x80000,
   T_ENUM = 0x100000,
   T_TYPEDEF_NAME = 0x200000,
+  T_BF16 = 0x400000,
 
   T_LLONG = 0x4000000,
 
@@ -227,7 +228,7 @@ public:
   virtual bool IsInteger() const { return !IsFloat() && !IsComplex(); }
   virtual bool IsUnsigned() const { return tag_ & T_UNSIGNED; }
   virtual bool IsFloat() const {
-    return (tag_ & T_HALF) || (tag_ & T_FLOAT) || (tag_ & T_DOUBLE);
+    return (tag_ & T_HALF) || (tag_ & T_BF16) || (tag_ & T_FLOAT) || (tag_ & T_DOUBLE);
   }
   virtual bool IsBool() const { return tag_ & T_BOOL; }
   bool IsComplex() const { return tag_ & T_COMPLEX; }
@@ -0,0 +1,49 @@
+#pragma once
+
+#ifndef _TRITON_RUNTIME_AOT_H_
+#define _TRITON_RUNTIME_AOT_H_
+
+#include <map>
+#include <vector>
+#include <string>
+#include "triton/runtime/function.h"
+
+namespace triton{
+namespace runtime{
+
+/* ------------------------- */
+/* Ahead-of-time compilation */
+/* ------------------------- */
+
+// one launch function is generated per config
+struct aot_config {
+  std::string name;
+  options_t opt;
+};
+
+// power-of-two divisor assumed for (some of) the pointer
+// and integer arguments, by name. Unspecified arguments
+// are not specialized
+typedef std::map<std::string, uint64_t> aot_spec_t;
+
+// Compiles `src` for every config and specialization on
+// `device`, and returns the files to write (name -> content):
+// - `<name>.h`: a dispatch header with one typed launch
+//   function per config, which picks the most specialized
+//   binary valid for its arguments like function::autotune.
+//   CUDA binaries are embedded in it as PTX
+// - `<name>_<config>_<i>.o` (host only): one object file
+//   per distinct binary, to link with the application. Objects
+//   target `cpu` with `features` (LLVM names), so that they
+//   do not depend on the machine that compiled them
+std::map<std::string, std::string> aot_compile(const std::string& name, const std::string& src,
+                                               const std::vector<aot_config>& confs,
+                                               const std::vector<aot_spec_t>& specs,
+                                               driver::device* device,
+                                               const std::string& cpu = "generic",
+                                               const std::string& features = "");
+
+}
+}
+
+#endif
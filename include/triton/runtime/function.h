@@ -9,6 +9,7 @@
 #include <string>
 #include <sstream>
 #include <memory>
+#include <mutex>
 #include <functional>
 // codegen
 #include "triton/ir/function.h"
@@ -22,6 +23,7 @@ namespace driver{
   class module;
   class stream;
   class kernel;
+  class buffer;
   class context;
   class device;
 }
@@ -32,6 +34,7 @@ namespace ir {
 class module;
 class function;
 class context;
+class type;
 }
 }
 
@@ -43,6 +46,25 @@ namespace runtime{
 /* Compilation options       */
 /* ------------------------- */
 
+// persistent execution (see codegen::transform::persistent)
+enum schedule_t {
+  // one program per tile
+  SCHEDULE_NONE,
+  // resident programs stride over the tiles
+  SCHEDULE_STATIC,
+  // resident programs pull tiles from a global counter
+  SCHEDULE_DYNAMIC
+};
+
+// order of the tiles of grid axes 0 and 1, for L2 locality
+// (see codegen::transform::tile_order)
+enum order_t {
+  ORDER_NONE,
+  ORDER_GROUPED,
+  ORDER_MORTON,
+  ORDER_HILBERT
+};
+
 struct options_t {
   template<class T>
   T D(const std::string& name) const {
@@ -50,6 +72,13 @@ struct options_t {
   }
   std::unordered_map<std::string, std::string> defines;
   int num_warps;
+  int num_stages = 2;
+  bool fast_math = true;
+  schedule_t schedule = SCHEDULE_NONE;
+  order_t order = ORDER_NONE;
+  // rows of tiles per group along axis 0 (0: 8). persistent
+  // kernels without an order use the grouped order when set
+  int group_size = 0;
 };
 
 /* ------------------------- */
@@ -63,6 +92,7 @@ enum arg_type {
   INT32_T,
   INT64_T,
   HALF_T,
+  BF16_T,
   FLOAT_T,
   DOUBLE_T,
   BUFFER_T
@@ -76,6 +106,7 @@ inline size_t size_of(arg_type ty){
   case INT32_T : return 4;
   case INT64_T : return 8;
   case HALF_T  : return 2;
+  case BF16_T  : return 2;
   case FLOAT_T : return 4;
   case DOUBLE_T: return 8;
   case BUFFER_T: return 8;
@@ -88,6 +119,18 @@ void add_arg(std::stringstream& ss, T arg) {
   ss.write((char*)&arg, sizeof(T));
 }
 
+// runtime type of a kernel argument
+arg_type convert(ir::type *ty);
+
+/* ------------------------- */
+/* Specialization            */
+/* ------------------------- */
+
+// pointers and integers are specialized on their largest
+// power-of-two divisor, up to max_divisor(ty)
+uint64_t max_divisor(arg_type ty);
+uint64_t pow2_divisor(uint64_t N, uint64_t max_divisor);
+
 
 /* ------------------------- */
 /* ------------------------- */
@@ -101,21 +144,48 @@ enum asm_mode_t {
 class kernel{
 public:
   typedef std::vector<size_t> grid_t;
+  // accumulated wall-clock time (ns) of each compilation pass
+  typedef std::map<std::string, double> pass_times_t;
+  // statistics of the compilation
+  struct stats_t {
+    // shared memory footprint (bytes) and its lower bound
+    size_t shared_mem;
+    size_t shared_mem_lower_bound;
+    // barriers inserted and removed by the membar pass
+    size_t barriers_inserted;
+    size_t barriers_removed;
+    // placement and live segments of every shared memory buffer
+    struct buffer_t {
+      size_t offset;
+      size_t size;
+      std::vector<std::pair<unsigned, unsigned>> live;
+    };
+    std::vector<buffer_t> shared_buffers;
+  };
 
 public:
   static std::shared_ptr<ir::module> src_to_ir(const std::string& src, const options_t& opt);
+  // host modules are not linked by the JIT unless `load` is set
   static std::tuple<std::shared_ptr<driver::module>,
                     std::shared_ptr<driver::kernel>,
-                    size_t> ir_to_bin(ir::module& ir, driver::device *dev, const options_t &opt);
+                    size_t> ir_to_bin(ir::module& ir, driver::device *dev, const options_t &opt,
+                                      pass_times_t* pass_times = nullptr,
+                                      stats_t* stats = nullptr,
+                                      bool load = true);
 
 public:
   kernel(const std::string& src, const options_t& opt, driver::device *device, const std::map<int, triton::ir::attribute> &attrs = {});
+  // in persistent mode, `grid` is the grid of tiles
   void operator()(const std::string& args, driver::stream *stream, const grid_t& grid) const;
   std::string get_asm(asm_mode_t mode);
+  const stats_t& stats() const { return stats_; }
 
 public:
   const options_t opt;
 
+private:
+  driver::buffer* counter(driver::stream *stream) const;
+
 private:
   driver::device* dev_;
   // handles
@@ -124,11 +194,21 @@ private:
   std::shared_ptr<driver::kernel> ker_;
   // shared mem
   size_t shared_mem_;
+  stats_t stats_;
+  // persistent mode: launches on the same stream run in order
+  // and share its tile counter, which each of them resets
+  size_t num_resident_;
+  mutable std::map<driver::stream*, std::shared_ptr<driver::buffer>> counters_;
+  mutable std::mutex counters_mutex_;
 };
 
 struct config {
   std::map<std::string, std::string> defines;
   int num_warps;
+  int num_stages = 2;
+  // ORDER_NONE keeps the order of the function's options
+  order_t order = ORDER_NONE;
+  int group_size = 0;
 };
 
 class function {
@@ -482,8 +482,12 @@ std::vector<unsigned> align::populate_starting_multiple(ir::value *v){
     return populate_starting_multiple_cast(x);
   if(auto *x = dynamic_cast<ir::binary_operator*>(v))
     return populate_starting_multiple_binop(x);
-  if(auto *x = dynamic_cast<ir::constant_int*>(v))
-    return add_to_cache(x, {std::min<unsigned>(x->get_value(), 128)}, starting_multiple_);
+  if(auto *x = dynamic_cast<ir::constant_int*>(v)){
+    // large constants are only known to be multiples of their lowest set bit
+    uint64_t cst = x->get_value();
+    unsigned result = cst <= 128 ? cst : std::min<uint64_t>(cst & -cst, 128);
+    return add_to_cache(x, {result}, starting_multiple_);
+  }
   if(auto *x = dynamic_cast<ir::make_range*>(v))
     return add_to_cache(x, {(unsigned)x->get_first()->get_value()}, starting_multiple_);
   if(auto *x = dynamic_cast<ir::make_range_dyn*>(v))
@@ -514,6 +518,21 @@ std::vector<unsigned> align::contiguous(ir::value* v) const {
   return max_contiguous_.at(v);
 }
 
+std::vector<unsigned> align::starting_multiple(ir::value* v) const {
+  return starting_multiple_.at(v);
+}
+
+// all elements of the tile are equal
+bool align::is_uniform(ir::value* v) const {
+  auto shapes = v->get_type()->is_tile_ty() ? v->get_type()->get_tile_shapes()
+                                            : std::vector<unsigned>{1};
+  const std::vector<cst_info>& cst = is_constant_.at(v);
+  for(size_t d = 0; d < shapes.size(); d++)
+    if(cst[d].num_cst < shapes[d])
+      return false;
+  return true;
+}
+
 
 void align::populate(ir::value *v) {
   populate_is_constant(v);
@@ -1,5 +1,7 @@
 #include <algorithm>
 #include <climits>
+#include <functional>
+#include <numeric>
 #include "triton/codegen/analysis/layout.h"
 #include "triton/codegen/analysis/allocation.h"
 #include "triton/codegen/analysis/liveness.h"
@@ -9,97 +11,134 @@ namespace triton{
 namespace codegen{
 namespace analysis{
 
+// offsets are aligned on the largest power of two (up to 16 bytes)
+// dividing the buffer size, so that vectorized accesses stay aligned
+unsigned allocation::alignment(shared_layout *x) {
+  unsigned size = x->get_size();
+  unsigned ret = 1;
+  while(ret < 16 && size % (2*ret) == 0)
+    ret *= 2;
+  return ret;
+}
 
 void allocation::run(ir::module &mod) {
-  using std::max;
-  using std::min;
-  typedef std::multimap<unsigned, segment> triples_map_type;
-
-  std::vector<shared_layout*> I;
-  for(auto x: liveness_->get())
-    I.push_back(x.first);
-  std::vector<shared_layout*> J = I;
-
-  triples_map_type H;
-  H.insert({0, segment{0, INT_MAX}});
-
+  offsets_.clear();
+  // buffers, in order of liveness
   std::vector<shared_layout*> V;
-  std::map<shared_layout*, unsigned> starts;
-  while(!J.empty()){
-    auto h_it = H.begin();
-    unsigned w = h_it->first;
-    segment xh = h_it->second;
-    H.erase(h_it);
-    auto j_it = std::find_if(J.begin(), J.end(), [&](shared_layout* JJ){
-      segment xj = liveness_->get(JJ);
-      bool res = xj.intersect(xh);
-      for(auto val: H)
-        res = res && !val.second.intersect(xj);
-      return res;
-    });
-    if(j_it != J.end()){
-      unsigned size = (*j_it)->get_size();
-      segment xj = liveness_->get(*j_it);
-      starts[*j_it] = w;
-      H.insert({w + size, segment{max(xh.start, xj.start), min(xh.end, xj.end)}});
-      if(xh.start < xj.start)
-        H.insert({w, segment{xh.start, xj.end}});
-      if(xj.end < xh.end)
-        H.insert({w, segment{xj.start, xh.end}});
-      V.push_back(*j_it);
-      J.erase(j_it);
-    }
-  }
-
-  // Build interference graph
-  std::map<shared_layout*, std::set<shared_layout*>> interferences;
-  for(shared_layout* x: V)
-  for(shared_layout* y: V){
-    if(x == y)
-      continue;
-    unsigned X0 = starts[x], Y0 = starts[y];
-    unsigned NX = x->get_size();
-    unsigned NY = y->get_size();
-    segment XS = {X0, X0 + NX};
-    segment YS = {Y0, Y0 + NY};
-    if(liveness_->get(x).intersect(liveness_->get(y))
-        && XS.intersect(YS))
-      interferences[x].insert(y);
+  for(auto x: liveness_->get())
+    V.push_back(x.first);
+  std::sort(V.begin(), V.end(), [&](shared_layout* x, shared_layout* y){
+    return liveness_->get(x).start() < liveness_->get(y).start();
+  });
+  size_t n = V.size();
+  std::vector<unsigned> size(n), align(n);
+  for(size_t i = 0; i < n; i++){
+    size[i] = V[i]->get_size();
+    align[i] = alignment(V[i]);
   }
 
-  // Initialize colors
-  std::map<shared_layout*, int> colors;
-  for(shared_layout* X: V)
-    colors[X] = (X==V[0])?0:-1;
+  // buffers whose live ranges intersect cannot overlap in memory
+  std::vector<std::vector<size_t>> interferences(n);
+  for(size_t i = 0; i < n; i++)
+  for(size_t j = 0; j < n; j++)
+    if(i != j && liveness_->get(V[i]).intersect(liveness_->get(V[j])))
+      interferences[i].push_back(j);
 
+  // lower bound: largest total size of simultaneously live buffers
+  lower_bound_ = 0;
+  for(size_t i = 0; i < n; i++)
+  for(const segment& s: liveness_->get(V[i]).segments){
+    size_t live = size[i];
+    for(size_t j: interferences[i])
+      if(liveness_->get(V[j]).contains(s.start))
+        live += size[j];
+    lower_bound_ = std::max(lower_bound_, live);
+  }
+  for(size_t i = 0; i < n; i++)
+    lower_bound_ = std::max<size_t>(lower_bound_, size[i]);
 
-  // First-fit graph coloring
-  std::vector<bool> available(V.size());
-  for(shared_layout* x: V){
-    // Non-neighboring colors are available
-    std::fill(available.begin(), available.end(), true);
-    for(shared_layout* Y: interferences[x]){
-      int color = colors[Y];
-      if(color >= 0)
-        available[color] = false;
+  // offset of buffer i given the already placed buffers.
+  // candidates are 0 and the end of every interfering placed buffer;
+  // first-fit returns the lowest feasible one, best-fit the one
+  // leaving the smallest gap below the next interfering buffer
+  const unsigned none = UINT_MAX;
+  auto place = [&](size_t i, const std::vector<unsigned>& offsets, bool best_fit) {
+    std::vector<unsigned> candidates = {0};
+    for(size_t j: interferences[i])
+      if(offsets[j] != none)
+        candidates.push_back((offsets[j] + size[j] + align[i] - 1) / align[i] * align[i]);
+    unsigned ret = none;
+    unsigned ret_gap = none;
+    for(unsigned c: candidates){
+      bool feasible = true;
+      unsigned gap = none;
+      for(size_t j: interferences[i]){
+        if(offsets[j] == none)
+          continue;
+        if(c < offsets[j] + size[j] && offsets[j] < c + size[i])
+          feasible = false;
+        if(offsets[j] >= c + size[i])
+          gap = std::min(gap, offsets[j] - c - size[i]);
+      }
+      if(!feasible)
+        continue;
+      bool better = best_fit ? std::make_pair(gap, c) < std::make_pair(ret_gap, ret) : c < ret;
+      if(better){
+        ret = c;
+        ret_gap = gap;
+      }
     }
-    // Assigns first available color
-    auto It = std::find(available.begin(), available.end(), true);
-    colors[x] = std::distance(available.begin(), It);
+    return ret;
+  };
+
+  // best-fit decreasing
+  std::vector<size_t> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t i, size_t j){
+    return size[i] > size[j];
+  });
+  std::vector<unsigned> offsets(n, none);
+  size_t best = 0;
+  for(size_t i: order){
+    offsets[i] = place(i, offsets, true);
+    best = std::max<size_t>(best, offsets[i] + size[i]);
   }
+  std::vector<unsigned> best_offsets = offsets;
 
-  // Finalize allocation
-  for(shared_layout* x: V){
-    unsigned Adj = 0;
-    for(shared_layout* y: interferences[x])
-      Adj = std::max<unsigned>(Adj, starts[y] + y->get_size());
-    offsets_[x] = starts[x] + colors[x] * Adj;
+  // small problems are solved exactly: any packing can be obtained
+  // by first-fit placement of the buffers in order of their offset,
+  // so it is enough to enumerate placement orders
+  const size_t max_exact = 8;
+  const size_t max_nodes = 100000;
+  if(n <= max_exact && best > lower_bound_){
+    std::fill(offsets.begin(), offsets.end(), none);
+    std::vector<bool> placed(n, false);
+    size_t nodes = 0;
+    std::function<void(size_t, size_t)> search = [&](size_t depth, size_t peak) {
+      if(peak >= best || best == lower_bound_ || nodes++ > max_nodes)
+        return;
+      if(depth == n){
+        best = peak;
+        best_offsets = offsets;
+        return;
+      }
+      for(size_t i = 0; i < n; i++){
+        if(placed[i])
+          continue;
+        placed[i] = true;
+        offsets[i] = place(i, offsets, false);
+        search(depth + 1, std::max<size_t>(peak, offsets[i] + size[i]));
+        offsets[i] = none;
+        placed[i] = false;
+      }
+    };
+    search(0, 0);
   }
 
-  // Save maximum size of induced memory space
-  allocated_size_ = 0;
-  for(shared_layout* x: V)
-    allocated_size_ = std::max<size_t>(allocated_size_, starts[x] + x->get_size());
+  // finalize allocation
+  for(size_t i = 0; i < n; i++)
+    offsets_[V[i]] = best_offsets[i];
+  allocated_size_ = best;
 }
 
 }
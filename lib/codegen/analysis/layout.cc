@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <functional>
 #include <numeric>
 #include <iostream>
 #include "triton/codegen/analysis/axes.h"
@@ -22,7 +23,7 @@ inline unsigned clamp(unsigned x, unsigned a, unsigned b) {
   return std::min(std::max(x, lo), hi);
 }
 
-inline bool is_hmma_c(ir::value *v){
+inline bool is_hmma_c(ir::value *v, target *tgt){
   bool result = false;
   if(auto *x = dynamic_cast<ir::dot_inst*>(v)){
     ir::value *a = x->get_operand(0);
@@ -31,6 +32,10 @@ inline bool is_hmma_c(ir::value *v){
     ir::type *b_ty = b->get_type();
     result = a_ty->get_scalar_ty()->is_half_ty() &&
              b_ty->get_scalar_ty()->is_half_ty();
+    // bfloat16 tensor cores only exist on sm_80+
+    if(tgt->as_nvidia() && tgt->as_nvidia()->sm() >= 80)
+      result = result || (a_ty->get_scalar_ty()->is_bf16_ty() &&
+                          b_ty->get_scalar_ty()->is_bf16_ty());
   }
   return result;
 }
@@ -51,10 +56,10 @@ inline void extract_dot_use(ir::value *v, ir::value*& result, size_t n) {
   }
 }
 
-inline void extract_hmma_dot_use(ir::value *v, ir::value*& result, size_t n) {
+inline void extract_hmma_dot_use(ir::value *v, ir::value*& result, size_t n, target *tgt) {
   for(ir::user* u: v->get_users()){
     auto i = dynamic_cast<ir::dot_inst*>(u);
-    if(i && is_hmma_c(i) && i->get_operand(n) == v)
+    if(i && is_hmma_c(i, tgt) && i->get_operand(n) == v)
       result = i;
   }
 }
@@ -211,7 +216,7 @@ scanline_layout::scanline_layout(size_t num_warps,
 
   unsigned i = order_[0];
   int contiguous = 1;
-  if(ptr){
+  if(ptr && i < ptr->get_type()->get_tile_rank()){
     int nbits = ptr->get_type()->get_pointer_element_ty()->get_scalar_ty()->get_primitive_size_in_bits();
     contiguous = std::min<int>(align->get(ptr, i), 128 / nbits);
   }
@@ -279,7 +284,8 @@ shared_layout::shared_layout(data_layout *arg,
                                  const std::vector<unsigned>& shape,
                                  const std::vector<ir::value *> &values,
                                  ir::type *ty,
-                                 analysis::align* align): data_layout(SHARED, axes, shape, values, align), ty_(ty) {
+                                 analysis::align* align,
+                                 target *tgt): data_layout(SHARED, axes, shape, values, align), ty_(ty) {
 
   size_ = 0;
   arg_layout_ = arg;
@@ -299,8 +305,8 @@ shared_layout::shared_layout(data_layout *arg,
   for(ir::value* v: values){
     extract_dot_use(v, dot_a, 0);
     extract_dot_use(v, dot_b, 1);
-    extract_hmma_dot_use(v, hmma_dot_a, 0);
-    extract_hmma_dot_use(v, hmma_dot_b, 1);
+    extract_hmma_dot_use(v, hmma_dot_a, 0, tgt);
+    extract_hmma_dot_use(v, hmma_dot_b, 1, tgt);
   }
   hmma_dot_a_ = hmma_dot_a;
   hmma_dot_b_ = hmma_dot_b;
@@ -351,10 +357,88 @@ void layouts::make_graph(ir::instruction *i) {
   }
 }
 
+// whether every tile of a group is distributed along the axes of its
+// largest tile, which are the only ones its layout describes
+bool layouts::is_consistent(const std::vector<ir::value*>& values) {
+  auto cmp = [](ir::value* x, ir::value *y) {
+    std::pair<int, int> xx = {x->get_type()->get_tile_rank(), x->get_type()->get_tile_num_elements()};
+    std::pair<int, int> yy = {y->get_type()->get_tile_rank(), y->get_type()->get_tile_num_elements()};
+    return xx < yy;
+  };
+  ir::value *largest = *std::max_element(values.begin(), values.end(), cmp);
+  std::vector<int> ref = axes_->get(largest);
+  for(ir::value *v: values){
+    const auto& shapes = v->get_type()->get_tile_shapes();
+    for(size_t d = 0; d < shapes.size(); d++)
+      if(shapes[d] > 1 && std::find(ref.begin(), ref.end(), axes_->get(v, d)) == ref.end())
+        return false;
+  }
+  return true;
+}
+
+// Groups mixing unrelated axes (e.g., attention scores [M, N] and the
+// [M, D] accumulator they rescale) are cut at their broadcasts and
+// reductions, and the cuts are restored as long as the groups they join
+// remain consistent. Remaining broadcasts convert their operand through
+// shared memory; reductions already write their result to it
+void layouts::split(ir::module &mod) {
+  std::set<size_t> inconsistent;
+  for(const auto& x: values_)
+    if(!is_consistent(x.second))
+      inconsistent.insert(x.first);
+  if(inconsistent.empty())
+    return;
+  std::vector<std::pair<ir::value*, ir::value*>> cuts;
+  graph_.clear();
+  ir::for_each_instruction(mod, [&](ir::instruction* i) {
+    // dots may join groups through their operands wherever they are
+    bool is_dot = dynamic_cast<ir::dot_inst*>(i);
+    bool mixed = i->get_type()->is_tile_ty() && inconsistent.find(groups_.at(i)) != inconsistent.end();
+    bool is_rc = mixed && dynamic_cast<ir::recoalesce_inst*>(i);
+    bool is_cut = mixed && (dynamic_cast<ir::broadcast_inst*>(i) || dynamic_cast<ir::reduce_inst*>(i));
+    if(!is_dot && !is_rc && !is_cut)
+      return make_graph(i);
+    graph_.add_edge(i, i);
+    for(ir::value *op: i->ops())
+      graph_.add_edge(op, op);
+    // the operands of a dot are copied to shared memory, and
+    // recoalesced tiles are converted through it
+    if(is_rc)
+      return;
+    if(is_dot)
+      connect(i, i->get_operand(2));
+    else
+      cuts.push_back({i, i->get_operand(0)});
+  });
+  graph_.connected_components(&values_, &groups_);
+  // restore cuts, broadcasts first
+  std::stable_partition(cuts.begin(), cuts.end(), [](const std::pair<ir::value*, ir::value*>& cut) {
+    return dynamic_cast<ir::broadcast_inst*>(cut.first) != nullptr;
+  });
+  std::map<size_t, size_t> parent;
+  std::function<size_t(size_t)> find = [&](size_t x) {
+    return parent.find(x) == parent.end() ? x : find(parent.at(x));
+  };
+  for(const auto& cut: cuts){
+    size_t x = find(groups_.at(cut.first));
+    size_t y = find(groups_.at(cut.second));
+    if(x == y)
+      continue;
+    std::vector<ir::value*> merged = values_.at(x);
+    merged.insert(merged.end(), values_.at(y).begin(), values_.at(y).end());
+    if(!is_consistent(merged))
+      continue;
+    values_[x] = merged;
+    parent[y] = x;
+    graph_.add_edge(cut.first, cut.second);
+  }
+  graph_.connected_components(&values_, &groups_);
+}
+
 void layouts::create(size_t id, const std::vector<ir::value*>& values) {
 //  if(layouts_.find(id) != layouts_.end())
 //    return;
-  auto it_hmma_c = std::find_if(values.begin(), values.end(), &is_hmma_c);
+  auto it_hmma_c = std::find_if(values.begin(), values.end(), [&](ir::value* v) { return is_hmma_c(v, tgt_); });
   auto cmp = [](ir::value* x, ir::value *y) {
     std::pair<int, int> xx = {x->get_type()->get_tile_rank(), x->get_type()->get_tile_num_elements()};
     std::pair<int, int> yy = {y->get_type()->get_tile_rank(), y->get_type()->get_tile_num_elements()};
@@ -382,7 +466,7 @@ void layouts::create(size_t id, const std::vector<ir::value*>& values) {
     ir::instruction *cts = (ir::instruction*)*it_cts;
     ir::value *arg = cts->get_operand(0);
     create(groups_.at(arg), values_.at(groups_.at(arg)));
-    layouts_[id] = new shared_layout(get(arg), axes, shapes, values, largest->get_type()->get_scalar_ty(), align_);
+    layouts_[id] = new shared_layout(get(arg), axes, shapes, values, largest->get_type()->get_scalar_ty(), align_, tgt_);
   }
   else{
     layouts_[id] = new scanline_layout(num_warps_, axes, shapes, values, align_, tgt_);
@@ -398,6 +482,7 @@ void layouts::run(ir::module &mod) {
 
   // connected components
   graph_.connected_components(&values_, &groups_);
+  split(mod);
 
   // create layouts
   for(const auto& x: values_)
@@ -412,12 +497,23 @@ void layouts::run(ir::module &mod) {
       unsigned axis = red->get_axis();
       // shape
       auto shapes = arg->get_type()->get_tile_shapes();
-      scanline_layout *layout = get(arg)->to_scanline();
-      shapes[axis] = layout->mts(axis);
+      // other layouts are reduced from a copy of the whole tile
+      if(scanline_layout *layout = get(arg)->to_scanline())
+        shapes[axis] = layout->mts(axis);
       // create layout
-      layouts_[id] = new shared_layout(layout, axes_->get(arg), shapes, {red}, red->get_type()->get_scalar_ty(), align_);
+      layouts_[id] = new shared_layout(get(arg), axes_->get(arg), shapes, {red}, red->get_type()->get_scalar_ty(), align_, tgt_);
       tmp_[red] = id;
     }
+    if(auto *bcast = dynamic_cast<ir::broadcast_inst*>(i)){
+      ir::value *arg = bcast->get_operand(0);
+      if(layout_of(arg) == layout_of(bcast))
+        return;
+      // conversion between layouts
+      id++;
+      auto shapes = arg->get_type()->get_tile_shapes();
+      layouts_[id] = new shared_layout(get(arg), axes_->get(arg), shapes, {bcast}, bcast->get_type()->get_scalar_ty(), align_, tgt_);
+      tmp_[bcast] = id;
+    }
     if(auto *recoalasce = dynamic_cast<ir::recoalesce_inst*>(i)){
       ir::value *val = recoalasce->get_operand(0);
       mma_layout* in_layout = get(val)->to_mma();
@@ -433,14 +529,35 @@ void layouts::run(ir::module &mod) {
         if(k != ld)
           shape[k] = in_layout->to_mma()->spt(k);
       // create layout
-      layouts_[id] = new shared_layout(out_layout, axes_->get(val), shape, {recoalasce}, val->get_type()->get_scalar_ty(), align_);
+      layouts_[id] = new shared_layout(out_layout, axes_->get(val), shape, {recoalasce}, val->get_type()->get_scalar_ty(), align_, tgt_);
       tmp_[recoalasce] = id;
     }
     if(auto *atom = dynamic_cast<ir::atomic_cas_inst*>(i)){
       id++;
-      layouts_[id] = new shared_layout(nullptr, {}, {1}, {atom}, atom->get_type()->get_scalar_ty(), align_);
+      layouts_[id] = new shared_layout(nullptr, {}, {1}, {atom}, atom->get_type()->get_scalar_ty(), align_, tgt_);
       tmp_[atom] = id;
     }
+    if(auto *atom = dynamic_cast<ir::atomic_rmw_inst*>(i))
+    if(!atom->get_type()->is_tile_ty() && !atom->get_users().empty()){
+      id++;
+      layouts_[id] = new shared_layout(nullptr, {}, {1}, {atom}, atom->get_type()->get_scalar_ty(), align_, tgt_);
+      tmp_[atom] = id;
+    }
+    // replicas of the elements of a tile get the old
+    // values of their owners through shared memory
+    if(auto *atom = dynamic_cast<ir::atomic_rmw_inst*>(i))
+    if(atom->get_type()->is_tile_ty() && !atom->get_users().empty() && tgt_->is_gpu())
+    if(scanline_layout *layout = get(atom)->to_scanline()){
+      size_t num_owners = 1;
+      for(size_t k = 0; k < layout->get_rank(); k++)
+        num_owners *= layout->mts(k);
+      if(num_owners < num_warps_*32){
+        id++;
+        auto shapes = atom->get_type()->get_tile_shapes();
+        layouts_[id] = new shared_layout(layout, axes_->get(atom), shapes, {atom}, atom->get_type()->get_scalar_ty(), align_, tgt_);
+        tmp_[atom] = id;
+      }
+    }
   });
 }
 
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <climits>
 #include <iostream>
 #include "triton/codegen/analysis/liveness.h"
@@ -14,42 +15,116 @@ namespace analysis{
 void liveness::run(ir::module &mod) {
   intervals_.clear();
 
-  // Assigns index to each instruction
-  std::map<ir::value*, slot_index> indices;
-  for(ir::function *fn: mod.get_function_list()){
-    slot_index index = 0;
-    for(ir::basic_block *block: fn->blocks())
-    for(ir::instruction *instr: block->get_inst_list()){
-      index += 1;
-      indices.insert({instr, index});
-    }
-  }
-
-  // create live intervals
+  // values stored in shared memory
+  std::map<ir::value*, shared_layout*> layout_of;
   for(auto &x: layouts_->get_all()) {
     shared_layout* layout = x.second->to_shared();
     if(!layout)
       continue;
-    // users
-    std::set<ir::user*> users;
-    for(ir::value *v: layout->get_values()){
-      for(ir::user *u: v->get_users())
-        users.insert(u);
-    }
-    // compute intervals
-    unsigned start = INT32_MAX;
+    intervals_[layout] = live_range();
     for(ir::value *v: layout->get_values())
-      if(indices.find(v) != indices.end())
-        start = std::min(start, indices.at(v));
-    unsigned end = 0;
-    for(ir::user *u: users)
-      if(indices.find(u) != indices.end())
-        end = std::max(end, indices.at(u));
-    intervals_[layout] = segment{start, end};
+      layout_of[v] = layout;
   }
+  auto is_shared = [&](ir::value* v) { return layout_of.find(v) != layout_of.end(); };
 
+  std::map<shared_layout*, std::vector<segment>> segments;
+  for(ir::function *fn: mod.get_function_list()){
+    // Assigns index to each instruction; block `b` spans
+    // slots [range[b].start, range[b].end)
+    std::map<ir::value*, slot_index> indices;
+    std::map<ir::basic_block*, segment> range;
+    slot_index index = 0;
+    for(ir::basic_block *block: fn->blocks()){
+      slot_index first = index + 1;
+      for(ir::instruction *instr: block->get_inst_list()){
+        index += 1;
+        indices.insert({instr, index});
+      }
+      range[block] = segment{first, index + 1};
+    }
 
+    // Local definitions and upward-exposed uses of each block.
+    // Operands of a phi-node are used at the end of the incoming block
+    std::map<ir::basic_block*, std::set<ir::value*>> defs, uses, phi_uses;
+    std::map<ir::basic_block*, std::map<ir::value*, slot_index>> last_use;
+    for(ir::basic_block *block: fn->blocks())
+    for(ir::instruction *instr: block->get_inst_list()){
+      if(ir::phi_node *phi = dynamic_cast<ir::phi_node*>(instr)){
+        for(unsigned n = 0; n < phi->get_num_incoming(); n++)
+          if(is_shared(phi->get_incoming_value(n)))
+            phi_uses[phi->get_incoming_block(n)].insert(phi->get_incoming_value(n));
+      }
+      else{
+        for(ir::value *op: instr->ops()){
+          if(!is_shared(op))
+            continue;
+          if(defs[block].find(op) == defs[block].end())
+            uses[block].insert(op);
+          last_use[block][op] = indices.at(instr);
+        }
+      }
+      if(is_shared(instr))
+        defs[block].insert(instr);
+    }
+
+    // Backward data-flow to a fixed point: values used by a
+    // loop-carried phi-node stay live around the back-edge
+    std::map<ir::basic_block*, std::set<ir::value*>> live_in, live_out;
+    bool changed = true;
+    while(changed){
+      changed = false;
+      auto blocks = fn->blocks();
+      for(auto it = blocks.rbegin(); it != blocks.rend(); it++){
+        ir::basic_block *block = *it;
+        std::set<ir::value*> out = phi_uses[block];
+        for(ir::basic_block *succ: block->get_successors())
+          out.insert(live_in[succ].begin(), live_in[succ].end());
+        std::set<ir::value*> in = uses[block];
+        for(ir::value *v: out)
+          if(defs[block].find(v) == defs[block].end())
+            in.insert(v);
+        if(in != live_in[block] || out != live_out[block]){
+          live_in[block] = in;
+          live_out[block] = out;
+          changed = true;
+        }
+      }
+    }
 
+    // Live segment of each value within each block.
+    // Phi-nodes are all defined on entry of their block.
+    // A value stops being live at its last use, so that
+    // the instruction using it may write to the same memory
+    for(ir::basic_block *block: fn->blocks()){
+      std::set<ir::value*> values = live_in[block];
+      values.insert(defs[block].begin(), defs[block].end());
+      for(ir::value *v: values){
+        bool is_def = defs[block].find(v) != defs[block].end();
+        bool is_phi = dynamic_cast<ir::phi_node*>(v) != nullptr;
+        slot_index start = is_def && !is_phi ? indices.at(v) : range[block].start;
+        slot_index end = start + 1;
+        if(live_out[block].find(v) != live_out[block].end())
+          end = range[block].end;
+        else if(last_use[block].find(v) != last_use[block].end())
+          end = std::max(last_use[block].at(v), is_def ? end : start);
+        if(start < end)
+          segments[layout_of.at(v)].push_back(segment{start, end});
+      }
+    }
+  }
+
+  // merge segments of all values in a layout
+  for(auto &x: segments){
+    std::vector<segment> &S = x.second;
+    std::sort(S.begin(), S.end(), [](const segment& a, const segment& b){ return a.start < b.start; });
+    std::vector<segment> &R = intervals_[x.first].segments;
+    for(const segment& s: S){
+      if(!R.empty() && s.start <= R.back().end)
+        R.back().end = std::max(R.back().end, s.end);
+      else
+        R.push_back(s);
+    }
+  }
 }
 
 }
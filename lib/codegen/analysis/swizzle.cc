@@ -26,13 +26,17 @@ void swizzle::run(ir::module &) {
         continue;
       }
       auto ord = layout->get_order();
-      scanline_layout* in_layout = dynamic_cast<scanline_layout*>(layout->get_arg_layout());
+      data_layout* in_layout = layout->get_arg_layout();
       if(!in_layout)
         continue;
+      // elements written per row: tiles of other layouts (e.g., the
+      // result of a previous dot) are written element by element
+      scanline_layout* in_scanline = in_layout->to_scanline();
+      int in_ld = in_scanline ? in_scanline->mts(ord[0])*in_scanline->nts(ord[0]) : layout->get_shape()[ord[0]];
       int dtsize = layout->get_type()->get_scalar_ty()->get_primitive_size_in_bits() / 8;
       if(tgt_->as_nvidia()->sm() < 80){
         int inner = mma_dot_a ? 0 : 1;
-        per_phase_[layout] = std::max<int>(128 / (in_layout->mts(ord[0])*in_layout->nts(ord[0])*dtsize), 1);
+        per_phase_[layout] = std::max<int>(128 / (in_ld*dtsize), 1);
         max_phase_[layout] = (ord[inner] == 1 ? 8 : 4) / per_phase_[layout];
         if(mma_dot_a)
           vec_[layout] = 2*layouts_->get(mma_dot_a)->to_mma()->rep(0);
@@ -40,7 +44,7 @@ void swizzle::run(ir::module &) {
           vec_[layout] = 2*layouts_->get(mma_dot_b)->to_mma()->rep(1);
       }
       else{
-        per_phase_[layout] = std::max<int>(128 / (in_layout->mts(ord[0])*in_layout->nts(ord[0])*dtsize), 1);
+        per_phase_[layout] = std::max<int>(128 / (in_ld*dtsize), 1);
         max_phase_[layout] = 8 / per_phase_[layout];
         vec_[layout]       = 8;
       }
@@ -1,4 +1,6 @@
 ﻿#include <numeric>
+#include <cmath>
+#include <cstring>
 #include "triton/codegen/selection/generator.h"
 #include "triton/codegen/target.h"
 #include "triton/codegen/analysis/axes.h"
@@ -102,6 +104,7 @@ Type *generator::cvt(ir::type *ty) {
   switch(ty->get_type_id()){
     case ir::type::VoidTyID:      return Type::getVoidTy(*ctx_);
     case ir::type::HalfTyID:      return Type::getHalfTy(*ctx_);
+    case ir::type::BF16TyID:      return Type::getInt16Ty(*ctx_);
     case ir::type::FloatTyID:     return Type::getFloatTy(*ctx_);
     case ir::type::DoubleTyID:    return Type::getDoubleTy(*ctx_);
     case ir::type::X86_FP80TyID:  return Type::getX86_FP80Ty(*ctx_);
@@ -138,9 +141,10 @@ generator::generator(analysis::axes *a_axes,
                     analysis::allocation *alloc,
                     analysis::swizzle *swizzle,
                     target *tgt,
-                    unsigned num_warps)
+                    unsigned num_warps,
+                    bool fast_math)
   : a_axes_(a_axes), layouts_(layouts), alignment_(alignment), alloc_(alloc), swizzle_(swizzle),
-    tgt_(tgt), num_warps_(num_warps) {
+    tgt_(tgt), num_warps_(num_warps), fast_math_(fast_math) {
 
 }
 
@@ -341,12 +345,63 @@ void generator::visit_cast_inst(ir::cast_inst* x) {
       default: throw std::runtime_error("unreachable switch");
     }
   };
+  ir::type *src_ty = x->get_operand(0)->get_type()->get_scalar_ty();
+  ir::type *dst_ty = x->get_type()->get_scalar_ty();
+  // bfloat16 is stored as i16 and converted through fp32 in software
+  if(src_ty->is_bf16_ty() || dst_ty->is_bf16_ty()){
+    ir::cast_op_t op = x->get_op();
+    for(indices_t idx: idxs_.at(x)){
+      Value *arg = vals_[x->get_operand(0)][idx];
+      if(op == ir::cast_op_t::BitCast){
+        vals_[x][idx] = bit_cast(arg, ty);
+        continue;
+      }
+      if(src_ty->is_bf16_ty())
+        arg = emit_bf16_to_f32(arg);
+      else if(op == ir::cast_op_t::SIToFP || op == ir::cast_op_t::UIToFP)
+        arg = cast(cvt(op), arg, f32_ty);
+      else
+        arg = fpcast(arg, f32_ty);
+      if(dst_ty->is_bf16_ty())
+        vals_[x][idx] = emit_f32_to_bf16(arg);
+      else if(dst_ty->is_floating_point_ty())
+        vals_[x][idx] = fpcast(arg, ty);
+      else
+        vals_[x][idx] = cast(cvt(op), arg, ty);
+    }
+    return;
+  }
   for(indices_t idx: idxs_.at(x)){
     Value *arg = vals_[x->get_operand(0)][idx];
     vals_[x][idx] = cast(cvt(x->get_op()), arg, ty);
   }
 }
 
+/**
+ * \brief Conversions between bfloat16 (as i16) and fp32
+ * bfloat16 is the upper half of an fp32. Narrowing rounds to nearest
+ * even and keeps NaNs quiet; sm_80+ has a native instruction for it.
+ */
+Value* generator::emit_bf16_to_f32(Value *x) {
+  Value *bits = builder_->CreateShl(builder_->CreateZExt(x, i32_ty), i32(16));
+  return bit_cast(bits, f32_ty);
+}
+
+Value* generator::emit_f32_to_bf16(Value *x) {
+  Type *i16_ty = builder_->getInt16Ty();
+  if(tgt_->as_nvidia() && tgt_->as_nvidia()->sm() >= 80){
+    FunctionType *fn_ty = FunctionType::get(i16_ty, {f32_ty}, false);
+    InlineAsm *iasm = InlineAsm::get(fn_ty, "cvt.rn.bf16.f32 $0, $1;", "=h,f", false);
+    return call(iasm, {x});
+  }
+  Value *bits = bit_cast(x, i32_ty);
+  Value *lsb = and_(builder_->CreateLShr(bits, i32(16)), i32(1));
+  Value *rounded = add(bits, add(lsb, i32(0x7FFF)));
+  Value *ret = builder_->CreateTrunc(builder_->CreateLShr(rounded, i32(16)), i16_ty);
+  Value *is_nan = fcmp(CmpInst::FCMP_UNO, x, x);
+  return select(is_nan, builder_->getInt16(0x7FC0), ret);
+}
+
 /**
  * \brief Code Generation for `return`
  */
@@ -444,7 +499,7 @@ void generator::visit_store_inst(ir::store_inst * x){
   if(val_op->get_type()->is_tile_ty()){
     auto ord = ords_.at(x->get_pointer_operand());
     size_t aln = alignment_->get(ptr_op, ord[0]);
-    size_t nts = axes_.at(a_axes_->get(x->get_pointer_operand(), ord[0])).contiguous;
+    size_t nts = axis_of(x->get_pointer_operand(), ord[0]).contiguous;
     vec  = std::min(nts, aln);
   }
   auto idxs    = idxs_.at(val_op);
@@ -477,6 +532,29 @@ void generator::visit_masked_store_inst(ir::masked_store_inst* x) {
   visit_store_inst(x);
 }
 
+/**
+ * \brief Code Generation for `prefetch`
+ */
+void generator::visit_prefetch_inst(ir::prefetch_inst* x) {
+  // only a hint for the cache hierarchy of CPUs
+  if(tgt_->is_gpu())
+    return;
+  ir::value *op = x->get_pointer_operand();
+  // one prefetch per cache line
+  size_t vec = 1;
+  if(op->get_type()->is_tile_ty()){
+    auto ord = ords_.at(op);
+    size_t dtsize = op->get_type()->get_scalar_ty()->get_pointer_element_ty()->get_primitive_size_in_bits() / 8;
+    vec = std::min<size_t>(alignment_->contiguous(op)[ord[0]], std::max<size_t>(64 / dtsize, 1));
+  }
+  auto idxs = idxs_.at(op);
+  for(size_t i = 0; i < idxs.size(); i += vec){
+    Value *ptr = vals_[op][idxs[i]];
+    ptr = bit_cast(ptr, builder_->getInt8PtrTy(ptr->getType()->getPointerAddressSpace()));
+    intrinsic(Intrinsic::prefetch, {ptr->getType()}, {ptr, i32(0), i32(3), i32(1)});
+  }
+}
+
 /**
  * \brief Code Generation for `reshape`
  */
@@ -502,11 +580,33 @@ void generator::visit_splat_inst(ir::splat_inst* x) {
 void generator::visit_broadcast_inst(ir::broadcast_inst* x) {
   ir::value* op = x->get_operand(0);
   const auto& shape = op->get_type()->get_tile_shapes();
+  std::map<indices_t, Value*> *in_vals = &vals_[op];
+  // operand distributed differently: converted through shared memory
+  std::map<indices_t, Value*> converted;
+  if(layouts_->has_tmp(x)){
+    analysis::data_layout* layout = layouts_->get(layouts_->tmp(x));
+    Type *ty = cvt(op->get_type()->get_scalar_ty());
+    Value *ptr = bit_cast(shared_ptr_.at(layout), ptr_ty(ty, 3));
+    auto order = layout->get_order();
+    add_barrier();
+    for(indices_t idx: idxs_.at(op))
+      store(vals_[op][idx], gep(ptr, shared_off(shape, order, idx)));
+    add_barrier();
+    for(indices_t out_idx: idxs_.at(x)){
+      indices_t in_idx = out_idx;
+      for(size_t k = 0; k < in_idx.size(); k++)
+        in_idx[k] = shape[k] == 1 ? i32(0) : in_idx[k];
+      if(converted.find(in_idx) == converted.end())
+        converted[in_idx] = load(gep(ptr, shared_off(shape, order, in_idx)));
+    }
+    add_barrier();
+    in_vals = &converted;
+  }
   for(auto out_idx: idxs_.at(x)){
     indices_t in_idx = out_idx;
     for(size_t k = 0; k < in_idx.size(); k++)
       in_idx[k] = shape[k] == 1 ? i32(0) : in_idx[k];
-    vals_[x][out_idx] = vals_[op][in_idx];
+    vals_[x][out_idx] = (*in_vals)[in_idx];
   }
 }
 
@@ -567,6 +667,13 @@ void generator::visit_log_inst(ir::log_inst* x){
  * \brief Code Generation for `atomic_cas`
  */
 void generator::visit_atomic_cas_inst(ir::atomic_cas_inst* cas) {
+  // the host runs one thread per program
+  if(!tgt_->is_gpu()){
+    Value *old = atomic_cmp_xchg(vals_[cas->get_operand(0)][{}], vals_[cas->get_operand(1)][{}], vals_[cas->get_operand(2)][{}],
+                                 AtomicOrdering::Monotonic, AtomicOrdering::Monotonic);
+    vals_[cas][{}] = extract_val(old, std::vector<unsigned>{0});
+    return;
+  }
   BasicBlock *current = builder_->GetInsertBlock();
   Module *module = current->getModule();
   Value *tid = tgt_->get_local_id(module, *builder_, 0);
@@ -616,87 +723,226 @@ void generator::visit_atomic_exch_inst(ir::atomic_exch_inst* xchg) {
 }
 
 /**
- * \brief Code Generation for `atomic_add`
+ * \brief Code Generation for one element of `atomic_rmw`
+ * Returns the old value when `has_ret` is set
  */
-//TODO: clean-up
-void generator::visit_atomic_add_inst(ir::atomic_add_inst* add) {
-
-  if(add->get_type()->is_tile_ty()){
-    ir::value* ptr = add->get_operand(0);
-    ir::value* val = add->get_operand(1);
-    ir::value* msk = add->get_operand(2);
+Value* generator::emit_atomic_rmw(ir::atomic_rmw_inst::op_t op, Value *ptr, Value *val, Value *msk, bool has_ret) {
+  typedef ir::atomic_rmw_inst rmw_t;
+  Type *ty = val->getType();
+  size_t nbits = ty->getScalarSizeInBits();
+  unsigned addr_space = ptr->getType()->getPointerAddressSpace();
+  // floating-point max/min on the integer representation:
+  // signed max/min for non-negative values, unsigned min/max for negative values
+  if(op == rmw_t::FMAX || op == rmw_t::FMIN){
+    if(nbits != 32 && nbits != 64)
+      throw std::runtime_error("atomic max/min requires 32-bit or 64-bit floating-point values");
+    Type *int_ty = builder_->getIntNTy(nbits);
+    Value *int_val = bit_cast(val, int_ty);
+    Value *int_ptr = bit_cast(ptr, int_ty->getPointerTo(addr_space));
+    Value *pos = icmp_sge(int_val, ConstantInt::get(int_ty, 0));
+    Value *old_pos = emit_atomic_rmw(op == rmw_t::FMAX ? rmw_t::MAX : rmw_t::MIN,
+                                     int_ptr, int_val, and_(msk, pos), has_ret);
+    Value *old_neg = emit_atomic_rmw(op == rmw_t::FMAX ? rmw_t::UMIN : rmw_t::UMAX,
+                                     int_ptr, int_val, and_(msk, builder_->CreateNot(pos)), has_ret);
+    return has_ret ? bit_cast(select(pos, old_pos, old_neg), ty) : nullptr;
+  }
+  // exchange floating-point values as integers
+  if(op == rmw_t::XCHG && ty->isFPOrFPVectorTy()){
+    Type *int_ty = builder_->getIntNTy(nbits);
+    Value *old = emit_atomic_rmw(op, bit_cast(ptr, int_ty->getPointerTo(addr_space)),
+                                 bit_cast(val, int_ty), msk, has_ret);
+    return has_ret ? bit_cast(old, ty) : nullptr;
+  }
+  // host: predicated atomicrmw
+  if(!tgt_->is_gpu()){
+    AtomicRMWInst::BinOp bin_op;
+    switch(op){
+      case rmw_t::ADD: bin_op = AtomicRMWInst::Add; break;
+      case rmw_t::FADD: bin_op = AtomicRMWInst::FAdd; break;
+      case rmw_t::MAX: bin_op = AtomicRMWInst::Max; break;
+      case rmw_t::MIN: bin_op = AtomicRMWInst::Min; break;
+      case rmw_t::UMAX: bin_op = AtomicRMWInst::UMax; break;
+      case rmw_t::UMIN: bin_op = AtomicRMWInst::UMin; break;
+      case rmw_t::XCHG: bin_op = AtomicRMWInst::Xchg; break;
+      case rmw_t::AND: bin_op = AtomicRMWInst::And; break;
+      case rmw_t::OR: bin_op = AtomicRMWInst::Or; break;
+      default: throw std::runtime_error("unsupported atomic operation");
+    }
+    BasicBlock *current = builder_->GetInsertBlock();
+    BasicBlock *atom_bb = BasicBlock::Create(*ctx_, "atom", current->getParent());
+    BasicBlock *atom_done_bb = BasicBlock::Create(*ctx_, "atom_done", current->getParent());
+    cond_br(msk, atom_bb, atom_done_bb);
+    builder_->SetInsertPoint(atom_bb);
+    Value *old = atomic_rmw(bin_op, ptr, val, AtomicOrdering::Monotonic, SyncScope::System);
+    br(atom_done_bb);
+    builder_->SetInsertPoint(atom_done_bb);
+    if(!has_ret)
+      return nullptr;
+    PHINode *ret = phi(ty, 2);
+    ret->addIncoming(UndefValue::get(ty), current);
+    ret->addIncoming(old, atom_bb);
+    return ret;
+  }
+  // gpu: predicated atom (or red when the old value is unused)
+  std::string mnemonic;
+  switch(op){
+    case rmw_t::ADD: mnemonic = ".add.u"; break;
+    case rmw_t::FADD: mnemonic = nbits == 16 ? ".add.noftz.f" : ".add.f"; break;
+    case rmw_t::MAX: mnemonic = ".max.s"; break;
+    case rmw_t::MIN: mnemonic = ".min.s"; break;
+    case rmw_t::UMAX: mnemonic = ".max.u"; break;
+    case rmw_t::UMIN: mnemonic = ".min.u"; break;
+    case rmw_t::XCHG: mnemonic = ".exch.b"; break;
+    case rmw_t::AND: mnemonic = ".and.b"; break;
+    case rmw_t::OR: mnemonic = ".or.b"; break;
+    default: throw std::runtime_error("unsupported atomic operation");
+  }
+  if(op != rmw_t::FADD && nbits != 32 && nbits != 64)
+    throw std::runtime_error("atomic operations require 32-bit or 64-bit integers on GPUs");
+  mnemonic += std::to_string(nbits);
+  if(ty->isVectorTy())
+    mnemonic += "x2";
+  std::string ty_id;
+  if(ty->isVectorTy() || ty->isIntegerTy(32)) ty_id = "r";
+  else if(ty->isIntegerTy(64)) ty_id = "l";
+  else if(ty->isHalfTy()) ty_id = "h";
+  else if(ty->isFloatTy()) ty_id = "f";
+  else ty_id = "d";
+  // extract pointer offset
+  std::string offset = "";
+  if(GetElementPtrInst *gep = dyn_cast<GetElementPtrInst>(ptr))
+  if(gep->getNumIndices() == 1)
+  if(ConstantInt *cst = dyn_cast<ConstantInt>(gep->idx_begin())){
+    offset = " + " + std::to_string(cst->getValue().getSExtValue()*nbits/8);
+    ptr = gep->getPointerOperand();
+  }
+  ptr = bit_cast(ptr, ty->getPointerTo(1));
+  std::vector<Type*> arg_ty = {msk->getType(), ptr->getType(), ty};
+  if(!has_ret){
+    FunctionType *fn_ty = FunctionType::get(void_ty, arg_ty, false);
+    std::string asm_str = "@$0 red.global.gpu" + mnemonic + " [$1" + offset + "], $2;";
+    InlineAsm *iasm = InlineAsm::get(fn_ty, asm_str, "b,l," + ty_id, true);
+    call(iasm, (ArrayRef<Value*>{msk, ptr, val}));
+    return nullptr;
+  }
+  FunctionType *fn_ty = FunctionType::get(ty, arg_ty, false);
+  std::string asm_str = "@$1 atom.global.gpu" + mnemonic + " $0, [$2" + offset + "], $3;";
+  InlineAsm *iasm = InlineAsm::get(fn_ty, asm_str, "=" + ty_id + ",b,l," + ty_id, true);
+  return call(iasm, (ArrayRef<Value*>{msk, ptr, val}));
+}
 
-    // vector size
+/**
+ * \brief Code Generation for `atomic_rmw`
+ */
+void generator::visit_atomic_rmw_inst(ir::atomic_rmw_inst* rmw) {
+  ir::value* ptr = rmw->get_operand(0);
+  ir::value* val = rmw->get_operand(1);
+  ir::value* msk = rmw->get_operand(2);
+  bool has_ret = !rmw->get_users().empty();
+
+  if(rmw->get_type()->is_tile_ty()){
+    // packed half-precision additions
     int vec = 1;
-    int ld = ords_.at(ptr)[0];
-    unsigned alignment = alignment_->get(ptr, ld);
-    vec = std::min<int>(layouts_->get(ptr)->to_scanline()->nts(ld), alignment);
-    vec = std::min(vec, val->get_type()->get_tile_element_ty()->is_half_ty() ? 2 : 1);
-
-    for(int i = 0; i < idxs_.at(val).size(); i += vec){
+    if(tgt_->is_gpu() && rmw->get_op() == ir::atomic_rmw_inst::FADD
+       && val->get_type()->get_tile_element_ty()->is_half_ty()){
+      int ld = ords_.at(ptr)[0];
+      unsigned alignment = alignment_->get(ptr, ld);
+      vec = std::min<int>(layouts_->get(ptr)->to_scanline()->nts(ld), alignment);
+      vec = std::min(vec, 2);
+    }
+    // threads left over once the tile is covered hold replicas
+    // of its elements: only their first owner applies them
+    Value *owner = nullptr;
+    analysis::scanline_layout *layout = layouts_->get(ptr)->to_scanline();
+    if(tgt_->is_gpu() && layout){
+      size_t num_owners = 1;
+      for(size_t k = 0; k < layout->get_rank(); k++)
+        num_owners *= layout->mts(k);
+      if(num_owners < num_warps_*32)
+        for(size_t k = 0; k < layout->get_rank(); k++){
+          Value *is_owner = icmp_ult(axis_of(ptr, k).thread_id, i32(layout->mts(k)));
+          owner = owner ? and_(owner, is_owner) : is_owner;
+        }
+    }
+    for(size_t i = 0; i < idxs_.at(val).size(); i += vec){
       auto idx = idxs_[val][i];
-      Value *rmw_val = UndefValue::get(vec_ty(vals_[val][idx]->getType(), vec));
-      for(int ii = 0; ii < vec; ii++)
-        rmw_val = insert_elt(rmw_val, vals_[val][idxs_[val][i+ii]], ii);
-      Value *rmw_ptr = vals_[ptr][idx];
-      Value *rmw_msk = vals_[msk][idx];
-      if(vec == 1)
-        rmw_val = extract_elt(rmw_val, i32(0));
-      Type* ty = rmw_val->getType();
-      size_t nbits = ty->getScalarSizeInBits();
-      // extract pointer offset
-      std::string offset = "";
-      if(GetElementPtrInst *gep = dyn_cast<GetElementPtrInst>(rmw_ptr))
-      if(gep->getNumIndices() == 1)
-      if(ConstantInt *cst = dyn_cast<ConstantInt>(gep->idx_begin())){
-        offset = " + " + std::to_string(cst->getValue().getSExtValue()*nbits/8);
-        rmw_ptr = gep->getPointerOperand();
+      Value *rmw_val = vals_[val][idx];
+      if(vec > 1){
+        rmw_val = UndefValue::get(vec_ty(rmw_val->getType(), vec));
+        for(int ii = 0; ii < vec; ii++)
+          rmw_val = insert_elt(rmw_val, vals_[val][idxs_[val][i+ii]], ii);
       }
-      rmw_ptr = bit_cast(rmw_ptr, ty->getPointerTo(1));
-      // asm argument type
-      std::vector<Type*> arg_ty = {rmw_msk->getType(), rmw_ptr->getType(), rmw_val->getType()};
-      // asm function type
-      FunctionType *fn_ty = FunctionType::get(ty, arg_ty, false);
-      // asm string
-      std::string suffix = vec == 2 ? "x2" : "";
-      std::string mod = nbits == 32 ? "" : ".noftz";
-      std::string asm_str = "@$0 atom.global.gpu.add" + mod + ".f" + std::to_string(nbits) + suffix + " $1, [$2" + offset + "], $3;";
-      std::string ty_id = nbits == 32 ? "f" : (vec == 1 ? "h" : "r");
-      std::string constraint = "b,=" + ty_id + ",l," + ty_id;
-      // create inline asm
-      InlineAsm *iasm = InlineAsm::get(fn_ty, asm_str, constraint, true);
-      // call asm
-      call(iasm, (ArrayRef<Value*>{rmw_msk, rmw_ptr, rmw_val}));
+      Value *rmw_msk = owner ? and_(vals_[msk][idx], owner) : vals_[msk][idx];
+      Value *old = emit_atomic_rmw(rmw->get_op(), vals_[ptr][idx], rmw_val, rmw_msk, has_ret);
+      if(!has_ret)
+        continue;
+      for(int ii = 0; ii < vec; ii++)
+        vals_[rmw][idxs_[rmw][i+ii]] = vec > 1 ? extract_elt(old, ii) : old;
+    }
+    if(!has_ret || !owner || !layouts_->has_tmp(rmw))
+      return;
+    // owners store the old values, which every thread reads back
+    // at the position of its element modulo the tile shape
+    const auto& shape = rmw->get_type()->get_tile_shapes();
+    analysis::data_layout* tmp = layouts_->get(layouts_->tmp(rmw));
+    Value *tmp_ptr = gep(shmem_, i32(alloc_->offset(tmp)));
+    tmp_ptr = bit_cast(tmp_ptr, ptr_ty(cvt(rmw->get_type()->get_scalar_ty()), 3));
+    std::map<indices_t, Value*> offs;
+    for(indices_t idx: idxs_.at(rmw)){
+      indices_t in_idx = idx;
+      for(size_t k = 0; k < in_idx.size(); k++)
+        in_idx[k] = urem(in_idx[k], i32(shape[k]));
+      offs[idx] = shared_off(shape, tmp->get_order(), in_idx);
     }
-  }
-  else{
-    Value *rmw_ptr = vals_[add->get_operand(0)][{}];
-    Value *rmw_val = vals_[add->get_operand(1)][{}];
-    Value *rmw_msk = vals_[add->get_operand(2)][{}];
-    Type* ty = rmw_val->getType();
-    size_t nbits = ty->getScalarSizeInBits();
-    std::vector<Type*> arg_ty = {rmw_msk->getType(), rmw_ptr->getType(), rmw_val->getType()};
-    FunctionType *fn_ty = FunctionType::get(ty, arg_ty, false);
-    std::string mod = nbits == 32 ? "" : ".noftz";
-    std::string asm_str = "@$0 atom.global.gpu.add" + mod + ".f" + std::to_string(nbits) + " $1, [$2], $3;";
-    std::string ty_id = nbits == 32 ? "f" : "h";
-    InlineAsm *iasm = InlineAsm::get(fn_ty, asm_str, "b,="+ty_id+",l,"+ty_id, true);
-
     BasicBlock *current = builder_->GetInsertBlock();
-    Module *module = current->getModule();
+    BasicBlock *owner_bb = BasicBlock::Create(*ctx_, "rmw_owner", current->getParent());
+    BasicBlock *owner_done_bb = BasicBlock::Create(*ctx_, "rmw_owner_done", current->getParent());
+    add_barrier();
+    cond_br(owner, owner_bb, owner_done_bb);
+    builder_->SetInsertPoint(owner_bb);
+    for(indices_t idx: idxs_.at(rmw))
+      store(vals_[rmw][idx], gep(tmp_ptr, offs[idx]));
+    br(owner_done_bb);
+    builder_->SetInsertPoint(owner_done_bb);
+    add_barrier();
+    for(indices_t idx: idxs_.at(rmw))
+      vals_[rmw][idx] = load(gep(tmp_ptr, offs[idx]));
+    add_barrier();
+    return;
+  }
 
-    Value *tid = tgt_->get_local_id(module, *builder_, 0);
-    Value *pred = icmp_eq(tid, i32(0));
-    BasicBlock *tid_0_bb = BasicBlock::Create(*ctx_, "tid_0", current->getParent());
-    BasicBlock *tid_0_done_bb = BasicBlock::Create(*ctx_, "tid_0_done", current->getParent());
-    tgt_->add_memfence(module, *builder_);
+  // the host runs one thread per program
+  if(!tgt_->is_gpu()){
+    Value *old = emit_atomic_rmw(rmw->get_op(), vals_[ptr][{}], vals_[val][{}], vals_[msk][{}], has_ret);
+    if(has_ret)
+      vals_[rmw][{}] = old;
+    return;
+  }
+  // scalars are updated by one thread and the old value
+  // is broadcast through shared memory
+  BasicBlock *current = builder_->GetInsertBlock();
+  Module *module = current->getModule();
+  Value *tid = tgt_->get_local_id(module, *builder_, 0);
+  Value *pred = icmp_eq(tid, i32(0));
+  BasicBlock *tid_0_bb = BasicBlock::Create(*ctx_, "tid_0", current->getParent());
+  BasicBlock *tid_0_done_bb = BasicBlock::Create(*ctx_, "tid_0_done", current->getParent());
+  tgt_->add_memfence(module, *builder_);
+  add_barrier();
+  cond_br(pred, tid_0_bb, tid_0_done_bb);
+  builder_->SetInsertPoint(tid_0_bb);
+  Value *old = emit_atomic_rmw(rmw->get_op(), vals_[ptr][{}], vals_[val][{}], vals_[msk][{}], has_ret);
+  Value *atom_ptr = nullptr;
+  if(has_ret){
+    atom_ptr = gep(shmem_, i32(alloc_->offset(layouts_->get(layouts_->tmp(rmw)))), "");
+    atom_ptr = bit_cast(atom_ptr, ptr_ty(old->getType(), 3));
+    store(old, atom_ptr);
+  }
+  br(tid_0_done_bb);
+  builder_->SetInsertPoint(tid_0_done_bb);
+  tgt_->add_memfence(module, *builder_);
+  if(has_ret){
     add_barrier();
-    cond_br(pred, tid_0_bb, tid_0_done_bb);
-    builder_->SetInsertPoint(tid_0_bb);
-    call(iasm, (ArrayRef<Value*>{rmw_msk, rmw_ptr, rmw_val}));
-    br(tid_0_done_bb);
-    builder_->SetInsertPoint(tid_0_done_bb);
-    tgt_->add_memfence(module, *builder_);
+    vals_[rmw][{}] = load(atom_ptr);
   }
 }
 
@@ -919,11 +1165,15 @@ void generator::visit_mma16816(ir::dot_inst* dot, ir::value *A, ir::value *B, ir
 
 
 
+  // operands are either fp16 or bf16 (stored as i16)
+  bool is_bf16 = A->get_type()->get_scalar_ty()->is_bf16_ty();
+  std::string ab_id = is_bf16 ? "bf16" : "f16";
+  Type *ab_ty = cvt(A->get_type()->get_scalar_ty());
   Type *fp32_ty = f32_ty;
-  Type *fp16x2_ty = vec_ty(f16_ty, 2);
+  Type *fp16x2_ty = vec_ty(ab_ty, 2);
   Type *fp16x2_pack4_ty = StructType::get(*ctx_, std::vector<llvm::Type*>{fp16x2_ty, fp16x2_ty, fp16x2_ty, fp16x2_ty});
   Type *fp32_pack4_ty = StructType::get(*ctx_, std::vector<llvm::Type*>{fp32_ty, fp32_ty, fp32_ty, fp32_ty});
-  FunctionType *ld_x4_ty = FunctionType::get(fp16x2_pack4_ty, std::vector<llvm::Type*>{ptr_ty(f16_ty, 3)}, false);
+  FunctionType *ld_x4_ty = FunctionType::get(fp16x2_pack4_ty, std::vector<llvm::Type*>{ptr_ty(ab_ty, 3)}, false);
 
   // left-hand-side values
   std::map<std::pair<unsigned, unsigned>, std::pair<Value*, Value*>> ha;
@@ -988,7 +1238,7 @@ void generator::visit_mma16816(ir::dot_inst* dot, ir::value *A, ir::value *B, ir
     ptrs_b[i] = gep(shmems_[B], {off_b[i]});
 
   FunctionType *mma_ty = FunctionType::get(fp32_pack4_ty, std::vector<llvm::Type*>{fp16x2_ty, fp16x2_ty, fp16x2_ty, fp16x2_ty, fp16x2_ty, fp16x2_ty, fp32_ty, fp32_ty, fp32_ty, fp32_ty}, false);
-  InlineAsm *mma_fn = InlineAsm::get(mma_ty, "mma.sync.aligned.m16n8k16.row.col.f32.f16.f16.f32 "
+  InlineAsm *mma_fn = InlineAsm::get(mma_ty, "mma.sync.aligned.m16n8k16.row.col.f32." + ab_id + "." + ab_id + ".f32 "
                                              "{$0, $1, $2, $3}, "
                                              "{$4, $5, $6, $7}, "
                                              "{$8, $9}, "
@@ -1056,7 +1306,9 @@ void generator::visit_mma16816(ir::dot_inst* dot, ir::value *A, ir::value *B, ir
 }
 
 /**
- * \brief Code Generation for FMA-based `dot` (FP32, FP64, Default)
+ * \brief Code Generation for FMA-based `dot` (FP32, FP64, INT8, Default)
+ * 8-bit integer operands are sign-extended and accumulated in 32-bit.
+ * NVIDIA GPUs (sm_61+) instead pack four consecutive k into one dp4a.
  */
 void generator::visit_fmadot(ir::dot_inst* C, ir::value* A, ir::value* B, ir::value* D, unsigned NK, Type *c_ty, Function *f_mul_add) {
   auto shape_c = C->get_type()->get_tile_shapes();
@@ -1089,8 +1341,8 @@ void generator::visit_fmadot(ir::dot_inst* C, ir::value* A, ir::value* B, ir::va
   int num_ptr_b   = 8;
   int vec_a = 2;
   int vec_b = 4;
-  distributed_axis ax_m = axes_.at(a_axes_->get(C, 0));
-  distributed_axis ax_n = axes_.at(a_axes_->get(C, 1));
+  distributed_axis ax_m = axis_of(C, 0);
+  distributed_axis ax_n = axis_of(C, 1);
 //  Value* thread = tgt_->get_local_id(mod_, *builder_, 0);
 
   Value* off_a0 = is_a_row ? i32(0) : mul(ax_m.thread_id, i32(ax_m.contiguous));
@@ -1120,9 +1372,42 @@ void generator::visit_fmadot(ir::dot_inst* C, ir::value* A, ir::value* B, ir::va
   for(int i = 0; i < num_ptr_b; i++)
     ptrs_b[i] = gep(shmems_[B], off_b[i]);
 
+  bool is_int = c_ty->isIntegerTy();
+  bool use_dp4a = is_int && tgt_->as_nvidia() && tgt_->as_nvidia()->sm() >= 61 && NK % 4 == 0 &&
+                  A->get_type()->get_scalar_ty()->is_integer_ty(8) &&
+                  B->get_type()->get_scalar_ty()->is_integer_ty(8);
+  unsigned k_step = use_dp4a ? 4 : 1;
+  InlineAsm *dp4a = nullptr;
+  if(use_dp4a)
+    dp4a = InlineAsm::get(FunctionType::get(i32_ty, {i32_ty, i32_ty, i32_ty}, false),
+                          "dp4a.s32.s32 $0, $1, $2, $3;", "=r,r,r,r", false);
+  // operand value(s) for k, k + 1, ..., k + k_step - 1
+  auto load_op = [&](ir::value *X, Value *ptr, int stride_k, unsigned k) -> Value* {
+    ir::type *x_ty = X->get_type()->get_scalar_ty();
+    if(use_dp4a){
+      Value *packed = UndefValue::get(vec_ty(builder_->getInt8Ty(), 4));
+      for(unsigned kk = 0; kk < 4; kk++)
+        packed = insert_elt(packed, load(gep(ptr, i32((k + kk)*stride_k))), kk);
+      return bit_cast(packed, i32_ty);
+    }
+    Value *ret = load(gep(ptr, i32(k*stride_k)));
+    if(is_int)
+      return builder_->CreateSExtOrTrunc(ret, c_ty);
+    if(x_ty->is_bf16_ty())
+      ret = emit_bf16_to_f32(ret);
+    return fpcast(ret, c_ty);
+  };
+  auto mul_add = [&](Value *a, Value *b, Value *c) -> Value* {
+    if(use_dp4a)
+      return call(dp4a, {a, b, c});
+    if(is_int)
+      return add(mul(a, b), c);
+    return call(f_mul_add, {a, b, c});
+  };
+
   std::map<indices_t, Value*> ret = vals_[D];
   std::map<std::pair<int, int>, Value*> has, hbs;
-  for(unsigned k = 0; k < NK; k++){
+  for(unsigned k = 0; k < NK; k += k_step){
     int z = 0;
     for(unsigned m = 0; m < shape_c[0]; m+=layout_c->mts(0)*layout_c->nts(0))
     for(unsigned n = 0; n < shape_c[1]; n+=layout_c->mts(1)*layout_c->nts(1))
@@ -1130,16 +1415,14 @@ void generator::visit_fmadot(ir::dot_inst* C, ir::value* A, ir::value* B, ir::va
     for(unsigned nn = 0; nn < layout_c->nts(1); nn++)
     {
       if(has.find({m + mm, k}) == has.end()){
-        Value* pa = gep(ptrs_a[0], i32((m + mm)*stride_a_m + k*stride_a_k));
-        Value* va = load(pa);
-        has[{m + mm, k}] = va;
+        Value* pa = gep(ptrs_a[0], i32((m + mm)*stride_a_m));
+        has[{m + mm, k}] = load_op(A, pa, stride_a_k, k);
       }
       if(hbs.find({n + nn, k}) == hbs.end()){
-        Value* pb = gep(ptrs_b[0], i32((n + nn)*stride_b_n + k*stride_b_k));
-        Value* vb = load(pb);
-        hbs[{n + nn, k}] = vb;
+        Value* pb = gep(ptrs_b[0], i32((n + nn)*stride_b_n));
+        hbs[{n + nn, k}] = load_op(B, pb, stride_b_k, k);
       }
-      ret[idxs_[C].at(z)] = call(f_mul_add, {has[{m+mm,k}], hbs[{n+nn, k}], ret[idxs_[C].at(z)]});
+      ret[idxs_[C].at(z)] = mul_add(has[{m+mm,k}], hbs[{n+nn, k}], ret[idxs_[C].at(z)]);
       z++;
     }
   }
@@ -1160,7 +1443,9 @@ void generator::visit_dot_inst(ir::dot_inst* dot) {
   ir::value *B = dot->get_operand(1);
   ir::value *D = dot->get_operand(2);
   Type *c_ty = cvt(D->get_type()->get_scalar_ty());
-  Function *f_mul_add = Intrinsic::getDeclaration(module, Intrinsic::fmuladd, std::vector<llvm::Type*>{c_ty});
+  Function *f_mul_add = nullptr;
+  if(c_ty->isFloatingPointTy())
+    f_mul_add = Intrinsic::getDeclaration(module, Intrinsic::fmuladd, std::vector<llvm::Type*>{c_ty});
   auto A_shapes = A->get_type()->get_tile_shapes();
   size_t red_axis = 1;
   unsigned NK = A_shapes[red_axis];
@@ -1188,6 +1473,138 @@ void generator::visit_sqrt_inst(ir::sqrt_inst* x) {
   }
 }
 
+/**
+ * \brief Code Generation for one element of `math`
+ * Single-precision approximations are built from LLVM IR so that
+ * they vectorize on CPUs. In fast-math mode, NVIDIA GPUs use the
+ * approximate instructions of their special function units instead.
+ */
+Value* generator::emit_math(ir::math_inst::op_t op, Value *x) {
+  typedef ir::math_inst math_t;
+  bool ptx_approx = fast_math_ && tgt_->is_gpu();
+  auto cst = [&](double c) -> Value* { return ConstantFP::get(f32_ty, c); };
+  auto fma = [&](Value *a, Value *b, Value *c) -> Value* {
+    return intrinsic(Intrinsic::fmuladd, {f32_ty}, {a, b, c});
+  };
+  // Horner scheme, highest degree first
+  auto poly = [&](Value *z, const std::vector<double> &coeffs) -> Value* {
+    Value *ret = cst(coeffs[0]);
+    for(size_t i = 1; i < coeffs.size(); i++)
+      ret = fma(ret, z, cst(coeffs[i]));
+    return ret;
+  };
+  auto ptx = [&](const std::string &ins, Value *arg) -> Value* {
+    FunctionType *fn_ty = FunctionType::get(f32_ty, {f32_ty}, false);
+    InlineAsm *iasm = InlineAsm::get(fn_ty, ins + ".approx.f32 $0, $1;", "=f,f", false);
+    return call(iasm, {arg});
+  };
+  auto exp = [&](Value *arg) -> Value* {
+    if(ptx_approx)
+      return ptx("ex2", fmul(arg, cst(1.4426950408889634)));
+    // exp(x) = 2^n * exp(r) with |r| <= ln(2)/2
+    arg = max_num(min_num(arg, cst(88.3762626647949)), cst(-87.3365478515625));
+    Value *n = intrinsic(Intrinsic::floor, {f32_ty}, {fma(arg, cst(1.4426950408889634), cst(0.5))});
+    Value *r = fma(n, cst(-0.693359375), arg);
+    r = fma(n, cst(2.12194440e-4), r);
+    Value *p = poly(r, {1.9875691500e-4, 1.3981999507e-3, 8.3334519073e-3,
+                        4.1665795894e-2, 1.6666665459e-1, 5.0000001201e-1});
+    p = fadd(fma(p, fmul(r, r), r), cst(1));
+    // scale by 2^(n-1) * 2 so that the biased exponent stays in range
+    Value *e = builder_->CreateShl(add(builder_->CreateFPToSI(n, i32_ty), i32(126)), i32(23));
+    return fmul(fmul(p, bit_cast(e, f32_ty)), cst(2));
+  };
+  auto rcp = [&](Value *arg) -> Value* {
+    if(ptx_approx)
+      return ptx("rcp", arg);
+    return builder_->CreateFDiv(cst(1), arg);
+  };
+  Value *abs = intrinsic(Intrinsic::fabs, {f32_ty}, {x});
+  switch(op){
+  case math_t::TANH: {
+    // tanh.approx needs sm_75 and PTX ISA 7.0
+    if(ptx_approx && tgt_->as_nvidia()->sm() >= 75 && tgt_->as_nvidia()->ptx() >= 70)
+      return ptx("tanh", x);
+    // tanh(|x|) = 1 - 2 / (exp(2|x|) + 1)
+    Value *ret = fsub(cst(1), fmul(cst(2), rcp(fadd(exp(fmul(cst(2), abs)), cst(1)))));
+    ret = intrinsic(Intrinsic::copysign, {f32_ty}, {ret, x});
+    if(fast_math_)
+      return ret;
+    // odd polynomial near zero to avoid cancellation
+    Value *z = fmul(x, x);
+    Value *small = fma(fmul(x, z), poly(z, {-5.70498872745e-3, 2.06390887954e-2, -5.37397155531e-2,
+                                            1.33314422036e-1, -3.33332819422e-1}), x);
+    return select(fcmp(CmpInst::FCMP_OLT, abs, cst(0.625)), small, ret);
+  }
+  case math_t::SIGMOID:
+    return rcp(fadd(cst(1), exp(builder_->CreateFNeg(x))));
+  case math_t::ERF: {
+    // |x| < 1: odd polynomial
+    Value *z = fmul(x, x);
+    Value *small = fmul(x, poly(z, {7.853861353153693e-5, -8.010193625184903e-4, 5.188327685732524e-3,
+                                    -2.685381193529856e-2, 1.128358514861418e-1, -3.761262582423300e-1,
+                                    1.128379165726710e+0}));
+    // |x| >= 1: Abramowitz & Stegun 7.1.26
+    Value *t = rcp(fma(cst(0.3275911), abs, cst(1)));
+    Value *p = fmul(t, poly(t, {1.061405429, -1.453152027, 1.421413741, -0.284496736, 0.254829592}));
+    Value *big = fsub(cst(1), fmul(p, exp(builder_->CreateFNeg(z))));
+    big = intrinsic(Intrinsic::copysign, {f32_ty}, {big, x});
+    return select(fcmp(CmpInst::FCMP_OLT, abs, cst(1)), small, big);
+  }
+  case math_t::SIN:
+  case math_t::COS: {
+    if(ptx_approx)
+      return ptx(op == math_t::SIN ? "sin" : "cos", x);
+    // reduce to |z| <= pi/4 with octant j in {0, 2, 4, 6}
+    Value *j = builder_->CreateFPToSI(fmul(abs, cst(1.27323954473516)), i32_ty);
+    j = and_(add(j, i32(1)), i32(~1));
+    Value *y = builder_->CreateSIToFP(j, f32_ty);
+    Value *z = fma(y, cst(-0.78515625), abs);
+    z = fma(y, cst(-2.4187564849853515625e-4), z);
+    z = fma(y, cst(-3.77489497744594108e-8), z);
+    Value *zz = fmul(z, z);
+    Value *sin_z = fma(fmul(zz, z), poly(zz, {-1.9515295891e-4, 8.3321608736e-3, -1.6666654611e-1}), z);
+    Value *cos_z = fma(fmul(zz, zz), poly(zz, {2.443315711809948e-5, -1.388731625493765e-3, 4.166664568298827e-2}),
+                       fma(zz, cst(-0.5), cst(1)));
+    j = and_(j, i32(7));
+    Value *flip = icmp(CmpInst::ICMP_UGT, j, i32(3));
+    Value *swap = icmp_eq(and_(j, i32(2)), i32(2));
+    Value *ret, *neg;
+    if(op == math_t::SIN){
+      ret = select(swap, cos_z, sin_z);
+      neg = xor_(flip, fcmp(CmpInst::FCMP_OLT, x, cst(0)));
+    }
+    else{
+      ret = select(swap, sin_z, cos_z);
+      neg = xor_(flip, swap);
+    }
+    return select(neg, builder_->CreateFNeg(ret), ret);
+  }
+  case math_t::RSQRT: {
+    if(ptx_approx)
+      return ptx("rsqrt", x);
+    Builder::FastMathFlagGuard guard(*builder_);
+    if(fast_math_){
+      FastMathFlags fmf;
+      fmf.setApproxFunc();
+      fmf.setAllowReciprocal();
+      builder_->setFastMathFlags(fmf);
+    }
+    return builder_->CreateFDiv(cst(1), intrinsic(Intrinsic::sqrt, {f32_ty}, {x}));
+  }
+  default:
+    throw std::runtime_error("unsupported math function");
+  }
+}
+
+/**
+ * \brief Code Generation for `math`
+ */
+void generator::visit_math_inst(ir::math_inst* x) {
+  ir::value *arg = x->get_operand(0);
+  for(indices_t idx: idxs_.at(x))
+    vals_[x][idx] = emit_math(x->get_op(), vals_[arg][idx]);
+}
+
 Value* generator::shared_off(const std::vector<unsigned>& shapes, const std::vector<int>& order, indices_t idx){
   // strides
   std::vector<Value*> strides(shapes.size(), builder_->getInt32(0));
@@ -1257,6 +1674,8 @@ void generator::visit_reduce1d_inst(ir::reduce_inst* x, std::function<Value*(Val
  */
 void generator::visit_reducend_inst(ir::reduce_inst* x, std::function<Value*(Value*,Value*)> do_acc, Value *neutral) {
   ir::value *arg = x->get_operand(0);
+  if(!layouts_->get(arg)->to_scanline())
+    return visit_reducend_copy_inst(x, do_acc);
   Type *ty = cvt(x->get_type()->get_scalar_ty());
   unsigned axis = x->get_axis();
 
@@ -1277,7 +1696,7 @@ void generator::visit_reducend_inst(ir::reduce_inst* x, std::function<Value*(Val
   auto order  = layout->get_order();
   int  space = base->getType()->getPointerAddressSpace();
   Value *ptr = bit_cast(base, ptr_ty(ty, space));
-  Value *lane = axes_.at(a_axes_->get(arg, axis)).thread_id;
+  Value *lane = axis_of(arg, axis).thread_id;
   for(auto& x: accs) {
     // current element being computed
     Value *&acc = x.second;
@@ -1315,6 +1734,37 @@ void generator::visit_reducend_inst(ir::reduce_inst* x, std::function<Value*(Val
   };
 }
 
+/**
+ * \brief Code Generation for `reduce` (ND case, other layouts)
+ * The whole tile is copied to shared memory, and each thread
+ * reduces the rows it holds
+ */
+void generator::visit_reducend_copy_inst(ir::reduce_inst* x, std::function<Value*(Value*,Value*)> do_acc) {
+  ir::value *arg = x->get_operand(0);
+  Type *ty = cvt(x->get_type()->get_scalar_ty());
+  unsigned axis = x->get_axis();
+  analysis::data_layout* layout = layouts_->get(layouts_->tmp(x));
+  Value *ptr = bit_cast(shared_ptr_.at(layout), ptr_ty(ty, 3));
+  auto shape  = layout->get_shape();
+  auto order  = layout->get_order();
+  add_barrier();
+  for(indices_t idx: idxs_.at(arg))
+    store(vals_[arg][idx], gep(ptr, shared_off(shape, order, idx)));
+  add_barrier();
+  for(indices_t idx: idxs_.at(x)){
+    indices_t read_idx = idx;
+    read_idx.insert(read_idx.begin() + axis, i32(0));
+    Value *acc = nullptr;
+    for(unsigned k = 0; k < shape[axis]; k++){
+      read_idx[axis] = i32(k);
+      Value *current = load(gep(ptr, shared_off(shape, order, read_idx)));
+      acc = !acc ? current : do_acc(acc, current);
+    }
+    vals_[x][idx] = acc;
+  }
+  add_barrier();
+}
+
 /**
  * \brief Code Generation for `reduce` (generic case)
  */
@@ -1382,10 +1832,10 @@ void generator::visit_recoalesce_inst(ir::recoalesce_inst* rc) {
   base = gep(shmem_, i32(alloc_->offset(layouts_->get(layouts_->tmp(rc)))));
   base = bit_cast(base, ptr_ty(ty, 3));
   Value *ld = i32(shape[ord[0]]);
-  auto in_ord0 = axes_.at(a_axes_->get(op, ord[0])).values;
-  auto in_ord1 = axes_.at(a_axes_->get(op, ord[1])).values;
-  auto out_ord0 = axes_.at(a_axes_->get(rc, ord[0])).values;
-  auto out_ord1 = axes_.at(a_axes_->get(rc, ord[1])).values;
+  auto in_ord0 = axis_of(op, ord[0]).values;
+  auto in_ord1 = axis_of(op, ord[1]).values;
+  auto out_ord0 = axis_of(rc, ord[0]).values;
+  auto out_ord1 = axis_of(rc, ord[1]).values;
   int in_spt0  = in_layout->spt(ord[0]);
   int in_spt1  = in_layout->spt(ord[1]);
   int out_spt0 = out_layout->mts(ord[0])*out_layout->nts(ord[0]);
@@ -1503,6 +1953,22 @@ void generator::visit_copy_to_shared_inst(ir::copy_to_shared_inst* cts) {
   analysis::shared_layout* out_layout = layouts_->get(cts)->to_shared();
   analysis::scanline_layout* in_layout = layouts_->get(arg)->to_scanline();
   auto out_order = out_layout->get_order();
+  // other layouts (e.g., the result of a previous dot) are
+  // copied element by element
+  if(!in_layout){
+    int vec = swizzle_->get_vec(out_layout);
+    int per_phase = swizzle_->get_per_phase(out_layout);
+    int max_phase = swizzle_->get_max_phase(out_layout);
+    auto shapes = cts->get_type()->get_tile_shapes();
+    for(indices_t idx: idxs_.at(arg)){
+      Value* phase = urem(udiv(idx[out_order[1]], i32(per_phase)), i32(max_phase));
+      Value* off_0 = idx[out_order[0]];
+      off_0 = add(mul(xor_(udiv(off_0, i32(vec)), phase), i32(vec)), urem(off_0, i32(vec)));
+      Value* off_1 = mul(idx[out_order[1]], i32(shapes[out_order[0]]));
+      store(vals_[arg][idx], gep(shmems_.at(cts), {add(off_0, off_1)}));
+    }
+    return;
+  }
   auto in_order = in_layout->get_order();
   // tiles
   if(out_order == in_order)
@@ -1630,8 +2096,19 @@ void generator::visit_constant_int(ir::constant_int *x){
 
 void generator::visit_constant_fp(ir::constant_fp *x){
   Type *ty = cvt(x->get_type()->get_scalar_ty());
+  Constant *cst = nullptr;
+  if(x->get_type()->get_scalar_ty()->is_bf16_ty()){
+    // round-to-nearest-even, as in emit_f32_to_bf16
+    float f = x->get_value();
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    bits = std::isnan(f) ? 0x7FC00000 : bits + 0x7FFF + ((bits >> 16) & 1);
+    cst = ConstantInt::get(ty, bits >> 16);
+  }
+  else
+    cst = ConstantFP::get(ty, x->get_value());
   for(indices_t idx: idxs_.at(x))
-    vals_[x][idx] = ConstantFP::get(ty, x->get_value());
+    vals_[x][idx] = cst;
 }
 
 void generator::visit_alloc_const(ir::alloc_const *alloc) {
@@ -1785,8 +2262,8 @@ void generator::visit_layout_mma(analysis::mma_layout* layout) {
       offset_b_k_[layout] = i32(0);
     }
     /* axes */
-    axes_[layout->get_axis(0)] = distributed_axis{1, idx_m, warp_0};
-    axes_[layout->get_axis(1)] = distributed_axis{1, idx_n, warp_1};
+    axes_[layout][layout->get_axis(0)] = distributed_axis{1, idx_m, warp_0};
+    axes_[layout][layout->get_axis(1)] = distributed_axis{1, idx_n, warp_1};
   }
   else{
     /* warp offset */
@@ -1816,8 +2293,8 @@ void generator::visit_layout_mma(analysis::mma_layout* layout) {
       idx_n.push_back(add(off_c_n, i32(n + 1)));
     }
     /* axes */
-    axes_[layout->get_axis(0)] = distributed_axis{1, idx_m, warp_0};
-    axes_[layout->get_axis(1)] = distributed_axis{1, idx_n, warp_1};
+    axes_[layout][layout->get_axis(0)] = distributed_axis{1, idx_m, warp_0};
+    axes_[layout][layout->get_axis(1)] = distributed_axis{1, idx_n, warp_1};
   }
 }
 
@@ -1854,7 +2331,7 @@ void generator::visit_layout_scanline(analysis::scanline_layout* layout) {
       unsigned offset = n / nts * per_block + n % nts;
       idx_list[n] = add(scaled_thread_id, i32(offset), "idx_" + str_k + "_" + std::to_string(n));
     }
-    axes_[layout->get_axis(k)] = distributed_axis{nts, idx_list, thread_id[k]};
+    axes_[layout][layout->get_axis(k)] = distributed_axis{nts, idx_list, thread_id[k]};
   }
 }
 
@@ -1899,6 +2376,14 @@ void generator::visit_argument(ir::argument* arg) {
 
 }
 
+/**
+ * \brief Distribution of the k-th axis of `v`. Layouts that share an
+ * axis may distribute it differently
+ */
+const distributed_axis& generator::axis_of(ir::value *v, unsigned k) {
+  return axes_.at(layouts_->get(v)).at(a_axes_->get(v, k));
+}
+
 void generator::init_idx(ir::value *v) {
   idxs_[v].clear();
   if(!v->get_type()->is_tile_ty()){
@@ -1913,10 +2398,8 @@ void generator::init_idx(ir::value *v) {
   std::vector<int> ord(rank);
   // compute axes
   for(size_t d = 0; d < shapes.size(); d++){
-    if(shapes[d] > 1){
-      unsigned x = a_axes_->get(v, d);
-      axes[d] = axes_.at(x);
-    }
+    if(shapes[d] > 1)
+      axes[d] = axis_of(v, d);
     else{
       axes[d].contiguous = 1;
       axes[d].values = {i32(0)};
@@ -147,7 +147,7 @@ Instruction* cpu_target::add_memfence(Module *module, IRBuilder<>& builder) {
 Value* cpu_target::get_block_id(Module *module, llvm::IRBuilder<> &builder, unsigned ax) {
   const Function *fn = builder.GetInsertBlock()->getParent();
   size_t num_params = fn->getFunctionType()->getNumParams();
-  static std::array<const Argument*, 3> ids = {
+  std::array<const Argument*, 3> ids = {
     fn->arg_begin() + num_params - 3,
     fn->arg_begin() + num_params - 2,
     fn->arg_begin() + num_params - 1
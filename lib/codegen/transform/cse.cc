@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <functional>
+#include "triton/codegen/transform/cse.h"
+#include "triton/codegen/analysis/axes.h"
+#include "triton/codegen/analysis/layout.h"
+#include "triton/ir/module.h"
+#include "triton/ir/function.h"
+#include "triton/ir/basic_block.h"
+#include "triton/ir/instructions.h"
+#include "triton/ir/utils.h"
+
+namespace triton {
+namespace codegen{
+namespace transform{
+
+bool cse::is_pure(ir::instruction *i) {
+  switch(i->get_id()){
+    case ir::INST_BINOP:
+    case ir::INST_GETELEMENTPTR:
+    case ir::INST_SELECT:
+    case ir::INST_SQRT:
+    case ir::INST_ICMP:
+    case ir::INST_FCMP:
+    case ir::INST_CAST_TRUNC:
+    case ir::INST_CAST_ZEXT:
+    case ir::INST_CAST_SEXT:
+    case ir::INST_CAST_FP_TRUNC:
+    case ir::INST_CAST_FP_EXT:
+    case ir::INST_CAST_UI_TO_FP:
+    case ir::INST_CAST_SI_TO_FP:
+    case ir::INST_CAST_FP_TO_UI:
+    case ir::INST_CAST_FP_TO_SI:
+    case ir::INST_CAST_PTR_TO_INT:
+    case ir::INST_CAST_INT_TO_PTR:
+    case ir::INST_CAST_BIT_CAST:
+    case ir::INST_CAST_ADDR_SPACE_CAST:
+    case ir::INST_RESHAPE:
+    case ir::INST_SPLAT:
+    case ir::INST_BROADCAST:
+    case ir::INST_DOWNCAST:
+    case ir::INST_GET_PROGRAM_ID:
+    case ir::INST_GET_NUM_PROGRAMS:
+    case ir::INST_EXP:
+    case ir::INST_LOG:
+    case ir::INST_MATH:
+    case ir::INST_TRANS:
+    case ir::INST_REDUCE:
+    case ir::INST_MAKE_RANGE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+cse::key_t cse::get_key(ir::instruction *i) {
+  std::vector<ir::value*> ops = i->ops();
+  // canonical operand order for commutative operators
+  if(auto *bin = dynamic_cast<ir::binary_operator*>(i)){
+    switch(bin->get_op()){
+      case ir::binary_op_t::Add:
+      case ir::binary_op_t::FAdd:
+      case ir::binary_op_t::Mul:
+      case ir::binary_op_t::FMul:
+      case ir::binary_op_t::And:
+      case ir::binary_op_t::Or:
+      case ir::binary_op_t::Xor:
+        std::sort(ops.begin(), ops.end());
+        break;
+      default:
+        break;
+    }
+  }
+  std::map<unsigned, unsigned> metadatas;
+  for(auto md: i->get_metadatas())
+  if(md.second)
+    metadatas[md.first] = md.second;
+  return key_t(i->get_id(), i->repr(), i->get_type(), ops, metadatas);
+}
+
+bool cse::is_compatible(ir::instruction *x, ir::instruction *y) {
+  if(!x->get_type()->is_tile_ty())
+    return true;
+  return axes_->get(x) == axes_->get(y) &&
+         layouts_->layout_of(x) == layouts_->layout_of(y);
+}
+
+void cse::run(ir::function *fn) {
+  auto idom = ir::cfg::immediate_dominators(fn);
+  std::map<ir::basic_block*, std::vector<ir::basic_block*>> children;
+  ir::basic_block *entry = nullptr;
+  for(ir::basic_block *block: fn->blocks()){
+    auto it = idom.find(block);
+    if(it == idom.end())
+      continue;
+    if(it->second)
+      children[it->second].push_back(block);
+    else
+      entry = block;
+  }
+  if(!entry)
+    return;
+  // pre-order walk of the dominator tree; available expressions
+  // are scoped to the dominator sub-tree that defines them
+  std::map<key_t, std::vector<ir::instruction*>> available;
+  std::vector<ir::instruction*> to_delete;
+  std::function<void(ir::basic_block*)> walk = [&](ir::basic_block *block) {
+    std::vector<key_t> defined;
+    for(ir::instruction *i: block->get_inst_list()){
+      if(!is_pure(i))
+        continue;
+      key_t key = get_key(i);
+      auto &candidates = available[key];
+      auto it = std::find_if(candidates.begin(), candidates.end(),
+                             [&](ir::instruction *x) { return is_compatible(x, i); });
+      if(it != candidates.end()){
+        i->replace_all_uses_with(*it);
+        to_delete.push_back(i);
+        continue;
+      }
+      candidates.push_back(i);
+      defined.push_back(key);
+    }
+    for(ir::basic_block *child: children[block])
+      walk(child);
+    for(const key_t &key: defined)
+      available[key].pop_back();
+  };
+  walk(entry);
+  for(ir::instruction *i: to_delete)
+    i->erase_from_parent();
+}
+
+void cse::run(ir::module &mod) {
+  for(ir::function *fn: mod.get_function_list())
+    run(fn);
+}
+
+}
+}
+}
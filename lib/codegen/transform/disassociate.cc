@@ -1,4 +1,5 @@
 #include "triton/codegen/transform/disassociate.h"
+#include "triton/codegen/transform/cse.h"
 #include "triton/ir/utils.h"
 #include "triton/ir/instructions.h"
 #include "triton/ir/builder.h"
@@ -21,10 +22,12 @@ void extract_retile_chain(ir::user *root,
     return;
   }
   for(ir::value *op: root->ops()){
-    ir::user *u = dynamic_cast<ir::user*>(op);
-    if(!u)
+    // only index computations are cloned; constants, loads, dots,
+    // reductions and loop-carried values are shared
+    ir::instruction *i = dynamic_cast<ir::instruction*>(op);
+    if(!i || !cse::is_pure(i) || i->get_id() == ir::INST_REDUCE || i->get_id() == ir::INST_TRANS)
       continue;
-    extract_retile_chain(u, result, depth + 1, seen);
+    extract_retile_chain(i, result, depth + 1, seen);
   }
 }
 
@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <iterator>
+#include "triton/codegen/transform/licm.h"
+#include "triton/codegen/transform/cse.h"
+#include "triton/ir/module.h"
+#include "triton/ir/function.h"
+#include "triton/ir/basic_block.h"
+#include "triton/ir/instructions.h"
+#include "triton/ir/constant.h"
+#include "triton/ir/utils.h"
+
+namespace triton {
+namespace codegen{
+namespace transform{
+
+// hoisted instructions are executed speculatively,
+// so they must neither trap nor touch shared memory
+// (transpositions and reductions go through it)
+bool licm::is_hoistable(ir::instruction *i) {
+  if(!cse::is_pure(i) || i->get_id() == ir::INST_TRANS || i->get_id() == ir::INST_REDUCE)
+    return false;
+  auto *bin = dynamic_cast<ir::binary_operator*>(i);
+  if(bin && (bin->is_int_div() || bin->is_int_rem())){
+    ir::value *rhs = bin->get_operand(1);
+    if(auto *splat = dynamic_cast<ir::splat_inst*>(rhs))
+      rhs = splat->get_operand(0);
+    auto *cst = dynamic_cast<ir::constant_int*>(rhs);
+    return cst && cst->get_value() != 0;
+  }
+  return true;
+}
+
+std::vector<licm::loop_t> licm::get_loops(ir::function *fn, const std::map<ir::basic_block*, ir::basic_block*> &idom) {
+  std::map<ir::basic_block*, std::set<ir::basic_block*>> bodies;
+  for(ir::basic_block *block: fn->blocks()){
+    if(idom.find(block) == idom.end())
+      continue;
+    for(ir::basic_block *header: block->get_successors()){
+      // back-edge
+      if(!ir::cfg::dominates(idom, header, block))
+        continue;
+      std::set<ir::basic_block*> &body = bodies[header];
+      body.insert(header);
+      std::vector<ir::basic_block*> stack = {block};
+      while(!stack.empty()){
+        ir::basic_block *current = stack.back();
+        stack.pop_back();
+        if(!body.insert(current).second)
+          continue;
+        for(ir::basic_block *pred: current->get_predecessors())
+          stack.push_back(pred);
+      }
+    }
+  }
+  std::vector<loop_t> result;
+  for(auto &x: bodies)
+    result.push_back({x.first, x.second});
+  // inner loops first
+  std::sort(result.begin(), result.end(), [](const loop_t &x, const loop_t &y) {
+    return x.blocks.size() < y.blocks.size();
+  });
+  return result;
+}
+
+void licm::run(ir::function *fn) {
+  auto idom = ir::cfg::immediate_dominators(fn);
+  for(const loop_t &loop: get_loops(fn, idom)){
+    // unique block entering the loop
+    ir::basic_block *entering = nullptr;
+    bool unique = true;
+    for(ir::basic_block *pred: loop.header->get_predecessors()){
+      if(loop.blocks.find(pred) != loop.blocks.end())
+        continue;
+      unique = unique && (!entering || entering == pred);
+      entering = pred;
+    }
+    if(!entering || !unique)
+      continue;
+    ir::basic_block::inst_list_t &dst = entering->get_inst_list();
+    if(dst.empty() || !dynamic_cast<ir::terminator_inst*>(dst.back()))
+      continue;
+    auto is_invariant = [&](ir::value *v) {
+      auto *i = dynamic_cast<ir::instruction*>(v);
+      return !i || loop.blocks.find(i->get_parent()) == loop.blocks.end();
+    };
+    // hoisted instructions are appended in order, so
+    // operands always precede their users
+    bool changed = true;
+    while(changed){
+      changed = false;
+      for(ir::basic_block *block: fn->blocks()){
+        if(loop.blocks.find(block) == loop.blocks.end())
+          continue;
+        ir::basic_block::inst_list_t insts = block->get_inst_list();
+        for(ir::instruction *i: insts){
+          if(!is_hoistable(i))
+            continue;
+          std::vector<ir::value*> ops = i->ops();
+          if(!std::all_of(ops.begin(), ops.end(), is_invariant))
+            continue;
+          block->erase(i);
+          dst.insert(std::prev(dst.end()), i);
+          i->set_parent(entering);
+          changed = true;
+        }
+      }
+    }
+  }
+}
+
+void licm::run(ir::module &mod) {
+  for(ir::function *fn: mod.get_function_list())
+    run(fn);
+}
+
+}
+}
+}
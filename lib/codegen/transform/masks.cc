@@ -0,0 +1,346 @@
+#include <algorithm>
+#include "triton/codegen/transform/masks.h"
+#include "triton/codegen/analysis/align.h"
+#include "triton/ir/module.h"
+#include "triton/ir/function.h"
+#include "triton/ir/basic_block.h"
+#include "triton/ir/instructions.h"
+#include "triton/ir/constant.h"
+#include "triton/ir/utils.h"
+
+namespace triton {
+namespace codegen{
+namespace transform{
+
+// offsets are kept small enough that sums and differences never overflow
+static const int64_t max_offset = int64_t(1) << 30;
+
+inline int64_t sext_value(ir::constant_int *x) {
+  unsigned width = x->get_type()->get_integer_bitwidth();
+  uint64_t v = x->get_value();
+  if(width >= 64)
+    return (int64_t)v;
+  uint64_t mask = (uint64_t(1) << width) - 1;
+  uint64_t sign = uint64_t(1) << (width - 1);
+  return (int64_t)(((v & mask) ^ sign) - sign);
+}
+
+inline ir::constant_int* get_int(ir::type *ty, int64_t v) {
+  unsigned width = ty->get_integer_bitwidth();
+  uint64_t bits = width >= 64 ? (uint64_t)v : (uint64_t)v & ((uint64_t(1) << width) - 1);
+  return ir::constant_int::get(ty, bits);
+}
+
+inline int64_t floor_div(int64_t a, int64_t b) {
+  int64_t q = a / b;
+  return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+inline uint64_t gcd(uint64_t a, uint64_t b) {
+  while(b){
+    uint64_t t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+// lower bound on `v` implied by `cond` being true
+static bool cond_lower_bound(ir::value *cond, ir::value *v, int64_t &result) {
+  auto *x = dynamic_cast<ir::icmp_inst*>(cond);
+  if(!x)
+    return false;
+  ir::value *lhs = x->get_operand(0);
+  ir::value *rhs = x->get_operand(1);
+  ir::cmp_pred_t pred = x->get_pred();
+  // canonicalize to `v pred c`
+  if(rhs == v){
+    std::swap(lhs, rhs);
+    switch(pred){
+      case ir::ICMP_SLT: pred = ir::ICMP_SGT; break;
+      case ir::ICMP_SLE: pred = ir::ICMP_SGE; break;
+      case ir::ICMP_SGT: pred = ir::ICMP_SLT; break;
+      case ir::ICMP_SGE: pred = ir::ICMP_SLE; break;
+      default: break;
+    }
+  }
+  auto *c = dynamic_cast<ir::constant_int*>(rhs);
+  if(lhs != v || !c)
+    return false;
+  int64_t cst = sext_value(c);
+  if(std::abs(cst) > max_offset)
+    return false;
+  switch(pred){
+    case ir::ICMP_SGT: result = cst + 1; return true;
+    case ir::ICMP_SGE:
+    case ir::ICMP_EQ:  result = cst; return true;
+    default: return false;
+  }
+}
+
+// every element of v is false
+static bool is_false(ir::value *v) {
+  if(auto *x = dynamic_cast<ir::constant_int*>(v))
+    return !(x->get_value() & 1);
+  if(dynamic_cast<ir::splat_inst*>(v) || dynamic_cast<ir::broadcast_inst*>(v) ||
+     dynamic_cast<ir::reshape_inst*>(v))
+    return is_false(((ir::instruction*)v)->get_operand(0));
+  return false;
+}
+
+// v = base + offset, with offset in [lo, hi]
+bool masks::get_range(ir::value *v, range_t &result) {
+  ir::type *ty = v->get_type();
+  if(!ty->get_scalar_ty()->is_integer_ty())
+    return false;
+  bool is_tile = ty->is_tile_ty();
+  if(auto *x = dynamic_cast<ir::constant_int*>(v)){
+    int64_t cst = sext_value(x);
+    if(std::abs(cst) > max_offset)
+      return false;
+    result = {nullptr, cst, cst};
+    return true;
+  }
+  if(auto *x = dynamic_cast<ir::make_range*>(v)){
+    result = {nullptr, (int64_t)x->get_first()->get_value(), (int64_t)x->get_last()->get_value() - 1};
+    return true;
+  }
+  if(auto *x = dynamic_cast<ir::make_range_sta*>(v))
+    return get_range(x->get_range(), result);
+  if(dynamic_cast<ir::splat_inst*>(v) || dynamic_cast<ir::broadcast_inst*>(v) ||
+     dynamic_cast<ir::reshape_inst*>(v))
+    return get_range(((ir::instruction*)v)->get_operand(0), result);
+  if(auto *x = dynamic_cast<ir::binary_operator*>(v))
+  if(x->is_int_add_sub()){
+    range_t lhs, rhs;
+    if(get_range(x->get_operand(0), lhs) && get_range(x->get_operand(1), rhs)){
+      bool is_add = x->get_op() == ir::binary_op_t::Add;
+      bool ok = true;
+      if(is_add){
+        ok = !lhs.base || !rhs.base;
+        result = {lhs.base ? lhs.base : rhs.base, lhs.lo + rhs.lo, lhs.hi + rhs.hi};
+      }
+      else{
+        ok = !rhs.base || rhs.base == lhs.base;
+        result = {rhs.base ? nullptr : lhs.base, lhs.lo - rhs.hi, lhs.hi - rhs.lo};
+      }
+      if(ok && std::abs(result.lo) <= max_offset && std::abs(result.hi) <= max_offset)
+        return true;
+    }
+  }
+  // opaque scalar
+  if(!is_tile){
+    result = {v, 0, 0};
+    return true;
+  }
+  return false;
+}
+
+// v is a multiple of the result; 0 means v is known to be 0
+uint64_t masks::get_multiple(ir::value *v) {
+  if(!v)
+    return 0;
+  if(auto *x = dynamic_cast<ir::constant_int*>(v))
+    return std::abs(sext_value(x));
+  return align_->starting_multiple(v)[0];
+}
+
+// (base_a + [lo_a, hi_a]) < (base_b + [lo_b, hi_b]) holds for every element
+// or for none when D = base_b - base_a, a multiple of m, cannot fall inside
+// the interval of differences. It is then equivalent to base_a + w_hi < base_b
+ir::value* masks::uniformize(ir::cmp_inst *x, ir::builder &builder) {
+  if(x->get_id() != ir::INST_ICMP || !x->get_type()->is_tile_ty())
+    return nullptr;
+  ir::value *lhs = x->get_operand(0);
+  ir::value *rhs = x->get_operand(1);
+  ir::cmp_pred_t pred = x->get_pred();
+  if(pred == ir::ICMP_SGT || pred == ir::ICMP_SGE)
+    std::swap(lhs, rhs);
+  else if(pred != ir::ICMP_SLT && pred != ir::ICMP_SLE)
+    return nullptr;
+  bool strict = pred == ir::ICMP_SLT || pred == ir::ICMP_SGT;
+  range_t a, b;
+  if(!get_range(lhs, a) || !get_range(rhs, b))
+    return nullptr;
+  // already uniform
+  if(a.lo == a.hi && b.lo == b.hi)
+    return nullptr;
+  // a <= b is a - 1 < b
+  int64_t w_lo = a.lo - b.hi - (strict ? 0 : 1);
+  int64_t w_hi = a.hi - b.lo - (strict ? 0 : 1);
+  int64_t m = (a.base == b.base) ? 0 : gcd(get_multiple(a.base), get_multiple(b.base));
+  bool straddles = (m == 0) ? (w_lo < 0 && 0 <= w_hi)
+                            : (floor_div(w_hi, m) * m > w_lo);
+  if(straddles)
+    return nullptr;
+  ir::type *ty = lhs->get_type()->get_scalar_ty();
+  ir::type *bool_ty = x->get_type()->get_scalar_ty();
+  builder.set_insert_point(x);
+  ir::value *cond;
+  if(a.base == b.base)
+    cond = ir::constant_int::get(bool_ty, w_hi < 0);
+  else {
+    ir::value *slhs = get_int(ty, w_hi);
+    if(a.base)
+      slhs = w_hi == 0 ? a.base : builder.create_add(a.base, slhs);
+    ir::value *srhs = b.base ? b.base : get_int(ty, 0);
+    cond = builder.create_icmp(ir::ICMP_SLT, slhs, srhs);
+  }
+  return builder.create_splat(cond, x->get_type()->get_tile_shapes());
+}
+
+// lower bound of the scalar v wherever `block` executes
+bool masks::lower_bound(ir::value *v, ir::basic_block *block, int64_t &result) {
+  if(auto *x = dynamic_cast<ir::constant_int*>(v)){
+    result = sext_value(x);
+    return std::abs(result) <= max_offset;
+  }
+  bool found = false;
+  int64_t bound = 0;
+  auto update = [&](int64_t b) {
+    bound = found ? std::max(bound, b) : b;
+    found = true;
+  };
+  // conditions of dominating branches
+  for(ir::basic_block *d = block; d && idoms_.count(d); d = idoms_.at(d)){
+    auto preds = d->get_predecessors();
+    if(preds.size() != 1)
+      continue;
+    auto *br = dynamic_cast<ir::cond_branch_inst*>(preds[0]->get_inst_list().back());
+    int64_t b;
+    if(br && br->get_true_dest() == d && br->get_false_dest() != d &&
+       cond_lower_bound(br->get_cond(), v, b))
+      update(b);
+  }
+  // loop variables that are tested on every edge into their header
+  if(auto *phi = dynamic_cast<ir::phi_node*>(v)){
+    ir::basic_block *header = phi->get_parent();
+    bool guarded = phi->get_num_incoming() > 0;
+    int64_t b = 0;
+    for(unsigned n = 0; guarded && n < phi->get_num_incoming(); n++){
+      auto *br = dynamic_cast<ir::cond_branch_inst*>(phi->get_incoming_block(n)->get_inst_list().back());
+      int64_t bn;
+      guarded = br && br->get_true_dest() == header && br->get_false_dest() != header &&
+                cond_lower_bound(br->get_cond(), phi->get_incoming_value(n), bn);
+      b = (n == 0) ? bn : std::min(b, bn);
+    }
+    if(guarded)
+      update(b);
+  }
+  if(found){
+    // round up to the next known multiple
+    int64_t m = get_multiple(v);
+    result = (m > 1) ? -floor_div(-bound, m) * m : bound;
+    return true;
+  }
+  // offsets by constants
+  auto *x = dynamic_cast<ir::binary_operator*>(v);
+  if(x && x->is_int_add_sub())
+  if(auto *c = dynamic_cast<ir::constant_int*>(x->get_operand(1))){
+    int64_t cst = sext_value(c);
+    if(std::abs(cst) > max_offset || !lower_bound(x->get_operand(0), block, result))
+      return false;
+    result += (x->get_op() == ir::binary_op_t::Add) ? cst : -cst;
+    return true;
+  }
+  return false;
+}
+
+// v is true (in every element) wherever `block` executes
+bool masks::is_true(ir::value *v, ir::basic_block *block) {
+  if(auto *x = dynamic_cast<ir::constant_int*>(v))
+    return x->get_value() & 1;
+  if(dynamic_cast<ir::splat_inst*>(v) || dynamic_cast<ir::broadcast_inst*>(v) ||
+     dynamic_cast<ir::reshape_inst*>(v))
+    return is_true(((ir::instruction*)v)->get_operand(0), block);
+  if(auto *x = dynamic_cast<ir::binary_operator*>(v))
+  if(x->get_op() == ir::binary_op_t::And)
+    return is_true(x->get_operand(0), block) && is_true(x->get_operand(1), block);
+  if(v->get_type()->is_tile_ty())
+    return false;
+  // branched on
+  for(ir::basic_block *d = block; d && idoms_.count(d); d = idoms_.at(d)){
+    auto preds = d->get_predecessors();
+    if(preds.size() != 1)
+      continue;
+    auto *br = dynamic_cast<ir::cond_branch_inst*>(preds[0]->get_inst_list().back());
+    if(br && br->get_cond() == v && br->get_true_dest() == d && br->get_false_dest() != d)
+      return true;
+  }
+  // constant < lower bound
+  auto *x = dynamic_cast<ir::icmp_inst*>(v);
+  if(!x)
+    return false;
+  ir::value *lhs = x->get_operand(0);
+  ir::value *rhs = x->get_operand(1);
+  ir::cmp_pred_t pred = x->get_pred();
+  if(pred == ir::ICMP_SGT || pred == ir::ICMP_SGE)
+    std::swap(lhs, rhs);
+  else if(pred != ir::ICMP_SLT && pred != ir::ICMP_SLE)
+    return false;
+  bool strict = pred == ir::ICMP_SLT || pred == ir::ICMP_SGT;
+  auto *c = dynamic_cast<ir::constant_int*>(lhs);
+  int64_t bound;
+  if(!c || !lower_bound(rhs, block, bound))
+    return false;
+  int64_t cst = sext_value(c);
+  return strict ? cst < bound : cst <= bound;
+}
+
+void masks::run(ir::module &mod) {
+  ir::builder &builder = mod.get_builder();
+  // uniformize comparisons
+  align_->run(mod);
+  std::vector<ir::cmp_inst*> cmps;
+  ir::for_each_instruction(mod, [&](ir::instruction *i) {
+    if(auto *x = dynamic_cast<ir::cmp_inst*>(i))
+      cmps.push_back(x);
+  });
+  for(ir::cmp_inst *x: cmps)
+  if(ir::value *result = uniformize(x, builder))
+    x->replace_all_uses_with(result);
+  // drop masks that are always true
+  align_->run(mod);
+  for(ir::function *fn: mod.get_function_list()){
+    idoms_ = ir::cfg::immediate_dominators(fn);
+    for(ir::basic_block *block: fn->blocks()){
+      std::vector<ir::instruction*> insts(block->get_inst_list().begin(), block->get_inst_list().end());
+      for(ir::instruction *i: insts){
+        if(auto *x = dynamic_cast<ir::masked_load_inst*>(i)){
+          ir::value *mask = x->get_mask_operand();
+          ir::value *result = nullptr;
+          if(is_true(mask, block)){
+            builder.set_insert_point(x);
+            result = builder.create_load(x->get_pointer_operand());
+          }
+          else if(is_false(mask))
+            result = x->get_false_value_operand();
+          if(result){
+            x->replace_all_uses_with(result);
+            x->erase_from_parent();
+          }
+        }
+        // loads guarded by a select are only turned into masked loads later
+        if(auto *x = dynamic_cast<ir::select_inst*>(i))
+        if(is_true(x->get_pred_op(), block)){
+          x->replace_all_uses_with(x->get_if_value_op());
+          x->erase_from_parent();
+        }
+        if(auto *x = dynamic_cast<ir::masked_store_inst*>(i)){
+          ir::value *mask = x->get_mask_operand();
+          if(is_true(mask, block)){
+            builder.set_insert_point(x);
+            builder.create_store(x->get_pointer_operand(), x->get_value_operand());
+            x->erase_from_parent();
+          }
+          else if(is_false(mask))
+            x->erase_from_parent();
+        }
+      }
+    }
+  }
+}
+
+}
+}
+}
@@ -17,20 +17,36 @@ namespace transform{
 
 
 
-int membar::group_of(ir::value* v, std::vector<ir::value*> &async_write) {
-  if(ir::phi_node* phi = dynamic_cast<ir::phi_node*>(v)){
-    analysis::shared_layout* layout = layouts_->get(v)->to_shared();
-    analysis::double_buffer_info_t* info = layout->get_double_buffer();
-    if(info)
-      return group_of(info->first, async_write);
-    std::vector<int> groups(phi->get_num_operands());
-    std::transform(phi->op_begin(), phi->op_end(), groups.begin(), [&](ir::value* v){ return group_of(v, async_write);});
-    return *std::max_element(groups.begin(), groups.end());
-  }
-  else{
-    auto it = std::find(async_write.begin(), async_write.end(), v);
-    return std::distance(async_write.begin(), it);
+// number of asynchronous copy groups that may stay in flight when
+// `v` is read, or -1 if the copy that produced `v` is complete
+int membar::groups_after(ir::value* v, const async_map_t& async_write, std::set<ir::value*>& seen) {
+  auto it = async_write.find(v);
+  if(it != async_write.end())
+    return it->second;
+  ir::phi_node* phi = dynamic_cast<ir::phi_node*>(v);
+  if(!phi || !seen.insert(phi).second)
+    return -1;
+  // the latch of a double-buffered phi-node writes the other half;
+  // the half that is read was renamed to the phi-node on entry
+  analysis::double_buffer_info_t* info = layouts_->get(v)->to_shared()->get_double_buffer();
+  if(info && info->phi == phi)
+    return groups_after(info->first, async_write, seen);
+  int ret = -1;
+  for(ir::value* op: phi->ops()){
+    int n = groups_after(op, async_write, seen);
+    if(n >= 0 && (ret < 0 || n < ret))
+      ret = n;
   }
+  return ret;
+}
+
+// keeps the smallest count of `v`, which is safe on every path
+void membar::add_async(async_map_t& async_write, ir::value* v, int n) {
+  auto it = async_write.find(v);
+  if(it == async_write.end())
+    async_write[v] = n;
+  else
+    it->second = std::min(it->second, n);
 }
 
 
@@ -52,26 +68,54 @@ membar::val_set_t membar::intersect_with(const val_set_t& as, const val_set_t& b
         continue;
       int b_start = alloc_->offset(b_layout);
       int b_end = b_start + b_layout->get_size();
-      if(a_start < b_end || b_start < a_end)
+      if(a_start < b_end && b_start < a_end)
         ret.insert(b);
     }
   }
   return ret;
 }
 
+// a write to a double-buffered layout and a read of its phi-node
+// made in the same iteration of the loop access different halves
+bool membar::is_other_half(ir::value* write, ir::value* read, const std::set<ir::value*>& safe_war) {
+  if(safe_war.find(write) == safe_war.end())
+    return false;
+  return layouts_->get(write)->to_shared()->get_double_buffer()->phi == read;
+}
+
 void membar::transfer(ir::basic_block *block,
-                      val_vec_t& async_write,
+                      async_map_t& async_write,
                       val_set_t& sync_write,
                       val_set_t& sync_read,
                       std::set<ir::value*>& safe_war,
-                      bool& inserted, ir::builder& builder) {
+                      bool& conflict, ir::builder* builder) {
   ir::basic_block::inst_list_t instructions = block->get_inst_list();
+  // accesses made before entering the block and not yet synchronized
+  val_set_t in_write = sync_write;
+  val_set_t in_read = sync_read;
   for(ir::instruction *i: instructions){
-    if(dynamic_cast<ir::phi_node*>(i))
+    // copies into a double buffer that are in flight when entering
+    // the loop are read through its phi-node
+    if(ir::phi_node* phi = dynamic_cast<ir::phi_node*>(i)){
+      if(!phi->get_type()->is_tile_ty() || !layouts_->get(phi)->to_shared())
+        continue;
+      analysis::double_buffer_info_t* info = layouts_->get(phi)->to_shared()->get_double_buffer();
+      if(!info || info->phi != phi)
+        continue;
+      for(ir::value* v: {info->first, info->latch}){
+        auto it = async_write.find(v);
+        if(it == async_write.end())
+          continue;
+        add_async(async_write, phi, it->second);
+        async_write.erase(it);
+      }
       continue;
-    if(std::find(async_write.begin(), async_write.end(), i) == async_write.end() &&
-       dynamic_cast<ir::masked_load_async_inst*>(i)){
-      async_write.push_back(i);
+    }
+    // a new group is committed after every asynchronous copy
+    if(dynamic_cast<ir::masked_load_async_inst*>(i)){
+      for(auto& x: async_write)
+        x.second++;
+      async_write[i] = 0;
     }
     if(dynamic_cast<ir::copy_to_shared_inst*>(i))
       sync_write.insert(i);
@@ -83,44 +127,118 @@ void membar::transfer(ir::basic_block *block,
                  [&](ir::value* i){ return i->get_type()->is_tile_ty() && layouts_->get(i)->to_shared();});
     // RAW (async)
     val_set_t tmp;
-    std::copy(async_write.begin(), async_write.end(), std::inserter(tmp, tmp.begin()));
+    for(const auto& x: async_write)
+      tmp.insert(x.first);
     if(intersect_with(read, tmp).size()){
-      std::vector<int> groups(read.size());
-      std::transform(read.begin(), read.end(), groups.begin(), [&](ir::value* v){ return group_of(v, async_write);});
-      int N = *std::max_element(groups.begin(), groups.end());
-      if(N < async_write.size()){
-        builder.set_insert_point(i);
-        async_wait = (ir::async_wait_inst*)builder.create_async_wait(async_write.size() - 1 - N);
-        barrier = (ir::barrier_inst*)builder.create_barrier();
-        inserted = true;
+      int N = -1;
+      for(ir::value* v: read){
+        std::set<ir::value*> seen;
+        int n = groups_after(v, async_write, seen);
+        if(n >= 0 && (N < 0 || n < N))
+          N = n;
+      }
+      if(N >= 0){
+        conflict = true;
+        if(!builder)
+          return;
+        builder->set_insert_point(i);
+        async_wait = (ir::async_wait_inst*)builder->create_async_wait(N);
+        barrier = (ir::barrier_inst*)builder->create_barrier();
+        num_inserted_++;
       }
     }
     // RAW, WAR
-    if(intersect_with(read, sync_write).size() || intersect_with({i}, sync_read).size()){
-      builder.set_insert_point(i);
-      barrier = (ir::barrier_inst*)builder.create_barrier();
-      inserted = true;
+    bool raw = false;
+    for(ir::value* r: read)
+    for(ir::value* w: intersect_with({r}, sync_write))
+      raw = raw || !is_other_half(w, r, safe_war) || in_write.find(w) != in_write.end();
+    bool war = false;
+    for(ir::value* r: intersect_with({i}, sync_read))
+      war = war || !is_other_half(i, r, safe_war) || in_read.find(r) != in_read.end();
+    if(raw || war){
+      conflict = true;
+      if(!builder)
+        return;
+      builder->set_insert_point(i);
+      barrier = (ir::barrier_inst*)builder->create_barrier();
+      inserted_.push_back(barrier);
+      num_inserted_++;
     }
     // update state of asynchronous copies
     if(async_wait){
-      int N = async_write.size() - async_wait->get_N();
-      async_write.erase(async_write.begin(), async_write.begin() + N);
+      for(auto it = async_write.begin(); it != async_write.end();)
+        if(it->second >= async_wait->get_N())
+          it = async_write.erase(it);
+        else
+          ++it;
     }
     // all the copy_to_shared and read from shared are synchronized after barrier
     if(barrier){
       sync_write.clear();
       sync_read.clear();
+      in_write.clear();
+      in_read.clear();
     }
     sync_read.insert(read.begin(), read.end());
 
   }
 }
 
+// data-flow over the CFG until the state at the end of every block
+// reaches a fixed point. missing barriers are inserted when a builder
+// is provided; otherwise returns whether any barrier is missing
+bool membar::solve(ir::function *fn, std::set<ir::value*>& safe_war, ir::builder* builder) {
+  std::vector<ir::basic_block*> rpo = ir::cfg::reverse_post_order(fn);
+  std::map<ir::basic_block*, async_map_t> async_writes;
+  std::map<ir::basic_block*, val_set_t> sync_writes;
+  std::map<ir::basic_block*, val_set_t> sync_reads;
+  bool changed;
+  do{
+    changed = false;
+    for(ir::basic_block *block: rpo){
+      // join inputs
+      async_map_t async_write;
+      val_set_t sync_write;
+      val_set_t sync_read;
+      for(ir::basic_block* pred: block->get_predecessors()){
+        for(const auto& x: async_writes[pred])
+          add_async(async_write, x.first, x.second);
+        sync_write.insert(sync_writes[pred].begin(), sync_writes[pred].end());
+        sync_read.insert(sync_reads[pred].begin(), sync_reads[pred].end());
+      }
+      bool conflict = false;
+      transfer(block, async_write, sync_write, sync_read, safe_war, conflict, builder);
+      if(conflict && !builder)
+        return true;
+      // states computed before a barrier was inserted are stale
+      if(conflict){
+        async_writes.clear();
+        sync_writes.clear();
+        sync_reads.clear();
+        changed = true;
+        break;
+      }
+      // out-states are recomputed from scratch. copies in flight
+      // only appear and their counts only decrease as more paths are
+      // joined, so the iteration terminates
+      changed = changed || async_writes[block] != async_write
+                        || sync_writes[block] != sync_write
+                        || sync_reads[block] != sync_read;
+      async_writes[block] = async_write;
+      sync_writes[block] = sync_write;
+      sync_reads[block] = sync_read;
+    }
+  }while(changed);
+  return false;
+}
+
 void membar::run(ir::module &mod) {
   ir::builder &builder = mod.get_builder();
+  num_inserted_ = 0;
+  num_removed_ = 0;
   // extract phi-node associates with double-buffered
-  // shared-memory copies. These can be read from and written to
-  // without needing synchronization
+  // shared-memory copies. These can be written to while the
+  // phi-node is read without needing synchronization
   std::set<ir::value*> safe_war;
   for(const auto& x: layouts_->get_all()){
     analysis::shared_layout* layout = x.second->to_shared();
@@ -133,34 +251,22 @@ void membar::run(ir::module &mod) {
   }
 
   for(ir::function *fn: mod.get_function_list()){
-    std::vector<ir::basic_block*> rpo = ir::cfg::reverse_post_order(fn);
-    std::map<ir::basic_block*, val_vec_t> async_writes;
-    std::map<ir::basic_block*, val_set_t> sync_writes;
-    std::map<ir::basic_block*, val_set_t> sync_reads;
-    std::list<ir::value *> pipelined;
-    bool inserted;
-    do{
-      inserted = false;
-      // find barrier location
-      for(ir::basic_block *block: rpo){
-        // join inputs
-        val_vec_t async_write;
-        val_set_t sync_write;
-        val_set_t sync_read;
-        val_set_t tmp;
-        for(ir::basic_block* pred: block->get_predecessors()){
-          for(ir::value* v: async_writes[pred])
-            if(tmp.insert(v).second)
-              async_write.push_back(v);
-          sync_write.insert(sync_writes[pred].begin(), sync_writes[pred].end());
-          sync_read.insert(sync_reads[pred].begin(), sync_reads[pred].end());
-        }
-        transfer(block, async_write, sync_write, sync_read, safe_war, inserted, builder);
-        async_writes[block] = async_write;
-        sync_writes[block] = sync_write;
-        sync_reads[block] = sync_read;
+    inserted_.clear();
+    solve(fn, safe_war, &builder);
+    // barriers inserted while the data-flow had not converged
+    // may be covered by barriers inserted later on
+    for(ir::barrier_inst *barrier: inserted_){
+      ir::basic_block *block = barrier->get_parent();
+      auto &instructions = block->get_inst_list();
+      auto it = std::find(instructions.begin(), instructions.end(), barrier);
+      it = instructions.erase(it);
+      if(solve(fn, safe_war, nullptr))
+        instructions.insert(it, barrier);
+      else{
+        delete barrier;
+        num_removed_++;
       }
-    }while(inserted);
+    }
   }
 }
 
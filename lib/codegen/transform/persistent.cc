@@ -0,0 +1,108 @@
+#include <array>
+#include <string>
+#include <vector>
+#include "triton/codegen/transform/persistent.h"
+#include "triton/codegen/transform/tile_order.h"
+#include "triton/ir/module.h"
+#include "triton/ir/function.h"
+#include "triton/ir/basic_block.h"
+#include "triton/ir/instructions.h"
+#include "triton/ir/builder.h"
+#include "triton/ir/type.h"
+
+namespace triton {
+namespace codegen{
+namespace transform{
+
+void persistent::run(ir::module &mod, ir::function *fn) {
+  ir::builder &builder = mod.get_builder();
+  ir::context &ctx = mod.get_context();
+  ir::type *int32_ty = builder.get_int32_ty();
+  // hidden arguments
+  std::array<ir::value*, 3> grid;
+  for(unsigned d = 0; d < 3; d++)
+    grid[d] = fn->add_arg(int32_ty, "__grid" + std::to_string(d));
+  ir::value *num_programs = fn->add_arg(int32_ty, "__num_programs");
+  ir::value *counter = fn->add_arg(ir::pointer_type::get(int32_ty, 1), "__tile_counter");
+  // instructions to rewrite
+  std::vector<ir::instruction*> rets;
+  std::vector<ir::get_program_id_inst*> pids;
+  std::vector<ir::get_num_program_inst*> nps;
+  for(ir::basic_block *block: fn->blocks())
+  for(ir::instruction *i: block->get_inst_list()){
+    if(dynamic_cast<ir::return_inst*>(i))
+      rets.push_back(i);
+    if(auto *pid = dynamic_cast<ir::get_program_id_inst*>(i))
+      pids.push_back(pid);
+    if(auto *np = dynamic_cast<ir::get_num_program_inst*>(i))
+      nps.push_back(np);
+  }
+  ir::basic_block *body = fn->blocks()[0];
+  ir::basic_block *entry = ir::basic_block::create(ctx, "persistent.entry", fn);
+  fn->insert_block(entry, body);
+  ir::basic_block *header = ir::basic_block::create(ctx, "persistent.header", fn);
+  ir::basic_block *decode = ir::basic_block::create(ctx, "persistent.decode", fn);
+  ir::basic_block *latch = ir::basic_block::create(ctx, "persistent.latch", fn);
+  ir::basic_block *exit = ir::basic_block::create(ctx, "persistent.exit", fn);
+  auto next_tile = [&]() {
+    return builder.create_atomic_rmw(ir::atomic_rmw_inst::ADD, counter, builder.get_int32(1), builder.get_int1(true));
+  };
+  // entry
+  builder.set_insert_point(entry);
+  ir::value *num_tiles = builder.create_mul(builder.create_mul(grid[0], grid[1]), grid[2]);
+  ir::value *first = dynamic_ ? next_tile() : builder.create_get_program_id(0);
+  builder.create_br(header);
+  // header
+  builder.set_insert_point(header);
+  ir::phi_node *tile = builder.create_phi(int32_ty, 2);
+  builder.create_cond_br(builder.create_icmpSLT(tile, num_tiles), decode, exit);
+  // decode
+  builder.set_insert_point(decode);
+  ir::value *plane = builder.create_mul(grid[0], grid[1]);
+  std::array<ir::value*, 2> tile_ids = order_->get_tile_ids(builder, builder.create_srem(tile, plane), grid[0], grid[1]);
+  std::array<ir::value*, 3> ids = {tile_ids[0], tile_ids[1], builder.create_sdiv(tile, plane)};
+  builder.create_br(body);
+  // latch
+  builder.set_insert_point(latch);
+  ir::value *next = dynamic_ ? next_tile() : builder.create_add(tile, num_programs);
+  builder.create_br(header);
+  tile->add_incoming(first, entry);
+  tile->add_incoming(next, latch);
+  // exit: each program ends with one out-of-range fetch, so
+  // the last of them is num_tiles + num_programs - 1
+  builder.set_insert_point(exit);
+  if(dynamic_){
+    ir::basic_block *reset = ir::basic_block::create(ctx, "persistent.reset", fn);
+    ir::basic_block *done = ir::basic_block::create(ctx, "persistent.done", fn);
+    ir::value *last = builder.create_sub(builder.create_add(num_tiles, num_programs), builder.get_int32(1));
+    builder.create_cond_br(builder.create_icmpEQ(tile, last), reset, done);
+    builder.set_insert_point(reset);
+    builder.create_atomic_exch(counter, builder.get_int32(0));
+    builder.create_br(done);
+    builder.set_insert_point(done);
+  }
+  builder.create_ret_void();
+  // rewrite the original body
+  for(ir::instruction *ret: rets){
+    builder.set_insert_point(ret);
+    builder.create_br(latch);
+    ret->erase_from_parent();
+  }
+  for(ir::get_program_id_inst *pid: pids){
+    pid->replace_all_uses_with(ids.at(pid->get_axis()));
+    pid->erase_from_parent();
+  }
+  for(ir::get_num_program_inst *np: nps){
+    np->replace_all_uses_with(grid.at(np->get_axis()));
+    np->erase_from_parent();
+  }
+}
+
+void persistent::run(ir::module &mod) {
+  for(ir::function *fn: mod.get_function_list())
+    run(mod, fn);
+}
+
+}
+}
+}
@@ -1,6 +1,8 @@
 #include <iostream>
 #include <algorithm>
+#include <set>
 #include "triton/codegen/transform/pipeline.h"
+#include "triton/codegen/transform/cse.h"
 #include "triton/ir/module.h"
 #include "triton/ir/function.h"
 #include "triton/ir/basic_block.h"
@@ -23,61 +25,274 @@ void recursive_deps(ir::value* v, ir::basic_block* block, std::vector<ir::instru
    recursive_deps(u, block, ret);
 }
 
+/* Loops */
+// Single-block loops, i.e., the form of innermost `for` loops:
+//   header: ...; br body, exit, cond_0  (or br body)
+//   body:   ...; br body, exit, cond_i
+struct loop_t {
+  ir::basic_block *header;
+  ir::basic_block *body;
+  ir::value *guard;   // nullptr when the body is always entered
+  ir::value *cond;
+};
+
+static bool get_loop(ir::basic_block *body, loop_t &loop) {
+  auto *body_br = dynamic_cast<ir::cond_branch_inst*>(body->get_inst_list().back());
+  if(!body_br || body_br->get_true_dest() != body || body_br->get_false_dest() == body)
+    return false;
+  auto preds = body->get_predecessors();
+  if(preds.size() != 2)
+    return false;
+  ir::basic_block *header = (preds[0] == body) ? preds[1] : preds[0];
+  if(header == body)
+    return false;
+  ir::instruction *header_term = header->get_inst_list().back();
+  ir::value *guard = nullptr;
+  if(auto *br = dynamic_cast<ir::cond_branch_inst*>(header_term)){
+    if(br->get_true_dest() != body || br->get_false_dest() == body)
+      return false;
+    guard = br->get_cond();
+  }
+  else if(!dynamic_cast<ir::uncond_branch_inst*>(header_term))
+    return false;
+  loop = {header, body, guard, body_br->get_cond()};
+  return true;
+}
+
+static bool writes_memory(ir::basic_block *block) {
+  for(ir::instruction *i: block->get_inst_list())
+    switch(i->get_id()){
+      case ir::INST_UNMASKED_STORE:
+      case ir::INST_MASKED_STORE:
+      case ir::INST_ATOMIC_RMW:
+      case ir::INST_ATOMIC_CAS:
+      case ir::INST_ATOMIC_EXCH:
+        return true;
+      default:
+        break;
+    }
+  return false;
+}
+
+// whether v depends on `phi` within the loop body
+static bool depends_on(ir::value *v, ir::phi_node *phi, ir::basic_block *body, std::set<ir::value*> &seen) {
+  auto *i = dynamic_cast<ir::instruction*>(v);
+  if(!i || i->get_parent() != body || !seen.insert(i).second)
+    return false;
+  if(i == phi)
+    return true;
+  if(dynamic_cast<ir::phi_node*>(i))
+    return false;
+  return std::any_of(i->op_begin(), i->op_end(), [&](ir::value *op) { return depends_on(op, phi, body, seen); });
+}
+
+// whether the value of a load is carried to the next iteration by a phi
+// node that is not a recurrence, i.e., the load is already pipelined by hand
+static bool is_carried(ir::value *v, ir::basic_block *body, std::set<ir::value*> &seen) {
+  if(!seen.insert(v).second)
+    return false;
+  for(ir::user *u: v->get_users()){
+    auto *i = dynamic_cast<ir::instruction*>(u);
+    if(!i || i->get_parent() != body || dynamic_cast<ir::dot_inst*>(i))
+      continue;
+    if(auto *phi = dynamic_cast<ir::phi_node*>(i)){
+      std::set<ir::value*> deps;
+      if(!depends_on(phi->get_value_for_block(body), phi, body, deps))
+        return true;
+    }
+    else if(is_carried(i, body, seen))
+      return true;
+  }
+  return false;
+}
+
+/* Stages */
+// Rematerializes values of a loop body for later iterations.
+// get(v, k) is the value that v takes k iterations after the one in which
+// phi nodes of the body evaluate to `base(phi)`. New instructions are
+// inserted before `pos`. Returns nullptr when v depends on an instruction
+// that cannot be safely re-executed (e.g., a load).
+class stager {
+public:
+  stager(ir::basic_block *body, bool in_place, ir::instruction *pos, ir::builder &builder)
+    : body_(body), in_place_(in_place), pos_(pos), builder_(builder) {}
+
+  bool varies(ir::value *v) {
+    auto *i = dynamic_cast<ir::instruction*>(v);
+    if(!i || i->get_parent() != body_)
+      return false;
+    if(dynamic_cast<ir::phi_node*>(i))
+      return true;
+    auto it = varies_.find(i);
+    if(it != varies_.end())
+      return it->second;
+    varies_[i] = false;
+    bool result = std::any_of(i->op_begin(), i->op_end(), [&](ir::value *op) { return varies(op); });
+    return varies_[i] = result;
+  }
+
+  ir::value* get(ir::value *v, int k) {
+    auto *i = dynamic_cast<ir::instruction*>(v);
+    if(!i || i->get_parent() != body_)
+      return v;
+    if(auto *phi = dynamic_cast<ir::phi_node*>(i)){
+      if(k > 0)
+        return get(phi->get_value_for_block(body_), k - 1);
+      return in_place_ ? phi : phi->get_value_for_block(other(phi));
+    }
+    if(in_place_ && (k == 0 || !varies(i)))
+      return i;
+    auto key = std::make_pair(v, k);
+    auto it = cache_.find(key);
+    if(it != cache_.end())
+      return it->second;
+    if(!cse::is_pure(i) || i->get_id() == ir::INST_REDUCE || i->get_id() == ir::INST_TRANS)
+      return cache_[key] = nullptr;
+    std::vector<ir::value*> ops;
+    for(ir::value *op: i->ops()){
+      ops.push_back(get(op, k));
+      if(!ops.back())
+        return cache_[key] = nullptr;
+    }
+    ir::instruction *result = i->clone();
+    for(size_t n = 0; n < ops.size(); n++)
+      if(result->get_operand(n) != ops[n])
+        result->replace_uses_of_with(result->get_operand(n), ops[n]);
+    builder_.set_insert_point(pos_);
+    builder_.insert(result);
+    return cache_[key] = result;
+  }
+
+private:
+  ir::basic_block *other(ir::phi_node *phi) {
+    for(unsigned n = 0; n < phi->get_num_incoming(); n++)
+      if(phi->get_incoming_block(n) != body_)
+        return phi->get_incoming_block(n);
+    throw std::runtime_error("loop-carried value has no initial value");
+  }
+
+private:
+  ir::basic_block *body_;
+  bool in_place_;
+  ir::instruction *pos_;
+  ir::builder &builder_;
+  std::map<std::pair<ir::value*, int>, ir::value*> cache_;
+  std::map<ir::instruction*, bool> varies_;
+};
+
+// condition under which the k-th next iteration is executed
+static ir::value* get_exec_cond(stager &stage, const loop_t &loop, int first, int k,
+                                ir::builder &builder, ir::instruction *pos) {
+  ir::value *result = (first == 0) ? loop.guard : nullptr;
+  for(int m = std::max(first, 1); m <= k; m++){
+    ir::value *cond = stage.get(loop.cond, m - 1);
+    if(!cond)
+      return nullptr;
+    builder.set_insert_point(pos);
+    result = result ? builder.create_and(result, cond) : cond;
+  }
+  if(!result)
+    result = ir::constant_int::get(loop.cond->get_type(), 1);
+  return result;
+}
+
+// load of `ld` for the iteration `k` iterations after that of `stage`
+static ir::value* get_staged_load(ir::load_inst *ld, stager &stage, const loop_t &loop,
+                                  int first, int k, ir::builder &builder, ir::instruction *pos) {
+  auto *masked = dynamic_cast<ir::masked_load_inst*>(ld);
+  ir::value *ptr = stage.get(ld->get_pointer_operand(), k);
+  ir::value *mask = masked ? stage.get(masked->get_mask_operand(), k) : nullptr;
+  ir::value *false_value = masked ? stage.get(masked->get_false_value_operand(), k) : nullptr;
+  ir::value *cond = get_exec_cond(stage, loop, first, k, builder, pos);
+  if(!ptr || !cond || (masked && (!mask || !false_value)))
+    return nullptr;
+  ir::type *ty = ld->get_type();
+  builder.set_insert_point(pos);
+  ir::value *result_mask = builder.create_splat(cond, ty->get_tile_shapes());
+  if(masked)
+    result_mask = builder.create_and(result_mask, mask);
+  else
+    false_value = builder.create_splat(ir::undef_value::get(ty->get_scalar_ty()), ty->get_tile_shapes());
+  return builder.create_masked_load(ptr, result_mask, false_value);
+}
+
 void pipeline::run(ir::module &mod) {
-  // *Very* conservative heuristics for pre-fetching.
+  ir::builder &builder = mod.get_builder();
   // A load instruction can be pipelined if:
-  //   - the pointer is a phi node that references a value
-  //     in its basic block (i.e., pointer induction variable)
-  //   - the load has only  a single use in a dot instruction
-  // As more use cases become apparent, this pass will be improved
-  std::vector<std::pair<ir::load_inst*, ir::phi_node*>> to_pipeline;
-  ir::for_each_instruction(mod, [&](ir::instruction *i){
-    if(auto* load = dynamic_cast<ir::load_inst*>(i)){
-      ir::phi_node* ptr = dynamic_cast<ir::phi_node*>(load->get_pointer_operand());
-      auto users = load->get_users();
-      if(ptr && ptr->get_incoming_block(1) == ptr->get_parent()
-         && users.size() == 1 && dynamic_cast<ir::dot_inst*>(*users.begin()))
-        to_pipeline.push_back({load, ptr});
-    }});
+  //   - it is in the body of a single-block loop that does not
+  //     write to memory
+  //   - its address changes across iterations
+  //   - its value is not already carried to the next iteration
+  //   - its address and mask can be computed for later iterations
+  //     without re-executing loads
+  std::vector<std::pair<ir::load_inst*, loop_t>> to_pipeline;
+  for(ir::function *fn: mod.get_function_list())
+  for(ir::basic_block *block: fn->blocks()){
+    loop_t loop;
+    if(num_stages_ < 2 || !get_loop(block, loop) || writes_memory(block))
+      continue;
+    stager stage(block, true, block->get_inst_list().back(), builder);
+    for(ir::instruction *i: block->get_inst_list()){
+      auto *ld = dynamic_cast<ir::load_inst*>(i);
+      if(!ld || ld->get_id() == ir::INST_MASKED_LOAD_ASYNC || !ld->get_type()->is_tile_ty())
+        continue;
+      std::set<ir::value*> seen;
+      if(stage.varies(ld->get_pointer_operand()) && !is_carried(ld, block, seen))
+        to_pipeline.push_back({ld, loop});
+    }
+  }
   // do the pipelining
-  std::vector<ir::phi_node*> new_loads;
-  ir::builder &builder = mod.get_builder();
   for(auto info: to_pipeline){
-    ir::load_inst* load = info.first;
-    ir::phi_node* ptr   = info.second;
-    ir::basic_block* block = load->get_parent();
-    ir::basic_block* header = block->get_predecessors()[0];
-    auto* block_br = dynamic_cast<ir::cond_branch_inst*>(block->get_inst_list().back());
-    auto* header_br = dynamic_cast<ir::cond_branch_inst*>(header->get_inst_list().back());
-    assert(block_br);
-    assert(header_br);
-    ir::type* ty = load->get_type();
-    // pre-fetch first iteration
-    builder.set_insert_point(header->get_inst_list().back());
-    ir::value* first_ptr = ptr->get_value_for_block(header);
-    ir::value* first_mask = builder.create_splat(header_br->get_cond(), ty->get_tile_shapes());
-    ir::value* false_value;
-    if(auto* masked_load = dynamic_cast<ir::masked_load_inst*>(load)){
-      first_mask = builder.create_and(first_mask, masked_load->get_mask_operand());
-      false_value = masked_load->get_false_value_operand();
+    ir::load_inst *load = info.first;
+    loop_t &loop = info.second;
+    ir::instruction *pre_pos = loop.header->get_inst_list().back();
+    ir::instruction *body_pos = loop.body->get_inst_list().back();
+    stager pre(loop.body, false, pre_pos, builder);
+    stager next(loop.body, true, body_pos, builder);
+    // on CPUs, prefetch instead of carrying tiles across iterations
+    if(emit_prefetch_){
+      for(int k = num_stages_ - 1; k >= 1; k--)
+      if(ir::value *ptr = next.get(load->get_pointer_operand(), k)){
+        builder.set_insert_point(body_pos);
+        builder.create_prefetch(ptr);
+        break;
+      }
+      continue;
+    }
+    // operands of dot are double-buffered in shared memory
+    auto users = load->get_users();
+    bool is_dot_operand = std::any_of(users.begin(), users.end(), [](ir::user *u) {
+      return dynamic_cast<ir::dot_inst*>(u);
+    });
+    int num_stages = is_dot_operand ? 2 : num_stages_;
+    // use as many stages as possible
+    std::vector<ir::value*> first_loads;
+    ir::value *next_load = nullptr;
+    for(; num_stages >= 2; num_stages--){
+      first_loads.clear();
+      for(int j = 0; j < num_stages - 1; j++){
+        first_loads.push_back(get_staged_load(load, pre, loop, 0, j, builder, pre_pos));
+        if(!first_loads.back())
+          break;
+      }
+      if(!first_loads.back())
+        continue;
+      next_load = get_staged_load(load, next, loop, 1, num_stages - 1, builder, body_pos);
+      if(next_load)
+        break;
+    }
+    if(!next_load)
+      continue;
+    // rotate through phi nodes; the first one holds the current iteration
+    builder.set_insert_point(loop.body->get_first_non_phi());
+    std::vector<ir::phi_node*> stages;
+    for(int j = 0; j < num_stages - 1; j++)
+      stages.push_back(builder.create_phi(load->get_type(), 2));
+    for(int j = 0; j < num_stages - 1; j++){
+      stages[j]->add_incoming(first_loads[j], loop.header);
+      stages[j]->add_incoming(j + 1 < num_stages - 1 ? stages[j + 1] : next_load, loop.body);
     }
-    else
-      false_value = builder.create_splat(ir::undef_value::get(ty->get_scalar_ty()), ty->get_tile_shapes());
-    ir::value* first_load = builder.create_masked_load(first_ptr, first_mask, false_value);
-    // pre-fetch next iteration
-    builder.set_insert_point(block->get_inst_list().back());
-    ir::value* next_ptr = ptr->get_value_for_block(block);
-    ir::value* next_mask = builder.create_splat(block_br->get_cond(), ty->get_tile_shapes());
-    if(auto* masked_load = dynamic_cast<ir::masked_load_inst*>(load))
-      next_mask = builder.create_and(next_mask, masked_load->get_mask_operand());
-    ir::value* next_load = builder.create_masked_load(next_ptr, next_mask, false_value);
-    // phi node
-    builder.set_insert_point(block->get_first_non_phi());
-    ir::phi_node* new_load = builder.create_phi(ty, 2);
-    new_load->add_incoming(first_load, header);
-    new_load->add_incoming(next_load, block);
-    load->replace_all_uses_with(new_load);
-    new_loads.push_back(new_load);
+    load->replace_all_uses_with(stages[0]);
   }
 
 
@@ -100,6 +315,8 @@ void pipeline::run(ir::module &mod) {
     }
 
     for(auto& x: to_move){
+      if(!x.second.dst)
+        continue;
       builder.set_insert_point_after(x.second.dst);
       for(ir::instruction* i: x.second.insts){
         x.first->erase(i);
@@ -0,0 +1,480 @@
+#include <cmath>
+#include <limits>
+#include "triton/codegen/transform/simplify.h"
+#include "triton/codegen/analysis/align.h"
+#include "triton/ir/module.h"
+#include "triton/ir/function.h"
+#include "triton/ir/basic_block.h"
+#include "triton/ir/instructions.h"
+#include "triton/ir/constant.h"
+#include "triton/ir/utils.h"
+
+namespace triton {
+namespace codegen{
+namespace transform{
+
+/* Scalar folding */
+// integer constants are only meaningful up to their bit-width
+inline uint64_t trunc_bits(uint64_t x, unsigned width) {
+  return width >= 64 ? x : x & ((uint64_t(1) << width) - 1);
+}
+
+inline int64_t sext_bits(uint64_t x, unsigned width) {
+  if(width >= 64)
+    return (int64_t)x;
+  uint64_t sign = uint64_t(1) << (width - 1);
+  return (int64_t)((trunc_bits(x, width) ^ sign) - sign);
+}
+
+// half-precision and bfloat16 arithmetic is not emulated
+inline bool is_foldable_fp(ir::type *ty) {
+  return ty->is_float_ty() || ty->is_double_ty();
+}
+
+inline double round_fp(double x, ir::type *ty) {
+  return ty->is_float_ty() ? (double)(float)x : x;
+}
+
+static bool is_zero(ir::constant *x) {
+  if(auto *i = dynamic_cast<ir::constant_int*>(x))
+    return trunc_bits(i->get_value(), x->get_type()->get_integer_bitwidth()) == 0;
+  if(auto *f = dynamic_cast<ir::constant_fp*>(x))
+    return f->get_value() == 0;
+  return false;
+}
+
+static bool is_one(ir::constant *x) {
+  if(auto *i = dynamic_cast<ir::constant_int*>(x))
+    return trunc_bits(i->get_value(), x->get_type()->get_integer_bitwidth()) == 1;
+  if(auto *f = dynamic_cast<ir::constant_fp*>(x))
+    return f->get_value() == 1;
+  return false;
+}
+
+static bool is_all_ones(ir::constant *x) {
+  auto *i = dynamic_cast<ir::constant_int*>(x);
+  if(!i)
+    return false;
+  unsigned width = x->get_type()->get_integer_bitwidth();
+  return trunc_bits(i->get_value(), width) == trunc_bits(~uint64_t(0), width);
+}
+
+static ir::constant* fold_binop(ir::binary_op_t op, ir::constant *lhs, ir::constant *rhs, ir::type *ty) {
+  auto *ilhs = dynamic_cast<ir::constant_int*>(lhs);
+  auto *irhs = dynamic_cast<ir::constant_int*>(rhs);
+  if(ilhs && irhs){
+    unsigned width = ty->get_integer_bitwidth();
+    uint64_t a = trunc_bits(ilhs->get_value(), width);
+    uint64_t b = trunc_bits(irhs->get_value(), width);
+    int64_t sa = sext_bits(a, width);
+    int64_t sb = sext_bits(b, width);
+    bool overflow = sa == std::numeric_limits<int64_t>::min() && sb == -1;
+    uint64_t result;
+    switch(op){
+      case ir::binary_op_t::Add: result = a + b; break;
+      case ir::binary_op_t::Sub: result = a - b; break;
+      case ir::binary_op_t::Mul: result = a * b; break;
+      case ir::binary_op_t::UDiv: if(b == 0) return nullptr; result = a / b; break;
+      case ir::binary_op_t::URem: if(b == 0) return nullptr; result = a % b; break;
+      case ir::binary_op_t::SDiv: if(sb == 0 || overflow) return nullptr; result = sa / sb; break;
+      case ir::binary_op_t::SRem: if(sb == 0 || overflow) return nullptr; result = sa % sb; break;
+      case ir::binary_op_t::Shl: if(b >= width) return nullptr; result = a << b; break;
+      case ir::binary_op_t::LShr: if(b >= width) return nullptr; result = a >> b; break;
+      case ir::binary_op_t::AShr: if(b >= width) return nullptr; result = sa >> b; break;
+      case ir::binary_op_t::And: result = a & b; break;
+      case ir::binary_op_t::Or: result = a | b; break;
+      case ir::binary_op_t::Xor: result = a ^ b; break;
+      default: return nullptr;
+    }
+    return ir::constant_int::get(ty, trunc_bits(result, width));
+  }
+  auto *flhs = dynamic_cast<ir::constant_fp*>(lhs);
+  auto *frhs = dynamic_cast<ir::constant_fp*>(rhs);
+  if(flhs && frhs && is_foldable_fp(ty)){
+    double a = flhs->get_value();
+    double b = frhs->get_value();
+    double result;
+    switch(op){
+      case ir::binary_op_t::FAdd: result = a + b; break;
+      case ir::binary_op_t::FSub: result = a - b; break;
+      case ir::binary_op_t::FMul: result = a * b; break;
+      case ir::binary_op_t::FDiv: result = a / b; break;
+      case ir::binary_op_t::FRem: result = std::fmod(a, b); break;
+      default: return nullptr;
+    }
+    return ir::constant_fp::get(ty, round_fp(result, ty));
+  }
+  return nullptr;
+}
+
+static ir::constant* fold_cmp(ir::cmp_pred_t pred, ir::constant *lhs, ir::constant *rhs, ir::type *ty) {
+  auto *ilhs = dynamic_cast<ir::constant_int*>(lhs);
+  auto *irhs = dynamic_cast<ir::constant_int*>(rhs);
+  auto *flhs = dynamic_cast<ir::constant_fp*>(lhs);
+  auto *frhs = dynamic_cast<ir::constant_fp*>(rhs);
+  bool result;
+  if(ilhs && irhs){
+    unsigned width = lhs->get_type()->get_integer_bitwidth();
+    uint64_t a = trunc_bits(ilhs->get_value(), width);
+    uint64_t b = trunc_bits(irhs->get_value(), width);
+    int64_t sa = sext_bits(a, width);
+    int64_t sb = sext_bits(b, width);
+    switch(pred){
+      case ir::ICMP_EQ:  result = a == b; break;
+      case ir::ICMP_NE:  result = a != b; break;
+      case ir::ICMP_UGT: result = a > b; break;
+      case ir::ICMP_UGE: result = a >= b; break;
+      case ir::ICMP_ULT: result = a < b; break;
+      case ir::ICMP_ULE: result = a <= b; break;
+      case ir::ICMP_SGT: result = sa > sb; break;
+      case ir::ICMP_SGE: result = sa >= sb; break;
+      case ir::ICMP_SLT: result = sa < sb; break;
+      case ir::ICMP_SLE: result = sa <= sb; break;
+      default: return nullptr;
+    }
+  }
+  else if(flhs && frhs){
+    double a = flhs->get_value();
+    double b = frhs->get_value();
+    bool uno = std::isnan(a) || std::isnan(b);
+    switch(pred){
+      case ir::FCMP_FALSE: result = false; break;
+      case ir::FCMP_OEQ: result = !uno && a == b; break;
+      case ir::FCMP_OGT: result = !uno && a > b; break;
+      case ir::FCMP_OGE: result = !uno && a >= b; break;
+      case ir::FCMP_OLT: result = !uno && a < b; break;
+      case ir::FCMP_OLE: result = !uno && a <= b; break;
+      case ir::FCMP_ONE: result = !uno && a != b; break;
+      case ir::FCMP_ORD: result = !uno; break;
+      case ir::FCMP_UNO: result = uno; break;
+      case ir::FCMP_UEQ: result = uno || a == b; break;
+      case ir::FCMP_UGT: result = uno || a > b; break;
+      case ir::FCMP_UGE: result = uno || a >= b; break;
+      case ir::FCMP_ULT: result = uno || a < b; break;
+      case ir::FCMP_ULE: result = uno || a <= b; break;
+      case ir::FCMP_UNE: result = uno || a != b; break;
+      case ir::FCMP_TRUE: result = true; break;
+      default: return nullptr;
+    }
+  }
+  else
+    return nullptr;
+  return ir::constant_int::get(ty, result);
+}
+
+static ir::constant* fold_cast(ir::cast_op_t op, ir::constant *arg, ir::type *ty) {
+  auto *i = dynamic_cast<ir::constant_int*>(arg);
+  auto *f = dynamic_cast<ir::constant_fp*>(arg);
+  switch(op){
+    case ir::cast_op_t::Trunc:
+      if(!i) return nullptr;
+      return ir::constant_int::get(ty, trunc_bits(i->get_value(), ty->get_integer_bitwidth()));
+    case ir::cast_op_t::ZExt:
+      if(!i) return nullptr;
+      return ir::constant_int::get(ty, trunc_bits(i->get_value(), arg->get_type()->get_integer_bitwidth()));
+    case ir::cast_op_t::SExt:
+      if(!i) return nullptr;
+      return ir::constant_int::get(ty, trunc_bits(sext_bits(i->get_value(), arg->get_type()->get_integer_bitwidth()),
+                                                  ty->get_integer_bitwidth()));
+    case ir::cast_op_t::UIToFP:
+    case ir::cast_op_t::SIToFP: {
+      if(!i) return nullptr;
+      unsigned width = arg->get_type()->get_integer_bitwidth();
+      double x = (op == ir::cast_op_t::SIToFP) ? (double)sext_bits(i->get_value(), width)
+                                               : (double)trunc_bits(i->get_value(), width);
+      // small integers are exact in every floating-point type
+      if(!is_foldable_fp(ty) && std::abs(x) > std::ldexp(1, ty->get_fp_mantissa_width()))
+        return nullptr;
+      return ir::constant_fp::get(ty, round_fp(x, ty));
+    }
+    case ir::cast_op_t::FPToSI:
+    case ir::cast_op_t::FPToUI: {
+      if(!f) return nullptr;
+      double x = std::trunc(f->get_value());
+      double lo = (op == ir::cast_op_t::FPToSI) ? -std::ldexp(1, ty->get_integer_bitwidth() - 1) : 0;
+      double hi = (op == ir::cast_op_t::FPToSI) ? std::ldexp(1, ty->get_integer_bitwidth() - 1)
+                                                : std::ldexp(1, ty->get_integer_bitwidth());
+      if(!(x >= lo && x < hi))
+        return nullptr;
+      uint64_t bits = (op == ir::cast_op_t::FPToSI) ? (uint64_t)(int64_t)x : (uint64_t)x;
+      return ir::constant_int::get(ty, trunc_bits(bits, ty->get_integer_bitwidth()));
+    }
+    case ir::cast_op_t::FPExt:
+      if(!f) return nullptr;
+      return ir::constant_fp::get(ty, f->get_value());
+    case ir::cast_op_t::FPTrunc:
+      if(!f || !is_foldable_fp(ty)) return nullptr;
+      return ir::constant_fp::get(ty, round_fp(f->get_value(), ty));
+    default:
+      return nullptr;
+  }
+}
+
+/* Simplifier */
+// scalar whose splat is v, if any
+ir::value* simplify::get_scalar(ir::value *v) {
+  if(!v->get_type()->is_tile_ty())
+    return v;
+  if(auto *x = dynamic_cast<ir::splat_inst*>(v))
+    return x->get_operand(0);
+  if(dynamic_cast<ir::broadcast_inst*>(v) || dynamic_cast<ir::reshape_inst*>(v))
+    return get_scalar(((ir::instruction*)v)->get_operand(0));
+  return nullptr;
+}
+
+ir::constant* simplify::get_constant(ir::value *v) {
+  ir::value *x = get_scalar(v);
+  if(dynamic_cast<ir::constant_int*>(x) || dynamic_cast<ir::constant_fp*>(x))
+    return (ir::constant*)x;
+  return nullptr;
+}
+
+// every element of v is a multiple of the positive constant m
+bool simplify::is_multiple_of(ir::value *v, ir::value *m) {
+  auto *cm = dynamic_cast<ir::constant_int*>(get_constant(m));
+  if(!cm)
+    return false;
+  int64_t c = sext_bits(cm->get_value(), cm->get_type()->get_integer_bitwidth());
+  if(c <= 0 || c > std::numeric_limits<int>::max())
+    return false;
+  if(auto *cv = dynamic_cast<ir::constant_int*>(get_constant(v)))
+    return sext_bits(cv->get_value(), cv->get_type()->get_integer_bitwidth()) % c == 0;
+  // only the first element of each contiguous run is known to be a
+  // multiple of starting_multiple, so the runs must have length one
+  std::vector<unsigned> sm = align_->starting_multiple(v);
+  std::vector<unsigned> mc = align_->contiguous(v);
+  bool uniform = align_->is_uniform(v);
+  for(size_t d = 0; d < sm.size(); d++)
+    if(sm[d] % c != 0 || (mc[d] > 1 && !uniform))
+      return false;
+  return true;
+}
+
+ir::value* simplify::splat_like(ir::value *v, ir::instruction *i, ir::builder &builder) {
+  if(!i->get_type()->is_tile_ty())
+    return v;
+  builder.set_insert_point(i);
+  return builder.create_splat(v, i->get_type()->get_tile_shapes());
+}
+
+ir::value* simplify::simplify_binop(ir::binary_operator *x, ir::builder &builder) {
+  ir::binary_op_t op = x->get_op();
+  ir::type *ty = x->get_type()->get_scalar_ty();
+  ir::value *lhs = x->get_operand(0);
+  ir::value *rhs = x->get_operand(1);
+  ir::constant *clhs = get_constant(lhs);
+  ir::constant *crhs = get_constant(rhs);
+  // constant folding
+  if(clhs && crhs)
+  if(ir::constant *result = fold_binop(op, clhs, crhs, ty))
+    return splat_like(result, x, builder);
+  // op(splat(a), splat(b)) -> splat(op(a, b))
+  ir::value *slhs = get_scalar(lhs);
+  ir::value *srhs = get_scalar(rhs);
+  if(x->get_type()->is_tile_ty() && slhs && srhs){
+    builder.set_insert_point(x);
+    ir::value *result = builder.insert(ir::binary_operator::create(op, slhs, srhs));
+    return splat_like(result, x, builder);
+  }
+  // algebraic identities
+  ir::value *zero = ty->is_integer_ty() ? ir::constant::get_null_value(ty) : nullptr;
+  switch(op){
+    case ir::binary_op_t::Add:
+      if(crhs && is_zero(crhs)) return lhs;
+      if(clhs && is_zero(clhs)) return rhs;
+      break;
+    case ir::binary_op_t::Sub:
+      if(crhs && is_zero(crhs)) return lhs;
+      if(lhs == rhs) return splat_like(zero, x, builder);
+      break;
+    case ir::binary_op_t::Mul:
+      if(crhs && is_one(crhs)) return lhs;
+      if(clhs && is_one(clhs)) return rhs;
+      if((crhs && is_zero(crhs)) || (clhs && is_zero(clhs)))
+        return splat_like(zero, x, builder);
+      // (a / m) * m -> a when a is a multiple of m
+      if(auto *div = dynamic_cast<ir::binary_operator*>(lhs))
+      if(div->is_int_div() && get_constant(div->get_operand(1)) == crhs
+         && is_multiple_of(div->get_operand(0), rhs))
+        return div->get_operand(0);
+      break;
+    case ir::binary_op_t::UDiv:
+    case ir::binary_op_t::SDiv:
+      if(crhs && is_one(crhs)) return lhs;
+      break;
+    case ir::binary_op_t::URem:
+    case ir::binary_op_t::SRem:
+      if((crhs && is_one(crhs)) || is_multiple_of(lhs, rhs))
+        return splat_like(zero, x, builder);
+      break;
+    case ir::binary_op_t::Shl:
+    case ir::binary_op_t::LShr:
+    case ir::binary_op_t::AShr:
+      if(crhs && is_zero(crhs)) return lhs;
+      break;
+    case ir::binary_op_t::And:
+      if(lhs == rhs) return lhs;
+      if(crhs && is_all_ones(crhs)) return lhs;
+      if(clhs && is_all_ones(clhs)) return rhs;
+      if((crhs && is_zero(crhs)) || (clhs && is_zero(clhs)))
+        return splat_like(zero, x, builder);
+      break;
+    case ir::binary_op_t::Or:
+      if(lhs == rhs) return lhs;
+      if(crhs && is_zero(crhs)) return lhs;
+      if(clhs && is_zero(clhs)) return rhs;
+      if(crhs && is_all_ones(crhs)) return rhs;
+      if(clhs && is_all_ones(clhs)) return lhs;
+      break;
+    case ir::binary_op_t::Xor:
+      if(crhs && is_zero(crhs)) return lhs;
+      if(clhs && is_zero(clhs)) return rhs;
+      if(lhs == rhs) return splat_like(zero, x, builder);
+      break;
+    case ir::binary_op_t::FMul:
+      if(crhs && is_one(crhs)) return lhs;
+      if(clhs && is_one(clhs)) return rhs;
+      break;
+    case ir::binary_op_t::FDiv:
+      if(crhs && is_one(crhs)) return lhs;
+      break;
+    // x + 0.0 is not x when x is -0.0
+    case ir::binary_op_t::FSub:
+      if(crhs && is_zero(crhs) && !std::signbit(((ir::constant_fp*)crhs)->get_value())) return lhs;
+      break;
+    case ir::binary_op_t::FAdd:
+      if(crhs && is_zero(crhs) && std::signbit(((ir::constant_fp*)crhs)->get_value())) return lhs;
+      if(clhs && is_zero(clhs) && std::signbit(((ir::constant_fp*)clhs)->get_value())) return rhs;
+      break;
+    default:
+      break;
+  }
+  return nullptr;
+}
+
+ir::value* simplify::simplify_cmp(ir::cmp_inst *x, ir::builder &builder) {
+  ir::cmp_pred_t pred = x->get_pred();
+  ir::type *ty = x->get_type()->get_scalar_ty();
+  ir::value *lhs = x->get_operand(0);
+  ir::value *rhs = x->get_operand(1);
+  ir::constant *clhs = get_constant(lhs);
+  ir::constant *crhs = get_constant(rhs);
+  if(clhs && crhs)
+  if(ir::constant *result = fold_cmp(pred, clhs, crhs, ty))
+    return splat_like(result, x, builder);
+  if(pred == ir::FCMP_FALSE || pred == ir::FCMP_TRUE)
+    return splat_like(ir::constant_int::get(ty, pred == ir::FCMP_TRUE), x, builder);
+  // integer comparison of a value with itself
+  if(lhs == rhs && x->get_id() == ir::INST_ICMP){
+    bool result = pred == ir::ICMP_EQ || pred == ir::ICMP_UGE || pred == ir::ICMP_ULE ||
+                  pred == ir::ICMP_SGE || pred == ir::ICMP_SLE;
+    return splat_like(ir::constant_int::get(ty, result), x, builder);
+  }
+  ir::value *slhs = get_scalar(lhs);
+  ir::value *srhs = get_scalar(rhs);
+  if(x->get_type()->is_tile_ty() && slhs && srhs){
+    builder.set_insert_point(x);
+    ir::value *result = (x->get_id() == ir::INST_ICMP) ? builder.create_icmp(pred, slhs, srhs)
+                                                       : builder.create_fcmp(pred, slhs, srhs);
+    return splat_like(result, x, builder);
+  }
+  return nullptr;
+}
+
+ir::value* simplify::simplify_cast(ir::cast_inst *x, ir::builder &builder) {
+  ir::value *arg = x->get_operand(0);
+  ir::type *ty = x->get_type()->get_scalar_ty();
+  if(arg->get_type() == x->get_type() && x->get_op() == ir::cast_op_t::BitCast)
+    return arg;
+  if(ir::constant *carg = get_constant(arg))
+  if(ir::constant *result = fold_cast(x->get_op(), carg, ty))
+    return splat_like(result, x, builder);
+  ir::value *sarg = get_scalar(arg);
+  if(x->get_type()->is_tile_ty() && sarg){
+    builder.set_insert_point(x);
+    ir::value *result = builder.create_cast(x->get_op(), sarg, ty);
+    return splat_like(result, x, builder);
+  }
+  return nullptr;
+}
+
+ir::value* simplify::simplify_select(ir::select_inst *x, ir::builder &builder) {
+  ir::value *pred = x->get_pred_op();
+  ir::value *if_value = x->get_if_value_op();
+  ir::value *else_value = x->get_else_value_op();
+  if(if_value == else_value)
+    return if_value;
+  if(auto *cpred = dynamic_cast<ir::constant_int*>(get_constant(pred)))
+    return trunc_bits(cpred->get_value(), 1) ? if_value : else_value;
+  ir::value *spred = get_scalar(pred);
+  ir::value *sif = get_scalar(if_value);
+  ir::value *selse = get_scalar(else_value);
+  if(x->get_type()->is_tile_ty() && spred && sif && selse){
+    builder.set_insert_point(x);
+    ir::value *result = builder.create_select(spred, sif, selse);
+    return splat_like(result, x, builder);
+  }
+  return nullptr;
+}
+
+ir::value* simplify::simplify_retile(ir::instruction *x, ir::builder &builder) {
+  ir::value *arg = x->get_operand(0);
+  if(arg->get_type() == x->get_type())
+    return arg;
+  // retiling a splat is a splat
+  if(ir::value *sarg = get_scalar(arg))
+    return splat_like(sarg, x, builder);
+  // broadcast(broadcast(a)) -> broadcast(a)
+  if(dynamic_cast<ir::broadcast_inst*>(x))
+  if(auto *inner = dynamic_cast<ir::broadcast_inst*>(arg)){
+    builder.set_insert_point(x);
+    return builder.create_broadcast(inner->get_operand(0), x->get_type()->get_tile_shapes());
+  }
+  return nullptr;
+}
+
+ir::value* simplify::simplify_inst(ir::instruction *x, ir::builder &builder) {
+  if(auto *i = dynamic_cast<ir::binary_operator*>(x))
+    return simplify_binop(i, builder);
+  if(auto *i = dynamic_cast<ir::cmp_inst*>(x))
+    return simplify_cmp(i, builder);
+  if(auto *i = dynamic_cast<ir::cast_inst*>(x))
+    return simplify_cast(i, builder);
+  if(auto *i = dynamic_cast<ir::select_inst*>(x))
+    return simplify_select(i, builder);
+  if(dynamic_cast<ir::broadcast_inst*>(x) || dynamic_cast<ir::reshape_inst*>(x))
+    return simplify_retile(x, builder);
+  // gep(p, 0) -> p
+  if(auto *i = dynamic_cast<ir::getelementptr_inst*>(x)){
+    ir::constant *off = get_constant(i->get_operand(1));
+    if(i->get_num_operands() == 2 && off && is_zero(off)
+       && i->get_operand(0)->get_type() == i->get_type())
+      return i->get_operand(0);
+  }
+  return nullptr;
+}
+
+void simplify::run(ir::module &mod) {
+  ir::builder &builder = mod.get_builder();
+  bool changed = true;
+  while(changed){
+    changed = false;
+    // facts for the instructions created by the previous round
+    align_->run(mod);
+    std::vector<ir::instruction*> to_erase;
+    ir::for_each_instruction(mod, [&](ir::instruction *i){
+      ir::value *result = simplify_inst(i, builder);
+      if(!result || result == i)
+        return;
+      i->replace_all_uses_with(result);
+      to_erase.push_back(i);
+      changed = true;
+    });
+    for(ir::instruction *i: to_erase)
+      i->erase_from_parent();
+  }
+}
+
+}
+}
+}
@@ -0,0 +1,137 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "triton/codegen/transform/tile_order.h"
+#include "triton/ir/module.h"
+#include "triton/ir/function.h"
+#include "triton/ir/basic_block.h"
+#include "triton/ir/instructions.h"
+#include "triton/ir/builder.h"
+#include "triton/ir/type.h"
+
+namespace triton {
+namespace codegen{
+namespace transform{
+
+tile_order::tile_order(kind_t kind, unsigned group_size)
+  : kind_(kind), group_size_(group_size ? group_size : 8), log2_group_size_(0) {
+  while((1u << log2_group_size_) < group_size_)
+    log2_group_size_++;
+  bool is_curve = kind_ == MORTON || kind_ == HILBERT;
+  if(is_curve && (1u << log2_group_size_) != group_size_)
+    throw std::runtime_error("group size of a space-filling tile order must be a power of two");
+}
+
+// (x, y) of the `lane`-th point of the curve over a
+// group_size x group_size square
+std::array<ir::value*, 2> tile_order::get_curve_ids(ir::builder &builder, ir::value *lane) {
+  ir::value *zero = builder.get_int32(0);
+  ir::value *one = builder.get_int32(1);
+  ir::value *x = zero;
+  ir::value *y = zero;
+  if(kind_ == MORTON){
+    // de-interleave the bits of `lane`
+    for(unsigned i = 0; i < log2_group_size_; i++){
+      ir::value *bx = builder.create_and(builder.create_lshr(lane, builder.get_int32(2*i)), one);
+      ir::value *by = builder.create_and(builder.create_lshr(lane, builder.get_int32(2*i + 1)), one);
+      x = builder.create_or(x, builder.create_shl(bx, builder.get_int32(i)));
+      y = builder.create_or(y, builder.create_shl(by, builder.get_int32(i)));
+    }
+    return {x, y};
+  }
+  // hilbert: rotate the quadrant at each level
+  ir::value *t = lane;
+  for(unsigned i = 0; i < log2_group_size_; i++){
+    ir::value *s = builder.get_int32(1u << i);
+    ir::value *s_1 = builder.get_int32((1u << i) - 1);
+    ir::value *rx = builder.create_and(builder.create_lshr(t, one), one);
+    ir::value *ry = builder.create_and(builder.create_xor(t, rx), one);
+    ir::value *is_rx = builder.create_icmpEQ(rx, one);
+    ir::value *is_ry = builder.create_icmpEQ(ry, one);
+    ir::value *fx = builder.create_select(is_rx, builder.create_sub(s_1, x), x);
+    ir::value *fy = builder.create_select(is_rx, builder.create_sub(s_1, y), y);
+    ir::value *nx = builder.create_select(is_ry, x, fy);
+    ir::value *ny = builder.create_select(is_ry, y, fx);
+    x = builder.create_add(nx, builder.create_mul(s, rx));
+    y = builder.create_add(ny, builder.create_mul(s, ry));
+    t = builder.create_lshr(t, builder.get_int32(2));
+  }
+  return {x, y};
+}
+
+std::array<ir::value*, 2> tile_order::get_tile_ids(ir::builder &builder, ir::value *idx,
+                                                   ir::value *grid0, ir::value *grid1) {
+  if(kind_ == NONE)
+    return {builder.create_srem(idx, grid0), builder.create_sdiv(idx, grid0)};
+  // band of `group_size` rows (fewer for the last one)
+  ir::value *group_size = builder.get_int32(group_size_);
+  ir::value *band_size = builder.create_mul(group_size, grid1);
+  ir::value *first = builder.create_mul(builder.create_sdiv(idx, band_size), group_size);
+  ir::value *left = builder.create_sub(grid0, first);
+  ir::value *height = builder.create_select(builder.create_icmpSLT(left, group_size), left, group_size);
+  ir::value *rem = builder.create_srem(idx, band_size);
+  ir::value *pid0 = builder.create_srem(rem, height);
+  ir::value *pid1 = builder.create_sdiv(rem, height);
+  if(kind_ != GROUPED){
+    // curve within full squares
+    ir::value *square_size = builder.create_mul(height, group_size);
+    ir::value *col = builder.create_mul(builder.create_sdiv(rem, square_size), group_size);
+    ir::value *lane = builder.create_srem(rem, square_size);
+    std::array<ir::value*, 2> curve = get_curve_ids(builder, lane);
+    ir::value *full_height = builder.create_icmpEQ(height, group_size);
+    ir::value *full_width = builder.create_icmpSLE(builder.create_add(col, group_size), grid1);
+    ir::value *row_ids = builder.create_select(full_width, curve[0], pid0);
+    ir::value *col_ids = builder.create_select(full_width, builder.create_add(col, curve[1]), pid1);
+    pid0 = builder.create_select(full_height, row_ids, pid0);
+    pid1 = builder.create_select(full_height, col_ids, pid1);
+  }
+  return {builder.create_add(first, pid0), pid1};
+}
+
+void tile_order::run(ir::module &mod, ir::function *fn) {
+  ir::builder &builder = mod.get_builder();
+  ir::context &ctx = mod.get_context();
+  // hidden arguments
+  std::array<ir::value*, 3> grid;
+  for(unsigned d = 0; d < 3; d++)
+    grid[d] = fn->add_arg(builder.get_int32_ty(), "__grid" + std::to_string(d));
+  // instructions to rewrite
+  std::vector<ir::get_program_id_inst*> pids;
+  std::vector<ir::get_num_program_inst*> nps;
+  for(ir::basic_block *block: fn->blocks())
+  for(ir::instruction *i: block->get_inst_list()){
+    if(auto *pid = dynamic_cast<ir::get_program_id_inst*>(i))
+      pids.push_back(pid);
+    if(auto *np = dynamic_cast<ir::get_num_program_inst*>(i))
+      nps.push_back(np);
+  }
+  // the launch order of the programs is axis 0 fastest
+  ir::basic_block *body = fn->blocks()[0];
+  ir::basic_block *entry = ir::basic_block::create(ctx, "tile_order.entry", fn);
+  fn->insert_block(entry, body);
+  builder.set_insert_point(entry);
+  ir::value *idx = builder.create_add(builder.create_mul(builder.create_get_program_id(1), grid[0]),
+                                      builder.create_get_program_id(0));
+  std::array<ir::value*, 2> ids = get_tile_ids(builder, idx, grid[0], grid[1]);
+  builder.create_br(body);
+  for(ir::get_program_id_inst *pid: pids){
+    unsigned axis = pid->get_axis();
+    if(axis >= 2)
+      continue;
+    pid->replace_all_uses_with(ids[axis]);
+    pid->erase_from_parent();
+  }
+  for(ir::get_num_program_inst *np: nps){
+    np->replace_all_uses_with(grid.at(np->get_axis()));
+    np->erase_from_parent();
+  }
+}
+
+void tile_order::run(ir::module &mod) {
+  for(ir::function *fn: mod.get_function_list())
+    run(mod, fn);
+}
+
+}
+}
+}
@@ -27,6 +27,7 @@
 #include <memory>
 #include "triton/driver/device.h"
 #include "triton/driver/context.h"
+#include "triton/driver/module.h"
 #include "triton/codegen/target.h"
 
 namespace triton
@@ -111,6 +112,11 @@ size_t cu_device::max_shared_memory() const {
   return cuGetInfo<CU_DEVICE_ATTRIBUTE_MAX_SHARED_MEMORY_PER_BLOCK>();
 }
 
+// number of streaming multiprocessors
+size_t cu_device::multiprocessor_count() const {
+  return cuGetInfo<CU_DEVICE_ATTRIBUTE_MULTIPROCESSOR_COUNT>();
+}
+
 // warp size
 size_t cu_device::warp_size() const {
   return cuGetInfo<CU_DEVICE_ATTRIBUTE_WARP_SIZE>();
@@ -173,7 +179,7 @@ std::string cu_device::infos() const{
 
 // target
 std::unique_ptr<codegen::target> cu_device::make_target() const {
-  return std::unique_ptr<codegen::nvidia_cu_target>(new codegen::nvidia_cu_target(compute_capability()));
+  return std::unique_ptr<codegen::nvidia_cu_target>(new codegen::nvidia_cu_target(compute_capability(), cu_module::ptx_version()));
 }
 
 
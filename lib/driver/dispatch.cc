@@ -151,9 +151,11 @@ CUDA_DEFINE1(CUresult, cuDeviceGetCount, int *)
 CUDA_DEFINE3(CUresult, cuMemcpyHtoD_v2, CUdeviceptr, const void *, size_t )
 CUDA_DEFINE1(CUresult, cuInit, unsigned int)
 CUDA_DEFINE2(CUresult, cuEventRecord, CUevent, CUstream)
+CUDA_DEFINE1(CUresult, cuEventSynchronize, CUevent)
 CUDA_DEFINE3(CUresult, cuCtxCreate_v2, CUcontext *, unsigned int, CUdevice)
 CUDA_DEFINE3(CUresult, cuModuleGetFunction, CUfunction *, CUmodule, const char *)
 CUDA_DEFINE1(CUresult, cuStreamSynchronize, CUstream)
+CUDA_DEFINE3(CUresult, cuStreamWaitEvent, CUstream, CUevent, unsigned int)
 CUDA_DEFINE1(CUresult, cuStreamDestroy_v2, CUstream)
 CUDA_DEFINE2(CUresult, cuStreamGetCtx, CUstream, CUcontext*)
 CUDA_DEFINE1(CUresult, cuEventDestroy_v2, CUevent)
@@ -168,6 +170,7 @@ CUDA_DEFINE1(CUresult, cuCtxPopCurrent_v2, CUcontext*)
 CUDA_DEFINE3(CUresult, cuFuncGetAttribute, int*, CUfunction_attribute, CUfunction)
 CUDA_DEFINE3(CUresult, cuFuncSetAttribute, CUfunction, CUfunction_attribute, int)
 CUDA_DEFINE2(CUresult, cuFuncSetCacheConfig, CUfunction, CUfunc_cache)
+CUDA_DEFINE4(CUresult, cuOccupancyMaxActiveBlocksPerMultiprocessor, int*, CUfunction, int, size_t)
 
 NVML_DEFINE2(nvmlReturn_t, nvmlDeviceGetHandleByPciBusId_v2, const char *, nvmlDevice_t*)
 NVML_DEFINE3(nvmlReturn_t, nvmlDeviceGetClockInfo, nvmlDevice_t, nvmlClockType_t, unsigned int*)
@@ -221,9 +224,11 @@ void* dispatch::cuDeviceGetCount_;
 void* dispatch::cuMemcpyHtoD_v2_;
 void* dispatch::cuInit_;
 void* dispatch::cuEventRecord_;
+void* dispatch::cuEventSynchronize_;
 void* dispatch::cuCtxCreate_v2_;
 void* dispatch::cuModuleGetFunction_;
 void* dispatch::cuStreamSynchronize_;
+void* dispatch::cuStreamWaitEvent_;
 void* dispatch::cuStreamDestroy_v2_;
 void* dispatch::cuStreamGetCtx_;
 void* dispatch::cuEventDestroy_v2_;
@@ -236,6 +241,7 @@ void* dispatch::cuCtxPopCurrent_v2_;
 void* dispatch::cuFuncGetAttribute_;
 void* dispatch::cuFuncSetAttribute_;
 void* dispatch::cuFuncSetCacheConfig_;
+void* dispatch::cuOccupancyMaxActiveBlocksPerMultiprocessor_;
 
 void* dispatch::nvmlInit_v2_;
 void* dispatch::nvmlDeviceGetHandleByPciBusId_v2_;
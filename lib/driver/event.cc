@@ -0,0 +1,97 @@
+/* Copyright 2015-2017 Philippe Tillet
+* 
+* Permission is hereby granted, free of charge, to any person obtaining 
+* a copy of this software and associated documentation files 
+* (the "Software"), to deal in the Software without restriction, 
+* including without limitation the rights to use, copy, modify, merge, 
+* publish, distribute, sublicense, and/or sell copies of the Software, 
+* and to permit persons to whom the Software is furnished to do so, 
+* subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be 
+* included in all copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdexcept>
+#include "triton/driver/event.h"
+
+namespace triton
+{
+
+namespace driver
+{
+
+/* ------------------------ */
+//         Base             //
+/* ------------------------ */
+
+event::event(CUevent cu, bool has_ownership)
+  : polymorphic_resource(cu, has_ownership) {
+}
+
+event::event(host_event_t hst, bool has_ownership)
+  : polymorphic_resource(hst, has_ownership) {
+}
+
+driver::event* event::create(backend_t backend) {
+  switch(backend){
+    case CUDA: return new cu_event();
+    case Host: return new host_event();
+    default: throw std::runtime_error("unknown backend");
+  }
+}
+
+/* ------------------------ */
+//          Host            //
+/* ------------------------ */
+
+host_event::host_event(): event(host_event_t(), true) {
+}
+
+void host_event::synchronize() {
+  // events that were never recorded are complete
+  if(hst_->time.valid())
+    hst_->time.wait();
+}
+
+float host_event::elapsed_time(driver::event* end) {
+  if(end->backend() != Host)
+    throw std::runtime_error("events must belong to the same backend");
+  auto start = hst_->time;
+  auto stop = end->hst()->time;
+  if(!start.valid() || !stop.valid())
+    throw std::runtime_error("event has not been recorded");
+  return std::chrono::duration<float, std::milli>(stop.get() - start.get()).count();
+}
+
+/* ------------------------ */
+//         CUDA             //
+/* ------------------------ */
+
+cu_event::cu_event(): event(CUevent(), true) {
+  dispatch::cuEventCreate(&*cu_, CU_EVENT_DEFAULT);
+}
+
+void cu_event::synchronize() {
+  dispatch::cuEventSynchronize(*cu_);
+}
+
+float cu_event::elapsed_time(driver::event* end) {
+  if(end->backend() != CUDA)
+    throw std::runtime_error("events must belong to the same backend");
+  float ms;
+  dispatch::cuEventElapsedTime(&ms, *cu_, *end->cu());
+  return ms;
+}
+
+}
+
+}
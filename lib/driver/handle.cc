@@ -35,6 +35,7 @@ inline void _delete(host_device_t)   { }
 inline void _delete(host_context_t)  { }
 inline void _delete(host_module_t)   { }
 inline void _delete(host_stream_t)   { }
+inline void _delete(host_event_t)    { }
 inline void _delete(host_buffer_t x)   { if(x.data) delete[] x.data; }
 inline void _delete(host_function_t) { }
 
@@ -73,6 +74,7 @@ template class handle<CUdeviceptr>;
 template class handle<CUstream>;
 template class handle<CUcontext>;
 template class handle<CUdevice>;
+template class handle<CUevent>;
 template class handle<cu_event_t>;
 template class handle<CUfunction>;
 template class handle<CUmodule>;
@@ -83,6 +85,7 @@ template class handle<host_device_t>;
 template class handle<host_context_t>;
 template class handle<host_module_t>;
 template class handle<host_stream_t>;
+template class handle<host_event_t>;
 template class handle<host_buffer_t>;
 template class handle<host_function_t>;
 
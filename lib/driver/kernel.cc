@@ -61,7 +61,9 @@ driver::module* kernel::module() {
 /* ------------------------ */
 
 host_kernel::host_kernel(driver::module* program, const char *name): kernel(program, host_function_t(), true) {
-  hst_->fn = program->hst()->functions.at(name);
+  if(program->hst()->functions.find(name) == program->hst()->functions.end())
+    throw std::runtime_error("unknown host function " + std::string(name));
+  hst_->name = name;
 }
 
 /* ------------------------ */
@@ -19,9 +19,12 @@
 * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
 * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
+#include <cstdio>
 #include <fstream>
 #include <unistd.h>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <regex>
 #include "triton/driver/module.h"
 #include "triton/driver/context.h"
@@ -29,6 +32,7 @@
 #include "triton/tools/sha1.hpp"
 #include "triton/tools/sys/getenv.hpp"
 #include "triton/tools/sys/mkdir.hpp"
+#include "triton/tools/thread_pool.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/IR/IRPrintingPasses.h"
@@ -42,8 +46,15 @@
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
 #include "llvm/IR/LegacyPassManager.h"
-#include "llvm/ExecutionEngine/ExecutionEngine.h"
-#include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/ExecutionEngine/Orc/CompileUtils.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Transforms/Utils/Cloning.h"
 
 std::string exec(const char* cmd) {
@@ -89,10 +100,10 @@ module::module(host_module_t mod, bool has_ownership)
 }
 
 
-module* module::create(driver::device* device, std::unique_ptr<llvm::Module> src) {
+module* module::create(driver::device* device, std::unique_ptr<llvm::Module> src, bool load) {
   switch(device->backend()){
     case CUDA: return new cu_module(device, std::move(src));
-    case Host: return new host_module(std::move(src));
+    case Host: return new host_module(std::move(src), load);
     default: throw std::runtime_error("unknown backend");
   }
 }
@@ -110,7 +121,209 @@ void module::compile_llvm_module(std::unique_ptr<llvm::Module> module, const std
 //        Host              //
 /* ------------------------ */
 
-host_module::host_module(std::unique_ptr<llvm::Module> src): module(host_module_t(), true) {
+// Object files of host modules, cached on disk under the
+// identifier of the module (the hash of its LLVM-IR)
+class host_object_cache: public llvm::ObjectCache {
+public:
+  host_object_cache(const std::string& path): path_(path) { }
+  void notifyObjectCompiled(const llvm::Module* module, llvm::MemoryBufferRef obj) override;
+  std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module* module) override;
+
+private:
+  std::string path_;
+};
+
+void host_object_cache::notifyObjectCompiled(const llvm::Module* module, llvm::MemoryBufferRef obj) {
+  if(path_.empty())
+    return;
+  // rename is atomic, so concurrent processes
+  // never read partially written objects
+  std::string path = path_ + "/" + module->getModuleIdentifier() + ".o";
+  std::string tmp = path + "." + std::to_string(getpid()) + "." +
+                    std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+  std::ofstream ofs(tmp, std::ios::binary);
+  ofs.write(obj.getBufferStart(), obj.getBufferSize());
+  ofs.close();
+  if(!ofs || std::rename(tmp.c_str(), path.c_str()) != 0)
+    std::remove(tmp.c_str());
+}
+
+std::unique_ptr<llvm::MemoryBuffer> host_object_cache::getObject(const llvm::Module* module) {
+  if(path_.empty())
+    return nullptr;
+  auto cached = llvm::MemoryBuffer::getFile(path_ + "/" + module->getModuleIdentifier() + ".o");
+  if(!cached)
+    return nullptr;
+  return std::move(*cached);
+}
+
+// JIT shared by all host modules. Modules are compiled
+// concurrently on a thread pool by the compile layer of
+// the JIT, which goes through the object cache. Each
+// module is linked under its own resource tracker, and
+// unlinked once the last lease on a module that uses it
+// is dropped
+class host_jit {
+  typedef host_module_t::entry_t entry_t;
+
+  struct entry_info {
+    std::shared_future<entry_t> fn;
+    llvm::orc::ResourceTrackerSP tracker;
+    size_t refs;
+  };
+
+  host_jit();
+  std::unique_ptr<llvm::Module> parse(const std::string& key, const std::string& bitcode, llvm::LLVMContext& ctx);
+  std::unique_ptr<llvm::MemoryBuffer> compile(llvm::Module& module, llvm::orc::JITTargetMachineBuilder jtmb, llvm::ObjectCache* cache);
+  entry_t load(const std::string& key, const std::string& bitcode, llvm::orc::ResourceTrackerSP tracker);
+
+public:
+  static host_jit& get();
+  std::string key(const std::string& llir);
+  std::unique_ptr<llvm::MemoryBuffer> object(const std::string& key, const std::string& bitcode);
+  std::unique_ptr<llvm::MemoryBuffer> object(const std::string& bitcode, const std::string& cpu, const std::string& features);
+  std::shared_future<entry_t> add(const std::string& key, const std::string& bitcode);
+  void release(const std::string& key);
+
+private:
+  llvm::orc::JITTargetMachineBuilder jtmb_;
+  host_object_cache cache_;
+  std::unique_ptr<llvm::orc::LLJIT> jit_;
+  std::mutex jit_mutex_;
+  std::mutex entries_mutex_;
+  std::map<std::string, entry_info> entries_;
+  ThreadPool pool_;
+};
+
+host_jit::host_jit()
+  : jtmb_(llvm::cantFail(llvm::orc::JITTargetMachineBuilder::detectHost())),
+    cache_(context::get_cache_path()),
+    pool_(std::max(1u, std::thread::hardware_concurrency())) {
+  jtmb_.setCodeGenOptLevel(llvm::CodeGenOpt::Aggressive);
+  // modules are compiled by the threads that look them up,
+  // so the compiler must not share a target machine
+  auto compiler = [this](llvm::orc::JITTargetMachineBuilder jtmb)
+      -> llvm::Expected<std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
+    return std::make_unique<llvm::orc::ConcurrentIRCompiler>(std::move(jtmb), &cache_);
+  };
+  jit_ = llvm::cantFail(llvm::orc::LLJITBuilder().setJITTargetMachineBuilder(jtmb_)
+                                                 .setCompileFunctionCreator(compiler)
+                                                 .create());
+  // math functions are resolved against the host process
+  char prefix = jit_->getDataLayout().getGlobalPrefix();
+  jit_->getMainJITDylib().addGenerator(llvm::cantFail(
+      llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(prefix)));
+}
+
+host_jit& host_jit::get() {
+  // never destroyed, as kernels may still be
+  // referenced during static destruction
+  static host_jit* jit = new host_jit();
+  return *jit;
+}
+
+std::string host_jit::key(const std::string& llir) {
+  // object files are only valid for the host and
+  // LLVM version that produced them
+  std::string src = llir + jtmb_.getTargetTriple().str() + jtmb_.getCPU()
+                  + jtmb_.getFeatures().getString() + LLVM_VERSION_STRING;
+  unsigned char hash[20];
+  sha1::calc((void*)src.data(), src.size(), hash);
+  char hex[41];
+  sha1::toHexString(hash, hex);
+  return std::string(hex, hex + 40);
+}
+
+std::shared_future<host_jit::entry_t> host_jit::add(const std::string& key, const std::string& bitcode) {
+  std::lock_guard<std::mutex> lock(entries_mutex_);
+  auto it = entries_.find(key);
+  if(it != entries_.end()){
+    it->second.refs++;
+    return it->second.fn;
+  }
+  llvm::orc::ResourceTrackerSP tracker = jit_->getMainJITDylib().createResourceTracker();
+  auto res = pool_.enqueue([this, key, bitcode, tracker]() { return load(key, bitcode, tracker); }).share();
+  entries_.insert({key, {res, tracker, 1}});
+  return res;
+}
+
+void host_jit::release(const std::string& key) {
+  // the entry stays registered until its object is unlinked,
+  // so that the same key is never linked twice at once
+  std::lock_guard<std::mutex> lock(entries_mutex_);
+  auto it = entries_.find(key);
+  if(it == entries_.end() || --it->second.refs > 0)
+    return;
+  // the object may still be compiling
+  it->second.fn.wait();
+  {
+    std::lock_guard<std::mutex> jit_lock(jit_mutex_);
+    llvm::consumeError(it->second.tracker->remove());
+  }
+  entries_.erase(it);
+}
+
+// the identifier of the module is its key in the object cache
+std::unique_ptr<llvm::Module> host_jit::parse(const std::string& key, const std::string& bitcode, llvm::LLVMContext& ctx) {
+  auto module = llvm::parseBitcodeFile(llvm::MemoryBufferRef(bitcode, key), ctx);
+  if(!module)
+    throw std::runtime_error(llvm::toString(module.takeError()));
+  (*module)->setModuleIdentifier(key);
+  return std::move(*module);
+}
+
+std::unique_ptr<llvm::MemoryBuffer> host_jit::compile(llvm::Module& module, llvm::orc::JITTargetMachineBuilder jtmb,
+                                                      llvm::ObjectCache* cache) {
+  auto machine = jtmb.createTargetMachine();
+  if(!machine)
+    throw std::runtime_error(llvm::toString(machine.takeError()));
+  module.setDataLayout((*machine)->createDataLayout());
+  module.setTargetTriple((*machine)->getTargetTriple().str());
+  auto obj = llvm::orc::SimpleCompiler(**machine, cache)(module);
+  if(!obj)
+    throw std::runtime_error(llvm::toString(obj.takeError()));
+  return std::move(*obj);
+}
+
+// same object as linked by the JIT, through the same cache
+std::unique_ptr<llvm::MemoryBuffer> host_jit::object(const std::string& key, const std::string& bitcode) {
+  llvm::LLVMContext ctx;
+  std::unique_ptr<llvm::Module> module = parse(key, bitcode, ctx);
+  return compile(*module, jtmb_, &cache_);
+}
+
+// objects for other CPUs of the host architecture are
+// not cached. they are meant to be linked ahead of time,
+// possibly into position-independent executables
+std::unique_ptr<llvm::MemoryBuffer> host_jit::object(const std::string& bitcode, const std::string& cpu, const std::string& features) {
+  llvm::orc::JITTargetMachineBuilder jtmb = jtmb_;
+  jtmb.setCPU(cpu);
+  jtmb.setFeatures(features);
+  jtmb.setRelocationModel(llvm::Reloc::PIC_);
+  llvm::LLVMContext ctx;
+  std::unique_ptr<llvm::Module> module = parse("aot", bitcode, ctx);
+  return compile(*module, jtmb, nullptr);
+}
+
+host_jit::entry_t host_jit::load(const std::string& key, const std::string& bitcode,
+                                 llvm::orc::ResourceTrackerSP tracker) {
+  auto ctx = std::make_unique<llvm::LLVMContext>();
+  std::unique_ptr<llvm::Module> module = parse(key, bitcode, *ctx);
+  {
+    std::lock_guard<std::mutex> lock(jit_mutex_);
+    llvm::orc::ThreadSafeModule tsm(std::move(module), std::move(ctx));
+    if(llvm::Error err = jit_->addIRModule(tracker, std::move(tsm)))
+      throw std::runtime_error(llvm::toString(std::move(err)));
+  }
+  // compiles the module, unless its object is cached
+  auto sym = jit_->lookup("_main_" + key);
+  if(!sym)
+    throw std::runtime_error(llvm::toString(sym.takeError()));
+  return (entry_t)sym->getAddress();
+}
+
+
+host_module::host_module(std::unique_ptr<llvm::Module> src, bool load): module(host_module_t(), true) {
   init_llvm();
   // create kernel wrapper
   llvm::LLVMContext &ctx = src->getContext();
@@ -157,34 +370,46 @@ host_module::host_module(std::unique_ptr<llvm::Module> src): module(host_module_
 //  pm.add(llvm::createVerifierPass());
 //  pm.run(*src);
 
-//   create execution engine
   for(llvm::Function& fn: src->functions())
-    hst_->functions[fn.getName().str()] = &fn;
-
-//  llvm::orc::JITTargetMachineBuilder JTMB = *llvm::orc::JITTargetMachineBuilder::detectHost();
-//  auto DL = JTMB.getDefaultDataLayoutForTarget();
-//  auto CIRC = std::unique_ptr<llvm::orc::ConcurrentIRCompiler>(new llvm::orc::ConcurrentIRCompiler(JTMB));
-//  hst_->ES = new llvm::orc::ExecutionSession();
-//  hst_->ObjectLayer = new llvm::orc::RTDyldObjectLinkingLayer(*hst_->ES, []() { return std::unique_ptr<llvm::SectionMemoryManager>(new llvm::SectionMemoryManager()); });
-//  hst_->CompileLayer = new llvm::orc::IRCompileLayer(*hst_->ES, *hst_->ObjectLayer, *CIRC);
-//  hst_->DL = new llvm::DataLayout(std::move(*DL));
-//  hst_->Mangle = new llvm::orc::MangleAndInterner(*hst_->ES, *hst_->DL);
-//  hst_->Ctx = new llvm::orc::ThreadSafeContext(std::unique_ptr<llvm::LLVMContext>(new llvm::LLVMContext()));
-//  hst_->MainJD =  &hst_->ES->createJITDylib("<main>");
-//  hst_->MainJD->setGenerator(llvm::cantFail(llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
-//                                            hst_->DL->getGlobalPrefix())));
-//  llvm::cantFail(hst_->CompileLayer->add(*hst_->MainJD, llvm::orc::ThreadSafeModule(std::move(src), *hst_->Ctx)));
-//  hst_->fn = (void(*)(char**, int32_t, int32_t, int32_t))(hst_->ES->lookup({hst_->MainJD}, (*hst_->Mangle)("_main"))->getAddress());
-
-
-
-  llvm::EngineBuilder builder(std::move(src));
-  builder.setErrorStr(&hst_->error);
-  builder.setMCJITMemoryManager(std::make_unique<llvm::SectionMemoryManager>());
-  builder.setOptLevel(llvm::CodeGenOpt::Aggressive);
-  builder.setEngineKind(llvm::EngineKind::JIT);
-  hst_->engine = builder.create();
-  hst_->fn = (void(*)(char**, int32_t, int32_t, int32_t))(hst_->engine->getFunctionAddress("_main"));
+    hst_->functions.insert(fn.getName().str());
+  // the printed IR identifies the module, both in-process
+  // and in the on-disk object cache
+  std::string llir;
+  llvm::raw_string_ostream oss(llir);
+  oss << *src;
+  oss.flush();
+  // definitions of all modules live in the same JITDylib,
+  // so only the (uniquely named) entry point is exported
+  key_ = host_jit::get().key(llir);
+  for(llvm::Function& fn: src->functions())
+    if(!fn.isDeclaration() && &fn != main)
+      fn.setLinkage(llvm::GlobalValue::InternalLinkage);
+  for(llvm::GlobalVariable& gv: src->globals())
+    if(!gv.isDeclaration())
+      gv.setLinkage(llvm::GlobalValue::InternalLinkage);
+  main->setName("_main_" + key_);
+  // the context of the module does not outlive
+  // the caller, so it is handed over as bitcode
+  llvm::raw_string_ostream bc(bitcode_);
+  llvm::WriteBitcodeToFile(*src, bc);
+  bc.flush();
+  if(!load)
+    return;
+  // compilation is asynchronous; the entry point is
+  // resolved the first time the module is launched
+  hst_->fn = host_jit::get().add(key_, bitcode_);
+  std::string key = key_;
+  hst_->lease = std::shared_ptr<void>(nullptr, [key](void*) { host_jit::get().release(key); });
+}
+
+std::string host_module::entry() const {
+  return "_main_" + key_;
+}
+
+std::string host_module::object(const std::string& cpu, const std::string& features) const {
+  std::unique_ptr<llvm::MemoryBuffer> obj = cpu.empty() ? host_jit::get().object(key_, bitcode_)
+                                                        : host_jit::get().object(bitcode_, cpu, features);
+  return obj->getBuffer().str();
 }
 
 std::unique_ptr<buffer> host_module::symbol(const char *name) const {
@@ -212,6 +437,15 @@ static std::map<int, int> vptx = {
   {11020, 72}
 };
 
+int cu_module::ptx_version() {
+  int version;
+  dispatch::cuDriverGetVersion(&version);
+  int major = version / 1000;
+  if(major < 10)
+    throw std::runtime_error("Triton requires CUDA 10+");
+  return vptx.at(version);
+}
+
 std::string cu_module::compile_llvm_module(std::unique_ptr<llvm::Module> module, driver::device* device) {
   // LLVM version in use may not officially support target hardware
   int max_nvvm_cc = 75;
@@ -224,15 +458,8 @@ std::string cu_module::compile_llvm_module(std::unique_ptr<llvm::Module> module,
   // compute capability
   int cc = ((driver::cu_device*)device)->compute_capability();
   std::string sm = "sm_" + std::to_string(cc);
-  // driver version
-  int version;
-  dispatch::cuDriverGetVersion(&version);
-  int major = version / 1000;
-  int minor = (version - major*1000) / 10;
-  if(major < 10)
-    throw std::runtime_error("Triton requires CUDA 10+");
   // PTX version
-  int ptx = vptx.at(version);
+  int ptx = ptx_version();
   int ptx_major = ptx / 10;
   int ptx_minor = ptx % 10;
   // create
@@ -0,0 +1,200 @@
+/* Copyright 2015-2017 Philippe Tillet
+* 
+* Permission is hereby granted, free of charge, to any person obtaining 
+* a copy of this software and associated documentation files 
+* (the "Software"), to deal in the Software without restriction, 
+* including without limitation the rights to use, copy, modify, merge, 
+* publish, distribute, sublicense, and/or sell copies of the Software, 
+* and to permit persons to whom the Software is furnished to do so, 
+* subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be 
+* included in all copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include "triton/driver/profiler.h"
+
+namespace triton
+{
+
+namespace driver
+{
+
+namespace {
+
+std::string escape(const std::string& str) {
+  std::string ret;
+  for(char c: str){
+    if(c == '"' || c == '\\')
+      ret += '\\';
+    ret += c;
+  }
+  return ret;
+}
+
+// the trace format expects microseconds
+double us(int64_t ns) {
+  return ns * 1e-3;
+}
+
+}
+
+host_profiler::host_profiler(): epoch_(clock::now()) {
+}
+
+int64_t host_profiler::now() const {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - epoch_).count();
+}
+
+size_t host_profiler::stream_id(const void* stream) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = streams_.find(stream);
+  if(it == streams_.end())
+    it = streams_.insert({stream, streams_.size()}).first;
+  return it->second;
+}
+
+void host_profiler::record(launch_t&& launch) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  launches_.push_back(std::move(launch));
+}
+
+std::vector<host_profiler::launch_t> host_profiler::launches() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return launches_;
+}
+
+void host_profiler::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  launches_.clear();
+}
+
+host_profiler::launch_stats_t host_profiler::stats(const launch_t& launch) {
+  launch_stats_t ret;
+  ret.queue_delay = launch.start - launch.enqueued;
+  ret.duration = launch.end - launch.start;
+  ret.min = 0;
+  ret.max = 0;
+  ret.mean = 0;
+  ret.imbalance = 1;
+  ret.workers.resize(launch.num_threads, worker_stats_t{0, 0, 0});
+  if(launch.programs.empty())
+    return ret;
+  ret.min = std::numeric_limits<int64_t>::max();
+  for(const program_t& p: launch.programs){
+    int64_t dur = p.end - p.start;
+    ret.min = std::min(ret.min, dur);
+    ret.max = std::max(ret.max, dur);
+    ret.mean += dur;
+    size_t bucket = 0;
+    while(bucket < 63 && (int64_t(2) << bucket) <= dur)
+      bucket++;
+    if(ret.histogram.size() <= bucket)
+      ret.histogram.resize(bucket + 1, 0);
+    ret.histogram[bucket]++;
+    worker_stats_t& w = ret.workers.at(p.worker);
+    w.num_programs++;
+    w.busy += dur;
+  }
+  ret.mean /= launch.programs.size();
+  int64_t max_busy = 0;
+  double mean_busy = 0;
+  for(worker_stats_t& w: ret.workers){
+    w.idle = ret.duration - w.busy;
+    max_busy = std::max(max_busy, w.busy);
+    mean_busy += w.busy;
+  }
+  mean_busy /= ret.workers.size();
+  if(mean_busy > 0)
+    ret.imbalance = max_busy / mean_busy;
+  return ret;
+}
+
+std::string host_profiler::chrome_trace() const {
+  std::vector<launch_t> launches = this->launches();
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(3);
+  oss << "{\"traceEvents\":[";
+  bool first = true;
+  auto event = [&]() -> std::ostringstream& {
+    oss << (first ? "\n" : ",\n");
+    first = false;
+    return oss;
+  };
+  // one process per stream: thread 0 is the in-order
+  // worker, thread i + 1 is the i-th program worker
+  std::map<size_t, size_t> num_threads;
+  for(const launch_t& l: launches)
+    num_threads[l.stream] = std::max(num_threads[l.stream], l.num_threads);
+  for(const auto& x: num_threads){
+    event() << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << x.first
+            << ",\"args\":{\"name\":\"host stream " << x.first << "\"}}";
+    event() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << x.first
+            << ",\"tid\":0,\"args\":{\"name\":\"launches\"}}";
+    for(size_t i = 0; i < x.second; i++)
+      event() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << x.first
+              << ",\"tid\":" << i + 1 << ",\"args\":{\"name\":\"worker " << i << "\"}}";
+  }
+  for(const launch_t& l: launches){
+    std::string name = escape(l.name);
+    launch_stats_t s = stats(l);
+    event() << "{\"name\":\"" << name << "\",\"cat\":\"launch\",\"ph\":\"X\""
+            << ",\"pid\":" << l.stream << ",\"tid\":0"
+            << ",\"ts\":" << us(l.start) << ",\"dur\":" << us(s.duration)
+            << ",\"args\":{\"grid\":[" << l.grid[0] << "," << l.grid[1] << "," << l.grid[2] << "]"
+            << ",\"queue_delay_us\":" << us(s.queue_delay)
+            << ",\"imbalance\":" << s.imbalance << "}}";
+    for(const program_t& p: l.programs)
+      event() << "{\"name\":\"" << name << "\",\"cat\":\"program\",\"ph\":\"X\""
+              << ",\"pid\":" << l.stream << ",\"tid\":" << p.worker + 1
+              << ",\"ts\":" << us(p.start) << ",\"dur\":" << us(p.end - p.start)
+              << ",\"args\":{\"id\":[" << p.id[0] << "," << p.id[1] << "," << p.id[2] << "]}}";
+  }
+  oss << "\n],\"displayTimeUnit\":\"ns\"}\n";
+  return oss.str();
+}
+
+std::string host_profiler::json() const {
+  std::vector<launch_t> launches = this->launches();
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(3);
+  oss << "{\"launches\":[";
+  for(size_t i = 0; i < launches.size(); i++){
+    const launch_t& l = launches[i];
+    launch_stats_t s = stats(l);
+    oss << (i ? ",\n" : "\n");
+    oss << "{\"name\":\"" << escape(l.name) << "\",\"stream\":" << l.stream
+        << ",\"grid\":[" << l.grid[0] << "," << l.grid[1] << "," << l.grid[2] << "]"
+        << ",\"num_threads\":" << l.num_threads
+        << ",\"enqueued_ns\":" << l.enqueued << ",\"start_ns\":" << l.start << ",\"end_ns\":" << l.end
+        << ",\"queue_delay_ns\":" << s.queue_delay << ",\"duration_ns\":" << s.duration
+        << ",\"programs\":{\"count\":" << l.programs.size()
+        << ",\"min_ns\":" << s.min << ",\"mean_ns\":" << s.mean << ",\"max_ns\":" << s.max
+        << ",\"histogram_log2_ns\":[";
+    for(size_t b = 0; b < s.histogram.size(); b++)
+      oss << (b ? "," : "") << s.histogram[b];
+    oss << "]},\"workers\":[";
+    for(size_t w = 0; w < s.workers.size(); w++)
+      oss << (w ? "," : "") << "{\"programs\":" << s.workers[w].num_programs
+          << ",\"busy_ns\":" << s.workers[w].busy << ",\"idle_ns\":" << s.workers[w].idle << "}";
+    oss << "],\"imbalance\":" << s.imbalance << "}";
+  }
+  oss << "\n]}\n";
+  return oss.str();
+}
+
+}
+
+}
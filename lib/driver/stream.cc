@@ -22,15 +22,17 @@
 
 #include <cassert>
 #include <unistd.h>
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstring>
 #include "triton/driver/backend.h"
 #include "triton/driver/stream.h"
 #include "triton/driver/context.h"
 #include "triton/driver/device.h"
 #include "triton/driver/kernel.h"
 #include "triton/driver/buffer.h"
-#include "llvm/ExecutionEngine/ExecutionEngine.h"
-#include "llvm/ExecutionEngine/GenericValue.h"
+#include "triton/driver/event.h"
 
 namespace triton
 {
@@ -64,35 +66,138 @@ driver::stream* stream::create(backend_t backend) {
 //          Host            //
 /* ------------------------ */
 
-host_stream::host_stream(): stream(host_stream_t(), true) {
+host_stream::host_stream(size_t num_threads): stream(host_stream_t(), true) {
+  if(num_threads == 0)
+    throw std::runtime_error("host stream needs at least one thread");
+  // a single worker executes operations in order
   hst_->pool.reset(new ThreadPool(1));
   hst_->futures.reset(new std::vector<std::future<void>>());
+  hst_->num_threads = num_threads;
+  if(num_threads > 1)
+    hst_->workers.reset(new ThreadPool(num_threads));
+}
+
+size_t host_stream::num_threads() const {
+  return hst_->num_threads;
+}
+
+void host_stream::set_profiler(std::shared_ptr<host_profiler> profiler) {
+  hst_->profiler = profiler;
 }
 
 void host_stream::synchronize() {
-  for(auto& x: *hst_->futures)
+  std::vector<std::future<void>> futures;
+  std::swap(futures, *hst_->futures);
+  for(auto& x: futures)
     x.wait();
-  hst_->futures->clear();
-  hst_->args.clear();
+  // rethrow errors of asynchronous operations
+  for(auto& x: futures)
+    x.get();
 }
 
 void host_stream::enqueue(driver::kernel* kernel, std::array<size_t, 3> grid, std::array<size_t, 3> block, void* args, size_t args_size, size_t) {
-  auto hst = kernel->module()->hst();
-  hst_->futures->reserve(hst_->futures->size() + grid[0]*grid[1]*grid[2]);
-  char* params = new char[args_size];
-  std::memcpy((void*)params, (void*)args, args_size);
-  for(size_t i = 0; i < grid[0]; i++)
-    for(size_t j = 0; j < grid[1]; j++)
-      for(size_t k = 0; k < grid[2]; k++)
-        hst_->futures->emplace_back(hst_->pool->enqueue(hst->fn, (char**)params, int32_t(i), int32_t(j), int32_t(k)));
+  if(!kernel->module()->hst()->fn.valid())
+    throw std::runtime_error("host module was not loaded");
+  // waits for the module to be compiled. the lease keeps its
+  // code linked until the launch has run, even if the kernel
+  // is destroyed in the meantime
+  auto fn = kernel->module()->hst()->fn.get();
+  std::shared_ptr<void> lease = kernel->module()->hst()->lease;
+  std::shared_ptr<char> params(new char[args_size], std::default_delete<char[]>());
+  std::memcpy((void*)params.get(), args, args_size);
+  std::shared_ptr<ThreadPool> workers = hst_->workers;
+  size_t num_threads = hst_->num_threads;
+  std::shared_ptr<host_profiler> profiler = hst_->profiler;
+  std::shared_ptr<host_profiler::launch_t> launch;
+  if(profiler){
+    launch.reset(new host_profiler::launch_t());
+    launch->name = kernel->hst()->name;
+    launch->stream = profiler->stream_id(this);
+    launch->grid = grid;
+    launch->num_threads = workers ? num_threads : 1;
+    launch->enqueued = profiler->now();
+  }
+  hst_->futures->push_back(hst_->pool->enqueue([fn, lease, params, grid, workers, num_threads, profiler, launch]() {
+    size_t num_programs = grid[0]*grid[1]*grid[2];
+    if(launch){
+      launch->start = profiler->now();
+      launch->programs.resize(num_programs);
+    }
+    auto run = [fn, params, grid, profiler, launch](size_t pid, size_t worker) {
+      int32_t i = pid % grid[0];
+      int32_t j = pid / grid[0] % grid[1];
+      int32_t k = pid / grid[0] / grid[1];
+      if(!launch)
+        return fn((char**)params.get(), i, j, k);
+      // programs are distinct, so they can be written without locking
+      host_profiler::program_t& p = launch->programs[pid];
+      p.id = {i, j, k};
+      p.worker = worker;
+      p.start = profiler->now();
+      fn((char**)params.get(), i, j, k);
+      p.end = profiler->now();
+    };
+    if(!workers || num_programs <= 1){
+      for(size_t pid = 0; pid < num_programs; pid++)
+        run(pid, 0);
+    }
+    else{
+      // programs are handed out dynamically since their
+      // cost can vary (e.g., masked tails)
+      auto next = std::make_shared<std::atomic<size_t>>(0);
+      std::vector<std::future<void>> done;
+      for(size_t t = 0; t < std::min(num_threads, num_programs); t++)
+        done.push_back(workers->enqueue([run, next, num_programs, t]() {
+          for(size_t pid = (*next)++; pid < num_programs; pid = (*next)++)
+            run(pid, t);
+        }));
+      for(auto& x: done)
+        x.wait();
+      for(auto& x: done)
+        x.get();
+    }
+    if(launch){
+      launch->end = profiler->now();
+      profiler->record(std::move(*launch));
+    }
+  }));
 }
 
 void host_stream::write(driver::buffer* buffer, bool blocking, std::size_t offset, std::size_t size, void const* ptr) {
-  std::memcpy((void*)buffer->hst()->data, ptr, size);
+  char* dst = buffer->hst()->data + offset;
+  auto done = hst_->pool->enqueue([dst, ptr, size]() { std::memcpy((void*)dst, ptr, size); });
+  if(blocking)
+    done.get();
+  else
+    hst_->futures->push_back(std::move(done));
 }
 
 void host_stream::read(driver::buffer* buffer, bool blocking, std::size_t offset, std::size_t size, void* ptr) {
-  std::memcpy(ptr, (const void*)buffer->hst()->data, size);
+  const char* src = buffer->hst()->data + offset;
+  auto done = hst_->pool->enqueue([src, ptr, size]() { std::memcpy(ptr, (const void*)src, size); });
+  if(blocking)
+    done.get();
+  else
+    hst_->futures->push_back(std::move(done));
+}
+
+void host_stream::record(driver::event* ev) {
+  typedef std::chrono::high_resolution_clock clock;
+  if(ev->backend() != Host)
+    throw std::runtime_error("event must belong to the host backend");
+  auto time = std::make_shared<std::promise<clock::time_point>>();
+  ev->hst()->time = time->get_future().share();
+  hst_->futures->push_back(hst_->pool->enqueue([time]() { time->set_value(clock::now()); }));
+}
+
+void host_stream::wait(driver::event* ev) {
+  if(ev->backend() != Host)
+    throw std::runtime_error("event must belong to the host backend");
+  auto time = ev->hst()->time;
+  // events that were never recorded are complete
+  if(!time.valid())
+    return;
+  hst_->futures->push_back(hst_->pool->enqueue([time]() { time.wait(); }));
 }
 
 
@@ -136,6 +241,18 @@ void cu_stream::read(driver::buffer* buffer, bool blocking, std::size_t offset,
     dispatch::cuMemcpyDtoHAsync(ptr, *buffer->cu() + offset, size, *cu_);
 }
 
+void cu_stream::record(driver::event* ev) {
+  if(ev->backend() != CUDA)
+    throw std::runtime_error("event must belong to the CUDA backend");
+  dispatch::cuEventRecord(*ev->cu(), *cu_);
+}
+
+void cu_stream::wait(driver::event* ev) {
+  if(ev->backend() != CUDA)
+    throw std::runtime_error("event must belong to the CUDA backend");
+  dispatch::cuStreamWaitEvent(*cu_, *ev->cu(), 0);
+}
+
 
 }
 
@@ -75,6 +75,9 @@ type *builder::get_int64_ty()
 type *builder::get_half_ty()
 { return type::get_half_ty(ctx_); }
 
+type *builder::get_bf16_ty()
+{ return type::get_bf16_ty(ctx_); }
+
 type *builder::get_float_ty()
 { return type::get_float_ty(ctx_); }
 
@@ -281,6 +284,10 @@ value *builder::create_masked_store(value *ptr, value *val, value *mask, const s
   return insert(masked_store_inst::create(ptr, val, mask, name));
 }
 
+value *builder::create_prefetch(value *ptr, const std::string &name){
+  return insert(prefetch_inst::create(ptr, name));
+}
+
 //===----------------------------------------------------------------------===//
 //                               tile instructions
 //===----------------------------------------------------------------------===//
@@ -321,8 +328,8 @@ value *builder::create_atomic_exch(value *ptr, value *val, const std::string &na
   return insert(atomic_exch_inst::create(ptr, val, name));
 }
 
-value *builder::create_atomic_add(value *ptr, value *val, value *msk, const std::string &name){
-  return insert(atomic_add_inst::create(ptr, val, msk, name));
+value *builder::create_atomic_rmw(atomic_rmw_inst::op_t op, value *ptr, value *val, value *msk, const std::string &name){
+  return insert(atomic_rmw_inst::create(op, ptr, val, msk, name));
 }
 
 value *builder::create_exp(value *arg, const std::string &name){
@@ -345,6 +352,10 @@ value *builder::create_sqrt(value *A, const std::string &name) {
   return insert(sqrt_inst::create(A, name));
 }
 
+value *builder::create_math(math_inst::op_t op, value *arg, const std::string &name) {
+  return insert(math_inst::create(arg, op, name));
+}
+
 value *builder::create_reduce(value *A, reduce_inst::op_t op, unsigned axis, const std::string &name) {
   return insert(reduce_inst::create(A, op, axis, name));
 }
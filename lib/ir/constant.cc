@@ -1,4 +1,6 @@
 #include <cassert>
+#include <limits>
+#include <sstream>
 #include "triton/ir/constant.h"
 #include "triton/ir/type.h"
 #include "triton/ir/context.h"
@@ -17,6 +19,8 @@ constant *constant::get_null_value(type *ty) {
     return constant_int::get(ty, 0);
   case type::HalfTyID:
     return constant_fp::get(type::get_half_ty(ctx), 0);
+  case type::BF16TyID:
+    return constant_fp::get(type::get_bf16_ty(ctx), 0);
   case type::FloatTyID:
     return constant_fp::get(type::get_float_ty(ctx), 0);
   case type::DoubleTyID:
@@ -78,6 +82,14 @@ constant *constant_fp::get(type *ty, double v){
   return result;
 }
 
+std::string constant_fp::repr() const {
+  // enough digits for the value to survive a round-trip through text
+  std::ostringstream oss;
+  oss.precision(std::numeric_limits<double>::max_digits10);
+  oss << value_;
+  return oss.str();
+}
+
 
 // undef value
 undef_value::undef_value(type *ty)
@@ -13,6 +13,7 @@ context_impl::context_impl(context &ctx)
     : void_ty(ctx, type::VoidTyID),
       label_ty(ctx, type::LabelTyID),
       half_ty(ctx, type::HalfTyID),
+      bf16_ty(ctx, type::BF16TyID),
       float_ty(ctx, type::FloatTyID),
       double_ty(ctx, type::DoubleTyID),
       int1_ty(ctx, 1),
@@ -35,9 +35,6 @@ function::function(function_type *ty, linkage_types_t linkage,
                    const std::string &name, module *parent)
     : global_object(ty, 0, linkage, name), parent_(parent), fn_ty_(ty) {
   unsigned num_params = fn_ty_->get_num_params();
-  // skip if no parameter
-  if(num_params == 0)
-    return;
   // create arguments
   args_.resize(num_params);
   for(unsigned i = 0; i < num_params; i++){
@@ -48,8 +45,19 @@ function::function(function_type *ty, linkage_types_t linkage,
     parent->push_function(this);
 }
 
+argument* function::add_arg(type *ty, const std::string &name) {
+  std::vector<type*> param_tys(fn_ty_->params_begin(), fn_ty_->params_end());
+  param_tys.push_back(ty);
+  fn_ty_ = function_type::get(fn_ty_->get_return_ty(), param_tys);
+  ty_ = pointer_type::get(fn_ty_, 0);
+  argument *arg = argument::create(ty, name, this, args_.size());
+  args_.push_back(arg);
+  return arg;
+}
+
 /* basic block */
 void function::insert_block(basic_block *block, basic_block *next) {
+  blocks_.erase(std::remove(blocks_.begin(), blocks_.end(), block), blocks_.end());
   auto it = std::find(blocks_.begin(), blocks_.end(), next);
   blocks_.insert(it, block);
 }
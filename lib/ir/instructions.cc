@@ -171,7 +171,7 @@ binary_operator *binary_operator::create(binary_op_t op, value *lhs, value *rhs,
 // cmp_inst
 std::string cmp_inst::repr_impl() const {
   switch (pred_) {
-    case FCMP_FALSE :  return "false";
+    case FCMP_FALSE :  return "fcmp_false";
     case FCMP_OEQ   :  return "fcmp_oeq";
     case FCMP_OGT   :  return "fcmp_ogt";
     case FCMP_OGE   :  return "fcmp_oge";
@@ -186,7 +186,7 @@ std::string cmp_inst::repr_impl() const {
     case FCMP_ULT   :  return "fcmp_ult";
     case FCMP_ULE   :  return "fcmp_ule";
     case FCMP_UNE   :  return "fcmp_une";
-    case FCMP_TRUE  :  return "true";
+    case FCMP_TRUE  :  return "fcmp_true";
     case ICMP_EQ    :  return "icmp_eq";
     case ICMP_NE    :  return "icmp_ne";
     case ICMP_UGT   :  return "icmp_ugt";
@@ -483,17 +483,46 @@ masked_load_async_inst* masked_load_async_inst::create(value *ptr, value *mask,
   return new masked_load_async_inst(ptr, mask, false_value, name, next);
 }
 
-// atomic add
+// prefetch
+prefetch_inst::prefetch_inst(value *ptr, const std::string &name, instruction *next)
+  : io_inst(type::get_void_ty(ptr->get_type()->get_context()), INST_PREFETCH, 1, name, next) {
+  set_operand(0, ptr);
+}
+
+prefetch_inst* prefetch_inst::create(value *ptr, const std::string &name, instruction *next) {
+  return new prefetch_inst(ptr, name, next);
+}
 
-atomic_add_inst::atomic_add_inst(value *ptr, value *val, value *msk, const std::string &name, instruction *next)
-  : io_inst(ptr->get_type()->get_pointer_element_ty(), INST_ATOMIC_ADD, 3, name, next) {
+// atomic read-modify-write
+std::string atomic_rmw_inst::to_str(op_t op) {
+  switch (op) {
+    case ADD: return "add";
+    case FADD: return "fadd";
+    case MAX: return "max";
+    case MIN: return "min";
+    case UMAX: return "umax";
+    case UMIN: return "umin";
+    case FMAX: return "fmax";
+    case FMIN: return "fmin";
+    case XCHG: return "xchg";
+    case AND: return "and";
+    case OR: return "or";
+    default: break;
+  }
+  assert(false);
+  return "";
+}
+
+atomic_rmw_inst::atomic_rmw_inst(op_t op, value *ptr, value *val, value *msk, const std::string &name, instruction *next)
+  : io_inst(ptr->get_type()->get_pointer_element_ty(), INST_ATOMIC_RMW, 3, name, next),
+    op_(op) {
   set_operand(0, ptr);
   set_operand(1, val);
   set_operand(2, msk);
 }
 
-instruction* atomic_add_inst::create(value *ptr, value *val, value *msk, const std::string &name, instruction *next) {
-  return new atomic_add_inst(ptr, val, msk, name, next);
+instruction* atomic_rmw_inst::create(op_t op, value *ptr, value *val, value *msk, const std::string &name, instruction *next) {
+  return new atomic_rmw_inst(op, ptr, val, msk, name, next);
 }
 
 // store
@@ -648,6 +677,13 @@ const std::vector<int> trans_inst::get_perm() const {
   return perm_;
 }
 
+std::string trans_inst::repr_impl() const {
+  std::string res = "trans(";
+  for(size_t i = 0; i < perm_.size(); i++)
+    res += (i > 0 ? ", " : "") + std::to_string(perm_[i]);
+  return res + ")";
+}
+
 //===----------------------------------------------------------------------===//
 //                               sqrt instructions
 //===----------------------------------------------------------------------===//
@@ -661,18 +697,46 @@ instruction* sqrt_inst::create(value *arg, const std::string &name, instruction
   return new sqrt_inst(arg, name, next);
 }
 
+//===----------------------------------------------------------------------===//
+//                               math instructions
+//===----------------------------------------------------------------------===//
+
+std::string math_inst::to_str(op_t op) {
+  switch (op) {
+    case TANH: return "tanh";
+    case ERF: return "erf";
+    case SIGMOID: return "sigmoid";
+    case SIN: return "sin";
+    case COS: return "cos";
+    case RSQRT: return "rsqrt";
+    default: break;
+  }
+  assert(false);
+  return "";
+}
+
+math_inst::math_inst(value *arg, op_t op, const std::string &name, instruction *next)
+  : builtin_inst(arg->get_type(), INST_MATH, 1, name, next),
+    op_(op) {
+  set_operand(0, arg);
+}
+
+instruction* math_inst::create(value *arg, op_t op, const std::string &name, instruction *next) {
+  return new math_inst(arg, op, name, next);
+}
+
 //===----------------------------------------------------------------------===//
 //                               reduce instructions
 //===----------------------------------------------------------------------===//
 
 std::string reduce_inst::to_str(op_t op) {
   switch (op) {
-    case ADD: return "+";
-    case SUB: return "-";
-    case MAX: return "imax";
-    case MIN: return "imin";
-    case FADD: return "+";
-    case FSUB: return "-";
+    case ADD: return "add";
+    case SUB: return "sub";
+    case MAX: return "max";
+    case MIN: return "min";
+    case FADD: return "fadd";
+    case FSUB: return "fsub";
     case FMAX: return "fmax";
     case FMIN: return "fmin";
     default: break;
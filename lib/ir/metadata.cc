@@ -1,3 +1,4 @@
+#include <stdexcept>
 #include "triton/ir/metadata.h"
 
 namespace triton{
@@ -10,5 +11,12 @@ metadata* metadata::get(kind_t kind, unsigned value) {
   return new metadata(kind, value);
 }
 
+std::string metadata::repr(kind_t kind) {
+  switch(kind){
+    case multiple_of: return "multiple_of";
+    default: throw std::runtime_error("unknown metadata kind");
+  }
+}
+
 }
 }
@@ -0,0 +1,701 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <stdexcept>
+#include "triton/ir/basic_block.h"
+#include "triton/ir/module.h"
+#include "triton/ir/type.h"
+#include "triton/ir/constant.h"
+#include "triton/ir/function.h"
+#include "triton/ir/instructions.h"
+#include "triton/ir/parser.h"
+
+namespace triton{
+namespace ir{
+
+//===----------------------------------------------------------------------===//
+//                               loader class
+//===----------------------------------------------------------------------===//
+
+static const std::map<std::string, binary_op_t> binary_ops = {
+  {"add", Add}, {"fadd", FAdd}, {"sub", Sub}, {"fsub", FSub},
+  {"mul", Mul}, {"fmul", FMul}, {"udiv", UDiv}, {"sdiv", SDiv},
+  {"fdiv", FDiv}, {"urem", URem}, {"srem", SRem}, {"frem", FRem},
+  {"shl", Shl}, {"lshr", LShr}, {"ashr", AShr},
+  {"and", And}, {"or", Or}, {"xor", Xor}
+};
+
+static const std::map<std::string, cast_op_t> cast_ops = {
+  {"trunc", Trunc}, {"zext", ZExt}, {"sext", SExt},
+  {"fp_trunc", FPTrunc}, {"fp_ext", FPExt},
+  {"ui_to_fp", UIToFP}, {"si_to_fp", SIToFP},
+  {"fp_to_ui", FPToUI}, {"fp_to_si", FPToSI},
+  {"ptr_to_int", PtrToInt}, {"int_to_ptr", IntToPtr},
+  {"bitcast", BitCast}, {"addr_space_cast", AddrSpaceCast}
+};
+
+static const std::map<std::string, cmp_pred_t> cmp_preds = {
+  {"fcmp_false", FCMP_FALSE}, {"fcmp_oeq", FCMP_OEQ}, {"fcmp_ogt", FCMP_OGT},
+  {"fcmp_oge", FCMP_OGE}, {"fcmp_olt", FCMP_OLT}, {"fcmp_ole", FCMP_OLE},
+  {"fcmp_one", FCMP_ONE}, {"fcmp_ord", FCMP_ORD}, {"fcmp_uno", FCMP_UNO},
+  {"fcmp_ueq", FCMP_UEQ}, {"fcmp_ugt", FCMP_UGT}, {"fcmp_uge", FCMP_UGE},
+  {"fcmp_ult", FCMP_ULT}, {"fcmp_ule", FCMP_ULE}, {"fcmp_une", FCMP_UNE},
+  {"fcmp_true", FCMP_TRUE},
+  {"icmp_eq", ICMP_EQ}, {"icmp_ne", ICMP_NE},
+  {"icmp_ugt", ICMP_UGT}, {"icmp_uge", ICMP_UGE},
+  {"icmp_ult", ICMP_ULT}, {"icmp_ule", ICMP_ULE},
+  {"icmp_sgt", ICMP_SGT}, {"icmp_sge", ICMP_SGE},
+  {"icmp_slt", ICMP_SLT}, {"icmp_sle", ICMP_SLE}
+};
+
+// numbered values are unnamed in the original IR
+static bool is_number(const std::string &name) {
+  if(name.empty())
+    return false;
+  for(char c: name)
+    if(!std::isdigit(c))
+      return false;
+  return true;
+}
+
+// splits e.g., "reduce(fadd, 0)" into "reduce" and {"fadd", "0"}
+static void split_repr(const std::string &repr, std::string &mnemonic, std::vector<std::string> &args) {
+  size_t open = repr.find_first_of("([");
+  mnemonic = repr.substr(0, open);
+  args.clear();
+  if(open == std::string::npos)
+    return;
+  std::string current;
+  for(size_t i = open + 1; i < repr.size(); i++){
+    char c = repr[i];
+    if(c == ',' || c == ':' || c == ')' || c == ']'){
+      if(!current.empty())
+        args.push_back(current);
+      current.clear();
+    }
+    else if(!std::isspace(c))
+      current += c;
+  }
+}
+
+static basic_block* as_block(value *v) {
+  if(auto *block = dynamic_cast<basic_block*>(v))
+    return block;
+  throw std::runtime_error("expected a basic block operand");
+}
+
+loader::loader(module &mod)
+  : mod_(mod), fn_(nullptr) { }
+
+void loader::add_global(type *elt_ty, const std::string &name, unsigned size) {
+  constant_int *cst = constant_int::get(type::get_int32_ty(mod_.get_context()), size);
+  alloc_const *alloc = new alloc_const(elt_ty, cst, is_number(name) ? "" : name);
+  mod_.add_alloc(alloc);
+  globals_[name] = alloc;
+}
+
+void loader::begin_function(const std::string &name, function_type *ty,
+                            const std::vector<std::string> &arg_names,
+                            const std::vector<std::vector<attribute>> &arg_attrs) {
+  if(arg_names.size() != ty->get_num_params() || arg_attrs.size() != arg_names.size())
+    throw std::runtime_error("argument list of " + name + " does not match its type");
+  fn_ = mod_.get_or_insert_function(name, ty);
+  values_.clear();
+  blocks_.clear();
+  defs_.clear();
+  ranges_.clear();
+  records_.clear();
+  for(size_t i = 0; i < arg_names.size(); i++){
+    argument *arg = fn_->args()[i];
+    if(!is_number(arg_names[i]))
+      arg->set_name(arg_names[i]);
+    values_[arg_names[i]] = arg;
+    for(attribute attr: arg_attrs[i])
+      fn_->add_attr(i + 1, attr);
+  }
+}
+
+void loader::add_block(const std::string &name) {
+  if(!fn_)
+    throw std::runtime_error("basic block " + name + " outside of a function");
+  if(blocks_.find(name) != blocks_.end())
+    throw std::runtime_error("redefinition of basic block " + name);
+  blocks_[name] = basic_block::create(mod_.get_context(), is_number(name) ? "" : name, fn_);
+}
+
+void loader::add_inst(const inst_t &inst) {
+  if(!fn_ || fn_->blocks().empty())
+    throw std::runtime_error("instruction outside of a basic block");
+  if(!inst.name.empty()){
+    if(defs_.find(inst.name) != defs_.end() || values_.find(inst.name) != values_.end())
+      throw std::runtime_error("redefinition of %" + inst.name);
+    defs_[inst.name] = records_.size();
+  }
+  records_.push_back(record_t{inst, fn_->blocks().back(), nullptr, false});
+}
+
+void loader::end_function() {
+  // create instructions in dependency order
+  for(record_t &rec: records_)
+    materialize(rec);
+  // insert them in textual order
+  for(record_t &rec: records_){
+    instruction *inst = rec.inst;
+    inst->set_parent(rec.block);
+    rec.block->get_inst_list().push_back(inst);
+    // phi nodes may reference values defined later in the function
+    if(auto *phi = dynamic_cast<phi_node*>(inst)){
+      const std::vector<operand_t> &ops = rec.desc.ops;
+      if(ops.size() % 2 != 0)
+        throw std::runtime_error("malformed phi node %" + rec.desc.name);
+      for(size_t n = 0; n < ops.size(); n += 2)
+        phi->add_incoming(get_operand(ops[n]), as_block(get_operand(ops[n + 1])));
+    }
+    // control flow
+    if(auto *br = dynamic_cast<uncond_branch_inst*>(inst))
+      br->get_dest()->add_predecessor(rec.block);
+    if(auto *br = dynamic_cast<cond_branch_inst*>(inst)){
+      br->get_true_dest()->add_predecessor(rec.block);
+      br->get_false_dest()->add_predecessor(rec.block);
+    }
+  }
+  fn_ = nullptr;
+}
+
+value *loader::get_value(const std::string &name) {
+  auto it = values_.find(name);
+  if(it != values_.end())
+    return it->second;
+  auto def = defs_.find(name);
+  if(def == defs_.end())
+    throw std::runtime_error("use of undefined value %" + name);
+  return values_[name] = materialize(records_[def->second]);
+}
+
+basic_block *loader::get_block(const std::string &name) {
+  auto it = blocks_.find(name);
+  if(it == blocks_.end())
+    throw std::runtime_error("use of undefined basic block " + name);
+  return it->second;
+}
+
+value *loader::get_operand(const operand_t &op) {
+  switch(op.kind){
+    case operand_t::VALUE: return get_value(op.name);
+    case operand_t::BLOCK: return get_block(op.name);
+    case operand_t::GLOBAL: {
+      auto it = globals_.find(op.name);
+      if(it == globals_.end())
+        throw std::runtime_error("use of undefined global @" + op.name);
+      return it->second;
+    }
+    case operand_t::CONSTANT:
+      if(op.ty->get_scalar_ty()->is_floating_point_ty())
+        return constant_fp::get(op.ty, op.fval);
+      return constant_int::get(op.ty, op.ival);
+    case operand_t::UNDEF: return undef_value::get(op.ty);
+    case operand_t::RANGE: {
+      value *&range = ranges_[op.ty];
+      if(!range){
+        type *elt_ty = op.ty->get_scalar_ty();
+        unsigned size = op.ty->get_tile_shapes().at(0);
+        range = make_range_sta::get(make_range::create(constant_int::get(elt_ty, 0),
+                                                       constant_int::get(elt_ty, size)));
+      }
+      return range;
+    }
+    default: throw std::runtime_error("unreachable");
+  }
+}
+
+instruction *loader::materialize(record_t &rec) {
+  if(rec.inst)
+    return rec.inst;
+  if(rec.visiting)
+    throw std::runtime_error("cyclic definition of %" + rec.desc.name);
+  rec.visiting = true;
+  std::vector<value*> ops;
+  // incoming values of phi nodes are only resolved once all
+  // instructions exist
+  if(rec.desc.repr != "phi")
+    for(const operand_t &op: rec.desc.ops)
+      ops.push_back(get_operand(op));
+  instruction *inst = create(rec.desc, ops);
+  if(inst->get_type() != rec.desc.ty)
+    throw std::runtime_error("type mismatch: " + rec.desc.repr + " returns " + inst->get_type()->repr()
+                             + ", not " + rec.desc.ty->repr());
+  if(!is_number(rec.desc.name))
+    inst->set_name(rec.desc.name);
+  for(auto md: rec.desc.metadatas)
+    inst->set_metadata(md.first, md.second);
+  rec.visiting = false;
+  return rec.inst = inst;
+}
+
+instruction *loader::create(const inst_t &desc, const std::vector<value*> &ops) {
+  context &ctx = mod_.get_context();
+  std::string mnemonic;
+  std::vector<std::string> args;
+  split_repr(desc.repr, mnemonic, args);
+  auto expect = [&](size_t num_ops, size_t num_args) {
+    if(ops.size() != num_ops || args.size() != num_args)
+      throw std::runtime_error("wrong number of operands for " + desc.repr);
+  };
+  auto arg = [&](size_t i) { return std::stoi(args.at(i)); };
+  // generic instructions
+  if(mnemonic == "phi")
+    return phi_node::create(desc.ty, desc.ops.size() / 2);
+  if(binary_ops.count(mnemonic)){
+    expect(2, 0);
+    return binary_operator::create(binary_ops.at(mnemonic), ops[0], ops[1]);
+  }
+  if(cmp_preds.count(mnemonic)){
+    expect(2, 0);
+    cmp_pred_t pred = cmp_preds.at(mnemonic);
+    if(mnemonic.compare(0, 5, "icmp_") == 0)
+      return icmp_inst::create(pred, ops[0], ops[1]);
+    return fcmp_inst::create(pred, ops[0], ops[1]);
+  }
+  if(cast_ops.count(mnemonic)){
+    expect(1, 0);
+    return cast_inst::create(cast_ops.at(mnemonic), ops[0], desc.ty);
+  }
+  if(mnemonic == "ret")
+    return return_inst::create(ctx, ops.empty() ? nullptr : ops[0]);
+  if(mnemonic == "br" && ops.size() == 1)
+    return branch_inst::create(as_block(ops[0]));
+  if(mnemonic == "br"){
+    expect(3, 0);
+    return branch_inst::create(ops[2], as_block(ops[0]), as_block(ops[1]));
+  }
+  if(mnemonic == "getelementptr" && !ops.empty())
+    return getelementptr_inst::create(ops[0], std::vector<value*>(ops.begin() + 1, ops.end()));
+  // memory
+  if(mnemonic == "unmasked_load"){
+    expect(1, 0);
+    return unmasked_load_inst::create(ops[0]);
+  }
+  if(mnemonic == "masked_load"){
+    expect(3, 0);
+    return masked_load_inst::create(ops[0], ops[1], ops[2]);
+  }
+  if(mnemonic == "masked_load_async"){
+    expect(3, 0);
+    return masked_load_async_inst::create(ops[0], ops[1], ops[2]);
+  }
+  if(mnemonic == "unmasked_store"){
+    expect(2, 0);
+    return unmasked_store_inst::create(ops[0], ops[1]);
+  }
+  if(mnemonic == "masked_store"){
+    expect(3, 0);
+    return masked_store_inst::create(ops[0], ops[1], ops[2]);
+  }
+  if(mnemonic == "prefetch"){
+    expect(1, 0);
+    return prefetch_inst::create(ops[0]);
+  }
+  if(mnemonic == "atomic_rmw"){
+    expect(3, 1);
+    for(int op = atomic_rmw_inst::ADD; op <= atomic_rmw_inst::OR; op++)
+      if(atomic_rmw_inst::to_str((atomic_rmw_inst::op_t)op) == args[0])
+        return atomic_rmw_inst::create((atomic_rmw_inst::op_t)op, ops[0], ops[1], ops[2]);
+    throw std::runtime_error("unknown atomic operation " + args[0]);
+  }
+  if(mnemonic == "atomic_cas"){
+    expect(3, 0);
+    return atomic_cas_inst::create(ops[0], ops[1], ops[2]);
+  }
+  if(mnemonic == "atomic_exch"){
+    expect(2, 0);
+    return atomic_exch_inst::create(ops[0], ops[1]);
+  }
+  // retiling
+  if(mnemonic == "reshape"){
+    expect(1, 0);
+    return reshape_inst::create(ops[0], desc.ty->get_tile_shapes());
+  }
+  if(mnemonic == "splat"){
+    expect(1, 0);
+    return splat_inst::create(ops[0], desc.ty->get_tile_shapes());
+  }
+  if(mnemonic == "broadcast"){
+    expect(1, 0);
+    return broadcast_inst::create(ops[0], desc.ty->get_tile_shapes());
+  }
+  if(mnemonic == "downcast"){
+    expect(1, 0);
+    return downcast_inst::create(ops[0]);
+  }
+  // builtins
+  if(mnemonic == "get_program_id"){
+    expect(0, 1);
+    return get_program_id_inst::create(ctx, arg(0));
+  }
+  if(mnemonic == "get_num_program"){
+    expect(0, 1);
+    return get_num_program_inst::create(ctx, arg(0));
+  }
+  if(mnemonic == "exp"){
+    expect(1, 0);
+    return exp_inst::create(ops[0]);
+  }
+  if(mnemonic == "log"){
+    expect(1, 0);
+    return log_inst::create(ops[0]);
+  }
+  if(mnemonic == "sqrt"){
+    expect(1, 0);
+    return sqrt_inst::create(ops[0]);
+  }
+  if(mnemonic == "dot"){
+    expect(3, 0);
+    return dot_inst::create_nn(ops[0], ops[1], ops[2]);
+  }
+  if(mnemonic == "trans" && ops.size() == 1){
+    std::vector<int> perm;
+    for(size_t i = 0; i < args.size(); i++)
+      perm.push_back(arg(i));
+    return trans_inst::create(ops[0], perm);
+  }
+  if(mnemonic == "math"){
+    expect(1, 1);
+    for(int op = math_inst::TANH; op <= math_inst::RSQRT; op++)
+      if(math_inst::to_str((math_inst::op_t)op) == args[0])
+        return math_inst::create(ops[0], (math_inst::op_t)op);
+    throw std::runtime_error("unknown math function " + args[0]);
+  }
+  if(mnemonic == "reduce"){
+    expect(1, 2);
+    for(int op = reduce_inst::ADD; op <= reduce_inst::FMIN; op++)
+      if(reduce_inst::to_str((reduce_inst::op_t)op) == args[0])
+        return reduce_inst::create(ops[0], (reduce_inst::op_t)op, arg(1));
+    throw std::runtime_error("unknown reduction " + args[0]);
+  }
+  if(mnemonic == "select"){
+    expect(3, 0);
+    return select_inst::create(ops[0], ops[1], ops[2]);
+  }
+  // intrinsics
+  if(mnemonic == "copy_to_shared"){
+    expect(1, 0);
+    return copy_to_shared_inst::create(ops[0]);
+  }
+  if(mnemonic == "copy_from_shared"){
+    expect(1, 0);
+    return copy_from_shared_inst::create(ops[0]);
+  }
+  if(mnemonic == "recoalesce_inst"){
+    expect(1, 0);
+    return recoalesce_inst::create(ops[0]);
+  }
+  if(mnemonic == "barrier"){
+    expect(0, 0);
+    return barrier_inst::create(ctx);
+  }
+  if(mnemonic == "async_wait_group"){
+    expect(0, 1);
+    return async_wait_inst::create(ctx, arg(0));
+  }
+  if(mnemonic == "nv_dynamic_program_idx"){
+    expect(0, 0);
+    return make_range_dyn::create(desc.ty);
+  }
+  if(mnemonic == "make_range"){
+    expect(0, 2);
+    type *elt_ty = desc.ty->get_scalar_ty();
+    return make_range::create(constant_int::get(elt_ty, arg(0)), constant_int::get(elt_ty, arg(1)));
+  }
+  throw std::runtime_error("unknown instruction " + desc.repr);
+}
+
+//===----------------------------------------------------------------------===//
+//                               textual parser
+//===----------------------------------------------------------------------===//
+
+class lexer {
+public:
+  lexer(std::istream &is);
+  const std::string &peek(size_t k = 0) const;
+  std::string next();
+  bool accept(const std::string &tok);
+  void expect(const std::string &tok);
+  unsigned next_unsigned();
+  void error(const std::string &msg) const;
+
+private:
+  std::vector<std::string> toks_;
+  std::vector<unsigned> lines_;
+  size_t pos_;
+};
+
+lexer::lexer(std::istream &is): pos_(0) {
+  static const std::string punct = "()[]<>{},:=*";
+  unsigned line = 1;
+  char c;
+  while(is.get(c)){
+    if(c == '\n')
+      line++;
+    else if(std::isspace(c))
+      continue;
+    // ';' ends statements and starts comments
+    else if(c == ';'){
+      toks_.push_back(";");
+      lines_.push_back(line);
+      while(is.peek() != EOF && is.peek() != '\n')
+        is.get(c);
+    }
+    else if(punct.find(c) != std::string::npos){
+      toks_.push_back(std::string(1, c));
+      lines_.push_back(line);
+    }
+    else{
+      std::string word(1, c);
+      while(is.peek() != EOF){
+        char d = is.peek();
+        if(std::isspace(d) || d == ';' || punct.find(d) != std::string::npos)
+          break;
+        word += (char)is.get();
+      }
+      toks_.push_back(word);
+      lines_.push_back(line);
+    }
+  }
+}
+
+const std::string &lexer::peek(size_t k) const {
+  static const std::string eof = "";
+  return pos_ + k < toks_.size() ? toks_[pos_ + k] : eof;
+}
+
+std::string lexer::next() {
+  if(pos_ >= toks_.size())
+    error("unexpected end of input");
+  return toks_[pos_++];
+}
+
+bool lexer::accept(const std::string &tok) {
+  if(peek() != tok)
+    return false;
+  pos_++;
+  return true;
+}
+
+void lexer::expect(const std::string &tok) {
+  if(!accept(tok))
+    error("expected '" + tok + "', got '" + peek() + "'");
+}
+
+unsigned lexer::next_unsigned() {
+  std::string tok = next();
+  if(!is_number(tok))
+    error("expected an integer, got '" + tok + "'");
+  return std::stoul(tok);
+}
+
+void lexer::error(const std::string &msg) const {
+  if(lines_.empty())
+    throw std::runtime_error(msg);
+  size_t i = std::min(pos_, lines_.size() - 1);
+  throw std::runtime_error("line " + std::to_string(lines_[i]) + ": " + msg);
+}
+
+static type* parse_type(lexer &lex, context &ctx) {
+  std::string tok = lex.next();
+  type *ty = nullptr;
+  if(tok == "void")       ty = type::get_void_ty(ctx);
+  else if(tok == "label") ty = type::get_label_ty(ctx);
+  else if(tok == "f16")   ty = type::get_half_ty(ctx);
+  else if(tok == "bf16")  ty = type::get_bf16_ty(ctx);
+  else if(tok == "f32")   ty = type::get_float_ty(ctx);
+  else if(tok == "f64")   ty = type::get_double_ty(ctx);
+  else if(tok.size() > 1 && tok[0] == 'i' && is_number(tok.substr(1)))
+    ty = integer_type::get(ctx, std::stoul(tok.substr(1)));
+  else
+    lex.error("unknown type '" + tok + "'");
+  // pointers
+  while(true){
+    unsigned addr_space = 0;
+    if(lex.accept("addrspace")){
+      lex.expect("(");
+      addr_space = lex.next_unsigned();
+      lex.expect(")");
+      lex.expect("*");
+    }
+    else if(!lex.accept("*"))
+      break;
+    ty = pointer_type::get(ty, addr_space);
+  }
+  // tiles
+  if(lex.accept("<")){
+    type::tile_shapes_t shapes;
+    do
+      shapes.push_back(lex.next_unsigned());
+    while(lex.accept(","));
+    lex.expect(">");
+    ty = tile_type::get(ty, shapes);
+  }
+  return ty;
+}
+
+static std::string strip(lexer &lex, const std::string &tok, char prefix) {
+  if(tok.size() < 2 || tok[0] != prefix)
+    lex.error("expected a name starting with '" + std::string(1, prefix) + "', got '" + tok + "'");
+  return tok.substr(1);
+}
+
+static attribute parse_attribute(lexer &lex) {
+  std::string tok = lex.next();
+  if(tok == ".readonly")  return attribute(readonly);
+  if(tok == ".writeonly") return attribute(writeonly);
+  if(tok == ".noalias")   return attribute(noalias);
+  if(tok == ".retune")    return attribute(retune);
+  attribute_kind_t kind = not_implemented;
+  if(tok == ".aligned")          kind = aligned;
+  else if(tok == ".multiple_of") kind = multiple_of;
+  else lex.error("unknown attribute '" + tok + "'");
+  lex.expect("(");
+  unsigned value = lex.next_unsigned();
+  lex.expect(")");
+  return attribute(kind, value);
+}
+
+static loader::operand_t parse_operand(lexer &lex, context &ctx) {
+  loader::operand_t op{loader::operand_t::VALUE, "", nullptr, 0, 0};
+  const std::string &tok = lex.peek();
+  if(tok.size() > 1 && tok[0] == '%')
+    op.name = strip(lex, lex.next(), '%');
+  else if(tok.size() > 1 && tok[0] == '@'){
+    op.kind = loader::operand_t::GLOBAL;
+    op.name = strip(lex, lex.next(), '@');
+  }
+  else if(lex.accept("label")){
+    op.kind = loader::operand_t::BLOCK;
+    op.name = lex.next();
+  }
+  else{
+    op.ty = parse_type(lex, ctx);
+    std::string literal = lex.next();
+    if(literal == "undef")
+      op.kind = loader::operand_t::UNDEF;
+    else if(literal == "make_range_sta")
+      op.kind = loader::operand_t::RANGE;
+    else{
+      op.kind = loader::operand_t::CONSTANT;
+      char *end;
+      if(op.ty->get_scalar_ty()->is_floating_point_ty())
+        op.fval = std::strtod(literal.c_str(), &end);
+      else if(literal[0] == '-')
+        op.ival = (uint64_t)std::strtoll(literal.c_str(), &end, 10);
+      else
+        op.ival = std::strtoull(literal.c_str(), &end, 10);
+      if(literal.empty() || *end != '\0')
+        lex.error("invalid constant '" + literal + "'");
+    }
+  }
+  return op;
+}
+
+static void parse_inst(lexer &lex, context &ctx, loader &ld) {
+  loader::inst_t inst;
+  if(lex.peek(1) == "="){
+    inst.name = strip(lex, lex.next(), '%');
+    lex.expect("=");
+  }
+  // mnemonic and its parameters, e.g. reduce(fadd, 0) or make_range[0 : 128]
+  inst.repr = lex.next();
+  if(lex.peek() == "(" || lex.peek() == "["){
+    std::string close = lex.peek() == "(" ? ")" : "]";
+    inst.repr += lex.next();
+    while(!lex.accept(close)){
+      std::string tok = lex.next();
+      inst.repr += tok == "," ? ", " : tok == ":" ? " : " : tok;
+    }
+    inst.repr += close;
+  }
+  inst.ty = parse_type(lex, ctx);
+  // operands
+  bool has_ops = lex.peek() != ";" && lex.peek()[0] != '!';
+  while(has_ops){
+    if(lex.accept("[")){
+      inst.ops.push_back(parse_operand(lex, ctx));
+      lex.expect(",");
+      inst.ops.push_back(parse_operand(lex, ctx));
+      lex.expect("]");
+    }
+    else
+      inst.ops.push_back(parse_operand(lex, ctx));
+    has_ops = lex.accept(",");
+  }
+  // metadata
+  while(lex.peek()[0] == '!'){
+    std::string name = strip(lex, lex.next(), '!');
+    if(name != metadata::repr(metadata::multiple_of))
+      lex.error("unknown metadata '" + name + "'");
+    lex.expect("(");
+    inst.metadatas.push_back({metadata::multiple_of, lex.next_unsigned()});
+    lex.expect(")");
+  }
+  lex.expect(";");
+  ld.add_inst(inst);
+}
+
+static void parse_function(lexer &lex, context &ctx, loader &ld) {
+  lex.expect("def");
+  type *ret_ty = parse_type(lex, ctx);
+  std::string name = lex.next();
+  // arguments
+  std::vector<type*> arg_tys;
+  std::vector<std::string> arg_names;
+  std::vector<std::vector<attribute>> arg_attrs;
+  lex.expect("(");
+  if(!lex.accept(")")){
+    do{
+      arg_tys.push_back(parse_type(lex, ctx));
+      arg_names.push_back(strip(lex, lex.next(), '%'));
+      arg_attrs.push_back({});
+      while(lex.peek()[0] == '.')
+        arg_attrs.back().push_back(parse_attribute(lex));
+    }while(lex.accept(","));
+    lex.expect(")");
+  }
+  ld.begin_function(name, function_type::get(ret_ty, arg_tys), arg_names, arg_attrs);
+  // body
+  lex.expect("{");
+  while(!lex.accept("}")){
+    if(lex.accept(";"))
+      continue;
+    if(lex.peek(1) == ":"){
+      ld.add_block(lex.next());
+      lex.expect(":");
+      continue;
+    }
+    parse_inst(lex, ctx, ld);
+  }
+  ld.end_function();
+}
+
+void parse(std::istream &is, module &mod) {
+  lexer lex(is);
+  context &ctx = mod.get_context();
+  loader ld(mod);
+  while(!lex.peek().empty()){
+    if(lex.accept(";"))
+      continue;
+    // globals
+    if(lex.accept("alloc_const")){
+      type *elt_ty = parse_type(lex, ctx);
+      std::string name = strip(lex, lex.next(), '@');
+      lex.expect("[");
+      unsigned size = lex.next_unsigned();
+      lex.expect("]");
+      lex.expect(";");
+      ld.add_global(elt_ty, name, size);
+      continue;
+    }
+    parse_function(lex, ctx, ld);
+  }
+}
+
+}
+}
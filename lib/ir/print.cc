@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include "triton/ir/basic_block.h"
 #include "triton/ir/module.h"
@@ -10,67 +11,102 @@
 namespace triton{
 namespace ir{
 
-std::string get_name(ir::value *v, unsigned i) {
-  if(v->get_name().empty()){
-    std::string name = "%" + std::to_string(i);
-    v->set_name(name);
+/* Name table */
+name_table::name_table(function *fn) {
+  std::set<std::string> used_values, used_blocks;
+  unsigned num_values = 0, num_blocks = 0;
+  for(ir::argument *arg: fn->args())
+    add(arg, used_values, num_values);
+  for(ir::basic_block *block: fn->blocks()){
+    add(block, used_blocks, num_blocks);
+    for(ir::instruction *inst: block->get_inst_list())
+    if(!inst->get_type()->is_void_ty())
+      add(inst, used_values, num_values);
   }
-  return v->get_name();
 }
 
+void name_table::add(value *v, std::set<std::string> &used, unsigned &cnt) {
+  const std::string &base = v->get_name();
+  std::string name = base.empty() ? std::to_string(cnt++) : base;
+  for(unsigned k = 1; used.find(name) != used.end(); k++)
+    name = base.empty() ? std::to_string(cnt++) : base + "." + std::to_string(k);
+  used.insert(name);
+  names_[v] = name;
+}
+
+/* Printer */
+static std::string get_global_name(ir::alloc_const *x, const std::vector<ir::alloc_const*> &allocs) {
+  if(!x->get_name().empty())
+    return "@" + x->get_name();
+  auto it = std::find(allocs.begin(), allocs.end(), x);
+  return "@" + std::to_string(it - allocs.begin());
+}
+
+static std::string get_operand(ir::value *v, const name_table &names, const std::vector<ir::alloc_const*> &allocs) {
+  if(auto *x = dynamic_cast<ir::basic_block*>(v))
+    return "label " + names.get(x);
+  if(auto *x = dynamic_cast<ir::alloc_const*>(v))
+    return get_global_name(x, allocs);
+  if(dynamic_cast<ir::make_range_sta*>(v))
+    return v->get_type()->repr() + " make_range_sta";
+  if(auto *x = dynamic_cast<ir::constant*>(v))
+    return v->get_type()->repr() + " " + x->repr();
+  return "%" + names.get(v);
+}
 
 void print(module &mod, std::ostream& os) {
-  unsigned cnt = 0;
+  const std::vector<ir::alloc_const*> &allocs = mod.allocs();
+  for(ir::alloc_const *alloc: allocs){
+    auto *size = (ir::constant_int*)alloc->get_operand(0);
+    os << "alloc_const " << alloc->get_type()->get_pointer_element_ty()->repr() << " "
+       << get_global_name(alloc, allocs) << "[" << size->get_value() << "];" << std::endl;
+  }
   for(ir::function *fn: mod.get_function_list()){
+    name_table names(fn);
     os << "def " << fn->get_fn_type()->get_return_ty()->repr() << " " << fn->get_name() << "(" ;
     for(ir::argument* arg: fn->args()) {
       if(arg->get_arg_no() > 0)
         os << ", ";
-      os << arg->get_type()->repr() << " " << arg->get_name();
-      auto attrs = fn->get_attributes(arg);
-      if(attrs.size() > 0)
-        os << " ";
-      for(ir::attribute attr: attrs)
-        os << attr.repr() << " ";
+      os << arg->get_type()->repr() << " %" << names.get(arg);
+      for(ir::attribute attr: fn->get_attributes(arg))
+        os << " " << attr.repr();
     }
     os << ")" << std::endl;
     os << "{" << std::endl;
     for(ir::basic_block *block: fn->blocks()){
       auto const &predecessors = block->get_predecessors();
-      os << block->get_name() << ":";
+      os << names.get(block) << ":";
       if(!predecessors.empty()){
         os << "                 ";
         os << "; preds = ";
-        auto const &predecessors = block->get_predecessors();
-        for(ir::basic_block *pred: predecessors)
-          os << pred->get_name() << (pred!=predecessors.back()?", ":"");
+        for(size_t i = 0; i < predecessors.size(); i++)
+          os << (i > 0 ? ", " : "") << names.get(predecessors[i]);
       }
       os << std::endl;
       for(ir::instruction *inst: block->get_inst_list()){
         os << "  ";
-        if(!inst->get_type()->is_void_ty()){
-          os << get_name(inst, cnt++);
-          os << " = ";
-        }
+        if(!inst->get_type()->is_void_ty())
+          os << "%" << names.get(inst) << " = ";
         ir::type* type = inst->get_type();
         os << inst->repr() << " " << type->repr();
-        ir::instruction::ops_t ops = inst->ops();
         size_t num_ops = inst->get_num_operands();
         if(num_ops > 0)
-          os << " ";;
-        for(unsigned i = 0; i < num_ops; i++){
-          if(auto *x = dynamic_cast<ir::constant*>(ops[i]))
-            os << x->repr();
-          else
-            os << get_name(ops[i], cnt++);
-          os << (i < num_ops - 1?", ":"");
+          os << " ";
+        // phi nodes: [value, label block] pairs
+        if(auto *phi = dynamic_cast<ir::phi_node*>(inst)){
+          for(unsigned n = 0; n < phi->get_num_incoming(); n++)
+            os << (n > 0 ? ", " : "") << "["
+               << get_operand(phi->get_incoming_value(n), names, allocs) << ", "
+               << get_operand(phi->get_incoming_block(n), names, allocs) << "]";
+        }
+        else{
+          for(unsigned i = 0; i < num_ops; i++)
+            os << (i > 0 ? ", " : "") << get_operand(inst->get_operand(i), names, allocs);
         }
-        os << ";";
-//        os << " (";
-//        for(ir::user* usr: inst->get_users())
-//          os << get_name(usr, cnt++) << ", " ;
-//        os << " )";
-        os << std::endl;
+        for(auto md: inst->get_metadatas())
+        if(md.second)
+          os << " !" << ir::metadata::repr(md.first) << "(" << md.second << ")";
+        os << ";" << std::endl;
       }
     }
     os << "}" << std::endl;
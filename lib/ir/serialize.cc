@@ -0,0 +1,427 @@
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include "triton/ir/basic_block.h"
+#include "triton/ir/module.h"
+#include "triton/ir/type.h"
+#include "triton/ir/constant.h"
+#include "triton/ir/function.h"
+#include "triton/ir/instructions.h"
+#include "triton/ir/print.h"
+#include "triton/ir/parser.h"
+#include "triton/ir/serialize.h"
+
+namespace triton{
+namespace ir{
+
+static const char magic[] = {'T', 'R', 'I', 'R'};
+static const unsigned version = 2;
+
+//===----------------------------------------------------------------------===//
+//                               encoding helpers
+//===----------------------------------------------------------------------===//
+
+static void write_uint(std::ostream &os, uint64_t x) {
+  do{
+    uint8_t byte = x & 0x7f;
+    x >>= 7;
+    os.put(x ? byte | 0x80 : byte);
+  }while(x);
+}
+
+static uint64_t read_uint(std::istream &is) {
+  uint64_t x = 0;
+  for(unsigned shift = 0; shift < 64; shift += 7){
+    int byte = is.get();
+    if(byte == EOF)
+      throw std::runtime_error("unexpected end of Triton-IR binary");
+    x |= uint64_t(byte & 0x7f) << shift;
+    if(!(byte & 0x80))
+      return x;
+  }
+  throw std::runtime_error("malformed integer in Triton-IR binary");
+}
+
+static void write_double(std::ostream &os, double x) {
+  uint64_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  for(unsigned i = 0; i < 8; i++)
+    os.put((bits >> (8*i)) & 0xff);
+}
+
+static double read_double(std::istream &is) {
+  uint64_t bits = 0;
+  for(unsigned i = 0; i < 8; i++){
+    int byte = is.get();
+    if(byte == EOF)
+      throw std::runtime_error("unexpected end of Triton-IR binary");
+    bits |= uint64_t(byte) << (8*i);
+  }
+  double x;
+  std::memcpy(&x, &bits, sizeof(x));
+  return x;
+}
+
+//===----------------------------------------------------------------------===//
+//                               writer
+//===----------------------------------------------------------------------===//
+
+class writer {
+public:
+  writer(module &mod): mod_(mod) { }
+  void run(std::ostream &os);
+
+private:
+  unsigned get_string(const std::string &str);
+  unsigned get_type(type *ty);
+  std::string get_global_name(alloc_const *x);
+  void write_operand(value *v, const name_table &names);
+  void write_function(function *fn);
+
+private:
+  module &mod_;
+  std::map<std::string, unsigned> strings_;
+  std::vector<std::string> string_list_;
+  std::map<type*, unsigned> types_;
+  std::ostringstream types_os_;
+  std::ostringstream os_;
+};
+
+unsigned writer::get_string(const std::string &str) {
+  auto it = strings_.find(str);
+  if(it != strings_.end())
+    return it->second;
+  string_list_.push_back(str);
+  return strings_[str] = string_list_.size() - 1;
+}
+
+// types are written after the types they contain
+unsigned writer::get_type(type *ty) {
+  auto it = types_.find(ty);
+  if(it != types_.end())
+    return it->second;
+  std::vector<unsigned> contained;
+  if(ty->is_pointer_ty())
+    contained.push_back(get_type(ty->get_pointer_element_ty()));
+  else if(ty->is_tile_ty())
+    contained.push_back(get_type(ty->get_tile_element_ty()));
+  else if(auto *fn_ty = dynamic_cast<function_type*>(ty)){
+    contained.push_back(get_type(fn_ty->get_return_ty()));
+    for(unsigned i = 0; i < fn_ty->get_num_params(); i++)
+      contained.push_back(get_type(fn_ty->get_param_ty(i)));
+  }
+  write_uint(types_os_, ty->get_type_id());
+  switch(ty->get_type_id()){
+    case type::IntegerTyID:
+      write_uint(types_os_, ty->get_integer_bitwidth());
+      break;
+    case type::PointerTyID:
+      write_uint(types_os_, contained[0]);
+      write_uint(types_os_, ty->get_pointer_address_space());
+      break;
+    case type::TileTyID:
+      write_uint(types_os_, contained[0]);
+      write_uint(types_os_, ty->get_tile_rank());
+      for(unsigned shape: ty->get_tile_shapes())
+        write_uint(types_os_, shape);
+      break;
+    case type::FunctionTyID:
+      write_uint(types_os_, contained.size());
+      for(unsigned x: contained)
+        write_uint(types_os_, x);
+      break;
+    default:
+      break;
+  }
+  unsigned id = types_.size();
+  return types_[ty] = id;
+}
+
+std::string writer::get_global_name(alloc_const *x) {
+  if(!x->get_name().empty())
+    return x->get_name();
+  const std::vector<alloc_const*> &allocs = mod_.allocs();
+  return std::to_string(std::find(allocs.begin(), allocs.end(), x) - allocs.begin());
+}
+
+void writer::write_operand(value *v, const name_table &names) {
+  typedef loader::operand_t operand_t;
+  if(auto *x = dynamic_cast<basic_block*>(v)){
+    write_uint(os_, operand_t::BLOCK);
+    write_uint(os_, get_string(names.get(x)));
+  }
+  else if(auto *x = dynamic_cast<alloc_const*>(v)){
+    write_uint(os_, operand_t::GLOBAL);
+    write_uint(os_, get_string(get_global_name(x)));
+  }
+  else if(dynamic_cast<make_range_sta*>(v)){
+    write_uint(os_, operand_t::RANGE);
+    write_uint(os_, get_type(v->get_type()));
+  }
+  else if(dynamic_cast<undef_value*>(v)){
+    write_uint(os_, operand_t::UNDEF);
+    write_uint(os_, get_type(v->get_type()));
+  }
+  else if(auto *x = dynamic_cast<constant_int*>(v)){
+    write_uint(os_, operand_t::CONSTANT);
+    write_uint(os_, get_type(v->get_type()));
+    write_uint(os_, x->get_value());
+  }
+  else if(auto *x = dynamic_cast<constant_fp*>(v)){
+    write_uint(os_, operand_t::CONSTANT);
+    write_uint(os_, get_type(v->get_type()));
+    write_double(os_, x->get_value());
+  }
+  else{
+    write_uint(os_, operand_t::VALUE);
+    write_uint(os_, get_string(names.get(v)));
+  }
+}
+
+void writer::write_function(function *fn) {
+  name_table names(fn);
+  write_uint(os_, get_string(fn->get_name()));
+  write_uint(os_, get_type(fn->get_fn_type()));
+  for(argument *arg: fn->args()){
+    write_uint(os_, get_string(names.get(arg)));
+    std::set<attribute> attrs = fn->get_attributes(arg);
+    write_uint(os_, attrs.size());
+    for(attribute attr: attrs){
+      write_uint(os_, attr.get_kind());
+      write_uint(os_, attr.get_value());
+    }
+  }
+  write_uint(os_, fn->blocks().size());
+  for(basic_block *block: fn->blocks()){
+    write_uint(os_, get_string(names.get(block)));
+    write_uint(os_, block->get_inst_list().size());
+    for(instruction *inst: block->get_inst_list()){
+      bool is_void = inst->get_type()->is_void_ty();
+      write_uint(os_, get_string(is_void ? "" : names.get(inst)));
+      write_uint(os_, get_string(inst->repr()));
+      write_uint(os_, get_type(inst->get_type()));
+      if(auto *phi = dynamic_cast<phi_node*>(inst)){
+        write_uint(os_, 2*phi->get_num_incoming());
+        for(unsigned n = 0; n < phi->get_num_incoming(); n++){
+          write_operand(phi->get_incoming_value(n), names);
+          write_operand(phi->get_incoming_block(n), names);
+        }
+      }
+      else{
+        write_uint(os_, inst->get_num_operands());
+        for(unsigned i = 0; i < inst->get_num_operands(); i++)
+          write_operand(inst->get_operand(i), names);
+      }
+      std::vector<std::pair<metadata::kind_t, unsigned>> mds;
+      for(auto md: inst->get_metadatas())
+        if(md.second)
+          mds.push_back(md);
+      write_uint(os_, mds.size());
+      for(auto md: mds){
+        write_uint(os_, md.first);
+        write_uint(os_, md.second);
+      }
+    }
+  }
+}
+
+void writer::run(std::ostream &os) {
+  // body
+  const std::vector<alloc_const*> &allocs = mod_.allocs();
+  write_uint(os_, allocs.size());
+  for(alloc_const *alloc: allocs){
+    write_uint(os_, get_string(get_global_name(alloc)));
+    write_uint(os_, get_type(alloc->get_type()->get_pointer_element_ty()));
+    write_uint(os_, ((constant_int*)alloc->get_operand(0))->get_value());
+  }
+  write_uint(os_, mod_.get_function_list().size());
+  for(function *fn: mod_.get_function_list())
+    write_function(fn);
+  // header and tables
+  os.write(magic, sizeof(magic));
+  write_uint(os, version);
+  write_uint(os, string_list_.size());
+  for(const std::string &str: string_list_){
+    write_uint(os, str.size());
+    os.write(str.data(), str.size());
+  }
+  write_uint(os, types_.size());
+  os << types_os_.str();
+  os << os_.str();
+}
+
+//===----------------------------------------------------------------------===//
+//                               reader
+//===----------------------------------------------------------------------===//
+
+class reader {
+public:
+  reader(std::istream &is, module &mod): is_(is), mod_(mod), loader_(mod) { }
+  void run();
+
+private:
+  const std::string &read_string();
+  type *read_type();
+  type *read_type_entry();
+  loader::operand_t read_operand();
+  void read_function();
+
+private:
+  std::istream &is_;
+  module &mod_;
+  loader loader_;
+  std::vector<std::string> strings_;
+  std::vector<type*> types_;
+};
+
+const std::string &reader::read_string() {
+  return strings_.at(read_uint(is_));
+}
+
+type *reader::read_type() {
+  return types_.at(read_uint(is_));
+}
+
+type *reader::read_type_entry() {
+  context &ctx = mod_.get_context();
+  switch(read_uint(is_)){
+    case type::VoidTyID: return type::get_void_ty(ctx);
+    case type::LabelTyID: return type::get_label_ty(ctx);
+    case type::HalfTyID: return type::get_half_ty(ctx);
+    case type::BF16TyID: return type::get_bf16_ty(ctx);
+    case type::FloatTyID: return type::get_float_ty(ctx);
+    case type::DoubleTyID: return type::get_double_ty(ctx);
+    case type::IntegerTyID: return integer_type::get(ctx, read_uint(is_));
+    case type::PointerTyID: {
+      type *elt_ty = read_type();
+      return pointer_type::get(elt_ty, read_uint(is_));
+    }
+    case type::TileTyID: {
+      type *elt_ty = read_type();
+      type::tile_shapes_t shapes(read_uint(is_));
+      for(unsigned &shape: shapes)
+        shape = read_uint(is_);
+      return tile_type::get(elt_ty, shapes);
+    }
+    case type::FunctionTyID: {
+      size_t num_contained = read_uint(is_);
+      if(num_contained == 0)
+        throw std::runtime_error("malformed function type in Triton-IR binary");
+      type *ret_ty = read_type();
+      std::vector<type*> param_tys;
+      for(size_t i = 1; i < num_contained; i++)
+        param_tys.push_back(read_type());
+      return function_type::get(ret_ty, param_tys);
+    }
+    default: throw std::runtime_error("unsupported type in Triton-IR binary");
+  }
+}
+
+loader::operand_t reader::read_operand() {
+  typedef loader::operand_t operand_t;
+  operand_t op{(operand_t::kind_t)read_uint(is_), "", nullptr, 0, 0};
+  switch(op.kind){
+    case operand_t::VALUE:
+    case operand_t::BLOCK:
+    case operand_t::GLOBAL:
+      op.name = read_string();
+      break;
+    case operand_t::UNDEF:
+    case operand_t::RANGE:
+      op.ty = read_type();
+      break;
+    case operand_t::CONSTANT:
+      op.ty = read_type();
+      if(op.ty->get_scalar_ty()->is_floating_point_ty())
+        op.fval = read_double(is_);
+      else
+        op.ival = read_uint(is_);
+      break;
+    default: throw std::runtime_error("unknown operand kind in Triton-IR binary");
+  }
+  return op;
+}
+
+void reader::read_function() {
+  std::string name = read_string();
+  function_type *fn_ty = dynamic_cast<function_type*>(read_type());
+  if(!fn_ty)
+    throw std::runtime_error("malformed function in Triton-IR binary");
+  std::vector<std::string> arg_names(fn_ty->get_num_params());
+  std::vector<std::vector<attribute>> arg_attrs(arg_names.size());
+  for(size_t i = 0; i < arg_names.size(); i++){
+    arg_names[i] = read_string();
+    size_t num_attrs = read_uint(is_);
+    for(size_t j = 0; j < num_attrs; j++){
+      attribute_kind_t kind = (attribute_kind_t)read_uint(is_);
+      arg_attrs[i].push_back(attribute(kind, read_uint(is_)));
+    }
+  }
+  loader_.begin_function(name, fn_ty, arg_names, arg_attrs);
+  size_t num_blocks = read_uint(is_);
+  for(size_t b = 0; b < num_blocks; b++){
+    loader_.add_block(read_string());
+    size_t num_insts = read_uint(is_);
+    for(size_t i = 0; i < num_insts; i++){
+      loader::inst_t inst;
+      inst.name = read_string();
+      inst.repr = read_string();
+      inst.ty = read_type();
+      inst.ops.resize(read_uint(is_));
+      for(loader::operand_t &op: inst.ops)
+        op = read_operand();
+      size_t num_mds = read_uint(is_);
+      for(size_t j = 0; j < num_mds; j++){
+        metadata::kind_t kind = (metadata::kind_t)read_uint(is_);
+        inst.metadatas.push_back({kind, (unsigned)read_uint(is_)});
+      }
+      loader_.add_inst(inst);
+    }
+  }
+  loader_.end_function();
+}
+
+void reader::run() {
+  // header
+  char header[sizeof(magic)];
+  if(!is_.read(header, sizeof(header)) || !std::equal(header, header + sizeof(header), magic))
+    throw std::runtime_error("not a Triton-IR binary");
+  if(read_uint(is_) != version)
+    throw std::runtime_error("unsupported Triton-IR binary version");
+  // tables
+  strings_.resize(read_uint(is_));
+  for(std::string &str: strings_){
+    str.resize(read_uint(is_));
+    if(!is_.read(&str[0], str.size()))
+      throw std::runtime_error("unexpected end of Triton-IR binary");
+  }
+  size_t num_types = read_uint(is_);
+  for(size_t i = 0; i < num_types; i++)
+    types_.push_back(read_type_entry());
+  // body
+  size_t num_allocs = read_uint(is_);
+  for(size_t i = 0; i < num_allocs; i++){
+    std::string name = read_string();
+    type *elt_ty = read_type();
+    loader_.add_global(elt_ty, name, read_uint(is_));
+  }
+  size_t num_functions = read_uint(is_);
+  for(size_t i = 0; i < num_functions; i++)
+    read_function();
+}
+
+//===----------------------------------------------------------------------===//
+//                               entry points
+//===----------------------------------------------------------------------===//
+
+void serialize(module &mod, std::ostream &os) {
+  writer(mod).run(os);
+}
+
+void deserialize(std::istream &is, module &mod) {
+  reader(is, mod).run();
+}
+
+}
+}
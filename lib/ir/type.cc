@@ -1,4 +1,5 @@
 #include <cassert>
+#include <stdexcept>
 #include "triton/ir/type.h"
 #include "triton/ir/context.h"
 #include "triton/ir/context_impl.h"
@@ -22,6 +23,7 @@ type *type::get_scalar_ty() const {
 unsigned type::get_primitive_size_in_bits() const {
   switch (id_) {
     case HalfTyID: return 16;
+    case BF16TyID: return 16;
     case FloatTyID: return 32;
     case DoubleTyID: return 64;
     case X86_FP80TyID: return 80;
@@ -43,6 +45,7 @@ unsigned type::get_fp_mantissa_width() const {
   id_t id = get_scalar_ty()->id_;
   assert(is_floating_point_ty() && "Not a floating point type!");
   if (id == HalfTyID) return 11;
+  if (id == BF16TyID) return 8;
   if (id == FloatTyID) return 24;
   if (id == DoubleTyID) return 53;
   throw std::runtime_error("unreachable");
@@ -103,7 +106,7 @@ bool type::is_integer_ty(unsigned width) const
 
 
 bool type::is_floating_point_ty() const
-{ return is_half_ty() || is_float_ty() || is_double_ty(); }
+{ return is_half_ty() || is_bf16_ty() || is_float_ty() || is_double_ty(); }
 
 bool type::is_sized() const {
   // primitive types are sized
@@ -122,6 +125,7 @@ type *type::get_void_ty(context &ctx) { return &ctx.p_impl->void_ty; }
 type *type::get_label_ty(context &ctx) { return &ctx.p_impl->label_ty; }
 // half
 type *type::get_half_ty(context &ctx) { return &ctx.p_impl->half_ty; }
+type *type::get_bf16_ty(context &ctx) { return &ctx.p_impl->bf16_ty; }
 type *type::get_float_ty(context &ctx) { return &ctx.p_impl->float_ty; }
 type *type::get_double_ty(context &ctx) { return &ctx.p_impl->double_ty; }
 // integer types
@@ -132,7 +136,25 @@ integer_type *type::get_int32_ty(context &ctx) { return &ctx.p_impl->int32_ty; }
 integer_type *type::get_int64_ty(context &ctx) { return &ctx.p_impl->int64_ty; }
 integer_type *type::get_int128_ty(context &ctx) { return &ctx.p_impl->int128_ty; }
 
+//===----------------------------------------------------------------------===//
+//                               integer_type class
+//===----------------------------------------------------------------------===//
 
+integer_type* integer_type::get(context &ctx, unsigned width) {
+  switch(width){
+    case 1: return get_int1_ty(ctx);
+    case 8: return get_int8_ty(ctx);
+    case 16: return get_int16_ty(ctx);
+    case 32: return get_int32_ty(ctx);
+    case 64: return get_int64_ty(ctx);
+    case 128: return get_int128_ty(ctx);
+    default: throw std::runtime_error("unsupported integer bitwidth: " + std::to_string(width));
+  }
+}
+
+//===----------------------------------------------------------------------===//
+//                               pointer_type class
+//===----------------------------------------------------------------------===//
 
 pointer_type::pointer_type(type *ty, unsigned address_space)
     : type(ty->get_context(), PointerTyID), address_space_(address_space){
@@ -29,6 +29,72 @@ std::vector<basic_block*> cfg::reverse_post_order(function* fn) {
   return std::move(result);
 }
 
+// Cooper, Harvey & Kennedy, "A Simple, Fast Dominance Algorithm"
+std::map<basic_block*, basic_block*> cfg::immediate_dominators(function* fn) {
+  // post-order numbering
+  std::vector<basic_block*> po;
+  std::set<basic_block*> visited;
+  std::stack<std::pair<basic_block*, size_t>> stack;
+  if(fn->blocks().empty())
+    return {};
+  basic_block* entry = fn->blocks().front();
+  visited.insert(entry);
+  stack.push({entry, 0});
+  while(!stack.empty()){
+    auto &top = stack.top();
+    const auto &succs = top.first->get_successors();
+    if(top.second < succs.size()){
+      basic_block* succ = succs[top.second++];
+      if(visited.insert(succ).second)
+        stack.push({succ, 0});
+      continue;
+    }
+    po.push_back(top.first);
+    stack.pop();
+  }
+  std::map<basic_block*, size_t> order;
+  for(size_t i = 0; i < po.size(); i++)
+    order[po[i]] = i;
+  // fixed-point over reverse post-order
+  std::map<basic_block*, basic_block*> idom;
+  idom[entry] = entry;
+  auto intersect = [&](basic_block* x, basic_block* y) {
+    while(x != y){
+      while(order.at(x) < order.at(y)) x = idom.at(x);
+      while(order.at(y) < order.at(x)) y = idom.at(y);
+    }
+    return x;
+  };
+  bool changed = true;
+  while(changed){
+    changed = false;
+    for(auto it = po.rbegin(); it != po.rend(); it++){
+      basic_block* block = *it;
+      if(block == entry)
+        continue;
+      basic_block* new_idom = nullptr;
+      for(basic_block* pred: block->get_predecessors()){
+        if(idom.find(pred) == idom.end())
+          continue;
+        new_idom = new_idom ? intersect(pred, new_idom) : pred;
+      }
+      if(idom[block] != new_idom){
+        idom[block] = new_idom;
+        changed = true;
+      }
+    }
+  }
+  idom[entry] = nullptr;
+  return idom;
+}
+
+bool cfg::dominates(const std::map<basic_block*, basic_block*>& idom, basic_block* x, basic_block* y) {
+  for(; y; y = idom.at(y))
+    if(y == x)
+      return true;
+  return false;
+}
+
 void for_each_instruction(module &mod, const std::function<void (instruction *)> &do_work) {
   for(ir::function *fn: mod.get_function_list())
   for(ir::basic_block *block: cfg::reverse_post_order(fn))
@@ -5,6 +5,8 @@
 #include "triton/lang/parser.h"
 #include "triton/lang/token.h"
 
+#include <set>
+
 
 static MemPoolImp<BinaryOp>         binaryOpPool;
 static MemPoolImp<TransOp>          transOpPool;
@@ -214,6 +216,9 @@ ArithmType* BinaryOp::Convert() {
   auto rhsType = rhs_->Type()->ScalarType()->ToArithm();
   assert(lhsType && rhsType);
   auto maxType = ArithmType::MaxType(lhsType, rhsType);
+  // bfloat16 is a storage format: arithmetic is done in fp32
+  if (maxType->Tag() == T_BF16)
+    maxType = ArithmType::New(T_FLOAT);
   if (lhsType != maxType) { // Pointer comparation is enough!
     lhs_ = UnaryOp::New(Token::CAST, lhs_, ScalarOrLikeTile(lhs_, maxType));
   }
@@ -496,8 +501,14 @@ void BinaryOp::MatmulOpTypeChecking() {
   if(retType != rhsType->Derived())
     Error(this, "matrix multiplication operands have incompatible data types");
   ArithmType* ScalType = lhsType->ScalarType()->ToArithm();
-  if(ScalType->Tag() & T_HALF)
+  if(ScalType->Tag() & (T_HALF | T_BF16))
     ScalType = ArithmType::New(T_FLOAT);
+  // 8-bit integer operands accumulate in 32-bit
+  if(ScalType->IsInteger()){
+    if(ScalType->Tag() != T_CHAR)
+      Error(this, "integer matrix multiplication expects (signed) char operands");
+    ScalType = ArithmType::New(T_INT);
+  }
   type_ = TileType::New(retShape, ScalType);
 }
 
@@ -623,6 +634,8 @@ bool UnaryOp::IsLVal() {
   assert(arithmType);
   if (arithmType->IsInteger())
     arithmType = ArithmType::IntegerPromote(arithmType);
+  if (arithmType->Tag() == T_BF16)
+    arithmType = ArithmType::New(T_FLOAT);
   ::Type* retType = ScalarOrLikeTile(operand_, arithmType);
   operand_ = Expr::MayCast(operand_, retType);
   return retType;
@@ -661,6 +674,12 @@ void UnaryOp::TypeChecking() {
   case Token::EXP:
   case Token::LOG:
   case Token::SQRTF:
+  case Token::TANH:
+  case Token::ERF:
+  case Token::SIGMOID:
+  case Token::SIN:
+  case Token::COS:
+  case Token::RSQRT:
     return IntrinsicOpTypeChecking();
 
   default:
@@ -707,11 +726,18 @@ void UnaryOp::ReduceOpTypeChecking() {
   if(!tileType)
     Error(this, "array expected for reduction operation");
   auto shape = tileType->Shape();
+  QualType eltType = tileType->Derived();
+  // bfloat16 reductions are carried out in fp32
+  auto arithmType = eltType->ToArithm();
+  if(arithmType && arithmType->Tag() == T_BF16){
+    eltType = ArithmType::New(T_FLOAT);
+    operand_ = Expr::MayCast(operand_, TileType::New(tileType->Shape(), eltType));
+  }
   shape.erase(shape.begin() + ax);
   if(shape.empty())
-    type_ = tileType->Derived();
+    type_ = eltType;
   else
-    type_ = TileType::New(shape, tileType->Derived());
+    type_ = TileType::New(shape, eltType);
 }
 
 void UnaryOp::UnaryArithmOpTypeChecking() {
@@ -791,7 +817,11 @@ void UnaryOp::CastOpTypeChecking() {
 }
 
 void UnaryOp::IntrinsicOpTypeChecking() {
+  auto scalType = TryExtractScalarType(this, operand_);
+  if (!scalType->IsReal())
+    Error(this, "expect operand of real type");
   type_ = ScalarOrLikeTile(operand_, ArithmType::New(T_FLOAT));
+  operand_ = Expr::MayCast(operand_, type_);
 }
 
 /*
@@ -841,10 +871,10 @@ ArithmType* ConditionalOp::Convert() {
   assert(lhsType && rhsType);
   auto type = ArithmType::MaxType(lhsType, rhsType);
   if (lhsType != type) { // Pointer comparation is enough!
-    exprTrue_ = UnaryOp::New(Token::CAST, exprTrue_, type);
+    exprTrue_ = UnaryOp::New(Token::CAST, exprTrue_, ScalarOrLikeTile(exprTrue_, type));
   }
   if (rhsType != type) {
-    exprFalse_ = UnaryOp::New(Token::CAST, exprFalse_, type);
+    exprFalse_ = UnaryOp::New(Token::CAST, exprFalse_, ScalarOrLikeTile(exprFalse_, type));
   }
 
   return type;
@@ -882,6 +912,8 @@ FuncCall* FuncCall::New(Expr* designator, const ArgList& args) {
 
 
 void FuncCall::TypeChecking() {
+  if (IsAtomicRMW())
+    return AtomicRMWTypeChecking();
   auto pointerType = designator_->Type()->ToPointer();
   if (pointerType) {
     if (!pointerType->Derived()->ToFunc())
@@ -920,6 +952,40 @@ void FuncCall::TypeChecking() {
 }
 
 
+bool FuncCall::IsAtomicRMW() const {
+  static const std::set<std::string> names = {
+    "atomic_add", "atomic_max", "atomic_min",
+    "atomic_xchg", "atomic_and", "atomic_or"
+  };
+  return names.find(Name()) != names.end();
+}
+
+/*
+ * Atomic read-modify-write builtins: op(ptr, val[, mask])
+ *  1. ptr is a pointer or a tile of pointers of any shape
+ *  2. val and mask are broadcast to the shape of ptr
+ *  3. the result is the old value(s) pointed to by ptr
+ */
+void FuncCall::AtomicRMWTypeChecking() {
+  if (args_.size() != 2 && args_.size() != 3)
+    Error(this, "'%s' expects a pointer, a value and an optional mask", Name().c_str());
+  auto pointerType = TryExtractScalarType(this, args_[0])->ToPointer();
+  if (!pointerType)
+    Error(args_[0], "pointer expected for first argument of '%s'", Name().c_str());
+  ::Type* scalType = pointerType->Derived().GetPtr();
+  if (!scalType->IsReal())
+    Error(this, "'%s' expects pointer to integer or floating-point values", Name().c_str());
+  if (scalType->ToArithm() && scalType->ToArithm()->Tag() == T_BF16)
+    Error(this, "'%s' does not support bfloat16 values", Name().c_str());
+  if ((Name() == "atomic_and" || Name() == "atomic_or") && !scalType->IsInteger())
+    Error(this, "'%s' expects pointer to integer values", Name().c_str());
+  type_ = ScalarOrLikeTile(args_[0], scalType);
+  args_[1] = Expr::MayCast(args_[1], type_);
+  if (args_.size() == 3)
+    args_[2] = Expr::MayCast(args_[2], ScalarOrLikeTile(args_[0], ArithmType::New(T_BOOL)));
+}
+
+
 /*
  * Identifier
  */
@@ -48,7 +48,7 @@ void Generator::VisitBinaryOp(BinaryOp* binary) {
       ir::type* ret_ty = GenIRType(binary->Type(), *ctx_);
       ir::type* ret_scal_ty = ret_ty->get_scalar_ty();
       ir::value* _0;
-      if(ret_scal_ty->is_float_ty())
+      if(ret_scal_ty->is_floating_point_ty())
         _0 = ir::constant_fp::get(ret_scal_ty, 0);
       else
         _0 = ir::constant_int::get(ret_scal_ty, 0);
@@ -248,6 +248,12 @@ void Generator::VisitUnaryOp(UnaryOp* unary) {
     case Token::EXP:         return set_ret(bld_->create_exp(arg)); //FIXME cast
     case Token::LOG:         return set_ret(bld_->create_log(arg));
     case Token::SQRTF:       return set_ret(bld_->create_sqrt(arg));
+    case Token::TANH:        return set_ret(bld_->create_math(ir::math_inst::TANH, arg));
+    case Token::ERF:         return set_ret(bld_->create_math(ir::math_inst::ERF, arg));
+    case Token::SIGMOID:     return set_ret(bld_->create_math(ir::math_inst::SIGMOID, arg));
+    case Token::SIN:         return set_ret(bld_->create_math(ir::math_inst::SIN, arg));
+    case Token::COS:         return set_ret(bld_->create_math(ir::math_inst::COS, arg));
+    case Token::RSQRT:       return set_ret(bld_->create_math(ir::math_inst::RSQRT, arg));
     case Token::REDUCE: {
       int ax, tag;
       UnaryOp::decodeRed(unary->info_, ax, tag);
@@ -275,7 +281,8 @@ void Generator::VisitConditionalOp(ConditionalOp* condOp) {
   ir::value* true_val = ret_;
   VisitExpr(condOp->exprFalse_);
   ir::value* false_val = ret_;
-  auto begin = std::find(instructions.begin(), instructions.end(), start);
+  // only loads emitted for the operands are masked
+  auto begin = std::next(std::find(instructions.begin(), instructions.end(), start));
   bool is_in_true_cond = true;
   for(auto it = begin; it != instructions.end(); it++){
     ir::instruction* instr = *it;
@@ -286,7 +293,11 @@ void Generator::VisitConditionalOp(ConditionalOp* condOp) {
       ir::type* ty = ld->get_type();
       ir::value* cond = is_in_true_cond ? true_cond : true_cond;
       ir::value* ptr = ld->get_pointer_operand();
-      ir::value* else_val = ir::undef_value::get(ty);
+      // tile constants are uniqued: splat so that loads of the
+      // same type do not share an operand
+      ir::value* else_val = ir::undef_value::get(ty->get_scalar_ty());
+      if(ty->is_tile_ty())
+        else_val = bld_->create_splat(else_val, ty->get_tile_shapes());
       ir::value* masked_ld = bld_->create_masked_load(ptr, cond, else_val);
       ld->replace_all_uses_with(masked_ld);
       ld->erase_from_parent();
@@ -346,21 +357,40 @@ void Generator::VisitFuncCall(FuncCall* funcCall) {
     ir::value* val = ret_;
     return set_ret(bld_->create_atomic_cas(ptr, cmp, val));
   }
-  if(name == "atomic_xchg"){
-    VisitExpr(funcCall->Args()->at(0));
-    ir::value* ptr = ret_;
-    VisitExpr(funcCall->Args()->at(1));
-    ir::value* val = ret_;
-    return set_ret(bld_->create_atomic_exch(ptr, val));
-  }
-  if(name.substr(0, 10) == "atomic_add"){
-    VisitExpr(funcCall->Args()->at(0));
+  if(funcCall->IsAtomicRMW()){
+    auto args = funcCall->Args();
+    VisitExpr(args->at(0));
     ir::value* ptr = ret_;
-    VisitExpr(funcCall->Args()->at(1));
+    VisitExpr(args->at(1));
     ir::value* val = ret_;
-    VisitExpr(funcCall->Args()->at(2));
-    ir::value* msk = ret_;
-    return set_ret(bld_->create_atomic_add(ptr, val, msk));
+    // scalar exchanges without mask are used to release locks
+    if(name == "atomic_xchg" && args->size() == 2 && !ptr->get_type()->is_tile_ty())
+      return set_ret(bld_->create_atomic_exch(ptr, val));
+    ir::value* msk = bld_->get_int1(true);
+    if(args->size() == 3){
+      VisitExpr(args->at(2));
+      msk = ret_;
+    }
+    else if(ptr->get_type()->is_tile_ty())
+      msk = bld_->create_splat(msk, ptr->get_type()->get_tile_shapes());
+    // op info
+    auto type = funcCall->Type()->ScalarType();
+    auto flt = type->IsFloat();
+    auto sign = !type->IsUnsigned();
+    ir::atomic_rmw_inst::op_t op;
+    if(name == "atomic_add")
+      op = flt ? ir::atomic_rmw_inst::FADD : ir::atomic_rmw_inst::ADD;
+    else if(name == "atomic_max")
+      op = flt ? ir::atomic_rmw_inst::FMAX : sign ? ir::atomic_rmw_inst::MAX : ir::atomic_rmw_inst::UMAX;
+    else if(name == "atomic_min")
+      op = flt ? ir::atomic_rmw_inst::FMIN : sign ? ir::atomic_rmw_inst::MIN : ir::atomic_rmw_inst::UMIN;
+    else if(name == "atomic_xchg")
+      op = ir::atomic_rmw_inst::XCHG;
+    else if(name == "atomic_and")
+      op = ir::atomic_rmw_inst::AND;
+    else
+      op = ir::atomic_rmw_inst::OR;
+    return set_ret(bld_->create_atomic_rmw(op, ptr, val, msk));
   }
   if(name == "calloc"){
     VisitExpr(funcCall->Args()->at(0));
@@ -652,6 +682,9 @@ ir::value* Generator::GenNumcastOp(ir::value*src, ir::type* dst_ty) {
   bool dst_signed = false;
   if(src_scalar_ty == dst_scalar_ty)
     return src;
+  else if((src_scalar_ty->is_half_ty() && dst_scalar_ty->is_bf16_ty()) ||
+          (src_scalar_ty->is_bf16_ty() && dst_scalar_ty->is_half_ty()))
+    return GenNumcastOp(GenNumcastOp(src, bld_->get_float_ty()), dst_ty);
   else if(src_scalar_ty->is_pointer_ty() && dst_scalar_ty->is_bool_ty())
     return bld_->create_icmpNE(bld_->create_ptr_to_int(src, ir::tile_type::get_same_shapes(bld_->get_int64_ty(), src->get_type())),
                                bld_->create_splat(bld_->get_int64(0), src->get_type()->get_tile_shapes()));
@@ -756,6 +789,8 @@ ir::type* Generator::GenIRArithmType(ArithmType* type, ir::context& ctx) {
     return ir::type::get_int64_ty(ctx);
   if(tag & T_HALF)
     return ir::type::get_half_ty(ctx);
+  if(tag & T_BF16)
+    return ir::type::get_bf16_ty(ctx);
   if(tag & T_FLOAT)
     return ir::type::get_float_ty(ctx);
   if(tag & T_DOUBLE)
@@ -231,6 +231,10 @@ void Preprocessor::Finalize(TokenSequence os) {
       Error(tok, "stray token in program");
     } else if (tok->tag_ == Token::IDENTIFIER) {
       auto tag = Token::KeyWordTag(tok->str_);
+      // math builtins are only reserved where they are called,
+      // so that kernels can keep using their names as identifiers
+      if (Token::TANH <= tag && tag <= Token::RSQRT && (os.Empty() || !os.Test(Token::LPAR)))
+        tag = Token::IDENTIFIER;
       if (Token::IsKeyWord(tag)) {
         const_cast<Token*>(tok)->tag_ = tag;
       } else {
@@ -408,6 +408,9 @@ Expr* Parser::ParsePostfixExpr() {
     primExpr = ParseUnaryIntrinsicOp(Token::SQRTF);
   else if(ts_.Try(Token::LOG))
     primExpr = ParseUnaryIntrinsicOp(Token::LOG);
+  else if(ts_.Test(Token::TANH) || ts_.Test(Token::ERF) || ts_.Test(Token::SIGMOID) ||
+          ts_.Test(Token::SIN) || ts_.Test(Token::COS) || ts_.Test(Token::RSQRT))
+    primExpr = ParseUnaryIntrinsicOp(ts_.Next()->tag_);
   else
     primExpr = ParsePrimaryExpr();
   return ParsePostfixExprTail(primExpr);
@@ -1157,6 +1160,12 @@ QualType Parser::ParseDeclSpec(int* storageSpec, int* funcSpec, int* alignSpec)
       typeSpec |= T_HALF;
       break;
 
+    case Token::BF16:
+      if(typeSpec & ~T_COMPLEX)
+        Error(tok, ERR_DECL_SPEC);
+      typeSpec |= T_BF16;
+      break;
+
     case Token::FLOAT:
       if (typeSpec & ~T_COMPLEX)
         Error(tok, ERR_DECL_SPEC);
@@ -25,6 +25,7 @@ const std::unordered_map<std::string, int> Token::kwTypeMap_ {
   { "for", Token::FOR },
   { "goto", Token::GOTO },
   { "half", Token::HALF },
+  { "bfloat16", Token::BF16 },
   { "if", Token::IF },
   { "inline", Token::INLINE },
   { "int", Token::INT },
@@ -48,6 +49,12 @@ const std::unordered_map<std::string, int> Token::kwTypeMap_ {
   { "exp", Token::EXP },
   { "log", Token::LOG },
   { "sqrtf", Token::SQRTF },
+  { "tanh", Token::TANH },
+  { "erf", Token::ERF },
+  { "sigmoid", Token::SIGMOID },
+  { "sin", Token::SIN },
+  { "cos", Token::COS },
+  { "rsqrt", Token::RSQRT },
   { "_Alignas", Token::ALIGNAS },
   { "_Alignof", Token::ALIGNOF },
   { "_Atomic", Token::ATOMIC },
@@ -125,6 +132,7 @@ const std::unordered_map<int, const char*> Token::tagLexemeMap_ {
   { Token::DOUBLE, "double" },
   { Token::ELSE, "else" },
   { Token::ENUM, "enum" },
+  { Token::BF16, "bfloat16" },
   { Token::EXTERN, "extern" },
   { Token::FLOAT, "float" },
   { Token::FOR, "for" },
@@ -153,6 +161,12 @@ const std::unordered_map<int, const char*> Token::tagLexemeMap_ {
   { Token::EXP, "exp" },
   { Token::LOG, "log" },
   { Token::SQRTF, "sqrtf" },
+  { Token::TANH, "tanh" },
+  { Token::ERF, "erf" },
+  { Token::SIGMOID, "sigmoid" },
+  { Token::SIN, "sin" },
+  { Token::COS, "cos" },
+  { Token::RSQRT, "rsqrt" },
   { Token::ALIGNAS, "_Alignas" },
   { Token::ALIGNOF, "_Alignof" },
   { Token::ATOMIC, "_Atomic" },
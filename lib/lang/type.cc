@@ -67,6 +67,7 @@ ArithmType* ArithmType::New(int typeSpec) {
   static auto llongType   = NEW_TYPE(T_LLONG)
   static auto ullongType  = NEW_TYPE(T_UNSIGNED | T_LLONG);
   static auto halfType    = NEW_TYPE(T_HALF);
+  static auto bf16Type    = NEW_TYPE(T_BF16);
   static auto floatType   = NEW_TYPE(T_FLOAT);
   static auto doubleType  = NEW_TYPE(T_DOUBLE);
   static auto ldoubleType = NEW_TYPE(T_LONG | T_DOUBLE);
@@ -86,6 +87,7 @@ ArithmType* ArithmType::New(int typeSpec) {
   case T_LLONG:             return llongType;
   case T_UNSIGNED | T_LLONG:return ullongType;
   case T_HALF:              return halfType;
+  case T_BF16:              return bf16Type;
   case T_FLOAT:             return floatType;
   case T_DOUBLE:            return doubleType;
   case T_LONG | T_DOUBLE:   return ldoubleType;
@@ -150,7 +152,7 @@ int ArithmType::Width() const {
     return intWidth_ << 1;
   case T_LLONG: case T_UNSIGNED | T_LLONG:
     return intWidth_ << 1;
-  case T_HALF:
+  case T_HALF: case T_BF16:
     return intWidth_ >> 1;
   case T_FLOAT:
     return intWidth_;
@@ -182,7 +184,7 @@ int ArithmType::Rank() const {
   case T_INT: case T_UNSIGNED: case T_UNSIGNED | T_INT: return 3;
   case T_LONG: case T_UNSIGNED | T_LONG: return 4;
   case T_LLONG: case T_UNSIGNED | T_LLONG: return 5;
-  case T_HALF: return 6;
+  case T_HALF: case T_BF16: return 6;
   case T_FLOAT: return 7;
   case T_DOUBLE: return 8;
   case T_LONG | T_DOUBLE: return 9;
@@ -200,6 +202,9 @@ ArithmType* ArithmType::MaxType(ArithmType* lhs,
     lhs = ArithmType::IntegerPromote(lhs);
   if (rhs->IsInteger())
     rhs = ArithmType::IntegerPromote(rhs);
+  // half and bfloat16 have the same rank but neither contains the other
+  if (lhs->Rank() == rhs->Rank() && lhs->IsFloat() && lhs->Tag() != rhs->Tag())
+    return ArithmType::New(T_FLOAT);
   auto ret = lhs->Rank() > rhs->Rank() ? lhs: rhs;
   if (lhs->Width() == rhs->Width() && (lhs->IsUnsigned() || rhs->IsUnsigned()))
     return ArithmType::New(T_UNSIGNED | ret->Tag());
@@ -260,6 +265,12 @@ std::string ArithmType::Str() const {
   case T_UNSIGNED | T_LLONG:
     return "unsigned long long" + width;
 
+  case T_HALF:
+    return "half" + width;
+
+  case T_BF16:
+    return "bfloat16" + width;
+
   case T_FLOAT:
     return "float" + width;
 
@@ -0,0 +1,291 @@
+#include <cmath>
+#include <cctype>
+#include <sstream>
+#include <algorithm>
+#include "triton/runtime/aot.h"
+#include "triton/driver/device.h"
+#include "triton/driver/module.h"
+#include "triton/ir/module.h"
+#include "triton/ir/function.h"
+
+namespace triton{
+namespace runtime{
+
+namespace {
+
+// type of an argument in the generated header
+std::string c_type(arg_type ty, bool is_host) {
+  switch(ty){
+  case INT1_T  : return "bool";
+  case INT8_T  : return "int8_t";
+  case INT16_T : return "int16_t";
+  case INT32_T : return "int32_t";
+  case INT64_T : return "int64_t";
+  case HALF_T  : return "uint16_t";
+  case BF16_T  : return "uint16_t";
+  case FLOAT_T : return "float";
+  case DOUBLE_T: return "double";
+  case BUFFER_T: return is_host ? "void*" : "CUdeviceptr";
+  default: throw std::runtime_error("unknown type");
+  }
+}
+
+// unsigned type that the specialization of an argument reads
+std::string u_type(arg_type ty, bool is_host) {
+  if(ty == BUFFER_T && is_host)
+    return "uintptr_t";
+  switch(size_of(ty)){
+  case 1: return "uint8_t";
+  case 2: return "uint16_t";
+  case 4: return "uint32_t";
+  default: return "uint64_t";
+  }
+}
+
+bool is_integer(const std::string& str) {
+  size_t start = (!str.empty() && str[0] == '-') ? 1 : 0;
+  return str.size() > start &&
+         std::all_of(str.begin() + start, str.end(), [](char c) { return std::isdigit(c); });
+}
+
+struct binary_t {
+  std::string id;
+  std::vector<uint64_t> spec;
+  std::string entry;
+  std::string code;
+  size_t shared_mem;
+};
+
+}
+
+std::map<std::string, std::string> aot_compile(const std::string& name, const std::string& src,
+                                               const std::vector<aot_config>& confs,
+                                               const std::vector<aot_spec_t>& specs,
+                                               driver::device* device,
+                                               const std::string& cpu,
+                                               const std::string& features) {
+  if(confs.empty())
+    throw std::runtime_error("no config to compile");
+  // the generated launchers do not pass hidden arguments
+  for(const aot_config& conf: confs)
+    if(conf.opt.schedule != SCHEDULE_NONE || conf.opt.order != ORDER_NONE)
+      throw std::runtime_error("persistent or tile-ordered kernels cannot be compiled ahead of time");
+  bool is_host = device->backend() == driver::Host;
+  // signature
+  std::shared_ptr<ir::module> ir = kernel::src_to_ir(src, confs[0].opt);
+  std::vector<ir::argument*> args = ir->get_function_list()[0]->args();
+  std::string kernel_name = ir->get_function_list()[0]->get_name();
+  std::vector<arg_type> sig;
+  for(ir::argument* arg: args)
+    sig.push_back(convert(arg->get_type()));
+  std::vector<int> align_idxs;
+  for(size_t i = 0; i < args.size(); i++)
+    if(args[i]->get_type()->is_pointer_ty() ||
+       args[i]->get_type()->is_integer_ty())
+      align_idxs.push_back(i);
+  // specializations, most specialized first. the generic
+  // one always comes last so that every call is valid
+  std::vector<std::vector<uint64_t>> keys;
+  for(const aot_spec_t& spec: specs){
+    std::vector<uint64_t> key(align_idxs.size(), 1);
+    for(const auto& x: spec){
+      auto pred = [&](int idx) { return args[idx]->get_name() == x.first; };
+      auto it = std::find_if(align_idxs.begin(), align_idxs.end(), pred);
+      if(it == align_idxs.end())
+        throw std::runtime_error(x.first + " is not a pointer or integer argument");
+      uint64_t max = max_divisor(sig[*it]);
+      if(x.second == 0 || (x.second & (x.second - 1)) != 0 || x.second > max)
+        throw std::runtime_error("divisor of " + x.first + " must be a power of two no greater than " + std::to_string(max));
+      key[std::distance(align_idxs.begin(), it)] = x.second;
+    }
+    keys.push_back(key);
+  }
+  auto strength = [](const std::vector<uint64_t>& key) {
+    double ret = 0;
+    for(uint64_t x: key)
+      ret += std::log2(x);
+    return ret;
+  };
+  std::stable_sort(keys.begin(), keys.end(), [&](const std::vector<uint64_t>& a, const std::vector<uint64_t>& b) {
+    return strength(a) > strength(b);
+  });
+  keys.push_back(std::vector<uint64_t>(align_idxs.size(), 1));
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  // argument offsets, with natural alignment
+  std::vector<size_t> offs;
+  size_t params_size = 0;
+  for(arg_type ty: sig){
+    size_t size = size_of(ty);
+    params_size = (params_size + size - 1) / size * size;
+    offs.push_back(params_size);
+    params_size += size;
+  }
+  // compile binaries. the entry of a host binary is named after
+  // its LLVM-IR, so binaries that compile to the same code share
+  // their entry and object
+  std::map<std::string, std::string> files;
+  std::map<std::string, std::vector<binary_t>> bins;
+  std::vector<std::string> entries;
+  for(const aot_config& conf: confs){
+    for(size_t i = 0; i < keys.size(); i++){
+      std::shared_ptr<ir::module> ir = kernel::src_to_ir(src, conf.opt);
+      for(size_t k = 0; k < align_idxs.size(); k++){
+        bool is_ptr = sig[align_idxs[k]] == BUFFER_T;
+        ir->get_function_list()[0]->add_attr(align_idxs[k] + 1, ir::attribute(is_ptr ? ir::aligned : ir::multiple_of, keys[i][k]));
+      }
+      auto res = kernel::ir_to_bin(*ir, device, conf.opt, nullptr, nullptr, false);
+      binary_t bin;
+      bin.id = conf.name + "_" + std::to_string(i);
+      bin.spec = keys[i];
+      bin.shared_mem = std::get<2>(res);
+      if(is_host){
+        driver::host_module* mod = (driver::host_module*)std::get<0>(res).get();
+        bin.entry = mod->entry();
+        if(std::find(entries.begin(), entries.end(), bin.entry) == entries.end()){
+          entries.push_back(bin.entry);
+          files[name + "_" + bin.id + ".o"] = mod->object(cpu, features);
+        }
+      }
+      else{
+        bin.entry = kernel_name;
+        bin.code = ((driver::cu_module*)std::get<0>(res).get())->ptx();
+      }
+      bins[conf.name].push_back(bin);
+    }
+  }
+  // dispatch header
+  std::ostringstream os;
+  os << "// Generated by triton-aot from kernel `" << kernel_name << "`. Do not edit." << std::endl;
+  os << "#pragma once" << std::endl;
+  os << std::endl;
+  os << "#include <cstdint>" << std::endl;
+  os << "#include <cstring>" << std::endl;
+  if(!is_host)
+    os << "#include <cuda.h>" << std::endl;
+  os << std::endl;
+  if(is_host){
+    for(const std::string& entry: entries)
+      os << "extern \"C\" void " << entry << "(char**, int32_t, int32_t, int32_t);" << std::endl;
+    os << std::endl;
+  }
+  os << "namespace triton_aot{" << std::endl;
+  os << "namespace " << name << "{" << std::endl;
+  os << "namespace detail{" << std::endl;
+  os << std::endl;
+  os << "inline uint64_t pow2_divisor(uint64_t N, uint64_t max_divisor){" << std::endl;
+  os << "  uint64_t result = 1;" << std::endl;
+  os << "  while(result < max_divisor && N % (2*result) == 0)" << std::endl;
+  os << "    result *= 2;" << std::endl;
+  os << "  return result;" << std::endl;
+  os << "}" << std::endl;
+  os << std::endl;
+  if(is_host){
+    os << "typedef void(*entry_t)(char**, int32_t, int32_t, int32_t);" << std::endl;
+    os << std::endl;
+    os << "// programs run sequentially on the calling thread" << std::endl;
+    os << "inline void launch(entry_t entry, unsigned grid_0, unsigned grid_1, unsigned grid_2, char* params){" << std::endl;
+    os << "  for(unsigned i = 0; i < grid_0; i++)" << std::endl;
+    os << "  for(unsigned j = 0; j < grid_1; j++)" << std::endl;
+    os << "  for(unsigned k = 0; k < grid_2; k++)" << std::endl;
+    os << "    entry((char**)params, i, j, k);" << std::endl;
+    os << "}" << std::endl;
+  }
+  else{
+    os << "struct binary_t{" << std::endl;
+    os << "  const char* ptx;" << std::endl;
+    os << "  const char* entry;" << std::endl;
+    os << "  unsigned shared_mem;" << std::endl;
+    os << "  unsigned num_warps;" << std::endl;
+    os << "  CUmodule module;" << std::endl;
+    os << "  CUfunction function;" << std::endl;
+    os << "};" << std::endl;
+    os << std::endl;
+    os << "// the module is loaded in the current context on first launch" << std::endl;
+    os << "inline CUresult launch(binary_t& bin, CUstream stream, unsigned grid_0, unsigned grid_1, unsigned grid_2, char* params, size_t size){" << std::endl;
+    os << "  CUresult err;" << std::endl;
+    os << "  if(!bin.function){" << std::endl;
+    os << "    if((err = cuModuleLoadData(&bin.module, bin.ptx)) != CUDA_SUCCESS)" << std::endl;
+    os << "      return err;" << std::endl;
+    os << "    if((err = cuModuleGetFunction(&bin.function, bin.module, bin.entry)) != CUDA_SUCCESS)" << std::endl;
+    os << "      return err;" << std::endl;
+    os << "    if(bin.shared_mem > 49152 &&" << std::endl;
+    os << "       (err = cuFuncSetAttribute(bin.function, CU_FUNC_ATTRIBUTE_MAX_DYNAMIC_SHARED_SIZE_BYTES, bin.shared_mem)) != CUDA_SUCCESS)" << std::endl;
+    os << "      return err;" << std::endl;
+    os << "  }" << std::endl;
+    os << "  void *config[] = {" << std::endl;
+    os << "      CU_LAUNCH_PARAM_BUFFER_POINTER, params," << std::endl;
+    os << "      CU_LAUNCH_PARAM_BUFFER_SIZE,    &size," << std::endl;
+    os << "      CU_LAUNCH_PARAM_END" << std::endl;
+    os << "  };" << std::endl;
+    os << "  return cuLaunchKernel(bin.function, grid_0, grid_1, grid_2, bin.num_warps*32, 1, 1, bin.shared_mem, stream, nullptr, config);" << std::endl;
+    os << "}" << std::endl;
+    for(const aot_config& conf: confs)
+    for(const binary_t& bin: bins.at(conf.name)){
+      os << std::endl;
+      os << "static const char ptx_" << bin.id << "[] = R\"ptx(" << bin.code << ")ptx\";" << std::endl;
+      os << "static binary_t " << bin.id << " = {ptx_" << bin.id << ", \"" << bin.entry << "\", "
+         << bin.shared_mem << ", " << conf.opt.num_warps << ", nullptr, nullptr};" << std::endl;
+    }
+  }
+  os << std::endl;
+  os << "}" << std::endl;
+  // launch functions
+  for(const aot_config& conf: confs){
+    const options_t& opt = conf.opt;
+    std::map<std::string, std::string> defines(opt.defines.begin(), opt.defines.end());
+    os << std::endl;
+    os << "//";
+    for(const auto& x: defines)
+      os << " " << x.first << "=" << x.second;
+    os << " num_warps=" << opt.num_warps << " num_stages=" << opt.num_stages << std::endl;
+    for(const auto& x: defines)
+      if(is_integer(x.second))
+        os << "constexpr int64_t " << conf.name << "_" << x.first << " = " << x.second << ";" << std::endl;
+    os << (is_host ? "inline void " : "inline CUresult ") << conf.name << "(";
+    if(!is_host)
+      os << "CUstream _stream, ";
+    os << "unsigned _grid_0, unsigned _grid_1, unsigned _grid_2";
+    for(size_t i = 0; i < args.size(); i++)
+      os << "," << std::endl << "    " << c_type(sig[i], is_host) << " " << args[i]->get_name();
+    os << "){" << std::endl;
+    os << "  alignas(8) char _params[" << std::max<size_t>(params_size, 1) << "];" << std::endl;
+    for(size_t i = 0; i < args.size(); i++)
+      os << "  std::memcpy(_params + " << offs[i] << ", &" << args[i]->get_name() << ", " << size_of(sig[i]) << ");" << std::endl;
+    const std::vector<binary_t>& conf_bins = bins.at(conf.name);
+    for(size_t k = 0; k < align_idxs.size(); k++){
+      int idx = align_idxs[k];
+      auto pred = [&](const binary_t& bin) { return bin.spec[k] > 1; };
+      if(std::none_of(conf_bins.begin(), conf_bins.end(), pred))
+        continue;
+      os << "  uint64_t _div_" << args[idx]->get_name() << " = detail::pow2_divisor((uint64_t)(" << u_type(sig[idx], is_host) << ")"
+         << args[idx]->get_name() << ", " << max_divisor(sig[idx]) << ");" << std::endl;
+    }
+    for(size_t i = 0; i < conf_bins.size(); i++){
+      const binary_t& bin = conf_bins[i];
+      std::string launch = is_host ? "detail::launch(" + bin.entry + ", _grid_0, _grid_1, _grid_2, _params)"
+                                   : "detail::launch(detail::" + bin.id + ", _stream, _grid_0, _grid_1, _grid_2, _params, " + std::to_string(params_size) + ")";
+      std::vector<std::string> conds;
+      for(size_t k = 0; k < align_idxs.size(); k++)
+        if(bin.spec[k] > 1)
+          conds.push_back("_div_" + args[align_idxs[k]]->get_name() + " % " + std::to_string(bin.spec[k]) + " == 0");
+      if(conds.empty()){
+        os << "  " << (is_host ? "" : "return ") << launch << ";" << std::endl;
+        continue;
+      }
+      os << "  if(";
+      for(size_t c = 0; c < conds.size(); c++)
+        os << (c > 0 ? " && " : "") << conds[c];
+      os << ")" << std::endl;
+      os << "    return " << launch << ";" << std::endl;
+    }
+    os << "}" << std::endl;
+  }
+  os << std::endl;
+  os << "}" << std::endl;
+  os << "}" << std::endl;
+  files[name + ".h"] = os.str();
+  return files;
+}
+
+}
+}
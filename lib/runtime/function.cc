@@ -5,6 +5,9 @@
 #include <algorithm>
 #include <sstream>
 #include <memory>
+#include <array>
+#include <cstring>
+#include <limits>
 #include "triton/codegen/analysis/axes.h"
 #include "triton/codegen/analysis/allocation.h"
 #include "triton/codegen/analysis/liveness.h"
@@ -16,15 +19,23 @@
 #include "triton/codegen/transform/membar.h"
 #include "triton/codegen/transform/reassociate.h"
 #include "triton/codegen/transform/cts.h"
+#include "triton/codegen/transform/cse.h"
+#include "triton/codegen/transform/licm.h"
+#include "triton/codegen/transform/simplify.h"
+#include "triton/codegen/transform/masks.h"
 #include "triton/codegen/transform/disassociate.h"
 #include "triton/codegen/selection/generator.h"
 #include "triton/codegen/transform/pipeline.h"
+#include "triton/codegen/transform/persistent.h"
+#include "triton/codegen/transform/tile_order.h"
 #include "triton/runtime/function.h"
 #include "triton/lang/cpp.h"
 #include "triton/lang/parser.h"
 #include "triton/lang/code_gen.h"
 #include "triton/driver/device.h"
 #include "triton/driver/stream.h"
+#include "triton/driver/buffer.h"
+#include "triton/driver/dispatch.h"
 #include "triton/driver/kernel.h"
 #include "triton/driver/module.h"
 #include "triton/driver/error.h"
@@ -68,25 +79,13 @@ R"(
 #define min(a,b) (((a)<(b))?(a):(b))
 #define max(a,b) (((a)>(b))?(a):(b))
 
-#define PASTER(a, b, _) a ## _ ## b
-#define EVALUATOR(a, b, _)  PASTER(a, b, _)
-#define atomic_add(TYPE, TM, TN) EVALUATOR(atomic_add, EVALUATOR(TYPE, EVALUATOR(TM, TN, x), _), _)
-#define DECLARATION(TYPE, TM, TN) extern void atomic_add(TYPE, TM, TN)(TYPE*[TM, TN], TYPE[TM, TN], bool[TM, TN])
-
-DECLARATION(float, 64, 64);
-DECLARATION(float, 64, 128);
-DECLARATION(float, 128, 64);
-DECLARATION(float, 128, 128);
-extern void atomic_add_half_1x1(half*, half, bool);
-
-DECLARATION(half , 64, 64);
-DECLARATION(half , 64, 128);
-DECLARATION(half , 128, 64);
-DECLARATION(half , 128, 128);
-extern void atomic_add_float_1x1(float*, float, bool);
-
 extern int atomic_cas(int*, int, int);
-extern int atomic_xchg(int*, int);
+extern void atomic_add();
+extern void atomic_max();
+extern void atomic_min();
+extern void atomic_xchg();
+extern void atomic_and();
+extern void atomic_or();
 extern int get_program_id(int);
 extern void __debug_barrier();
 extern int get_num_programs(int);
@@ -121,19 +120,22 @@ typedef long int64;
 
 std::tuple<std::shared_ptr<driver::module>,
            std::shared_ptr<driver::kernel>,
-           size_t> kernel::ir_to_bin(ir::module &ir, driver::device* dev, const options_t& opt) {
+           size_t> kernel::ir_to_bin(ir::module &ir, driver::device* dev, const options_t& opt,
+                                     pass_times_t* pass_times,
+                                     stats_t* stats,
+                                     bool load) {
   // generate llvm code
   llvm::LLVMContext ctx;
   std::string name = ir.get_function_list()[0]->get_name();
   std::unique_ptr<llvm::Module> llvm(new llvm::Module(name, ctx));
   // optimizations
   std::unique_ptr<codegen::target> target = dev->make_target();
-  bool cts_use_async = target->as_nvidia()->sm() >= 80;
+  bool cts_use_async = target->as_nvidia() && target->as_nvidia()->sm() >= 80;
   // create passes
   codegen::analysis::align align;
   codegen::analysis::axes axes;
   codegen::transform::cts cts(cts_use_async);
-  codegen::transform::pipeline pipeline(cts_use_async);
+  codegen::transform::pipeline pipeline(cts_use_async, opt.num_stages, !target->is_gpu());
   codegen::transform::disassociate disassociate;
   codegen::analysis::layouts layouts(&axes, &align, opt.num_warps, target.get());
   codegen::analysis::liveness liveness(&layouts);
@@ -141,52 +143,105 @@ std::tuple<std::shared_ptr<driver::module>,
   codegen::analysis::allocation allocation(&liveness);
   codegen::transform::membar barriers(&liveness, &layouts, &allocation);
   codegen::transform::dce dce;
+  codegen::transform::cse cse(&axes, &layouts);
+  codegen::transform::licm licm;
+  codegen::transform::simplify simplify(&align);
+  codegen::transform::masks masks(&align);
   codegen::transform::peephole peephole(target.get(), &layouts);
   codegen::transform::reassociate reassociate;
   codegen::transform::coalesce coalesce(&align, &layouts);
-  codegen::generator isel(&axes, &layouts, &align, &allocation, &swizzle, target.get(), opt.num_warps);
-  // run passes
-  dce.run(ir);
-  pipeline.run(ir);
-  dce.run(ir);
-  disassociate.run(ir);
-  dce.run(ir);
-  align.run(ir);
-  axes.run(ir);
-  layouts.run(ir);
-  peephole.run(ir);
-  dce.run(ir);
+  // a group size alone still selects the grouped order of persistent kernels
+  order_t order_kind = opt.order;
+  if(opt.schedule != SCHEDULE_NONE && opt.order == ORDER_NONE && opt.group_size > 0)
+    order_kind = ORDER_GROUPED;
+  codegen::transform::tile_order order((codegen::transform::tile_order::kind_t)order_kind, opt.group_size);
+  codegen::transform::persistent persistent(&order, opt.schedule == SCHEDULE_DYNAMIC);
+  codegen::generator isel(&axes, &layouts, &align, &allocation, &swizzle, target.get(), opt.num_warps, opt.fast_math);
+  // run passes, timing each of them if requested
+  tools::timer tmr;
+  auto run = [&](auto& pass, const char* pass_name) {
+    if(pass_times)
+      tmr.start();
+    pass.run(ir);
+    if(pass_times)
+      (*pass_times)[pass_name] += tmr.get().count();
+  };
+  if(opt.schedule != SCHEDULE_NONE)
+    run(persistent, "persistent");
+  else if(opt.order != ORDER_NONE)
+    run(order, "tile_order");
+  run(dce, "dce");
+  run(simplify, "simplify");
+  run(dce, "dce");
+  run(masks, "masks");
+  run(dce, "dce");
+  run(pipeline, "pipeline");
+  run(dce, "dce");
+  run(disassociate, "disassociate");
+  run(dce, "dce");
+  run(align, "align");
+  run(axes, "axes");
+  run(layouts, "layouts");
+  run(peephole, "peephole");
+  run(dce, "dce");
+  run(align, "align");
+  run(axes, "axes");
+  run(layouts, "layouts");
+  run(cse, "cse");
+  run(licm, "licm");
+  run(dce, "dce");
 //  ir::print(ir, std::cout);
   if(target->is_gpu())
-    cts.run(ir);
-  align.run(ir);
-  axes.run(ir);
-  layouts.run(ir);
-  coalesce.run(ir);
-  dce.run(ir);
-  align.run(ir);
-  dce.run(ir);
+    run(cts, "cts");
+  run(align, "align");
+  run(axes, "axes");
+  run(layouts, "layouts");
+  run(coalesce, "coalesce");
+  run(dce, "dce");
+  run(align, "align");
+  run(dce, "dce");
   if(target->is_gpu()){
-    reassociate.run(ir);
-    cts.run(ir);
+    run(reassociate, "reassociate");
+    run(cts, "cts");
   }
-  dce.run(ir);
-  align.run(ir);
-  axes.run(ir);
-  layouts.run(ir);
-  peephole.run(ir);
-  dce.run(ir);
-  align.run(ir);
-  axes.run(ir);
-  layouts.run(ir);
-  swizzle.run(ir);
-  liveness.run(ir);
-  allocation.run(ir);
-  barriers.run(ir);
+  run(dce, "dce");
+  run(align, "align");
+  run(axes, "axes");
+  run(layouts, "layouts");
+  run(peephole, "peephole");
+  run(dce, "dce");
+  run(align, "align");
+  run(axes, "axes");
+  run(layouts, "layouts");
+  run(cse, "cse");
+  run(licm, "licm");
+  run(dce, "dce");
+  run(align, "align");
+  run(axes, "axes");
+  run(layouts, "layouts");
+  run(swizzle, "swizzle");
+  run(liveness, "liveness");
+  run(allocation, "allocation");
+  run(barriers, "barriers");
+  tmr.start();
   isel.visit(ir, *llvm);
-  std::shared_ptr<driver::module> mod(driver::module::create(dev, std::move(llvm)));
+  if(pass_times)
+    (*pass_times)["isel"] += tmr.get().count();
+  tmr.start();
+  std::shared_ptr<driver::module> mod(driver::module::create(dev, std::move(llvm), load));
+  if(pass_times)
+    (*pass_times)["llvm"] += tmr.get().count();
   std::shared_ptr<driver::kernel> ker(driver::kernel::create(&*mod, name.c_str()));
   size_t shared_mem = allocation.allocated_size();
+  if(stats){
+    *stats = {shared_mem, allocation.lower_bound(), barriers.num_inserted(), barriers.num_removed(), {}};
+    for(const auto& x: liveness.get()){
+      stats_t::buffer_t buffer = {allocation.offset(x.first), x.first->get_size(), {}};
+      for(const codegen::analysis::segment& s: x.second.segments)
+        buffer.live.push_back({s.start, s.end});
+      stats->shared_buffers.push_back(buffer);
+    }
+  }
   return std::make_tuple(mod, ker, shared_mem);
 }
 
@@ -198,7 +253,31 @@ kernel::kernel(const std::string& src, const options_t& opt, driver::device *dev
   for(const auto&x: attrs)
     ir_->get_function_list()[0]->add_attr(x.first, x.second);
   // compile to binary
-  std::tie(mod_, ker_, shared_mem_) = ir_to_bin(*ir_, dev, opt);
+  std::tie(mod_, ker_, shared_mem_) = ir_to_bin(*ir_, dev, opt, nullptr, &stats_);
+  // persistent mode
+  num_resident_ = 0;
+  if(opt.schedule != SCHEDULE_NONE && dev_->backend() == driver::CUDA){
+    int per_sm = 0;
+    driver::dispatch::cuOccupancyMaxActiveBlocksPerMultiprocessor(&per_sm, *ker_->cu(), opt.num_warps*32, shared_mem_);
+    num_resident_ = ((driver::cu_device*)dev_)->multiprocessor_count() * std::max(per_sm, 1);
+  }
+}
+
+driver::buffer* kernel::counter(driver::stream *stream) const {
+  std::lock_guard<std::mutex> lock(counters_mutex_);
+  std::shared_ptr<driver::buffer>& counter = counters_[stream];
+  if(counter)
+    return counter.get();
+  int32_t zero = 0;
+  if(dev_->backend() == driver::CUDA){
+    counter.reset(new driver::cu_buffer(sizeof(zero)));
+    driver::dispatch::cuMemcpyHtoD(*counter->cu(), &zero, sizeof(zero));
+  }
+  else{
+    counter.reset(new driver::host_buffer(sizeof(zero)));
+    std::memcpy(counter->hst()->data, &zero, sizeof(zero));
+  }
+  return counter.get();
 }
 
 void kernel::operator()(const std::string& args, driver::stream *stream, const std::vector<size_t>& _grid) const{
@@ -208,8 +287,44 @@ void kernel::operator()(const std::string& args, driver::stream *stream, const s
   std::array<size_t, 3> grid;
   for(size_t i = 0; i < 3; i++)
     grid[i] = (i < _grid.size()) ? _grid[i] : 1;
+  std::array<size_t, 3> block = {(size_t)opt.num_warps * 32, 1, 1};
   // enqueue
-  stream->enqueue(&*ker_, grid, {(size_t)opt.num_warps * 32, 1, 1}, (void*)args.data(), args.size(), shared_mem_);
+  if(opt.schedule == SCHEDULE_NONE && opt.order == ORDER_NONE){
+    stream->enqueue(&*ker_, grid, block, (void*)args.data(), args.size(), shared_mem_);
+    return;
+  }
+  // hidden arguments, naturally aligned
+  std::string params = args;
+  auto push = [&](const void* x, size_t size) {
+    params.resize((params.size() + size - 1) / size * size);
+    params.append((const char*)x, size);
+  };
+  for(size_t d = 0; d < 3; d++){
+    int32_t grid_d = grid[d];
+    push(&grid_d, sizeof(grid_d));
+  }
+  if(opt.schedule == SCHEDULE_NONE){
+    stream->enqueue(&*ker_, grid, block, (void*)params.data(), params.size(), shared_mem_);
+    return;
+  }
+  // persistent mode: the tiles are distributed over as many
+  // programs as can run concurrently (one per host thread)
+  size_t num_tiles = grid[0]*grid[1]*grid[2];
+  if(num_tiles > (size_t)std::numeric_limits<int32_t>::max())
+    throw std::runtime_error("too many tiles for a persistent kernel");
+  size_t num_programs = num_resident_;
+  if(stream->backend() == driver::Host)
+    num_programs = ((driver::host_stream*)stream)->num_threads();
+  num_programs = std::max<size_t>(std::min(num_programs, num_tiles), 1);
+  int32_t num_programs_i32 = num_programs;
+  push(&num_programs_i32, sizeof(num_programs_i32));
+  uint64_t counter_ptr = 0;
+  if(opt.schedule == SCHEDULE_DYNAMIC){
+    driver::buffer* buf = counter(stream);
+    counter_ptr = buf->backend() == driver::CUDA ? (uint64_t)*buf->cu() : (uint64_t)buf->hst()->data;
+  }
+  push(&counter_ptr, sizeof(counter_ptr));
+  stream->enqueue(&*ker_, {num_programs, 1, 1}, block, (void*)params.data(), params.size(), shared_mem_);
 }
 
 std::string kernel::get_asm(asm_mode_t mode) {
@@ -258,6 +373,20 @@ std::string kernel::get_asm(asm_mode_t mode) {
 
 
 
+arg_type convert(ir::type *ty) {
+  if(ty->is_integer_ty(1))  return INT1_T;
+  if(ty->is_integer_ty(8))  return INT8_T;
+  if(ty->is_integer_ty(16)) return INT16_T;
+  if(ty->is_integer_ty(32)) return INT32_T;
+  if(ty->is_integer_ty(64)) return INT64_T;
+  if(ty->is_half_ty())      return HALF_T;
+  if(ty->is_bf16_ty())      return BF16_T;
+  if(ty->is_float_ty())     return FLOAT_T;
+  if(ty->is_double_ty())    return DOUBLE_T;
+  if(ty->is_pointer_ty())   return BUFFER_T;
+  throw std::runtime_error("unknown type");
+}
+
 function::function(const std::string& src, const options_t &opt, driver::device *device,
                    const std::vector<config> &tune_confs, const std::vector<std::string>& tune_key)
   : src_(src), device_(device) {
@@ -267,22 +396,15 @@ function::function(const std::string& src, const options_t &opt, driver::device
   for(size_t i = 0; i < tune_confs.size(); i++){
     opts_[i].defines.insert(tune_confs[i].defines.begin(), tune_confs[i].defines.end());
     opts_[i].num_warps = tune_confs[i].num_warps;
+    opts_[i].num_stages = tune_confs[i].num_stages;
+    if(tune_confs[i].order != ORDER_NONE){
+      opts_[i].order = tune_confs[i].order;
+      opts_[i].group_size = tune_confs[i].group_size;
+    }
   }
   std::shared_ptr<ir::module> ir = kernel::src_to_ir(src, opts_[0]);
   std::vector<ir::argument*> args = ir->get_function_list()[0]->args();
   // signature
-  auto convert = [](ir::type *ty) {
-    if(ty->is_integer_ty(1))  return INT1_T;
-    if(ty->is_integer_ty(8))  return INT8_T;
-    if(ty->is_integer_ty(16)) return INT16_T;
-    if(ty->is_integer_ty(32)) return INT32_T;
-    if(ty->is_integer_ty(64)) return INT64_T;
-    if(ty->is_half_ty())      return HALF_T;
-    if(ty->is_float_ty())     return FLOAT_T;
-    if(ty->is_double_ty())    return DOUBLE_T;
-    if(ty->is_pointer_ty())   return BUFFER_T;
-    throw std::runtime_error("unknown type");
-  };
   for(ir::argument* arg: args)
     sig_.push_back(convert(arg->get_type()));
   // find indices of autotune keys
@@ -310,12 +432,17 @@ function::function(const std::string& src, const options_t &opt, driver::device
   }
 }
 
-uint64_t pow2_divisor(uint64_t N){
-  if(N % 16 == 0) return 16;
-  if(N % 8 == 0) return 8;
-  if(N % 4 == 0) return 4;
-  if(N % 2 == 0) return 2;
-  return 1;
+uint64_t max_divisor(arg_type ty){
+  // integers are specialized up to the largest tile size so that
+  // bounds checks against them can be proven away
+  return ty == BUFFER_T ? 16 : 128;
+}
+
+uint64_t pow2_divisor(uint64_t N, uint64_t max_divisor){
+  uint64_t result = 1;
+  while(result < max_divisor && N % (2*result) == 0)
+    result *= 2;
+  return result;
 }
 
 kernel* function::autotune(const std::string &args, const grid_fn_ty& grid_fn, driver::stream* stream) {
@@ -325,7 +452,7 @@ kernel* function::autotune(const std::string &args, const grid_fn_ty& grid_fn, d
     int idx = align_idxs_[i];
     uint64_t tmp = 0;
     std::memcpy((void*)&tmp, (void*)((char*)args.data() + arg_off_[idx]), arg_size_[idx]);
-    rt_key[i] = pow2_divisor(tmp);
+    rt_key[i] = pow2_divisor(tmp, max_divisor(sig_[idx]));
   }
   // auto-tuning key
   std::vector<uint64_t> at_key(key_idxs_.size(), 0);
@@ -0,0 +1,53 @@
+import torch
+import triton
+
+# fused attention against the three block-sparse launches it replaces
+# (sdd matmul, softmax, dsd matmul), on the same layout
+confs = [
+    triton.testing.Benchmark(
+              x_names = ['L'],
+              x_vals  = [512, 1024, 2048, 4096, 8192],
+              y_name  = 'provider',
+              y_vals  = ['fused', 'unfused'],
+              y_lines = ['Fused', 'Unfused'],
+              ylabel  = 'TFLOPS',
+              plot_name = f'attention-{layout_mode}-{mode}',
+              args = {'Z': 4, 'H': 16, 'D': 64, 'block': 64, 'dtype': torch.float16,
+                      'layout_mode': layout_mode, 'mode': mode}
+    )\
+    for layout_mode in ['dense', 'tril'] for mode in ['forward', 'backward']
+]
+
+
+@triton.testing.perf_report(confs)
+def bench_op(Z, H, L, D, block, dtype, layout_mode, mode, provider):
+    make_layout = {
+        'tril': lambda H, M, N: torch.tril(torch.ones((H, M, N), dtype=torch.int64)),
+        'dense': lambda H, M, N: torch.ones(H, M, N, dtype=torch.int64),
+    }[layout_mode]
+    layout = make_layout(H, L // block, L // block)
+    q, k, v = [torch.randn(Z, H, L, D, dtype=dtype, device='cuda', requires_grad=True) for _ in range(3)]
+    scale = D**-0.5
+    if provider == 'fused':
+        attention = triton.ops.blocksparse.attention(layout, block)
+        op = lambda: attention(q, k, v, scale=scale)
+    if provider == 'unfused':
+        sdd = triton.ops.blocksparse.matmul(layout, block, 'sdd', trans_a=False, trans_b=True)
+        softmax = triton.ops.blocksparse.softmax(layout, block)
+        dsd = triton.ops.blocksparse.matmul(layout, block, 'dsd', trans_a=False, trans_b=False)
+        op = lambda: dsd(softmax(sdd(q, k), scale=scale), v)
+    # two matmuls of Z * H * nnz(layout) blocks forward, five backward
+    num_flops = 2 * 2 * Z * D * float(layout.sum()) * block * block * (1 if mode == 'forward' else 2.5) * 1e-12
+    tflops = lambda ms: num_flops / ms * 1e3
+    if mode == 'forward':
+        mean_ms, min_ms, max_ms = triton.testing.do_bench(op)
+    if mode == 'backward':
+        o = op()
+        do = torch.randn_like(o)
+        fn = lambda: o.backward(do, retain_graph=True)
+        mean_ms, min_ms, max_ms = triton.testing.do_bench(fn, grad_to_none=q)
+    return tflops(mean_ms), tflops(min_ms), tflops(max_ms)
+
+
+if __name__ == '__main__':
+    bench_op.run('tmp', False)
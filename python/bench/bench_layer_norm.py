@@ -0,0 +1,48 @@
+import torch
+import triton
+
+confs = [
+    triton.testing.Benchmark(
+              x_names = ['N'],
+              x_vals  = [512, 1024, 2048, 3072, 4096, 6144, 8192, 12288, 16384],
+              y_name  = 'provider',
+              y_vals  = ['triton', 'torch'],
+              y_lines = ['Triton', 'Torch'],
+              ylabel  = 'GBPS',
+              plot_name = f'layer-norm-{mode}-4096',
+              args = {'M': 4096, 'dtype': torch.float16, 'mode': mode}
+    )\
+    for mode in ['forward', 'backward']
+]
+
+
+@triton.testing.perf_report(confs)
+def bench_op(M, N, dtype, mode, provider):
+    # create inputs
+    x = torch.randn(M, N, dtype=dtype, device='cuda', requires_grad=True)
+    w = torch.randn(N, dtype=dtype, device='cuda', requires_grad=True)
+    b = torch.randn(N, dtype=dtype, device='cuda', requires_grad=True)
+    # minimum traffic of either provider: forward reads x, w and b and
+    # writes y, mean and rstd; backward reads x, dy, w, mean and rstd
+    # and writes dx, dw and db. Extra passes over the rows are not counted
+    row, col, stats = x.numel() * x.element_size(), N * w.element_size(), M * 4
+    if mode == 'forward':
+        num_bytes = 2 * row + 2 * col + 2 * stats
+    else:
+        num_bytes = 3 * row + 3 * col + 2 * stats
+    num_gb = num_bytes * 1e-9
+    gbps = lambda ms: num_gb / ms * 1e3
+    op = {'torch': lambda: torch.nn.functional.layer_norm(x, (N, ), w, b),
+          'triton': lambda: triton.ops.layer_norm(x, w, b)}[provider]
+    if mode == 'forward':
+        mean_ms, min_ms, max_ms = triton.testing.do_bench(op)
+    if mode == 'backward':
+        y = op()
+        dy = torch.randn_like(y)
+        fn = lambda: y.backward(dy, retain_graph=True)
+        mean_ms, min_ms, max_ms = triton.testing.do_bench(fn, grad_to_none=x)
+    return gbps(mean_ms), gbps(min_ms), gbps(max_ms)
+
+
+if __name__ == '__main__':
+    bench_op.run('tmp', False)
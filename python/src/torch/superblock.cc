@@ -1,13 +1,36 @@
 #include <torch/extension.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <list>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <vector>
-#ifdef _OPENMP
-#include <omp.h>
-#endif
 
 typedef std::vector<std::tuple<int, torch::Tensor>> ret_t;
 
+// runs f(0), ..., f(n-1) on all hardware threads
+template<class F>
+void parallel_for(int64_t n, F f) {
+  int64_t num_threads = std::min<int64_t>(n, std::max(1u, std::thread::hardware_concurrency()));
+  if(num_threads <= 1){
+    for(int64_t i = 0; i < n; i++)
+      f(i);
+    return;
+  }
+  std::atomic<int64_t> next(0);
+  std::vector<std::thread> threads;
+  for(int64_t t = 0; t < num_threads; t++)
+    threads.emplace_back([&]() {
+      for(int64_t i = next++; i < n; i = next++)
+        f(i);
+    });
+  for(std::thread &t: threads)
+    t.join();
+}
+
 void segment_blocks(torch::Tensor layout, torch::Tensor idx, torch::Tensor scratch, int max_width, ret_t& ret){
   size_t H = layout.size(0);
   size_t M = layout.size(1);
@@ -18,10 +41,7 @@ void segment_blocks(torch::Tensor layout, torch::Tensor idx, torch::Tensor scrat
   auto _idx     = idx.accessor    <int, 3>();
   auto _scratch = scratch.accessor<int, 3>();
   std::vector<int> current(H, 0);
-  #ifdef _OPENMP
-  #pragma omp parallel for
-  #endif
-  for(size_t h = 0; h < H; h++){
+  parallel_for(H, [&](size_t h) {
     // surrounding indices
     std::vector<int>              ii_left(max_width, -1);
     std::vector<std::vector<int>> ii_top(max_width, std::vector<int>(N, -1));
@@ -77,7 +97,7 @@ void segment_blocks(torch::Tensor layout, torch::Tensor idx, torch::Tensor scrat
         }
       }
     }
-  }
+  });
   std::vector<torch::Tensor> to_cat;
   for(size_t h = 0; h < H; h++)
     if(current[h] > 0)
@@ -111,7 +131,239 @@ ret_t superblock(torch::Tensor layout, int start_width) {
   return ret;
 }
 
+/* ------------------------ */
+/* DSD/DDS look-up tables   */
+/* ------------------------ */
+
+struct segment_t {
+  int offset;
+  int size;
+  int column;
+  int lockid;
+  int maxid;
+};
+
+// Splits the reductions of each column into segments of at most
+// `max(sizes)` blocks (heuristics taken from OpenAI blocksparse).
+// Columns split in more than one segment get a lock.
+int load_balance(const std::vector<int>& sizes, std::vector<segment_t>& segments) {
+  int seg_max = 1;
+  for(int size: sizes)
+    seg_max = std::max(seg_max, size);
+  int seg_min = std::max((seg_max + 3) / 4, 4);
+  int nlocks = 0;
+  int offset = 0;
+  for(size_t col = 0; col < sizes.size(); col++){
+    int div = sizes[col] / seg_max;
+    int rem = sizes[col] % seg_max;
+    bool is_empty = sizes[col] < seg_min;
+    int first = segments.size();
+    for(int d = 0; d < div; d++)
+      segments.push_back({0, seg_max, (int)col, 0, 0});
+    if(rem < seg_min && !is_empty)
+      segments.back().size += rem;
+    if(rem >= seg_min || is_empty)
+      segments.push_back({0, rem, (int)col, 0, 0});
+    int num = segments.size() - first;
+    if(div > 1 || (div == 1 && rem >= seg_min)){
+      nlocks++;
+      for(int i = first; i < first + num; i++){
+        segments[i].lockid = nlocks;
+        segments[i].maxid = num;
+      }
+    }
+    for(int i = first; i < first + num; i++){
+      segments[i].offset = offset;
+      offset += segments[i].size;
+    }
+  }
+  return nlocks;
+}
+
+// Builds the look-up table of DSD/DDS kernels from a contiguous
+// H x M x N layout. Reductions go over the rows of each head when
+// `trans` is set and over its columns otherwise. The table is made of
+// a 6-int header per segment (offset, size, column, depth, lock id,
+// number of segments of the column) followed by the pair of pointer
+// increments of each step.
+std::vector<int> make_dxx_lut(const int* layout, int64_t H, int64_t M, int64_t N,
+                              int block, int step, bool trans, int &num_locks, int &width) {
+  int64_t O = trans ? M : N;
+  int64_t I = trans ? N : M;
+  auto at = [&](int64_t h, int64_t o, int64_t i) {
+    return trans ? layout[(h*M + o)*N + i] : layout[(h*M + i)*N + o];
+  };
+  // load-balancing
+  std::vector<std::vector<segment_t>> segments(H);
+  std::vector<int> nlocks(H), nnz(H);
+  parallel_for(H, [&](int64_t h) {
+    std::vector<int> sizes(O, 0);
+    for(int64_t o = 0; o < O; o++)
+    for(int64_t i = 0; i < I; i++)
+      sizes[o] += at(h, o, i) != 0;
+    nlocks[h] = load_balance(sizes, segments[h]);
+    for(int size: sizes)
+      nnz[h] += size;
+  });
+  std::vector<int> seg_start(H + 1, 0), blk_start(H + 1, 0), lock_start(H + 1, 0);
+  for(int64_t h = 0; h < H; h++){
+    seg_start[h + 1] = seg_start[h] + segments[h].size();
+    blk_start[h + 1] = blk_start[h] + nnz[h];
+    lock_start[h + 1] = lock_start[h] + nlocks[h];
+  }
+  width = seg_start[H];
+  num_locks = std::max(1, lock_start[H]);
+  int num_blocks = blk_start[H];
+  // offsets of blocks along the reduction (idx), and
+  // position of blocks in the block-sparse operand (widx)
+  std::vector<int> idx(num_blocks), widx(num_blocks);
+  parallel_for(H, [&](int64_t h) {
+    std::vector<int> rank;
+    if(!trans){
+      rank.resize(M*N);
+      int r = blk_start[h];
+      for(int64_t m = 0; m < M; m++)
+      for(int64_t n = 0; n < N; n++)
+        if(layout[(h*M + m)*N + n] != 0)
+          rank[m*N + n] = r++;
+    }
+    int k = blk_start[h];
+    for(int64_t o = 0; o < O; o++)
+    for(int64_t i = 0; i < I; i++){
+      if(at(h, o, i) == 0)
+        continue;
+      idx[k] = i * block;
+      widx[k] = trans ? k : rank[i*N + o];
+      k++;
+    }
+  });
+  // header
+  int div = block / step;
+  std::vector<int> lut(6*width + 2*div*num_blocks + 2, 0);
+  std::vector<char> is_start(num_blocks, false);
+  parallel_for(H, [&](int64_t h) {
+    for(size_t s = 0; s < segments[h].size(); s++){
+      const segment_t &seg = segments[h][s];
+      int offset = std::min(blk_start[h] + seg.offset, std::max(num_blocks - 1, 0));
+      if(seg.size > 0)
+        is_start[offset] = true;
+      int *header = &lut[6*(seg_start[h] + s)];
+      header[0] = 6*width + 2*div*offset;
+      header[1] = seg.size * step * div;
+      header[2] = seg.column;
+      header[3] = h;
+      header[4] = seg.lockid > 0 ? lock_start[h] + seg.lockid : 0;
+      header[5] = seg.maxid;
+    }
+  });
+  // increments
+  parallel_for(num_blocks, [&](int64_t k) {
+    int *incs = &lut[6*width + 2*div*k];
+    int xinc = idx[k] - (k > 0 ? idx[k - 1] : 0);
+    int winc = (widx[k] - (k > 0 ? widx[k - 1] : 0)) * block * block;
+    int wstep = trans ? step : step * block;
+    for(int d = 0; d < div; d++){
+      incs[2*d + 0] = step;
+      incs[2*d + 1] = wstep;
+    }
+    incs[0] = is_start[k] ? idx[k] : xinc - (div - 1) * step;
+    incs[1] = is_start[k] ? widx[k] : winc - (div - 1) * wstep;
+  });
+  return lut;
+}
+
+/* ------------------------ */
+/* Caching                  */
+/* ------------------------ */
+
+// Look-up tables are cached by layout so that layouts
+// seen before do not have to go through the builders again.
+// At most `capacity` tables are kept: the least recently used
+// ones are evicted, which releases their device memory once
+// they are no longer referenced from Python.
+template<class T>
+class lut_cache {
+  typedef std::tuple<uint64_t, std::vector<int64_t>, std::string> key_t;
+  struct entry_t {
+    key_t key;
+    torch::Tensor layout;
+    T value;
+  };
+
+public:
+  lut_cache(size_t capacity = 64): capacity_(capacity) {}
+
+  template<class F>
+  T get(torch::Tensor layout, const std::string &params, F make) {
+    const char *data = (const char*)layout.data_ptr<int>();
+    size_t nbytes = layout.numel() * sizeof(int);
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for(size_t i = 0; i < nbytes; i++)
+      hash = (hash ^ (uint8_t)data[i]) * 1099511628211ULL;
+    key_t key = std::make_tuple(hash, layout.sizes().vec(), params);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for(auto it = entries_.begin(); it != entries_.end(); it++)
+        if(it->key == key && std::memcmp(it->layout.data_ptr<int>(), data, nbytes) == 0){
+          // most recently used first
+          entries_.splice(entries_.begin(), entries_, it);
+          return it->value;
+        }
+    }
+    T value = make();
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_front({key, layout.clone(), value});
+    if(entries_.size() > capacity_)
+      entries_.pop_back();
+    return value;
+  }
+
+private:
+  size_t capacity_;
+  std::mutex mutex_;
+  std::list<entry_t> entries_;
+};
+
+torch::Tensor to_layout(torch::Tensor layout) {
+  return layout.to(torch::kCPU).to(torch::kInt32).contiguous();
+}
+
+typedef std::vector<std::tuple<torch::Tensor, int, int>> sdd_lut_t;
+typedef std::tuple<torch::Tensor, int, int> dxx_lut_t;
+
+sdd_lut_t sdd_lut(torch::Tensor layout, int block, torch::Device device) {
+  static lut_cache<sdd_lut_t> cache;
+  layout = to_layout(layout);
+  return cache.get(layout, std::to_string(block) + "," + device.str(), [&]() {
+    sdd_lut_t ret;
+    // super-blocking zeroes the layout
+    for(auto &x: superblock(layout.clone(), 128 / block)){
+      int pack = std::get<0>(x);
+      torch::Tensor nnz = std::get<1>(x);
+      int width = nnz.size(0) / (pack * pack);
+      ret.push_back(std::make_tuple(nnz.view(-1).to(device), width, pack));
+    }
+    return ret;
+  });
+}
+
+dxx_lut_t dxx_lut(torch::Tensor layout, int block, int step, bool trans, torch::Device device) {
+  static lut_cache<dxx_lut_t> cache;
+  layout = to_layout(layout);
+  std::string params = std::to_string(block) + "," + std::to_string(step) + "," +
+                       std::to_string(trans) + "," + device.str();
+  return cache.get(layout, params, [&]() {
+    int num_locks, width;
+    std::vector<int> lut = make_dxx_lut(layout.data_ptr<int>(), layout.size(0), layout.size(1), layout.size(2),
+                                        block, step, trans, num_locks, width);
+    torch::Tensor ret = torch::from_blob(lut.data(), {(int64_t)lut.size()}, torch::kInt32).to(device, torch::kInt32, false, true);
+    return std::make_tuple(ret, num_locks, width);
+  });
+}
 
 void init_superblocking(pybind11::module &m) {
   m.def("superblock", &superblock, "super-blocking for block-sparse matrix multiplication");
+  m.def("sdd_lut", &sdd_lut, "look-up tables for SDD block-sparse matrix multiplication");
+  m.def("dxx_lut", &dxx_lut, "look-up table for DSD/DDS block-sparse matrix multiplication");
 }
\ No newline at end of file
@@ -1,10 +1,21 @@
-﻿#include "triton/driver/stream.h"
+﻿#include "triton/codegen/analysis/align.h"
+#include "triton/codegen/transform/dce.h"
+#include "triton/codegen/transform/masks.h"
+#include "triton/codegen/transform/simplify.h"
+#include "triton/driver/event.h"
+#include "triton/driver/stream.h"
+#include "triton/ir/module.h"
+#include "triton/ir/parser.h"
+#include "triton/ir/print.h"
+#include "triton/ir/serialize.h"
+#include "triton/runtime/aot.h"
 #include "triton/runtime/function.h"
 #include <pybind11/buffer_info.h>
 #include <pybind11/functional.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <regex>
+#include <sstream>
 #include <string>
 
 namespace py = pybind11;
@@ -76,8 +87,114 @@ std::string extract_kernels(const std::string &str, const std::vector<std::strin
   return ret;
 }
 
+/*!
+  @brief Functions for converting the Triton-IR of a kernel between its textual and binary forms
+
+  The text is that of ir::print, which ir::parse reads back
+*/
+std::string print_ir(const std::string &src, const std::map<std::string, std::string> &defines) {
+  rt::options_t opt;
+  opt.defines.insert(defines.begin(), defines.end());
+  std::shared_ptr<ir::module> mod = rt::kernel::src_to_ir(src, opt);
+  std::ostringstream oss;
+  ir::print(*mod, oss);
+  return oss.str();
+}
+
+std::string parse_ir(const std::string &text) {
+  ir::module mod("");
+  std::istringstream iss(text);
+  ir::parse(iss, mod);
+  std::ostringstream oss;
+  ir::print(mod, oss);
+  return oss.str();
+}
+
+py::bytes serialize_ir(const std::string &text) {
+  ir::module mod("");
+  std::istringstream iss(text);
+  ir::parse(iss, mod);
+  std::ostringstream oss;
+  ir::serialize(mod, oss);
+  return py::bytes(oss.str());
+}
+
+std::string deserialize_ir(const std::string &bin) {
+  ir::module mod("");
+  std::istringstream iss(bin);
+  ir::deserialize(iss, mod);
+  std::ostringstream oss;
+  ir::print(mod, oss);
+  return oss.str();
+}
+
+/*!
+  @brief Function for running IR-level passes on the textual IR of a module
+
+  Passes ("dce", "simplify" or "masks") run in the given order; the result is printed
+*/
+std::string transform_ir(const std::string &text, const std::vector<std::string> &passes) {
+  ir::module mod("");
+  std::istringstream iss(text);
+  ir::parse(iss, mod);
+  codegen::analysis::align align;
+  codegen::transform::dce dce;
+  codegen::transform::simplify simplify(&align);
+  codegen::transform::masks masks(&align);
+  for (const std::string &pass : passes) {
+    if (pass == "dce")
+      dce.run(mod);
+    else if (pass == "simplify")
+      simplify.run(mod);
+    else if (pass == "masks")
+      masks.run(mod);
+    else
+      throw std::runtime_error("unknown pass: " + pass);
+  }
+  std::ostringstream oss;
+  ir::print(mod, oss);
+  return oss.str();
+}
+
+/*!
+  @brief Function for compiling a kernel ahead of time for the host
+
+  Returns the dispatch header and object files of runtime::aot_compile, by name
+*/
+std::map<std::string, py::bytes> aot_compile(const std::string &name, const std::string &src,
+                                             const std::map<std::string, rt::config> &configs,
+                                             const std::vector<rt::aot_spec_t> &specs,
+                                             const std::string &cpu, const std::string &features,
+                                             bool fast_math) {
+  std::vector<rt::aot_config> confs;
+  for (const auto &x : configs) {
+    rt::aot_config conf;
+    conf.name = x.first;
+    conf.opt.defines.insert(x.second.defines.begin(), x.second.defines.end());
+    conf.opt.num_warps = x.second.num_warps;
+    conf.opt.num_stages = x.second.num_stages;
+    conf.opt.order = x.second.order;
+    conf.opt.group_size = x.second.group_size;
+    conf.opt.fast_math = fast_math;
+    confs.push_back(conf);
+  }
+  drv::host_device device;
+  std::map<std::string, py::bytes> ret;
+  for (const auto &x : rt::aot_compile(name, src, confs, specs, &device, cpu, features))
+    ret.insert({x.first, py::bytes(x.second)});
+  return ret;
+}
+
 void init_triton_tools(py::module &&m) {
   m.def("extract_kernels", &extract_kernels);
+  m.def("print_ir", &print_ir, py::arg("src"), py::arg("defines") = std::map<std::string, std::string>());
+  m.def("parse_ir", &parse_ir);
+  m.def("serialize_ir", &serialize_ir);
+  m.def("deserialize_ir", &deserialize_ir);
+  m.def("transform_ir", &transform_ir);
+  m.def("aot_compile", &aot_compile, py::arg("name"), py::arg("src"), py::arg("configs"),
+        py::arg("specs") = std::vector<rt::aot_spec_t>(), py::arg("cpu") = "generic", py::arg("features") = "",
+        py::arg("fast_math") = true);
 }
 
 /*****************************************************************************/
@@ -95,10 +212,21 @@ void init_triton_driver(py::module &&m) {
       .def(py::init<>());
 
   // base stream
-  py::class_<drv::stream>(m, "stream");
+  py::class_<drv::stream>(m, "stream")
+      .def("synchronize", &drv::stream::synchronize)
+      .def("record", &drv::stream::record)
+      .def("wait", &drv::stream::wait);
   // host stream
   py::class_<drv::host_stream, drv::stream>(m, "host_stream")
-      .def(py::init<>());
+      .def(py::init<size_t>(), py::arg("num_threads") = 1)
+      .def_property_readonly("num_threads", &drv::host_stream::num_threads)
+      .def("set_profiler", &drv::host_stream::set_profiler);
+  // host profiler
+  py::class_<drv::host_profiler, std::shared_ptr<drv::host_profiler>>(m, "host_profiler")
+      .def(py::init<>())
+      .def("clear", &drv::host_profiler::clear)
+      .def("chrome_trace", &drv::host_profiler::chrome_trace)
+      .def("json", &drv::host_profiler::json);
   // cuda stream
   py::class_<drv::cu_stream, drv::stream>(m, "cu_stream")
       // py doesn't support opaque pointer (e.g., CUstream) so
@@ -106,6 +234,17 @@ void init_triton_driver(py::module &&m) {
       .def(py::init([](uint64_t handle, bool take_ownership) {
         return std::unique_ptr<driver::cu_stream>(new driver::cu_stream((CUstream)handle, take_ownership));
       }));
+
+  // base event
+  py::class_<drv::event>(m, "event")
+      .def("synchronize", &drv::event::synchronize)
+      .def("elapsed_time", &drv::event::elapsed_time);
+  // host event
+  py::class_<drv::host_event, drv::event>(m, "host_event")
+      .def(py::init<>());
+  // cuda event, created in the current context
+  py::class_<drv::cu_event, drv::event>(m, "cu_event")
+      .def(py::init<>());
 }
 
 /*****************************************************************************/
@@ -120,6 +259,7 @@ void init_triton_runtime(py::module &&m) {
       .value("int32", rt::INT32_T)
       .value("int64", rt::INT64_T)
       .value("half", rt::HALF_T)
+      .value("bf16", rt::BF16_T)
       .value("float", rt::FLOAT_T)
       .value("double", rt::DOUBLE_T)
       .value("buffer", rt::BUFFER_T);
@@ -127,23 +267,59 @@ void init_triton_runtime(py::module &&m) {
   py::enum_<rt::asm_mode_t>(m, "asm_mode")
       .value("ptx", rt::ASM_NV_PTX)
       .value("sass", rt::ASM_NV_SASS);
+  // persistent execution
+  py::enum_<rt::schedule_t>(m, "schedule")
+      .value("none", rt::SCHEDULE_NONE)
+      .value("static", rt::SCHEDULE_STATIC)
+      .value("dynamic", rt::SCHEDULE_DYNAMIC);
+  // tile order
+  py::enum_<rt::order_t>(m, "order")
+      .value("none", rt::ORDER_NONE)
+      .value("grouped", rt::ORDER_GROUPED)
+      .value("morton", rt::ORDER_MORTON)
+      .value("hilbert", rt::ORDER_HILBERT);
   // compilation options
   py::class_<rt::options_t>(m, "options", py::dynamic_attr())
       .def(py::init<>())
       .def_readwrite("defines", &rt::options_t::defines)
       .def_readwrite("num_warps", &rt::options_t::num_warps)
+      .def_readwrite("num_stages", &rt::options_t::num_stages)
+      .def_readwrite("fast_math", &rt::options_t::fast_math)
+      .def_readwrite("schedule", &rt::options_t::schedule)
+      .def_readwrite("order", &rt::options_t::order)
+      .def_readwrite("group_size", &rt::options_t::group_size)
       .def("__getattr__", [](rt::options_t *opt, const std::string &name) {
         return opt->D<int>(name);
       });
   //  kernel
+  py::class_<rt::kernel::stats_t::buffer_t>(m, "shared_buffer")
+      .def_readonly("offset", &rt::kernel::stats_t::buffer_t::offset)
+      .def_readonly("size", &rt::kernel::stats_t::buffer_t::size)
+      .def_readonly("live", &rt::kernel::stats_t::buffer_t::live);
+  py::class_<rt::kernel::stats_t>(m, "kernel_stats")
+      .def_readonly("shared_mem", &rt::kernel::stats_t::shared_mem)
+      .def_readonly("shared_mem_lower_bound", &rt::kernel::stats_t::shared_mem_lower_bound)
+      .def_readonly("barriers_inserted", &rt::kernel::stats_t::barriers_inserted)
+      .def_readonly("barriers_removed", &rt::kernel::stats_t::barriers_removed)
+      .def_readonly("shared_buffers", &rt::kernel::stats_t::shared_buffers);
   py::class_<rt::kernel>(m, "kernel")
       .def("__call__", &rt::kernel::operator())
-      .def_readonly("opt", &rt::kernel::opt);
+      .def_readonly("opt", &rt::kernel::opt)
+      .def("asm", &rt::kernel::get_asm)
+      .def_property_readonly("stats", &rt::kernel::stats);
   // tune conf
   py::class_<rt::config>(m, "config")
-      .def(py::init<std::map<std::string, std::string>, int>(),
+      .def(py::init<std::map<std::string, std::string>, int, int, rt::order_t, int>(),
            py::arg("defines") = std::map<std::string, std::string>(),
-           py::arg("num_warps"));
+           py::arg("num_warps"),
+           py::arg("num_stages") = 2,
+           py::arg("order") = rt::ORDER_NONE,
+           py::arg("group_size") = 0)
+      .def_readwrite("defines", &rt::config::defines)
+      .def_readwrite("num_warps", &rt::config::num_warps)
+      .def_readwrite("num_stages", &rt::config::num_stages)
+      .def_readwrite("order", &rt::config::order)
+      .def_readwrite("group_size", &rt::config::group_size);
 
   // function
   py::class_<rt::function>(m, "function")
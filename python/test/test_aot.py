@@ -0,0 +1,106 @@
+import platform
+import shutil
+import subprocess
+import triton
+import triton._C.libtriton.triton as _triton
+import pytest
+
+src = """
+__global__ void add(float *X __readonly __noalias, float *Y __readonly __noalias,
+                    float *Z __noalias, int N) {
+  int off[BLOCK] = get_program_id(0) * BLOCK + 0 ... BLOCK;
+  bool check[BLOCK] = off < N;
+  float x[BLOCK] = check ? *(X + off) : 0;
+  float y[BLOCK] = check ? *(Y + off) : 0;
+  *?(check)(Z + off) = x + y;
+}
+"""
+
+act_src = """
+__global__ void act(float *X __readonly __noalias, float *Y __noalias, int N) {
+  int off[BLOCK] = get_program_id(0) * BLOCK + 0 ... BLOCK;
+  bool check[BLOCK] = off < N;
+  float x[BLOCK] = check ? *(X + off) : 0;
+  *?(check)(Y + off) = tanh(x);
+}
+"""
+
+main = """
+#include <cstdio>
+#include <vector>
+#include "add.h"
+
+int main() {
+  for(int N: {1000, 1024}){
+    std::vector<float> x(N), y(N), z(N, -1);
+    for(int i = 0; i < N; i++){
+      x[i] = i;
+      y[i] = 2*i;
+    }
+    unsigned grid = (N + triton_aot::add::CONFIG_BLOCK - 1) / triton_aot::add::CONFIG_BLOCK;
+    triton_aot::add::CONFIG(grid, 1, 1, x.data(), y.data(), z.data(), N);
+    for(int i = 0; i < N; i++)
+      if(z[i] != 3*i){
+        std::printf("N=%d: z[%d] = %f\\n", N, i, z[i]);
+        return 1;
+      }
+  }
+  std::printf("ok\\n");
+  return 0;
+}
+"""
+
+
+def build_and_run(tmp_path, files, config):
+    cxx = shutil.which("c++")
+    if cxx is None:
+        pytest.skip("no C++ compiler")
+    objs = sorted(name for name in files if name.endswith(".o"))
+    for name, content in files.items():
+        (tmp_path / name).write_bytes(content)
+    (tmp_path / "main.cc").write_text(main.replace("CONFIG", config))
+    exe = tmp_path / "main"
+    subprocess.check_call([cxx, "-std=c++11", "-I", str(tmp_path), str(tmp_path / "main.cc")]
+                          + [str(tmp_path / name) for name in objs] + ["-o", str(exe), "-lm"])
+    out = subprocess.run([str(exe)], stdout=subprocess.PIPE, check=True).stdout.decode()
+    assert out.strip() == "ok"
+
+
+# the dispatch header and the objects, compiled for a generic
+# CPU, are linked into a standalone program that checks them
+@pytest.mark.parametrize("cpu, features", [
+    ("generic", ""),
+    pytest.param("x86-64", "+sse4.2", marks=pytest.mark.skipif(platform.machine() != "x86_64", reason="x86 only")),
+])
+def test_host(tmp_path, cpu, features):
+    configs = {"small": triton.config(defines={"BLOCK": "128"}, num_warps=1)}
+    specs = [{"X": 16, "Y": 16, "Z": 16, "N": 16}]
+    files = _triton.tools.aot_compile("add", src, configs, specs, cpu=cpu, features=features)
+    # the generic and the specialized binaries
+    assert sorted(name for name in files if name.endswith(".o")) == ["add_small_0.o", "add_small_1.o"]
+    build_and_run(tmp_path, files, "small")
+
+
+def test_host_duplicates(tmp_path):
+    # configs that compile to the same code share their objects,
+    # which would otherwise define the same entry twice
+    configs = {"small": triton.config(defines={"BLOCK": "128"}, num_warps=1),
+               "same": triton.config(defines={"BLOCK": "128"}, num_warps=1)}
+    specs = [{"X": 16, "Y": 16, "Z": 16, "N": 16}]
+    files = _triton.tools.aot_compile("add", src, configs, specs)
+    assert sorted(name for name in files if name.endswith(".o")) == ["add_same_0.o", "add_same_1.o"]
+    build_and_run(tmp_path, files, "small")
+    build_and_run(tmp_path, files, "same")
+
+
+def test_host_options():
+    # options of the configs are forwarded: persistent or
+    # tile-ordered configs are rejected rather than ignored,
+    # and fast math changes the generated code
+    configs = {"small": triton.config(defines={"BLOCK": "128"}, num_warps=1, order=triton.order.grouped)}
+    with pytest.raises(RuntimeError):
+        _triton.tools.aot_compile("add", src, configs)
+    configs = {"small": triton.config(defines={"BLOCK": "128"}, num_warps=1)}
+    objs = [_triton.tools.aot_compile("act", act_src, configs, fast_math=fast_math)["act_small_0.o"]
+            for fast_math in [True, False]]
+    assert objs[0] != objs[1]
@@ -0,0 +1,76 @@
+import functools
+import torch
+import triton
+import pytest
+
+src = """
+__global__ void atomic(TYPE *X __noalias __readonly, TYPE *Z __noalias, TYPE *OLD __noalias) {
+  int pid = get_program_id(0);
+  int rm[TM] = 0 ... TM;
+  int rn[TN] = 0 ... TN;
+  int off[TM, TN] = rm[:, newaxis] * TN + rn [newaxis, :];
+  TYPE *px[TM, TN] = X + pid * TM * TN + off;
+  TYPE *pz[TM, TN] = Z + off;
+  TYPE old[TM, TN] = OP(pz, *px, rm[:, newaxis] < M);
+  TYPE *pold[TM, TN] = OLD + pid * TM * TN + off;
+  *pold = old;
+}
+"""
+
+@pytest.mark.parametrize("op, dtype, TM, TN",
+    [
+    (op, dtype, TM, TN) for op in ['add', 'max', 'min']
+                        for dtype in ['int32', 'float32']
+                        for TM, TN in [(1, 64), (16, 16), (32, 8)]
+    ] + [
+    (op, 'int32', 16, 16) for op in ['and', 'or', 'xchg']
+    ] + [('add', 'float16', 16, 16), ('xchg', 'float32', 16, 16)]
+                         )
+def test_op(op, dtype, TM, TN, P=4):
+    dtype = getattr(torch, dtype)
+    M = TM // 2 if TM > 1 else 1
+    # xchg results depend on the order of programs
+    P = 1 if op == 'xchg' else P
+    if dtype.is_floating_point:
+        x = torch.randn(P, TM, TN, dtype=dtype, device='cuda')
+    else:
+        x = torch.randint(-100, 100, (P, TM, TN), dtype=dtype, device='cuda')
+    z = torch.zeros(TM, TN, dtype=dtype, device='cuda')
+    if op in ['and', 'or']:
+        z = torch.randint(-100, 100, (TM, TN), dtype=dtype, device='cuda')
+    old = torch.empty_like(x)
+    # reference
+    th_z = z.clone()
+    red = {
+        'add': lambda x: th_z + x.sum(0),
+        'max': lambda x: torch.max(th_z, x.max(0)[0]),
+        'min': lambda x: torch.min(th_z, x.min(0)[0]),
+        'and': lambda x: functools.reduce(torch.bitwise_and, x, th_z),
+        'or': lambda x: functools.reduce(torch.bitwise_or, x, th_z),
+        'xchg': lambda x: x[0],
+    }[op]
+    th_z[:M] = red(x).to(dtype)[:M]
+    # triton
+    defines = {'TYPE': dtype, 'TM': TM, 'TN': TN, 'M': M, 'OP': f'atomic_{op}'}
+    kernel = triton.kernel(src, device=x.device, defines=defines)
+    kernel(x.data_ptr(), z.data_ptr(), old.data_ptr(), grid=lambda opt: [P])
+    atol = 1e-2 if dtype == torch.float16 else 1e-5
+    assert torch.allclose(z, th_z, atol=atol)
+    if op == 'xchg':
+        assert torch.equal(old[0, :M], torch.zeros_like(old[0, :M]))
+
+# tiles smaller than the number of threads are replicated
+# across them: each element must still be updated once, and
+# every replica must see the value it had before the update
+@pytest.mark.parametrize("TM, TN, num_warps", [(1, 64, 4), (1, 32, 8), (2, 32, 4), (4, 16, 8)])
+def test_replicas(TM, TN, num_warps):
+    x = torch.randint(1, 100, (1, TM, TN), dtype=torch.int32, device='cuda')
+    z = torch.randint(-100, 100, (TM, TN), dtype=torch.int32, device='cuda')
+    old = torch.empty_like(x)
+    th_z = z + x[0]
+    th_old = z.clone()
+    defines = {'TYPE': torch.int32, 'TM': TM, 'TN': TN, 'M': TM, 'OP': 'atomic_add'}
+    kernel = triton.kernel(src, device=x.device, defines=defines, num_warps=num_warps)
+    kernel(x.data_ptr(), z.data_ptr(), old.data_ptr(), grid=lambda opt: [1])
+    assert torch.equal(z, th_z)
+    assert torch.equal(old[0], th_old)
@@ -0,0 +1,64 @@
+import torch
+import triton
+import pytest
+
+def torch_attention(q, k, v, scale, layout, block, attn_mask=None, key_padding_mask=None):
+    L = q.shape[2]
+    s = torch.einsum("zhsd,zhtd->zhst", q.float(), k.float()) * scale
+    if key_padding_mask is not None:
+        s = s + key_padding_mask[:, None, None, :].float()
+    if attn_mask is not None:
+        s = s.masked_fill(attn_mask == 0, float("-inf"))
+    # blocks outside of the layout
+    dense = layout.repeat_interleave(block, 1).repeat_interleave(block, 2)[:, :L, :L].to(q.device)
+    s = s.masked_fill(dense[None] == 0, float("-inf"))
+    p = torch.softmax(s, -1).nan_to_num()
+    return torch.einsum("zhst,zhtd->zhsd", p, v.float()).to(q.dtype)
+
+@pytest.mark.parametrize(
+    "BLOCK, L, D, DTYPE, LAYOUT",
+    [(block, L, D, dtype, layout) for block in [16, 32, 64] for L in [256, 400] for D in [32, 64]
+     for dtype in ["float16", "float32"] for layout in ["random", "tril"]],
+)
+def test_op(BLOCK, L, D, DTYPE, LAYOUT, Z=2, H=3):
+    DTYPE = {"float16": torch.float16, "float32": torch.float32}[DTYPE]
+    torch.random.manual_seed(0)
+    scale = D**-0.5
+    num_blocks = triton.cdiv(L, BLOCK)
+    # every block row keeps its diagonal block
+    layout = {
+        "random": torch.randint(2, (H, num_blocks, num_blocks)) | torch.eye(num_blocks, dtype=torch.int64),
+        "tril": torch.tril(torch.ones(H, num_blocks, num_blocks, dtype=torch.int64)),
+    }[LAYOUT]
+    attn_mask = torch.tril(torch.ones(L, L, dtype=DTYPE, device="cuda")) if LAYOUT == "tril" else None
+    kp_mask = torch.zeros(Z, L, dtype=DTYPE, device="cuda")
+    kp_mask[:, -L // 8:] = float("-inf")
+    q, k, v = [torch.randn(Z, H, L, D, dtype=DTYPE, device="cuda", requires_grad=True) for _ in range(3)]
+    dout = torch.randn(Z, H, L, D, dtype=DTYPE, device="cuda")
+    # triton result
+    op = triton.ops.blocksparse.attention(layout, BLOCK)
+    tt_o = op(q, k, v, scale=scale, key_padding_mask=kp_mask, attn_mask=attn_mask, attn_mask_mode="mul")
+    tt_o.backward(dout)
+    tt_grads = [x.grad.clone() for x in (q, k, v)]
+    for x in (q, k, v):
+        x.grad = None
+    # torch result
+    th_o = torch_attention(q, k, v, scale, layout, BLOCK, attn_mask, kp_mask)
+    th_o.backward(dout)
+    th_grads = [x.grad.clone() for x in (q, k, v)]
+    # compare
+    assert triton.testing.allclose(th_o, tt_o)
+    for th_g, tt_g in zip(th_grads, tt_grads):
+        assert triton.testing.allclose(th_g, tt_g)
+
+@pytest.mark.parametrize("CAUSAL, DTYPE", [(causal, dtype) for causal in [False, True] for dtype in ["float16", "float32"]])
+def test_dense(CAUSAL, DTYPE, Z=2, H=4, L=1000, D=64):
+    DTYPE = {"float16": torch.float16, "float32": torch.float32}[DTYPE]
+    torch.random.manual_seed(0)
+    q, k, v = [torch.randn(Z, H, L, D, dtype=DTYPE, device="cuda") for _ in range(3)]
+    tt_o = triton.ops.attention(q, k, v, causal=CAUSAL)
+    s = torch.einsum("zhsd,zhtd->zhst", q.float(), k.float()) * D**-0.5
+    if CAUSAL:
+        s = s.masked_fill(torch.ones(L, L, device="cuda").tril() == 0, float("-inf"))
+    th_o = torch.einsum("zhst,zhtd->zhsd", torch.softmax(s, -1), v.float()).to(DTYPE)
+    assert triton.testing.allclose(th_o, tt_o)
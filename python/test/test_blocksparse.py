@@ -36,6 +36,128 @@ def test_matmul(MODE, TRANS_A, TRANS_B, BLOCK, DTYPE, Z=3, H=2, M=128, N=256, K=
     # compare
     assert triton.testing.allclose(rc, tc)
 
+# look-up tables of the Python implementation that libtriton replaced,
+# with lock ids increasing across heads
+def load_balance_ref(sizes):
+    max_size = sizes.max()
+    seg_max = max_size
+    seg_min = max(triton.cdiv(seg_max, 4), 4)
+    div = sizes // seg_max
+    rem = sizes % seg_max
+    packs = div + (sizes < seg_min).long() + (rem >= seg_min).long()
+    width = packs.sum()
+    segments = torch.empty(width, dtype=sizes.dtype)
+    column = torch.empty_like(segments)
+    lockid = torch.zeros_like(segments)
+    maxid = torch.zeros_like(segments)
+    nlocks = 0
+    current = 0
+    col_idx = 0
+    for i in range(len(sizes)):
+        d, r = div[i], rem[i]
+        isempty = sizes[i] < seg_min
+        last = current + d + (r >= seg_min) + isempty
+        column[current:last] = col_idx
+        if d > 1 or (d == 1 and r >= seg_min):
+            nlocks += 1
+            lockid[current:last] = nlocks
+            maxid[current:last] = last - current
+        segments[current:current + d] = seg_max
+        if r < seg_min and not isempty:
+            segments[current + d - 1] += r
+        if r >= seg_min or isempty:
+            segments[current + d] = r
+        current = last
+        col_idx += 1
+    offsets = torch.zeros_like(segments)
+    offsets[1:] = torch.cumsum(segments[:-1], dim=0)
+    return segments, column, lockid, maxid, offsets, nlocks
+
+def make_dxx_lut_ref(layout, block, step, trans):
+    _empty = torch.tensor([], dtype=torch.int64)
+    segments, column, depth, lockid, maxid, offsets = [_empty.clone() for _ in range(6)]
+    current_offset = 0
+    current_maxid = 0
+    for z in range(layout.size(0)):
+        sizes = torch.sum(layout[z, :, :], 1 if trans else 0)
+        z_segments, z_column, z_lockid, z_maxid, z_offsets, z_nlocks = load_balance_ref(sizes)
+        z_lockid[z_lockid > 0] += current_maxid
+        current_maxid += z_nlocks
+        segments = torch.cat((segments, z_segments))
+        column = torch.cat((column, z_column))
+        depth = torch.cat((depth, z * torch.ones_like(z_segments)))
+        maxid = torch.cat((maxid, z_maxid))
+        offsets = torch.cat((offsets, current_offset + z_offsets))
+        lockid = torch.cat((lockid, z_lockid))
+        current_offset += layout[z, :, :].sum()
+    segments *= step
+    # pointer increments
+    nnz = layout.nonzero(as_tuple=False) if trans else layout.transpose(1, 2).nonzero(as_tuple=False)
+    num_blocks = nnz.size(0)
+    offsets = torch.min(offsets, (num_blocks - 1) * torch.ones_like(offsets))
+    idx = nnz[:, 2] * block
+    xincs = idx.clone()
+    xincs[1:] -= idx[:-1]
+    div = block // step
+    xincs = xincs.view(-1, 1).repeat(1, div)
+    xincs[:, 1:] = step
+    xincs[:, 0] -= (div - 1) * step
+    xincs[offsets[segments > 0], 0] = idx[offsets[segments > 0]]
+    xincs = xincs.view(-1)
+    if trans:
+        widx = torch.arange(num_blocks)
+    else:
+        widx = _empty.clone()
+        current_offset = 0
+        for z in range(layout.size(0)):
+            layoutw = layout[z, :, :].clone()
+            msum = layoutw.sum()
+            layoutw[layoutw > 0] = 1 + torch.arange(msum)
+            widx = torch.cat((widx, current_offset + layoutw.T[layoutw.T > 0] - 1))
+            current_offset += msum
+    wstep = step if trans else step * block
+    wincs = widx * block * block
+    wincs[1:] -= widx[:-1] * block * block
+    wincs = wincs.view(-1, 1).repeat(1, div)
+    wincs[:, 1:] = wstep
+    wincs[:, 0] -= (div - 1) * wstep
+    wincs[offsets[segments > 0], 0] = widx[offsets[segments > 0]]
+    wincs = wincs.view(-1)
+    offsets *= 2 * div
+    segments *= div
+    width = column.size(0)
+    offsets += 6 * width
+    header = torch.stack((offsets, segments, column, depth, lockid, maxid), dim=1).view(-1)
+    incs = torch.stack((xincs, wincs), dim=1).view(-1)
+    incs = torch.cat((incs, torch.zeros(2, dtype=incs.dtype)))
+    lut = torch.cat((header, incs)).type(torch.int32)
+    return lut, max(1, int(lockid.max())), width
+
+@pytest.mark.parametrize(
+    "BLOCK, STEP, TRANS, DENSITY",
+    [(block, step, trans, density) for block in [16, 32, 64] for step in [16, 32, 64] if step <= block
+     for trans in [False, True] for density in [0.1, 0.5, 1.0]],
+)
+def test_lut(BLOCK, STEP, TRANS, DENSITY, H=3, M=13, N=21):
+    torch.random.manual_seed(0)
+    layout = (torch.rand(H, M, N) < DENSITY).long()
+    # keep a block in every head
+    layout[:, 0, 0] = 1
+    lut, num_locks, width = triton._C.libtriton.dxx_lut(layout, BLOCK, STEP, TRANS, torch.device("cpu"))
+    ref_lut, ref_num_locks, ref_width = make_dxx_lut_ref(layout, BLOCK, STEP, TRANS)
+    assert (width, num_locks) == (ref_width, ref_num_locks)
+    assert torch.equal(lut, ref_lut)
+    # sdd tables are the super-blocks of the layout
+    for (lut, width, pack), (ref_pack, nnz) in zip(triton._C.libtriton.sdd_lut(layout, BLOCK, torch.device("cpu")),
+                                                   triton._C.libtriton.superblock(layout.int(), 128 // BLOCK)):
+        assert (width, pack) == (nnz.shape[0] // (ref_pack * ref_pack), ref_pack)
+        assert torch.equal(lut, nnz.view(-1).int())
+    # layouts seen before are served from the cache, including after eviction
+    for density in [0.2 + 0.01 * i for i in range(100)]:
+        triton._C.libtriton.dxx_lut((torch.rand(H, M, N) < density).long(), BLOCK, STEP, TRANS, torch.device("cpu"))
+    lut, num_locks, width = triton._C.libtriton.dxx_lut(layout, BLOCK, STEP, TRANS, torch.device("cpu"))
+    assert torch.equal(lut, ref_lut)
+
 @pytest.mark.parametrize(
     "BLOCK, WIDTH",
     [(block, width) for block in [32] for width in [256, 576, 1024, 1792]],
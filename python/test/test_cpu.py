@@ -0,0 +1,198 @@
+import json
+import os
+import struct
+import subprocess
+import sys
+import torch
+import triton
+import triton._C.libtriton.triton as _triton
+import pytest
+
+
+@pytest.mark.parametrize("M, N, K, AT, BT", [
+    (M, N, K, AT, BT) for M, N, K in [(128, 128, 128), (107, 233, 311)]
+                      for AT in [False, True]
+                      for BT in [False, True]
+])
+def test_matmul(M, N, K, AT, BT):
+    torch.manual_seed(0)
+    a = torch.randn((K, M) if AT else (M, K), dtype=torch.float32)
+    b = torch.randn((N, K) if BT else (K, N), dtype=torch.float32)
+    a = a.t() if AT else a
+    b = b.t() if BT else b
+    th_c = torch.matmul(a, b)
+    tt_c = triton.ops.matmul(a, b)
+    assert triton.testing.allclose(th_c, tt_c)
+
+
+@pytest.mark.parametrize("M, N", [(128, 512), (67, 857)])
+def test_cross_entropy(M, N):
+    x = torch.randn(M, N, dtype=torch.float32, requires_grad=True)
+    idx = 4 + torch.ones(M, dtype=torch.int64)
+    tt_y = triton.ops.cross_entropy(x, idx)
+    th_y = torch.nn.CrossEntropyLoss(reduction="none")(x, idx)
+    assert torch.allclose(th_y, tt_y, atol=1e-3, rtol=1e-2)
+    dy = torch.randn_like(tt_y)
+    tt_y.backward(dy)
+    tt_dx = x.grad.clone()
+    x.grad.zero_()
+    th_y.backward(dy)
+    th_dx = x.grad.clone()
+    assert torch.allclose(th_dx, tt_dx, atol=1e-3, rtol=1e-2)
+
+
+@pytest.mark.parametrize("BLOCK, WIDTH", [(16, 128), (32, 256)])
+def test_blocksparse_softmax(BLOCK, WIDTH):
+    torch.random.manual_seed(0)
+    Z, H, M, N = 2, 4, WIDTH, WIDTH
+    scale = 0.4
+    layout = torch.randint(2, (H, M // BLOCK, N // BLOCK))
+    x = torch.randn((Z, H, M, N), dtype=torch.float32)
+    op = triton.ops.blocksparse.softmax(layout, BLOCK)
+    ty = op(triton.testing.sparsify_tensor(x, layout, BLOCK), scale=scale)
+    rx = triton.testing.mask_tensor(x, layout, BLOCK, value=float("-inf"))
+    ry = triton.testing.sparsify_tensor(torch.softmax(rx * scale, -1), layout, BLOCK)
+    assert triton.testing.allclose(ry, ty)
+
+
+@pytest.mark.parametrize("num_threads", [1, 4])
+def test_num_threads(num_threads):
+    # every program of the launch writes its own row
+    old = triton.get_num_threads()
+    triton.set_num_threads(num_threads)
+    try:
+        x = torch.randn(67, 857, dtype=torch.float32, requires_grad=True)
+        idx = torch.zeros(67, dtype=torch.int64)
+        tt_y = triton.ops.cross_entropy(x, idx)
+        th_y = torch.nn.CrossEntropyLoss(reduction="none")(x, idx)
+        assert torch.allclose(th_y, tt_y, atol=1e-3, rtol=1e-2)
+    finally:
+        triton.set_num_threads(old)
+
+
+def test_do_bench():
+    x = torch.randn(1024, 1024)
+    ms, min_ms, max_ms = triton.testing.do_bench(lambda: x + x, warmup=1, rep=5, device='cpu')
+    assert 0 < min_ms <= ms <= max_ms
+
+
+def test_profile_host(tmp_path):
+    x = torch.randn(67, 857, dtype=torch.float32)
+    idx = torch.zeros(67, dtype=torch.int64)
+    with triton.profile_host(tmp_path / "trace.json") as prof:
+        triton.ops.cross_entropy(x, idx)
+    launch = prof["launches"][-1]
+    assert launch["programs"]["count"] == 67
+    assert sum(w["programs"] for w in launch["workers"]) == 67
+    assert sum(launch["programs"]["histogram_log2_ns"]) == 67
+    assert launch["imbalance"] >= 1
+    trace = json.load(open(tmp_path / "trace.json"))
+    assert sum(e.get("cat") == "program" for e in trace["traceEvents"]) >= 67
+
+
+# every tile of a 3D grid writes its linear id once
+_tiles_src = """
+__global__ void tiles(int *X) {
+  int p0 = get_program_id(0);
+  int p1 = get_program_id(1);
+  int p2 = get_program_id(2);
+  int n0 = get_num_programs(0);
+  int n1 = get_num_programs(1);
+  int off = (p2 * n1 + p1) * n0 + p0;
+  atomic_add(X + off, off + 1);
+}
+"""
+
+
+@pytest.mark.parametrize("schedule, group_size", [
+    ("static", 0), ("dynamic", 0), ("dynamic", 3),
+])
+def test_persistent(schedule, group_size):
+    # the tile counter must be reset between two launches
+    grid = (7, 5, 3)
+    kernel = triton.kernel(_tiles_src, device=torch.device('cpu'), schedule=schedule, group_size=group_size)
+    for _ in range(2):
+        x = torch.zeros(7 * 5 * 3, dtype=torch.int32)
+        kernel(x.data_ptr(), grid=lambda opt: grid)
+        assert torch.equal(x, torch.arange(1, x.numel() + 1, dtype=torch.int32))
+
+
+@pytest.mark.parametrize("schedule, order, group_size", [
+    ("dynamic", "grouped", 3), ("dynamic", "hilbert", 4),
+    (None, "grouped", 3), (None, "morton", 2), (None, "hilbert", 4),
+])
+def test_tile_order(schedule, order, group_size):
+    grid = (7, 5, 3)
+    kernel = triton.kernel(_tiles_src, device=torch.device('cpu'), schedule=schedule, order=order,
+                           group_size=group_size)
+    for _ in range(2):
+        x = torch.zeros(7 * 5 * 3, dtype=torch.int32)
+        kernel(x.data_ptr(), grid=lambda opt: grid)
+        assert torch.equal(x, torch.arange(1, x.numel() + 1, dtype=torch.int32))
+
+
+def test_dynamic_streams():
+    # concurrent launches on different streams pull tiles from different counters
+    grid = (7, 5, 3)
+    kernel = triton.kernel(_tiles_src, device=torch.device('cpu'), schedule='dynamic')
+    streams = [_triton.driver.host_stream(4) for _ in range(4)]
+    xs = [torch.zeros(7 * 5 * 3, dtype=torch.int32) for _ in streams]
+    params = [struct.pack(kernel.tys, x.data_ptr()) for x in xs]
+    compiled = kernel.fn.autotune(params[0], lambda opt: grid, streams[0])
+    for _ in range(8):
+        for p, stream in zip(params, streams):
+            compiled(p, stream, grid)
+    for stream in streams:
+        stream.synchronize()
+    for x in xs:
+        assert torch.equal(x, 8 * torch.arange(1, x.numel() + 1, dtype=torch.int32))
+
+
+def test_unload():
+    # the object of a kernel is unlinked with its last module,
+    # after which the same kernel can be linked again
+    for _ in range(3):
+        kernel = triton.kernel(_tiles_src, device=torch.device('cpu'))
+        x = torch.zeros(2 * 3, dtype=torch.int32)
+        kernel(x.data_ptr(), grid=lambda opt: (2, 3, 1))
+        assert torch.equal(x, torch.arange(1, x.numel() + 1, dtype=torch.int32))
+        del kernel
+
+
+def test_unload_pending():
+    # launches still queued on a stream keep the code of
+    # their kernel linked after the kernel is destroyed
+    grid = (7, 5, 3)
+    kernel = triton.kernel(_tiles_src, device=torch.device('cpu'))
+    stream = _triton.driver.host_stream(1)
+    x = torch.zeros(7 * 5 * 3, dtype=torch.int32)
+    params = struct.pack(kernel.tys, x.data_ptr())
+    compiled = kernel.fn.autotune(params, lambda opt: grid, stream)
+    for _ in range(64):
+        compiled(params, stream, grid)
+    del compiled, kernel
+    stream.synchronize()
+    assert torch.equal(x, 64 * torch.arange(1, x.numel() + 1, dtype=torch.int32))
+
+
+_cache_script = """
+import torch, triton
+from test_cpu import _tiles_src
+kernel = triton.kernel(_tiles_src, device=torch.device('cpu'))
+x = torch.zeros(2 * 3, dtype=torch.int32)
+kernel(x.data_ptr(), grid=lambda opt: (2, 3, 1))
+assert torch.equal(x, torch.arange(1, x.numel() + 1, dtype=torch.int32))
+"""
+
+
+def test_object_cache(tmp_path):
+    # a second process links the objects cached by the first
+    # one instead of compiling them again
+    env = dict(os.environ, TRITON_CACHE_PATH=str(tmp_path))
+    run = lambda: subprocess.check_call([sys.executable, "-c", _cache_script], env=env,
+                                        cwd=os.path.dirname(os.path.abspath(__file__)))
+    run()
+    objs = {p.name: p.stat().st_mtime_ns for p in tmp_path.glob("*.o")}
+    assert objs
+    run()
+    assert {p.name: p.stat().st_mtime_ns for p in tmp_path.glob("*.o")} == objs
@@ -0,0 +1,87 @@
+import torch
+import triton
+import pytest
+
+# reductions and broadcasts of dot results, whose [TM, TN] layout differs
+# from that of the [TM] rows and of the [TM, TD] tiles they are combined with
+src = {
+'reduce': """
+__global__ void reduce(TYPE *A __readonly __noalias,
+                       TYPE *B __readonly __noalias,
+                       float *Y __noalias) {
+  int rm[TM] = 0 ... TM;
+  int rn[TN] = 0 ... TN;
+  int rk[TK] = 0 ... TK;
+  TYPE *pa[TM, TK] = A + rm[:, newaxis] * TK + rk[newaxis, :];
+  TYPE *pb[TK, TN] = B + rk[:, newaxis] * TN + rn[newaxis, :];
+  float c[TM, TN] = (*pa) @ (*pb);
+  float *py[TM] = Y + rm;
+  *py = c[:, REDUCE];
+}
+""",
+'broadcast': """
+__global__ void broadcast(TYPE *A __readonly __noalias,
+                          TYPE *B __readonly __noalias,
+                          TYPE *V __readonly __noalias,
+                          float *O __noalias) {
+  int rm[TM] = 0 ... TM;
+  int rn[TN] = 0 ... TN;
+  int rk[TK] = 0 ... TK;
+  int rd[TD] = 0 ... TD;
+  TYPE *pa[TM, TK] = A + rm[:, newaxis] * TK + rk[newaxis, :];
+  TYPE *pb[TK, TN] = B + rk[:, newaxis] * TN + rn[newaxis, :];
+  TYPE *pv[TN, TD] = V + rn[:, newaxis] * TD + rd[newaxis, :];
+  float s[TM, TN] = (*pa) @ (*pb);
+  float smax[TM] = s[:, max];
+  float p[TM, TN] = exp(s - smax[:, newaxis]);
+  TYPE tp[TM, TN] = p;
+  float acc[TM, TD] = tp @ (*pv);
+  float l[TM] = p[:, +];
+  float *po[TM, TD] = O + rm[:, newaxis] * TD + rd[newaxis, :];
+  *po = acc / l[:, newaxis];
+}
+""",
+}
+
+kernels = dict()
+
+def get_kernel(name, dtype, defines):
+    key = (name, dtype, tuple(sorted(defines.items())))
+    if key not in kernels:
+        defines = dict(defines, TYPE=dtype)
+        kernels[key] = triton.kernel(src[name], device=torch.device('cuda'), defines=defines, num_warps=4)
+    return kernels[key]
+
+@pytest.mark.parametrize("REDUCE, DTYPE, TM, TN, TK", [
+    (reduce, dtype, TM, TN, TK) for reduce in ['+', 'max'] for dtype in ['float16', 'float32']
+                                for (TM, TN, TK) in [(64, 64, 32), (32, 128, 16), (128, 32, 64)]
+])
+def test_reduce(REDUCE, DTYPE, TM, TN, TK):
+    dtype = {'float16': torch.float16, 'float32': torch.float32}[DTYPE]
+    torch.manual_seed(0)
+    a = torch.randn(TM, TK, dtype=dtype, device='cuda')
+    b = torch.randn(TK, TN, dtype=dtype, device='cuda')
+    y = torch.empty(TM, dtype=torch.float32, device='cuda')
+    kernel = get_kernel('reduce', dtype, {'TM': TM, 'TN': TN, 'TK': TK, 'REDUCE': REDUCE})
+    kernel(a.data_ptr(), b.data_ptr(), y.data_ptr(), grid=lambda opt: [1])
+    c = torch.matmul(a.float(), b.float())
+    th_y = c.sum(-1) if REDUCE == '+' else c.max(-1).values
+    assert triton.testing.allclose(th_y, y)
+
+@pytest.mark.parametrize("DTYPE, TM, TN, TK, TD", [
+    (dtype, TM, TN, TK, TD) for dtype in ['float16', 'float32']
+                            for (TM, TN, TK, TD) in [(64, 64, 32, 32), (32, 64, 16, 128), (64, 32, 64, 16)]
+])
+def test_broadcast(DTYPE, TM, TN, TK, TD):
+    dtype = {'float16': torch.float16, 'float32': torch.float32}[DTYPE]
+    torch.manual_seed(0)
+    a = torch.randn(TM, TK, dtype=dtype, device='cuda')
+    b = torch.randn(TK, TN, dtype=dtype, device='cuda')
+    v = torch.randn(TN, TD, dtype=dtype, device='cuda')
+    o = torch.empty(TM, TD, dtype=torch.float32, device='cuda')
+    kernel = get_kernel('broadcast', dtype, {'TM': TM, 'TN': TN, 'TK': TK, 'TD': TD})
+    kernel(a.data_ptr(), b.data_ptr(), v.data_ptr(), o.data_ptr(), grid=lambda opt: [1])
+    s = torch.matmul(a.float(), b.float())
+    p = torch.exp(s - s.max(-1, keepdim=True).values)
+    th_o = torch.matmul(p.to(dtype).float(), v.float()) / p.sum(-1, keepdim=True)
+    assert triton.testing.allclose(th_o, o)
@@ -0,0 +1,87 @@
+import struct
+import torch
+import triton
+import triton._C.libtriton.triton as _triton
+import pytest
+
+# every program adds its id to a slot, so that many launches take a while
+add_src = """
+__global__ void add(int *X) {
+  int pid = get_program_id(0);
+  atomic_add(X + pid % 64, pid);
+}
+"""
+
+copy_src = """
+__global__ void copy(int *X, int *Y) {
+  int off[64] = 0 ... 64;
+  *(Y + off) = *(X + off);
+}
+"""
+
+devices = ['cpu', pytest.param('cuda', marks=pytest.mark.skipif(not torch.cuda.is_available(), reason="no GPU"))]
+
+# torch streams must outlive the triton streams that wrap them
+_torch_streams = []
+
+
+def make_stream(device):
+    if device == 'cpu':
+        return _triton.driver.host_stream(2)
+    stream = torch.cuda.Stream()
+    _torch_streams.append(stream)
+    return _triton.driver.cu_stream(stream.cuda_stream, False)
+
+
+def make_event(device):
+    return _triton.driver.host_event() if device == 'cpu' else _triton.driver.cu_event()
+
+
+def launcher(src, device, stream, *args, grid):
+    kernel = triton.kernel(src, device=torch.device(device), num_warps=2)
+    params = struct.pack(kernel.tys, *[x.data_ptr() for x in args])
+    compiled = kernel.fn.autotune(params, lambda opt: grid, stream)
+    return lambda: compiled(params, stream, grid)
+
+
+@pytest.mark.parametrize("device", devices)
+def test_wait(device):
+    # the copy on the second stream only starts once the
+    # additions recorded on the first stream are done
+    writer, reader = make_stream(device), make_stream(device)
+    x = torch.zeros(64, dtype=torch.int32, device=device)
+    y = torch.full((64, ), -1, dtype=torch.int32, device=device)
+    add = launcher(add_src, device, writer, x, grid=(64 * 1024, 1, 1))
+    copy = launcher(copy_src, device, reader, x, y, grid=(1, 1, 1))
+    if device == 'cuda':
+        torch.cuda.synchronize()
+    event = make_event(device)
+    for _ in range(16):
+        add()
+    writer.record(event)
+    reader.wait(event)
+    copy()
+    reader.synchronize()
+    pid = torch.arange(64 * 1024, dtype=torch.int64)
+    expected = 16 * torch.zeros(64, dtype=torch.int64).index_add_(0, pid % 64, pid)
+    assert torch.equal(y.cpu().long(), expected)
+    writer.synchronize()
+
+
+@pytest.mark.parametrize("device", devices)
+def test_elapsed_time(device):
+    stream = make_stream(device)
+    x = torch.zeros(64, dtype=torch.int32, device=device)
+    add = launcher(add_src, device, stream, x, grid=(64 * 1024, 1, 1))
+    if device == 'cuda':
+        torch.cuda.synchronize()
+    events = [make_event(device) for _ in range(3)]
+    stream.record(events[0])
+    for event in events[1:]:
+        for _ in range(4):
+            add()
+        stream.record(event)
+    events[-1].synchronize()
+    times = [events[0].elapsed_time(event) for event in events]
+    assert 0 <= times[1] <= times[2]
+    assert times[2] > 0
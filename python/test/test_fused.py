@@ -0,0 +1,63 @@
+import torch
+import triton
+import pytest
+
+F = triton.ops.fused
+
+
+@pytest.mark.parametrize("device, dtype", [
+    (device, dtype) for device in ['cuda', 'cpu']
+                    for dtype in ['float16', 'float32']
+                    if not (device == 'cpu' and dtype == 'float16')
+])
+def test_bias_gelu(device, dtype, M=67, N=857):
+    dtype = {'float16': torch.float16, 'float32': torch.float32}[dtype]
+    x = torch.randn(M, N, dtype=dtype, device=device)
+    b = torch.randn(N, dtype=dtype, device=device)
+    fn = F.fuse(F.gelu(F.input('x') + F.input('b')))
+    th_y = torch.nn.functional.gelu((x + b).float()).to(dtype)
+    tt_y = fn(x=x, b=b)
+    assert torch.allclose(th_y, tt_y, atol=1e-3, rtol=1e-2)
+
+
+@pytest.mark.parametrize("device", ['cuda', 'cpu'])
+def test_broadcast(device, M=33, N=1000):
+    x = torch.randn(M, N, device=device)
+    r = torch.randn(M, 1, device=device)
+    s = torch.randn(1, device=device)
+    c = torch.randn(N, 3, device=device)[:, 0]
+    e = F.where(F.input('x') > 0.5, F.abs(F.input('x')) * F.input('r'), F.maximum(F.input('s'), F.input('c')))
+    th_y = torch.where(x > 0.5, x.abs() * r, torch.max(s, c).expand(M, N))
+    tt_y = F.fuse(e)(x=x, r=r, s=s, c=c)
+    assert torch.allclose(th_y, tt_y)
+
+
+@pytest.mark.parametrize("device, op, N", [
+    (device, op, N) for device in ['cuda', 'cpu']
+                    for op in ['sum', 'mean', 'max', 'min']
+                    for N in [129, 4099]
+])
+def test_reduce(device, op, N, M=17):
+    x = torch.randn(M, N, device=device)
+    m = torch.randn(M, 1, device=device)
+    fn = F.fuse(getattr(F, op)(F.exp(F.input('x') - F.input('m'))))
+    th_y = getattr(torch.exp(x - m), op)(-1)
+    th_y = th_y.values if op in ['max', 'min'] else th_y
+    tt_y = fn(x=x, m=m)
+    assert torch.allclose(th_y, tt_y, rtol=1e-4)
+
+
+@pytest.mark.parametrize("device", ['cuda', 'cpu'])
+def test_dropout(device, p=0.3, seed=1234, N=10007):
+    x = torch.randn(N, device=device)
+    tt_y = F.fuse(F.dropout(F.input('x'), p, seed))(x=x)
+    # same hash as the kernel, in 32-bit arithmetic
+    mask = 2**32 - 1
+    h = torch.arange(N, dtype=torch.int64) ^ ((seed * 1664525) & mask)
+    h = ((h ^ (h >> 16)) * 73244475) & mask
+    h = ((h ^ (h >> 16)) * 73244475) & mask
+    h = h ^ (h >> 16)
+    keep = ((h & 16777215).float() / 16777216 >= p).to(device)
+    th_y = torch.where(keep, x / (1 - p), torch.zeros_like(x))
+    assert torch.allclose(th_y, tt_y)
+    assert abs(keep.float().mean().item() - (1 - p)) < 0.02
@@ -0,0 +1,79 @@
+import re
+import triton
+import triton._C.libtriton.triton as _triton
+import pytest
+
+tools = _triton.tools
+
+matmul_defines = {
+    'STRIDE_AM': 'lda', 'STRIDE_AK': '1', 'STRIDE_BK': 'ldb', 'STRIDE_BN': '1',
+    'LDA_POW2_DIV': '8', 'LDB_POW2_DIV': '8', 'LDC_POW2_DIV': '8', 'IS_TK_DIV_K': '1',
+    'TM': '64', 'TN': '64', 'TK': '32'
+}
+
+@pytest.mark.parametrize("defines", [
+    dict(matmul_defines, TYPE='half', SPLITK='1'),
+    dict(matmul_defines, TYPE='float', SPLITK='2', SPLITK_WORKSPACE='1'),
+    dict(matmul_defines, TYPE='char', ACC_TYPE='int', TYPE_C='half', SCALED='1', SPLITK='1'),
+])
+def test_roundtrip(defines):
+    text = tools.print_ir(triton.ops._matmul.src, defines)
+    # print -> parse -> print
+    assert tools.parse_ir(text) == text
+    # serialize -> deserialize
+    binary = tools.serialize_ir(text)
+    assert len(binary) < len(text)
+    assert tools.deserialize_ir(binary) == text
+    assert tools.serialize_ir(tools.deserialize_ir(binary)) == binary
+
+fold_src = """
+__global__ void fold(int *X __noalias __aligned(16), int *Y __noalias __aligned(16), int n) {
+  int off[TM] = 0 ... TM;
+  int x[TM] = *(X + off);
+  int three[TM] = 3;
+  int c[TM] = three * 4 + 1;
+  *(Y + off) = (x + 0) * 1 + c;
+  *(Y + TM + off) = x * n + c * 0;
+}
+"""
+
+def test_fold():
+    text = tools.print_ir(fold_src, {'TM': '64'})
+    ret = tools.transform_ir(text, ['simplify', 'dce'])
+    assert tools.parse_ir(ret) == ret
+    # operations on constant splats are folded into a single splat
+    assert 'splat i32<64> i32 13;' in ret
+    # identities are removed
+    assert len(re.findall(r'= add i32<64>', ret)) == 1
+    assert len(re.findall(r'= mul i32<64>', ret)) == 1
+    # the product with a runtime argument is kept
+    assert re.search(r'(%\d+) = splat i32<64> %n;\n  %\d+ = mul i32<64> %\d+, \1;', ret)
+
+masks_src = """
+__global__ void mask(float *X __noalias __aligned(16), float *Y __noalias __aligned(16),
+                     int K __multipleof(TK), int N) {
+  int rk[TK] = 0 ... TK;
+  float *px[TK] = X + rk;
+  float acc[TK] = 0;
+  for (int k = K; k > 0; k -= TK) {
+    acc += *?(rk < k)px;
+    px += TK;
+  }
+  *?(rk < TK)(Y + rk) = acc;
+  *?(rk < N)(Y + TK + rk) = acc;
+}
+"""
+
+def test_masks():
+    text = tools.print_ir(masks_src, {'TK': '32'})
+    assert len(re.findall(r'\bmasked_load\b', text)) == 1
+    assert len(re.findall(r'\bmasked_store\b', text)) == 2
+    ret = tools.transform_ir(text, ['dce', 'simplify', 'dce', 'masks', 'dce'])
+    assert tools.parse_ir(ret) == ret
+    # K is a multiple of TK, so the mask holds while the loop runs,
+    # and the offsets are always smaller than TK
+    assert not re.search(r'\bmasked_load\b', ret)
+    assert len(re.findall(r'\bunmasked_load\b', ret)) == 1
+    # N is only known at run time
+    assert len(re.findall(r'\bmasked_store\b', ret)) == 1
+    assert re.search(r'(%\d+) = splat i32<32> %N;\n  %\d+ = icmp_slt i1<32> %\d+, \1;', ret)
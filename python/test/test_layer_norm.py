@@ -0,0 +1,61 @@
+import torch
+import triton
+import pytest
+
+def rms_norm(x, w, eps=1e-6):
+    x = x.float()
+    return x * torch.rsqrt(x.pow(2).mean(-1, keepdim=True) + eps) * w.float()
+
+@pytest.mark.parametrize("M, N, dtype, mode, rms",
+    [
+    (M, N, dtype, mode, rms) for M in [1024, 821]
+                             for N in [512, 857, 1871, 8573]
+                             for dtype in ['float16', 'float32']
+                             for mode in ['forward', 'backward']
+                             for rms in [False, True]
+    ]
+                         )
+def test_op(M, N, dtype, mode, rms):
+    dtype = {'float16': torch.float16, 'float32': torch.float32}[dtype]
+    # create inputs
+    x = torch.randn(M, N, dtype=dtype, device='cuda', requires_grad=True)
+    w = torch.randn(N, dtype=dtype, device='cuda', requires_grad=True)
+    b = torch.randn(N, dtype=dtype, device='cuda', requires_grad=True)
+    params = [x, w] if rms else [x, w, b]
+    # forward pass
+    if rms:
+        tt_y = triton.ops.rms_norm(x, w)
+        th_y = rms_norm(x, w).to(dtype)
+    else:
+        tt_y = triton.ops.layer_norm(x, w, b)
+        th_y = torch.nn.functional.layer_norm(x.float(), (N, ), w.float(), b.float()).to(dtype)
+    if mode == 'forward':
+        assert torch.allclose(th_y, tt_y, atol=1e-2, rtol=1e-2)
+    # backward pass
+    elif mode == 'backward':
+        dy = torch.randn_like(tt_y)
+        tt_y.backward(dy)
+        tt_grads = [p.grad.clone() for p in params]
+        for p in params:
+            p.grad = None
+        th_y.backward(dy)
+        th_grads = [p.grad.clone() for p in params]
+        for th_g, tt_g in zip(th_grads, tt_grads):
+            # weight gradients are sums over M rows
+            scale = th_g.float().abs().max().item()
+            assert torch.allclose(th_g.float() / scale, tt_g.float() / scale, atol=1e-2, rtol=1e-2)
+
+@pytest.mark.parametrize("N", [857, 8573])
+def test_no_bias(N):
+    M, dtype = 821, torch.float16
+    x = torch.randn(M, N, dtype=dtype, device='cuda', requires_grad=True)
+    w = torch.randn(N, dtype=dtype, device='cuda', requires_grad=True)
+    tt_y = triton.ops.layer_norm(x, w, None)
+    th_y = torch.nn.functional.layer_norm(x.float(), (N, ), w.float(), None).to(dtype)
+    assert torch.allclose(th_y, tt_y, atol=1e-2, rtol=1e-2)
+    dy = torch.randn_like(tt_y)
+    tt_dx, tt_dw = torch.autograd.grad(tt_y, [x, w], dy)
+    th_dx, th_dw = torch.autograd.grad(th_y, [x, w], dy)
+    for th_g, tt_g in [(th_dx, tt_dx), (th_dw, tt_dw)]:
+        scale = th_g.float().abs().max().item()
+        assert torch.allclose(th_g.float() / scale, tt_g.float() / scale, atol=1e-2, rtol=1e-2)
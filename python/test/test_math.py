@@ -0,0 +1,59 @@
+import torch
+import triton
+import pytest
+
+src = """
+__global__ void math(TYPE *X __noalias __readonly, TYPE *Y __noalias, int N) {
+  int off[BLOCK] = get_program_id(0) * BLOCK + 0 ... BLOCK;
+  bool check[BLOCK] = off < N;
+  TYPE *px[BLOCK] = X + off;
+  TYPE *py[BLOCK] = Y + off;
+  float x[BLOCK] = *? (check)px;
+  *? (check)py = OP(x);
+}
+"""
+
+ref = {
+    'tanh': torch.tanh,
+    'erf': torch.erf,
+    'sigmoid': torch.sigmoid,
+    'sin': torch.sin,
+    'cos': torch.cos,
+    'rsqrt': torch.rsqrt,
+}
+
+@pytest.mark.parametrize("op, dtype, fast_math",
+    [
+    (op, dtype, fast_math) for op in ref.keys()
+                           for dtype in ['float16', 'float32']
+                           for fast_math in [False, True]
+    ]
+                         )
+def test_op(op, dtype, fast_math, N=3931, BLOCK=1024):
+    dtype = {'float16': torch.float16, 'float32': torch.float32}[dtype]
+    x = 4 * torch.randn(N, dtype=dtype, device='cuda')
+    if op == 'rsqrt':
+        x = x.abs() + 1e-2
+    y = torch.empty_like(x)
+    defines = {'TYPE': dtype, 'BLOCK': BLOCK, 'OP': op}
+    kernel = triton.kernel(src, device=x.device, defines=defines, fast_math=fast_math)
+    kernel(x.data_ptr(), y.data_ptr(), N, grid=lambda opt: [triton.cdiv(N, BLOCK)])
+    th_y = ref[op](x.float()).to(dtype)
+    atol, rtol = (1e-3, 1e-2) if fast_math or dtype == torch.float16 else (1e-6, 1e-5)
+    assert torch.allclose(y, th_y, atol=atol, rtol=rtol)
+
+# builtin names are only reserved where they are called
+def test_identifiers(N=1024):
+    src = """
+    __global__ void identifiers(float *X, float *Y) {
+      int off[N] = 0 ... N;
+      float sigmoid[N] = *(X + off);
+      float cos = 2;
+      *(Y + off) = tanh(sigmoid) * cos;
+    }
+    """
+    x = torch.randn(N, device='cuda')
+    y = torch.empty_like(x)
+    kernel = triton.kernel(src, device=x.device, defines={'N': N})
+    kernel(x.data_ptr(), y.data_ptr(), grid=lambda opt: [1])
+    assert torch.allclose(y, 2 * torch.tanh(x), atol=1e-3, rtol=1e-2)
@@ -1,6 +1,9 @@
 import pytest
+import re
+import struct
 import itertools
 import triton
+import triton._C.libtriton.triton as _triton
 import torch
 
 @pytest.mark.parametrize(
@@ -44,11 +47,11 @@ import torch
             (128, 128, 32, 1, 4, 384, 128, 640, AT, BT, DTYPE),
             (128, 128, 32, 1, 4, 107, 233, 256, AT, BT, DTYPE),
             (128, 128, 32, 1, 4, 107, 233, 311, AT, BT, DTYPE),
-        ] for DTYPE in ["float16", "float32"] for AT in [False, True] for BT in [False, True]
+        ] for DTYPE in ["float16", "bfloat16", "float32"] for AT in [False, True] for BT in [False, True]
     ]),
 )
 def test_op(TM, TN, TK, SPLITK, NWARP, M, N, K, AT, BT, DTYPE):
-    DTYPE = {"float16": torch.float16, "float32": torch.float32}[DTYPE]
+    DTYPE = {"float16": torch.float16, "bfloat16": torch.bfloat16, "float32": torch.float32}[DTYPE]
     torch.manual_seed(0)
     defines = {"TM": str(TM), "TN": str(TN), "TK": str(TK), "SPLITK": str(SPLITK)}
     triton.ops._matmul._kernels = dict()
@@ -66,3 +69,122 @@ def test_op(TM, TN, TK, SPLITK, NWARP, M, N, K, AT, BT, DTYPE):
     th_c = torch.matmul(a, b)
     tt_c = triton.ops.matmul(a, b)
     assert triton.testing.allclose(th_c, tt_c)
+
+
+@pytest.mark.parametrize(
+    "TM, TN, TK, SPLITK, M, N, K, DTYPE",
+    itertools.chain(*[
+        [
+            (64, 64, 16, 2, 64, 64, 32, DTYPE),
+            (64, 64, 16, 4, 64, 64, 64, DTYPE),
+            (64, 64, 16, 8, 64, 64, 128, DTYPE),
+            (64, 64, 32, 4, 107, 233, 1024, DTYPE),
+            (32, 128, 32, 8, 256, 128, 4096, DTYPE),
+        ] for DTYPE in ["float16", "float32"]
+    ]),
+)
+def test_splitk_workspace(TM, TN, TK, SPLITK, M, N, K, DTYPE):
+    DTYPE = {"float16": torch.float16, "float32": torch.float32}[DTYPE]
+    torch.manual_seed(0)
+    defines = {"TM": str(TM), "TN": str(TN), "TK": str(TK), "SPLITK": str(SPLITK), "SPLITK_WORKSPACE": "1"}
+    triton.ops._matmul._kernels = dict()
+    triton.ops._matmul._CONFIGS = [triton.config(defines=defines, num_warps=4)]
+    a = torch.randn((M, K), device="cuda", dtype=DTYPE)
+    b = torch.randn((K, N), device="cuda", dtype=DTYPE)
+    th_c = torch.matmul(a, b)
+    # run twice to check that tickets are reset
+    for _ in range(2):
+        tt_c = triton.ops.matmul(a, b)
+        assert triton.testing.allclose(th_c, tt_c)
+
+
+@pytest.mark.parametrize(
+    "TM, TN, TK, NWARP, M, N, K",
+    [
+        (16, 16, 16, 1, None, None, None),
+        (64, 32, 64, 2, None, None, None),
+        (128, 64, 32, 4, None, None, None),
+        (128, 128, 32, 4, 107, 233, 256),
+    ],
+)
+def test_int8(TM, TN, TK, NWARP, M, N, K):
+    torch.manual_seed(0)
+    defines = {"TM": str(TM), "TN": str(TN), "TK": str(TK), "SPLITK": "1"}
+    triton.ops._matmul._kernels = dict()
+    triton.ops._matmul._CONFIGS = [triton.config(defines=defines, num_warps=NWARP)]
+    M = TM if M is None else M
+    N = TN if N is None else N
+    K = TK if K is None else K
+    a = torch.randint(-128, 128, (M, K), device="cuda", dtype=torch.int8)
+    b = torch.randint(-128, 128, (K, N), device="cuda", dtype=torch.int8)
+    scale_a = torch.rand(M, device="cuda", dtype=torch.float32)
+    scale_b = torch.rand(N, device="cuda", dtype=torch.float32)
+    th_c = torch.matmul(a.float(), b.float()) * scale_a[:, None] * scale_b[None, :]
+    tt_c = triton.ops.matmul(a, b, scale_a, scale_b)
+    assert triton.testing.allclose(th_c, tt_c)
+
+
+@pytest.mark.parametrize(
+    "scale_a, scale_b",
+    [
+        (lambda M: torch.rand(M, device="cuda", dtype=torch.float16), lambda N: torch.rand(N, device="cuda")),
+        (lambda M: torch.rand(M + 1, device="cuda"), lambda N: torch.rand(N, device="cuda")),
+        (lambda M: torch.rand(M, device="cuda"), lambda N: torch.rand(N, 1, device="cuda")),
+        (lambda M: torch.rand(M, device="cuda"), lambda N: torch.rand(2 * N, device="cuda")[::2]),
+    ],
+)
+def test_int8_scales(scale_a, scale_b, M=64, N=32, K=16):
+    a = torch.randint(-128, 128, (M, K), device="cuda", dtype=torch.int8)
+    b = torch.randint(-128, 128, (K, N), device="cuda", dtype=torch.int8)
+    with pytest.raises(ValueError):
+        triton.ops.matmul(a, b, scale_a(M), scale_b(N))
+
+
+# barriers inserted before membar's data-flow converged and
+# covered by later ones must not remain in the kernel
+@pytest.mark.parametrize("DTYPE", [torch.float16, torch.float32])
+def test_barriers(DTYPE, M=256, N=256, K=256):
+    a = torch.randn(M, K, device="cuda", dtype=DTYPE)
+    b = torch.randn(K, N, device="cuda", dtype=DTYPE)
+    c = torch.empty(M, N, device="cuda", dtype=DTYPE)
+    defines = {
+        "TYPE": DTYPE, "STRIDE_AM": "lda", "STRIDE_AK": "1", "STRIDE_BK": "ldb", "STRIDE_BN": "1",
+        "LDA_POW2_DIV": 8, "LDB_POW2_DIV": 8, "LDC_POW2_DIV": 8, "IS_TK_DIV_K": 1,
+        "TM": 64, "TN": 64, "TK": 32, "SPLITK": 1,
+    }
+    kernel = triton.kernel(triton.ops._matmul.src, device=a.device, defines=defines, num_warps=4)
+    args = [a.data_ptr(), b.data_ptr(), c.data_ptr(), 1.0, M, N, K, K, N, N, 0, 0, 0, 0]
+    grid = lambda opt: [M // 64, N // 64, 1]
+    kernel(*args, grid=grid)
+    stats = kernel.fn.autotune(struct.pack(kernel.tys, *args), grid, kernel.stream).stats
+    # one barrier per iteration of the main loop; float32 operands are
+    # copied asynchronously on sm_80+ and also wait for them before the dot
+    major, _ = torch.cuda.get_device_capability()
+    expected = 2 if DTYPE == torch.float32 and major >= 8 else 1
+    assert stats.barriers_inserted - stats.barriers_removed == expected
+    assert triton.testing.allclose(c, torch.matmul(a, b))
+
+
+# the main loop must only wait for the copies of the current iteration;
+# deeper pipelines must not leave stale copies in the wait counts
+@pytest.mark.skipif(not torch.cuda.is_available() or torch.cuda.get_device_capability()[0] < 8,
+                    reason="no asynchronous copies")
+@pytest.mark.parametrize("IS_TK_DIV_K, NUM_STAGES", itertools.product([0, 1], [2, 4]))
+def test_async_waits(IS_TK_DIV_K, NUM_STAGES, M=256, N=256, K=256):
+    a = torch.randn(M, K, device="cuda", dtype=torch.float32)
+    b = torch.randn(K, N, device="cuda", dtype=torch.float32)
+    c = torch.empty(M, N, device="cuda", dtype=torch.float32)
+    defines = {
+        "TYPE": torch.float32, "STRIDE_AM": "lda", "STRIDE_AK": "1", "STRIDE_BK": "ldb", "STRIDE_BN": "1",
+        "LDA_POW2_DIV": 8, "LDB_POW2_DIV": 8, "LDC_POW2_DIV": 8, "IS_TK_DIV_K": IS_TK_DIV_K,
+        "TM": 64, "TN": 64, "TK": 32, "SPLITK": 1,
+    }
+    kernel = triton.kernel(triton.ops._matmul.src, device=a.device, defines=defines, num_warps=4,
+                           num_stages=NUM_STAGES)
+    args = [a.data_ptr(), b.data_ptr(), c.data_ptr(), 1.0, M, N, K, K, N, N, 0, 0, 0, 0]
+    grid = lambda opt: [M // 64, N // 64, 1]
+    kernel(*args, grid=grid)
+    ptx = kernel.fn.autotune(struct.pack(kernel.tys, *args), grid, kernel.stream).asm(_triton.asm_mode.ptx)
+    expected = 2 if IS_TK_DIV_K else 1
+    assert set(re.findall(r"cp\.async\.wait_group (\d+);", ptx)) == {str(expected)}
+    assert triton.testing.allclose(c, torch.matmul(a, b))
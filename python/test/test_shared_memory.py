@@ -0,0 +1,105 @@
+import importlib
+import itertools
+import struct
+import torch
+import triton
+import pytest
+
+# the first tile of A stays live across the loop, whose tiles of B are
+# double-buffered, and the tile of B read in the branch can reuse them
+live_src = """
+__global__ void live(TYPE *A __readonly __noalias __aligned(16),
+                     TYPE *B __readonly __noalias __aligned(16),
+                     float *C __noalias __aligned(16),
+                     int K, int flag) {
+  int rm[TM] = 0 ... TM;
+  int rn[TN] = 0 ... TN;
+  int rk[TK] = 0 ... TK;
+  TYPE a[TM, TK] = *(A + rm[:, newaxis] * TK + rk[newaxis, :]);
+  TYPE *pb[TK, TN] = B + rk[:, newaxis] * TN + rn[newaxis, :];
+  float acc[TM, TN] = 0;
+  for (int k = K; k > 0; k -= TK) {
+    acc += a @ *pb;
+    pb += TK * TN;
+  }
+  if (flag > 0) {
+    TYPE b[TK, TN] = *pb;
+    acc += a @ b;
+  }
+  *(C + rm[:, newaxis] * TN + rn[newaxis, :]) = acc;
+}
+"""
+
+
+# compiles `kernel` for its largest alignments and returns its statistics
+def stats_of(kernel):
+    params = struct.pack(kernel.tys, *[0] * len(kernel.tys))
+    return kernel.fn.autotune(params, lambda opt: [1], kernel.stream).stats
+
+
+def check_allocation(stats):
+    # buffers that are live at the same time never share memory
+    for x, y in itertools.combinations(stats.shared_buffers, 2):
+        if any(s0 < e1 and s1 < e0 for s0, e0 in x.live for s1, e1 in y.live):
+            assert x.offset + x.size <= y.offset or y.offset + y.size <= x.offset
+    # nothing is allocated beyond the buffers, and these kernels
+    # are packed as tightly as their live ranges allow
+    assert stats.shared_mem == max(x.offset + x.size for x in stats.shared_buffers)
+    assert stats.shared_mem == stats.shared_mem_lower_bound
+
+
+@pytest.mark.parametrize("DTYPE, SHARED_MEM", [(torch.float16, 8192), (torch.float32, 16384)])
+def test_loops_and_branches(DTYPE, SHARED_MEM, K=128, T=32):
+    a = torch.randn(T, T, device="cuda", dtype=DTYPE)
+    b = torch.randn(K + T, T, device="cuda", dtype=DTYPE)
+    defines = {"TYPE": DTYPE, "TM": T, "TN": T, "TK": T}
+    kernel = triton.kernel(live_src, device=a.device, defines=defines, num_warps=4)
+    stats = stats_of(kernel)
+    check_allocation(stats)
+    assert len(stats.shared_buffers) == 4
+    assert stats.shared_mem == SHARED_MEM
+    for flag in [0, 1]:
+        c = torch.empty(T, T, device="cuda", dtype=torch.float32)
+        kernel(a.data_ptr(), b.data_ptr(), c.data_ptr(), K, flag, grid=lambda opt: [1])
+        rb = b[:K + T * flag].float()
+        assert triton.testing.allclose(c, a.float().repeat(1, rb.shape[0] // T) @ rb)
+
+
+@pytest.mark.parametrize("DTYPE, IS_TK_DIV_K", itertools.product([torch.float16, torch.float32], [0, 1]))
+def test_matmul(DTYPE, IS_TK_DIV_K):
+    defines = {
+        "TYPE": DTYPE, "STRIDE_AM": "lda", "STRIDE_AK": "1", "STRIDE_BK": "ldb", "STRIDE_BN": "1",
+        "LDA_POW2_DIV": 8, "LDB_POW2_DIV": 8, "LDC_POW2_DIV": 8, "IS_TK_DIV_K": IS_TK_DIV_K,
+        "TM": 64, "TN": 64, "TK": 32, "SPLITK": 1,
+    }
+    kernel = triton.kernel(triton.ops._matmul.src, device=torch.device("cuda"), defines=defines, num_warps=4)
+    check_allocation(stats_of(kernel))
+
+
+@pytest.mark.parametrize("MODE", ["sdd", "dsd", "dds"])
+def test_blocksparse(MODE, Z=2, H=2, M=128, N=256, K=128, BLOCK=32):
+    a = torch.randn(Z, H, M, K, dtype=torch.float16, device="cuda")
+    b = torch.randn(Z, H, K, N, dtype=torch.float16, device="cuda")
+    shape = {"sdd": (M, N), "dsd": (M, K), "dds": (K, N)}[MODE]
+    layout = torch.randint(2, (H, shape[0] // BLOCK, shape[1] // BLOCK))
+    op = triton.ops.blocksparse.matmul(layout, BLOCK, MODE)
+    ra = triton.testing.sparsify_tensor(a, layout, BLOCK) if MODE == "dsd" else a
+    rb = triton.testing.sparsify_tensor(b, layout, BLOCK) if MODE == "dds" else b
+    op(ra, rb)
+    cache = getattr(importlib.import_module("triton.ops.blocksparse.matmul")._matmul, MODE + "_cache")
+    assert cache
+    for kernel in cache.values():
+        check_allocation(stats_of(kernel))
+
+
+@pytest.mark.parametrize("DTYPE", [torch.float16, torch.float32])
+def test_attention(DTYPE, Z=1, H=2, L=256, D=64):
+    q, k, v = [torch.randn(Z, H, L, D, dtype=DTYPE, device="cuda", requires_grad=True) for _ in range(3)]
+    triton.ops.attention(q, k, v, causal=True).sum().backward()
+    kernels = importlib.import_module("triton.ops.blocksparse.attention").kernels
+    names = set()
+    for key, kernel in kernels.items():
+        if key[1] == DTYPE:
+            names.add(key[4])
+            check_allocation(stats_of(kernel))
+    assert names == {"forward", "backward_dq", "backward_dkdv"}
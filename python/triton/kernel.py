@@ -1,5 +1,7 @@
 import os
+import json
 import struct
+import contextlib
 from typing import Optional, Dict, List
 import torch
 # C bindings
@@ -8,14 +10,14 @@ import triton._C.libtriton.torch_utils as _torch_utils
 
 codes = {
     _triton.runtime.arg_type.int1: 'B', _triton.runtime.arg_type.int8: 'B', _triton.runtime.arg_type.int32: 'I',
-    _triton.runtime.arg_type.int64: 'Q', _triton.runtime.arg_type.half: 'H', _triton.runtime.arg_type.float: 'f',
-    _triton.runtime.arg_type.double: 'd', _triton.runtime.arg_type.buffer: 'P'
+    _triton.runtime.arg_type.int64: 'Q', _triton.runtime.arg_type.half: 'H', _triton.runtime.arg_type.bf16: 'H',
+    _triton.runtime.arg_type.float: 'f', _triton.runtime.arg_type.double: 'd', _triton.runtime.arg_type.buffer: 'P'
 }
 
 def th_to_triton(obj):
     tys = {
         torch.int8: 'char', torch.int16: 'short', torch.int32: 'int', torch.int64: 'long',\
-        torch.float16: 'half', torch.float32: 'float', torch.float64: 'double'
+        torch.float16: 'half', torch.bfloat16: 'bfloat16', torch.float32: 'float', torch.float64: 'double'
     }
     if isinstance(obj, torch.dtype):
         return tys[obj]
@@ -33,10 +35,67 @@ def read(path, kernel_names: Optional[List] = None):
     return source
 
 config = _triton.runtime.config
+# order of the tiles of grid axes 0 and 1, e.g. `config(..., order=order.hilbert)`
+order = _triton.runtime.order
+
+# Kernels launched on CPU tensors run on a host stream whose
+# worker threads split the programs of each launch
+_num_threads = None
+_host_streams = dict()
+_host_profiler = None
+
+def set_num_threads(num_threads: int):
+    global _num_threads
+    if num_threads < 1:
+        raise ValueError('num_threads must be positive')
+    _num_threads = num_threads
+
+def get_num_threads():
+    if _num_threads is not None:
+        return _num_threads
+    if 'TRITON_NUM_THREADS' in os.environ:
+        return int(os.environ['TRITON_NUM_THREADS'])
+    return torch.get_num_threads()
+
+def _host_stream():
+    num_threads = get_num_threads()
+    if num_threads not in _host_streams:
+        _host_streams[num_threads] = _triton.driver.host_stream(num_threads)
+        _host_streams[num_threads].set_profiler(_host_profiler)
+    return _host_streams[num_threads]
+
+@contextlib.contextmanager
+def profile_host(path: Optional[str] = None):
+    """
+    Records every program of the launches on CPU tensors in the body, and
+    yields a dict that is filled on exit with per-launch queueing delay,
+    program duration histograms (log2 ns buckets), per-worker busy/idle
+    time and load imbalance. If `path` is given, a Chrome trace
+    (chrome://tracing, Perfetto) is written there too.
+    """
+    global _host_profiler
+    if _host_profiler is not None:
+        raise RuntimeError('host profiling is already enabled')
+    _host_profiler = _triton.driver.host_profiler()
+    for stream in _host_streams.values():
+        stream.set_profiler(_host_profiler)
+    result = dict()
+    try:
+        yield result
+    finally:
+        profiler, _host_profiler = _host_profiler, None
+        for stream in _host_streams.values():
+            stream.set_profiler(None)
+        result.update(json.loads(profiler.json()))
+        if path is not None:
+            with open(path, 'w') as f:
+                f.write(profiler.chrome_trace())
 
 class kernel:
     def __init__(self, src, device, defines: Optional[Dict] = None, num_warps: int = 4,
-                 autotune_vals: Optional[List] = None, autotune_key: Optional[List] = None):
+                 autotune_vals: Optional[List] = None, autotune_key: Optional[List] = None, *,
+                 num_stages: int = 2, fast_math: bool = True, schedule: Optional[str] = None,
+                 order: Optional[str] = None, group_size: int = 0):
         if defines is None:
             defines = {}
         if autotune_vals is None:
@@ -56,12 +115,21 @@ class kernel:
         if device.type == 'cpu':
             self.device_id = -1
             self.device = _triton.driver.host_device()
-            self.device = _triton.driver.host_stream()
+            self.stream = None
         _torch_utils.set_device(self.device_id)
         # function
         self.opt = _triton.runtime.options()
         self.opt.defines = {k: th_to_triton(v) for k, v in defines.items()}
         self.opt.num_warps = num_warps
+        self.opt.num_stages = num_stages
+        self.opt.fast_math = fast_math
+        # persistent execution: 'static' or 'dynamic' tile scheduling
+        if schedule is not None:
+            self.opt.schedule = getattr(_triton.runtime.schedule, schedule)
+        # tile order: 'grouped', 'morton' or 'hilbert'
+        if order is not None:
+            self.opt.order = getattr(_triton.runtime.order, order)
+        self.opt.group_size = group_size
         # autotune_vals = [({}, 4)]
         self.fn = _triton.runtime.function(self.src, self.opt, self.device, autotune_vals, autotune_key)
         self.tys = ''.join([codes[x] for x in self.fn.signature()])
@@ -71,7 +139,11 @@ class kernel:
         _torch_utils.set_device(self.device_id)
         # pack parameters into a byte buffer
         params = struct.pack(self.tys, *args)
-        kernel = self.fn.autotune(params, grid, self.stream)
+        stream = _host_stream() if self.stream is None else self.stream
+        kernel = self.fn.autotune(params, grid, stream)
         # run kernel
         grid = grid(kernel.opt)
-        kernel(params, self.stream, grid)
+        kernel(params, stream, grid)
+        # operations on CPU tensors are synchronous in torch
+        if self.stream is None:
+            stream.synchronize()
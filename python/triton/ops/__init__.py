@@ -1,4 +1,7 @@
 from .conv import _conv, conv
 from .matmul import _matmul, matmul
 from .cross_entropy import _cross_entropy, cross_entropy
-from . import blocksparse
\ No newline at end of file
+from .layer_norm import _layer_norm, layer_norm, rms_norm
+from .attention import attention
+from . import blocksparse
+from . import fused
\ No newline at end of file
@@ -0,0 +1,32 @@
+import torch
+import triton
+from .blocksparse.attention import attention as _blocksparse_attention
+
+# dense attention runs the block-sparse kernels on a full (or, when
+# causal, lower triangular) layout; the diagonal blocks are masked
+# in-kernel. float32 tiles are kept smaller so that the backward kernels
+# fit in shared memory
+BLOCK = {torch.float16: 64, torch.float32: 32}
+
+ops = dict()
+
+def make_op(H, L, dtype, causal):
+    block = BLOCK[dtype]
+    num_blocks = triton.cdiv(L, block)
+    key = (H, num_blocks, block, causal)
+    if key not in ops:
+        layout = torch.ones(H, num_blocks, num_blocks, dtype=torch.int64)
+        if causal:
+            layout = torch.tril(layout)
+        ops[key] = _blocksparse_attention(layout, block)
+    return ops[key]
+
+def attention(q, k, v, scale=None, causal=False, key_padding_mask=None, key_padding_mask_mode='add'):
+    Z, H, L, D = q.shape
+    if q.dtype not in BLOCK:
+        raise ValueError('attention is only supported for %s' % list(BLOCK.keys()))
+    if scale is None:
+        scale = D**-0.5
+    op = make_op(H, L, q.dtype, causal)
+    return op(q, k, v, scale=scale, key_padding_mask=key_padding_mask, key_padding_mask_mode=key_padding_mask_mode,
+              causal=causal)
@@ -1,2 +1,3 @@
 from .matmul import matmul
-from .softmax import softmax
\ No newline at end of file
+from .softmax import softmax
+from .attention import attention
\ No newline at end of file
@@ -0,0 +1,326 @@
+// Fused attention softmax(Q K^T * scale + masks) V over the block-sparse
+// layout described by a softmax.c look-up table. Each program handles
+// BLOCK rows of one head and walks the non-zero blocks of its block row,
+// so scores never leave the chip. Q, K, V and their gradients are dense
+// [Z, H, L, TD] tensors; rows past L (dense attention) are masked out.
+// LSE and DELTA are float [Z, H * num_blocks * BLOCK] buffers.
+
+// scores `s` of the pairs in `check` are scaled, shifted by the relative
+// position embedding and masked as in softmax.c, through the `prpe`,
+// `pkp_m` and `pattn_m` pointers set up by each kernel; the other pairs
+// are set to -inf. With CAUSAL, `check` also drops keys past the query
+#ifdef APPLY_RPE
+#define ADD_RPE(s, check) float rpe[BLOCK, BLOCK] = check ? *prpe : 0; s = s + rpe;
+#else
+#define ADD_RPE(s, check)
+#endif
+#ifdef APPLY_KP_MASK
+#ifdef KP_MASK_MUL
+#define ADD_KP_MASK(s, check) float kp_m[BLOCK, BLOCK] = check ? *pkp_m : 0; s = (kp_m == 0) ? (float[BLOCK, BLOCK]) - F32_INFINITY : s;
+#else
+#define ADD_KP_MASK(s, check) float kp_m[BLOCK, BLOCK] = check ? *pkp_m : 0; s = s + kp_m;
+#endif
+#else
+#define ADD_KP_MASK(s, check)
+#endif
+#ifdef APPLY_ATTN_MASK
+#ifdef ATTN_MASK_MUL
+#define ADD_ATTN_MASK(s, check) float attn_m[BLOCK, BLOCK] = check ? *pattn_m : 0; s = (attn_m == 0) ? (float[BLOCK, BLOCK]) - F32_INFINITY : s;
+#else
+#define ADD_ATTN_MASK(s, check) float attn_m[BLOCK, BLOCK] = check ? *pattn_m : 0; s = s + attn_m;
+#endif
+#else
+#define ADD_ATTN_MASK(s, check)
+#endif
+#define MASK_SCORES(s, check) \
+  s = s * scale;              \
+  ADD_RPE(s, check)           \
+  ADD_KP_MASK(s, check)       \
+  ADD_ATTN_MASK(s, check)     \
+  s = check ? s : -F32_INFINITY;
+
+__global__ void forward(TYPE *Q __readonly __noalias,
+                        TYPE *K __readonly __noalias,
+                        TYPE *V __readonly __noalias,
+                        TYPE *O __noalias,
+                        float *LSE __noalias,
+                        float scale,
+                        int *LUT __readonly __noalias,
+                        TYPE *RPE __readonly __noalias,
+                        TYPE *KP_M __readonly __noalias,
+                        TYPE *ATTN_M __readonly __noalias,
+                        int L, int num_blocks,
+                        long stride_z, long stride_h, int stride_l,
+                        long stride_zlse,
+                        long stride_zrpe,
+                        int stride_hrpe,
+                        int stride_srpe,
+                        int stride_zkpm,
+                        int stride_zattnm) {
+  int pidhm = get_program_id(0);
+  int pidz = get_program_id(1);
+  int head = pidhm / num_blocks;
+  int rbm = pidhm % num_blocks;
+  // extract information from look-up table
+  int *header = LUT + pidhm * 2;
+  int size = *(header + 0);
+  int offset = *(header + 1);
+  // queries
+  int rm[BLOCK] = rbm * BLOCK + 0 ... BLOCK;
+  int rd[TD] = 0 ... TD;
+  long offzh = pidz * stride_z + head * stride_h;
+  bool checkm[BLOCK] = rm < L;
+  bool checkq[BLOCK, TD] = checkm[:, newaxis];
+  TYPE *pq[BLOCK, TD] = Q + offzh + rm[:, newaxis] * stride_l + rd[newaxis, :];
+  TYPE q[BLOCK, TD] = checkq ? *pq : 0;
+  // online softmax: `m` is the running maximum of the scores of each
+  // row, `l` the running sum of their exponentials
+  float m[BLOCK] = -F32_INFINITY;
+  float l[BLOCK] = 0;
+  float acc[BLOCK, TD] = 0;
+  for (int j = 0; j < size; j++) {
+    int column = *(LUT + offset + j * 4 + 1);
+    // keys
+    int rn[BLOCK] = column * BLOCK + 0 ... BLOCK;
+    bool checkn[BLOCK] = rn < L;
+    bool checkk[TD, BLOCK] = checkn[newaxis, :];
+    bool checkv[BLOCK, TD] = checkn[:, newaxis];
+    bool check[BLOCK, BLOCK] = checkm[:, newaxis] && checkn[newaxis, :];
+#ifdef CAUSAL
+    check = check && rm[:, newaxis] >= rn[newaxis, :];
+#endif
+    TYPE *pk[TD, BLOCK] = K + offzh + rn[newaxis, :] * stride_l + rd[:, newaxis];
+    TYPE *pv[BLOCK, TD] = V + offzh + rn[:, newaxis] * stride_l + rd[newaxis, :];
+#ifdef APPLY_RPE
+    TYPE *prpe[BLOCK, BLOCK] = RPE + pidz * stride_zrpe + head * stride_hrpe + rm[:, newaxis] * stride_srpe + rn[newaxis, :];
+#endif
+#ifdef APPLY_KP_MASK
+    TYPE *pkp_m[BLOCK, BLOCK] = KP_M + pidz * stride_zkpm + rn[newaxis, :];
+#endif
+#ifdef APPLY_ATTN_MASK
+    TYPE *pattn_m[BLOCK, BLOCK] = ATTN_M + rm[:, newaxis] * stride_zattnm + rn[newaxis, :];
+#endif
+    TYPE k[TD, BLOCK] = checkk ? *pk : 0;
+    float s[BLOCK, BLOCK] = q @ k;
+    MASK_SCORES(s, check)
+    // rows without any unmasked score yet are kept at zero
+    float smax[BLOCK] = s[:, max];
+    float mnew[BLOCK] = max(m, smax);
+    float mref[BLOCK] = mnew > -F32_INFINITY ? mnew : 0;
+    float alpha[BLOCK] = exp(m - mref);
+    float p[BLOCK, BLOCK] = exp(s - mref[:, newaxis]);
+    l = l * alpha + p[:, +];
+    acc = acc * alpha[:, newaxis];
+    TYPE tp[BLOCK, BLOCK] = p;
+    TYPE v[BLOCK, TD] = checkv ? *pv : 0;
+    acc += tp @ v;
+    m = mnew;
+  }
+  // fully masked rows are zero
+  float lsafe[BLOCK] = l > 0 ? l : 1;
+  TYPE o[BLOCK, TD] = acc / lsafe[:, newaxis];
+  // the output gets its own mask: sharing the one of `q` would put the
+  // accumulator in the layout of an operand of the dots
+  bool checko[BLOCK, TD] = checkm[:, newaxis];
+  TYPE *po[BLOCK, TD] = O + offzh + rm[:, newaxis] * stride_l + rd[newaxis, :];
+  *? (checko)po = o;
+  // log-sum-exp of the scores for the backward pass
+  float mfin[BLOCK] = m > -F32_INFINITY ? m : 0;
+  float *plse[BLOCK] = LSE + pidz * stride_zlse + pidhm * BLOCK + 0 ... BLOCK;
+  *plse = mfin + log(lsafe);
+}
+
+// dq = sum_j ds_j @ k_j * scale with ds = p * (dp - delta), dp = do @ v^T
+// and delta = rowsum(do * o), which is also stored for backward_dkdv
+__global__ void backward_dq(TYPE *Q __readonly __noalias,
+                            TYPE *K __readonly __noalias,
+                            TYPE *V __readonly __noalias,
+                            TYPE *O __readonly __noalias,
+                            TYPE *DO __readonly __noalias,
+                            TYPE *DQ __noalias,
+                            float *LSE __readonly __noalias,
+                            float *DELTA __noalias,
+                            float scale,
+                            int *LUT __readonly __noalias,
+                            TYPE *RPE __readonly __noalias,
+                            TYPE *KP_M __readonly __noalias,
+                            TYPE *ATTN_M __readonly __noalias,
+                            int L, int num_blocks,
+                            long stride_z, long stride_h, int stride_l,
+                            long stride_zlse,
+                            long stride_zrpe,
+                            int stride_hrpe,
+                            int stride_srpe,
+                            int stride_zkpm,
+                            int stride_zattnm) {
+  int pidhm = get_program_id(0);
+  int pidz = get_program_id(1);
+  int head = pidhm / num_blocks;
+  int rbm = pidhm % num_blocks;
+  // extract information from look-up table
+  int *header = LUT + pidhm * 2;
+  int size = *(header + 0);
+  int offset = *(header + 1);
+  // queries
+  int rm[BLOCK] = rbm * BLOCK + 0 ... BLOCK;
+  int rd[TD] = 0 ... TD;
+  long offzh = pidz * stride_z + head * stride_h;
+  bool checkm[BLOCK] = rm < L;
+  bool checkq[BLOCK, TD] = checkm[:, newaxis];
+  long offq[BLOCK, TD] = offzh + rm[:, newaxis] * stride_l + rd[newaxis, :];
+  TYPE *pq[BLOCK, TD] = Q + offq;
+  TYPE *po[BLOCK, TD] = O + offq;
+  TYPE *pdout[BLOCK, TD] = DO + offq;
+  TYPE q[BLOCK, TD] = checkq ? *pq : 0;
+  TYPE o[BLOCK, TD] = checkq ? *po : 0;
+  TYPE dout[BLOCK, TD] = checkq ? *pdout : 0;
+  float Fo[BLOCK, TD] = o;
+  float Fdout[BLOCK, TD] = dout;
+  float delta[BLOCK] = (Fo * Fdout)[:, +];
+  long offlse[BLOCK] = pidz * stride_zlse + pidhm * BLOCK + 0 ... BLOCK;
+  float *pdelta[BLOCK] = DELTA + offlse;
+  *pdelta = delta;
+  float *plse[BLOCK] = LSE + offlse;
+  float lse[BLOCK] = *plse;
+  float dq[BLOCK, TD] = 0;
+  for (int j = 0; j < size; j++) {
+    int column = *(LUT + offset + j * 4 + 1);
+    // keys
+    int rn[BLOCK] = column * BLOCK + 0 ... BLOCK;
+    bool checkn[BLOCK] = rn < L;
+    bool checkkt[TD, BLOCK] = checkn[newaxis, :];
+    bool checkk[BLOCK, TD] = checkn[:, newaxis];
+    bool check[BLOCK, BLOCK] = checkm[:, newaxis] && checkn[newaxis, :];
+#ifdef CAUSAL
+    check = check && rm[:, newaxis] >= rn[newaxis, :];
+#endif
+    TYPE *pkt[TD, BLOCK] = K + offzh + rn[newaxis, :] * stride_l + rd[:, newaxis];
+    TYPE *pk[BLOCK, TD] = K + offzh + rn[:, newaxis] * stride_l + rd[newaxis, :];
+    TYPE *pvt[TD, BLOCK] = V + offzh + rn[newaxis, :] * stride_l + rd[:, newaxis];
+#ifdef APPLY_RPE
+    TYPE *prpe[BLOCK, BLOCK] = RPE + pidz * stride_zrpe + head * stride_hrpe + rm[:, newaxis] * stride_srpe + rn[newaxis, :];
+#endif
+#ifdef APPLY_KP_MASK
+    TYPE *pkp_m[BLOCK, BLOCK] = KP_M + pidz * stride_zkpm + rn[newaxis, :];
+#endif
+#ifdef APPLY_ATTN_MASK
+    TYPE *pattn_m[BLOCK, BLOCK] = ATTN_M + rm[:, newaxis] * stride_zattnm + rn[newaxis, :];
+#endif
+    TYPE kt[TD, BLOCK] = checkkt ? *pkt : 0;
+    float s[BLOCK, BLOCK] = q @ kt;
+    MASK_SCORES(s, check)
+    float p[BLOCK, BLOCK] = exp(s - lse[:, newaxis]);
+    TYPE vt[TD, BLOCK] = checkkt ? *pvt : 0;
+    float dp[BLOCK, BLOCK] = dout @ vt;
+    float ds[BLOCK, BLOCK] = p * (dp - delta[:, newaxis]) * scale;
+    TYPE tds[BLOCK, BLOCK] = ds;
+    TYPE k[BLOCK, TD] = checkk ? *pk : 0;
+    dq += tds @ k;
+  }
+  TYPE tdq[BLOCK, TD] = dq;
+  // own offsets and mask, as in forward
+  bool checkdq[BLOCK, TD] = checkm[:, newaxis];
+  TYPE *pdq[BLOCK, TD] = DQ + offzh + rm[:, newaxis] * stride_l + rd[newaxis, :];
+  *? (checkdq)pdq = tdq;
+}
+
+// dv = sum_i p_i^T @ do_i and dk = sum_i ds_i^T @ q_i * scale, computed
+// on transposed score tiles so that the look-up table is that of the
+// transposed layout: each program handles BLOCK keys
+__global__ void backward_dkdv(TYPE *Q __readonly __noalias,
+                              TYPE *K __readonly __noalias,
+                              TYPE *V __readonly __noalias,
+                              TYPE *DO __readonly __noalias,
+                              TYPE *DK __noalias,
+                              TYPE *DV __noalias,
+                              float *LSE __readonly __noalias,
+                              float *DELTA __readonly __noalias,
+                              float scale,
+                              int *LUT __readonly __noalias,
+                              TYPE *RPE __readonly __noalias,
+                              TYPE *KP_M __readonly __noalias,
+                              TYPE *ATTN_M __readonly __noalias,
+                              int L, int num_blocks,
+                              long stride_z, long stride_h, int stride_l,
+                              long stride_zlse,
+                              long stride_zrpe,
+                              int stride_hrpe,
+                              int stride_srpe,
+                              int stride_zkpm,
+                              int stride_zattnm) {
+  int pidhn = get_program_id(0);
+  int pidz = get_program_id(1);
+  int head = pidhn / num_blocks;
+  int rbn = pidhn % num_blocks;
+  // extract information from look-up table
+  int *header = LUT + pidhn * 2;
+  int size = *(header + 0);
+  int offset = *(header + 1);
+  // keys
+  int rn[BLOCK] = rbn * BLOCK + 0 ... BLOCK;
+  int rd[TD] = 0 ... TD;
+  long offzh = pidz * stride_z + head * stride_h;
+  bool checkn[BLOCK] = rn < L;
+  bool checkk[BLOCK, TD] = checkn[:, newaxis];
+  long offk[BLOCK, TD] = offzh + rn[:, newaxis] * stride_l + rd[newaxis, :];
+  TYPE *pk[BLOCK, TD] = K + offk;
+  TYPE *pv[BLOCK, TD] = V + offk;
+  TYPE k[BLOCK, TD] = checkk ? *pk : 0;
+  TYPE v[BLOCK, TD] = checkk ? *pv : 0;
+  float dk[BLOCK, TD] = 0;
+  float dv[BLOCK, TD] = 0;
+  for (int j = 0; j < size; j++) {
+    int column = *(LUT + offset + j * 4 + 1);
+    // queries
+    int rm[BLOCK] = column * BLOCK + 0 ... BLOCK;
+    bool checkm[BLOCK] = rm < L;
+    bool checkqt[TD, BLOCK] = checkm[newaxis, :];
+    bool checkq[BLOCK, TD] = checkm[:, newaxis];
+    bool check[BLOCK, BLOCK] = checkn[:, newaxis] && checkm[newaxis, :];
+#ifdef CAUSAL
+    check = check && rm[newaxis, :] >= rn[:, newaxis];
+#endif
+    long offqt[TD, BLOCK] = offzh + rm[newaxis, :] * stride_l + rd[:, newaxis];
+    long offq[BLOCK, TD] = offzh + rm[:, newaxis] * stride_l + rd[newaxis, :];
+    TYPE *pqt[TD, BLOCK] = Q + offqt;
+    TYPE *pq[BLOCK, TD] = Q + offq;
+    TYPE *pdoutt[TD, BLOCK] = DO + offqt;
+    TYPE *pdout[BLOCK, TD] = DO + offq;
+    long offlse[BLOCK] = pidz * stride_zlse + head * num_blocks * BLOCK + rm;
+    float *plse[BLOCK] = LSE + offlse;
+    float *pdelta[BLOCK] = DELTA + offlse;
+#ifdef APPLY_RPE
+    TYPE *prpe[BLOCK, BLOCK] = RPE + pidz * stride_zrpe + head * stride_hrpe + rm[newaxis, :] * stride_srpe + rn[:, newaxis];
+#endif
+#ifdef APPLY_KP_MASK
+    TYPE *pkp_m[BLOCK, BLOCK] = KP_M + pidz * stride_zkpm + rn[:, newaxis];
+#endif
+#ifdef APPLY_ATTN_MASK
+    TYPE *pattn_m[BLOCK, BLOCK] = ATTN_M + rm[newaxis, :] * stride_zattnm + rn[:, newaxis];
+#endif
+    TYPE qt[TD, BLOCK] = checkqt ? *pqt : 0;
+    float st[BLOCK, BLOCK] = k @ qt;
+    MASK_SCORES(st, check)
+    float lse[BLOCK] = *plse;
+    float pt[BLOCK, BLOCK] = exp(st - lse[newaxis, :]);
+    TYPE tpt[BLOCK, BLOCK] = pt;
+    TYPE dout[BLOCK, TD] = checkq ? *pdout : 0;
+    dv += tpt @ dout;
+    TYPE doutt[TD, BLOCK] = checkqt ? *pdoutt : 0;
+    float dpt[BLOCK, BLOCK] = v @ doutt;
+    float delta[BLOCK] = *pdelta;
+    float dst[BLOCK, BLOCK] = pt * (dpt - delta[newaxis, :]) * scale;
+    TYPE tdst[BLOCK, BLOCK] = dst;
+    TYPE q[BLOCK, TD] = checkq ? *pq : 0;
+    dk += tdst @ q;
+  }
+  TYPE tdk[BLOCK, TD] = dk;
+  TYPE tdv[BLOCK, TD] = dv;
+  // own offsets and mask, as in forward
+  bool checkdk[BLOCK, TD] = checkn[:, newaxis];
+  long offdk[BLOCK, TD] = offzh + rn[:, newaxis] * stride_l + rd[newaxis, :];
+  TYPE *pdk[BLOCK, TD] = DK + offdk;
+  TYPE *pdv[BLOCK, TD] = DV + offdk;
+  *? (checkdk)pdk = tdk;
+  *? (checkdk)pdv = tdv;
+}
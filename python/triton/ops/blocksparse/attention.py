@@ -0,0 +1,157 @@
+import triton
+import torch
+import os
+from .softmax import _softmax
+
+kernels = dict()
+
+def read_kernel(name):
+    fname = os.path.join(os.path.dirname(__file__), 'attention.c')
+    with open(fname, 'r') as f:
+        source = f.read()
+    # the score masking macros precede the kernels
+    header = source[:source.index('__global__')]
+    return header + triton.read(fname, kernel_names=[name])
+
+def make_kernel(device, dtype, block, TD, name, masks):
+    key = (device, dtype, block, TD, name, masks)
+    if key not in kernels:
+        apply_rpe, apply_kp_mask, apply_attn_mask, kp_mask_mode, attn_mask_mode, causal = masks
+        defines = {'TYPE': dtype, 'BLOCK': block, 'TD': TD}
+        if apply_rpe:
+            defines['APPLY_RPE'] = True
+        if apply_kp_mask:
+            defines['APPLY_KP_MASK'] = True
+            if kp_mask_mode == 'mul':
+                defines['KP_MASK_MUL'] = True
+        if apply_attn_mask:
+            defines['APPLY_ATTN_MASK'] = True
+            if attn_mask_mode == 'mul':
+                defines['ATTN_MASK_MUL'] = True
+        if causal:
+            defines['CAUSAL'] = True
+        kernels[key] = triton.kernel(read_kernel(name), device=device, defines=defines, num_warps=4)
+    return kernels[key]
+
+class _attention(torch.autograd.Function):
+    @staticmethod
+    def make_masks(q, rpe, key_padding_mask, attn_mask, kp_mask_mode, attn_mask_mode, causal):
+        masks = (rpe is not None, key_padding_mask is not None, attn_mask is not None, kp_mask_mode, attn_mask_mode,
+                 causal)
+        empty = torch.empty(0, dtype=q.dtype, device=q.device)
+        # handle None rpe
+        if rpe is None:
+            rpe = empty
+            strides = [0, 0, 0]
+        else:
+            strides = [rpe.stride(0), rpe.stride(1), rpe.stride(2)]
+        # handle None key_padding_mask
+        if key_padding_mask is None:
+            key_padding_mask = empty
+            strides += [0]
+        else:
+            strides += [key_padding_mask.stride(0)]
+        # handle None attention_mask
+        if attn_mask is None:
+            attn_mask = empty
+            strides += [0]
+        else:
+            strides += [attn_mask.stride(0)]
+        return masks, [rpe, key_padding_mask, attn_mask], strides
+
+    @staticmethod
+    def forward(ctx, q, k, v, scale, rpe, key_padding_mask, attn_mask, kp_mask_mode, attn_mask_mode, causal, block,
+                lut, lut_t, num_blocks):
+        Z, H, L, D = q.shape
+        q, k, v = q.contiguous(), k.contiguous(), v.contiguous()
+        masks, mask_tensors, mask_strides = _attention.make_masks(q, rpe, key_padding_mask, attn_mask, kp_mask_mode,
+                                                                  attn_mask_mode, causal)
+        o = torch.empty_like(q)
+        # log-sum-exp of the scores of each row, for the backward pass
+        lse = torch.empty(Z, H * num_blocks * block, dtype=torch.float32, device=q.device)
+        kernel = make_kernel(q.device, q.dtype, block, D, 'forward', masks)
+        kernel(q.data_ptr(), k.data_ptr(), v.data_ptr(), o.data_ptr(), lse.data_ptr(), scale, lut.data_ptr(),
+               *[x.data_ptr() for x in mask_tensors], L, num_blocks, q.stride(0), q.stride(1), q.stride(2),
+               lse.stride(0), *mask_strides,
+               grid=lambda opt: [H * num_blocks, Z])
+        ctx.save_for_backward(q, k, v, o, lse, lut, lut_t, *mask_tensors)
+        ctx.scale = scale
+        ctx.block = block
+        ctx.num_blocks = num_blocks
+        ctx.masks = masks
+        ctx.mask_strides = mask_strides
+        return o
+
+    @staticmethod
+    def backward(ctx, do):
+        q, k, v, o, lse, lut, lut_t, *mask_tensors = ctx.saved_tensors
+        Z, H, L, D = q.shape
+        block, num_blocks = ctx.block, ctx.num_blocks
+        do = do.contiguous()
+        mask_ptrs = [x.data_ptr() for x in mask_tensors]
+        # dq; also writes the row sums of do * o that dk needs
+        dq = torch.empty_like(q)
+        delta = torch.empty_like(lse)
+        kernel = make_kernel(q.device, q.dtype, block, D, 'backward_dq', ctx.masks)
+        kernel(q.data_ptr(), k.data_ptr(), v.data_ptr(), o.data_ptr(), do.data_ptr(), dq.data_ptr(), lse.data_ptr(),
+               delta.data_ptr(), ctx.scale, lut.data_ptr(), *mask_ptrs, L, num_blocks, q.stride(0), q.stride(1),
+               q.stride(2), lse.stride(0), *ctx.mask_strides,
+               grid=lambda opt: [H * num_blocks, Z])
+        # dk and dv, over the transposed layout
+        dk = torch.empty_like(k)
+        dv = torch.empty_like(v)
+        kernel = make_kernel(q.device, q.dtype, block, D, 'backward_dkdv', ctx.masks)
+        kernel(q.data_ptr(), k.data_ptr(), v.data_ptr(), do.data_ptr(), dk.data_ptr(), dv.data_ptr(), lse.data_ptr(),
+               delta.data_ptr(), ctx.scale, lut_t.data_ptr(), *mask_ptrs, L, num_blocks, q.stride(0), q.stride(1),
+               q.stride(2), lse.stride(0), *ctx.mask_strides,
+               grid=lambda opt: [H * num_blocks, Z])
+        return dq, dk, dv, None, None, None, None, None, None, None, None, None, None, None
+
+class attention:
+
+    apply_attention = _attention.apply
+
+    def make_lut(self, device):
+        key = (device, )
+        if key not in self.lut_cache:
+            lut, _ = _softmax.make_lut(self.layout, self.block, device)
+            lut_t, _ = _softmax.make_lut(self.layout.transpose(1, 2), self.block, device)
+            self.lut_cache[key] = (lut, lut_t)
+        return self.lut_cache[key]
+
+    def __init__(self, layout, block):
+        if layout.shape[1] != layout.shape[2]:
+            raise ValueError('attention layouts must be square')
+        self.layout = layout
+        self.block = block
+        self.lut_cache = dict()
+
+    # softmax(q @ k^T * scale + masks) @ v, for q, k and v of shape [Z, H, L, D]
+    # with L <= num_blocks * block; masks are those of blocksparse.softmax.
+    # causal masks keys past the query in-kernel
+    def __call__(self,
+                 q,
+                 k,
+                 v,
+                 scale=1.,
+                 rpe=None,
+                 key_padding_mask=None,
+                 attn_mask=None,
+                 key_padding_mask_mode='add',
+                 attn_mask_mode='add',
+                 causal=False):
+        Z, H, L, D = q.shape
+        num_blocks = self.layout.shape[1]
+        if k.shape != q.shape or v.shape != q.shape:
+            raise ValueError('q, k and v must have the same shape')
+        if self.layout.shape[0] != H or L > num_blocks * self.block:
+            raise ValueError('layout does not match inputs of shape %s' % (tuple(q.shape), ))
+        if D < 16 or D & (D - 1):
+            raise ValueError('head dimension must be a power of 2, at least 16')
+        for name, x in [('relative position embedding', rpe), ('Attention mask', attn_mask),
+                        ('Key padding mask', key_padding_mask)]:
+            if x is not None and x.dtype != q.dtype:
+                raise ValueError('%s must be %s' % (name, q.dtype))
+        lut, lut_t = self.make_lut(q.device)
+        return attention.apply_attention(q, k, v, scale, rpe, key_padding_mask, attn_mask, key_padding_mask_mode,
+                                         attn_mask_mode, causal, self.block, lut, lut_t, num_blocks)
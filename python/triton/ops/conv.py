@@ -44,9 +44,9 @@ class _conv(torch.autograd.Function):
             ci, r, s = _conv.unpack(idx, CI, R, S)
             nci, nr, ns = _conv.unpack(idx + TK, CI, R, S)
             delta = (nci - ci) * a.stride(1) + (nr - r) * a.stride(2) + (ns - s) * a.stride(3)
-            delta = delta.type(torch.int32).cuda()
-            _conv.kernel[dtype] = (delta, triton.kernel(_conv.src, device=device, defines=defines))
-        delta, kernel = _conv.kernel[dtype]
+            delta = delta.type(torch.int32).to(device)
+            _conv.kernel[(dtype, device)] = (delta, triton.kernel(_conv.src, device=device, defines=defines))
+        delta, kernel = _conv.kernel[(dtype, device)]
         # allocate output
         c = torch.empty([Z, CO, P, Q], dtype=dtype, device=device)
         # enqueue
@@ -21,7 +21,7 @@ def largest_pow2_divisor(N):
 def make_kernel(device, dtype, n_cols, cache, name):
     rounded = next_power_of_2(n_cols)
     div = largest_pow2_divisor(n_cols)
-    key = (dtype, rounded, div)
+    key = (device, dtype, rounded, div)
     if key not in cache:
         fname = os.path.join(os.path.dirname(__file__), "cross_entropy.c")
         src = triton.read(fname, kernel_names=[name])
@@ -0,0 +1,330 @@
+import torch
+import triton
+
+# Fused elementwise kernels, with an optional trailing reduction over
+# the last dimension. Expressions are built from named inputs, e.g.
+#
+#   x, b = fused.input('x'), fused.input('b')
+#   bias_gelu = fused.fuse(fused.gelu(x + b))
+#   y = bias_gelu(x=x_tensor, b=b_tensor)
+#
+# and compiled to a single Triton-C kernel whose tile size and number
+# of warps are auto-tuned. Inputs are broadcast against each other; a
+# tensor is read either fully, along the last dimension only (e.g.
+# a bias), along the leading dimensions only (e.g. a per-row
+# statistic) or as a scalar. Other broadcasts are materialized.
+# Arithmetic is done in float32.
+
+
+class expr:
+    def __init__(self, op, args=(), value=None):
+        self.op = op
+        self.args = tuple(_wrap(a) for a in args)
+        self.value = value
+        if any(a.op in _reductions for a in self.args):
+            raise ValueError("reductions must be the root of a fused expression")
+
+    def __add__(self, other): return expr('+', (self, other))
+    def __radd__(self, other): return expr('+', (other, self))
+    def __sub__(self, other): return expr('-', (self, other))
+    def __rsub__(self, other): return expr('-', (other, self))
+    def __mul__(self, other): return expr('*', (self, other))
+    def __rmul__(self, other): return expr('*', (other, self))
+    def __truediv__(self, other): return expr('/', (self, other))
+    def __rtruediv__(self, other): return expr('/', (other, self))
+    def __neg__(self): return expr('neg', (self, ))
+    def __lt__(self, other): return expr('<', (self, other))
+    def __le__(self, other): return expr('<=', (self, other))
+    def __gt__(self, other): return expr('>', (self, other))
+    def __ge__(self, other): return expr('>=', (self, other))
+
+
+def _wrap(x):
+    if isinstance(x, expr):
+        return x
+    if isinstance(x, (int, float)):
+        return expr('const', value=float(x))
+    raise TypeError("cannot use " + type(x).__name__ + " in a fused expression")
+
+
+def input(name):
+    if not name.isidentifier():
+        raise ValueError(name + " is not a valid input name")
+    return expr('input', value=name)
+
+
+# elementwise functions
+def exp(x): return expr('exp', (x, ))
+def log(x): return expr('log', (x, ))
+def sqrt(x): return expr('sqrtf', (x, ))
+def rsqrt(x): return expr('rsqrt', (x, ))
+def tanh(x): return expr('tanh', (x, ))
+def erf(x): return expr('erf', (x, ))
+def sigmoid(x): return expr('sigmoid', (x, ))
+def sin(x): return expr('sin', (x, ))
+def cos(x): return expr('cos', (x, ))
+def abs(x): return expr('abs', (x, ))
+def relu(x): return expr('relu', (x, ))
+def gelu(x): return 0.5 * x * (1. + erf(x * 0.7071067811865476))
+def maximum(x, y): return expr('maximum', (x, y))
+def minimum(x, y): return expr('minimum', (x, y))
+def where(cond, x, y): return expr('where', (cond, x, y))
+
+
+# Inverted dropout. The random numbers are a hash of `seed` and of
+# the linear index of each element, so they do not depend on the tile
+# size and `seed` must change from one call to the next
+def dropout(x, p, seed):
+    if not 0 <= p < 1:
+        raise ValueError("dropout probability must be in [0, 1)")
+    return where(expr('rand', value=int(seed)) >= p, x * (1. / (1. - p)), 0.)
+
+
+# reductions over the last dimension
+_reductions = {'sum': ('0', '+'), 'mean': ('0', '+'), 'max': ('-F32_INFINITY', 'max'), 'min': ('F32_INFINITY', 'min')}
+def sum(x): return expr('sum', (x, ))
+def mean(x): return expr('mean', (x, ))
+def max(x): return expr('max', (x, ))
+def min(x): return expr('min', (x, ))
+
+
+_binary = {'+', '-', '*', '/', '<', '<=', '>', '>='}
+_compare = {'<', '<=', '>', '>='}
+_unary = {'exp', 'log', 'sqrtf', 'rsqrt', 'tanh', 'erf', 'sigmoid', 'sin', 'cos'}
+
+
+# topological order of the nodes of `root`, shared nodes once
+def _nodes(root):
+    ret, seen = [], set()
+
+    def visit(node):
+        if id(node) in seen:
+            return
+        seen.add(id(node))
+        for arg in node.args:
+            visit(arg)
+        ret.append(node)
+
+    visit(root)
+    return ret
+
+
+# how an input of shape `shape` is read for an output of shape `out`
+def _layout(shape, out):
+    shape = (1, ) * (len(out) - len(shape)) + tuple(shape)
+    if all(s == 1 for s in shape):
+        return 'scalar'
+    if shape == tuple(out):
+        return 'full'
+    if all(s == 1 for s in shape[:-1]) and shape[-1] == out[-1]:
+        return 'col'
+    if shape[:-1] == tuple(out[:-1]) and shape[-1] == 1:
+        return 'row'
+    return None
+
+
+class _fused:
+
+    _kernels = dict()
+
+    _configs = [
+        triton.config(defines={'TILE': '256'}, num_warps=2),
+        triton.config(defines={'TILE': '512'}, num_warps=4),
+        triton.config(defines={'TILE': '1024'}, num_warps=4),
+        triton.config(defines={'TILE': '2048'}, num_warps=8),
+    ]
+
+    _reduce_configs = [
+        triton.config(defines={'TILE': '128'}, num_warps=1),
+        triton.config(defines={'TILE': '512'}, num_warps=4),
+        triton.config(defines={'TILE': '2048'}, num_warps=8),
+    ]
+
+    def __init__(self, root):
+        root = _wrap(root)
+        self.nodes = _nodes(root)
+        self.reduce = root.op if root.op in _reductions else None
+        self.inputs = []
+        self.consts = []
+        self.seeds = []
+        for node in self.nodes:
+            if node.op == 'input' and node.value not in self.inputs:
+                self.inputs.append(node.value)
+            if node.op == 'const':
+                self.consts.append(node.value)
+            if node.op == 'rand':
+                self.seeds.append(node.value)
+        if not self.inputs:
+            raise ValueError("fused expression has no input")
+
+    # Triton-C body, one statement per node; returns the
+    # name of the result and the canonical form of the DAG
+    def _body(self, layouts):
+        names, lines, key = dict(), [], []
+        is_bool = dict()
+        n_consts, n_seeds = 0, 0
+        # offsets of the inputs; the row is a scalar in reductions
+        loads = {'full': 'off', 'col': 'col', 'row': None if self.reduce else 'row'}
+        for i, node in enumerate(self.nodes):
+            args = [names[id(a)] for a in node.args]
+            ty = 'float'
+            is_scalar = False
+            if node.op == 'input':
+                name = node.value
+                offset = loads.get(layouts[name])
+                if offset is None:
+                    expr_ = '*(' + name + (' + row)' if layouts[name] == 'row' else ')')
+                    is_scalar = True
+                else:
+                    lines.append('  TYPE_{0} *p{1}[TILE] = {0} + {2};'.format(name, i, offset))
+                    expr_ = '*?(check)p' + str(i)
+                key.append('in:' + name + ':' + layouts[name])
+            elif node.op == 'const':
+                expr_ = 'c' + str(n_consts)
+                n_consts += 1
+                is_scalar = True
+                key.append('c')
+            elif node.op == 'rand':
+                # 32-bit integer hash of the element index, in [0, 1)
+                lines.append('  int h{0}[TILE] = off ^ (s{1} * 1664525);'.format(i, n_seeds))
+                lines.append('  h{0} = (h{0} ^ (h{0} >> 16)) * 73244475;'.format(i))
+                lines.append('  h{0} = (h{0} ^ (h{0} >> 16)) * 73244475;'.format(i))
+                lines.append('  h{0} = h{0} ^ (h{0} >> 16);'.format(i))
+                expr_ = '((float[TILE])(h{0} & 16777215)) / 16777216'.format(i)
+                n_seeds += 1
+                key.append('rand')
+            elif node.op in _binary:
+                a, b = [('(float[TILE])' + x if is_bool[id(y)] else x) for x, y in zip(args, node.args)]
+                expr_ = a + ' ' + node.op + ' ' + b
+                ty = 'bool' if node.op in _compare else 'float'
+                key.append(node.op)
+            elif node.op in _unary:
+                expr_ = node.op + '(' + args[0] + ')'
+                key.append(node.op)
+            elif node.op == 'neg':
+                expr_ = '-' + args[0]
+                key.append('neg')
+            elif node.op == 'abs':
+                expr_ = args[0] + ' < 0 ? -' + args[0] + ' : ' + args[0]
+                key.append('abs')
+            elif node.op == 'relu':
+                expr_ = args[0] + ' > 0 ? ' + args[0] + ' : 0'
+                key.append('relu')
+            elif node.op in ('maximum', 'minimum'):
+                cmp = '>' if node.op == 'maximum' else '<'
+                expr_ = args[0] + ' ' + cmp + ' ' + args[1] + ' ? ' + args[0] + ' : ' + args[1]
+                key.append(node.op)
+            elif node.op == 'where':
+                cond = args[0] if is_bool[id(node.args[0])] else '(' + args[0] + ' != 0)'
+                expr_ = cond + ' ? ' + args[1] + ' : ' + args[2]
+                key.append('where')
+            elif node.op in _reductions:
+                names[id(node)] = args[0]
+                is_bool[id(node)] = False
+                key.append(node.op)
+                continue
+            else:
+                raise ValueError("unknown fused op " + node.op)
+            # scalars are broadcast where they are used
+            if is_scalar:
+                lines.append('  float t{0} = {1};'.format(i, expr_))
+            else:
+                lines.append('  {0} t{1}[TILE] = {2};'.format(ty, i, expr_))
+            names[id(node)] = 't' + str(i)
+            is_bool[id(node)] = ty == 'bool'
+            key[-1] += '(' + ','.join(str(self.nodes.index(a)) for a in node.args) + ')'
+        ret = names[id(self.nodes[-1])]
+        if is_bool[id(self.nodes[-1])]:
+            ret = '(float[TILE])' + ret
+        return ret, lines, ';'.join(key)
+
+    def _src(self, layouts):
+        ret, body, key = self._body(layouts)
+        args = ['TYPE_{0} *{0} __readonly'.format(x) for x in self.inputs]
+        args += ['float c{0}'.format(i) for i in range(len(self.consts))]
+        args += ['int s{0}'.format(i) for i in range(len(self.seeds))]
+        args += ['TYPE_OUT *out', 'int N', 'int N_LAST']
+        src = '__global__ void fused(' + ', '.join(args) + ') {\n'
+        if self.reduce is None:
+            src += '  int off[TILE] = get_program_id(0) * TILE + 0 ... TILE;\n'
+            src += '  bool check[TILE] = off < N;\n'
+            src += '  int col[TILE] = off % N_LAST;\n'
+            src += '  int row[TILE] = off / N_LAST;\n'
+            src += '\n'.join(body) + '\n'
+            src += '  TYPE_OUT *pout[TILE] = out + off;\n'
+            src += '  *?(check)pout = {0};\n'.format(ret)
+            src += '}\n'
+            return src, key
+        # one program per row of the last dimension
+        init, op = _reductions[self.reduce]
+        src += '  int row = get_program_id(0);\n'
+        src += '  float acc[TILE] = {0};\n'.format(init)
+        src += '  for(int k = 0; k < N_LAST; k += TILE) {\n'
+        src += '    int col[TILE] = k + 0 ... TILE;\n'
+        src += '    bool check[TILE] = col < N_LAST;\n'
+        src += '    int off[TILE] = row * N_LAST + col;\n'
+        src += '\n'.join('  ' + line for line in body) + '\n'
+        if op == '+':
+            src += '    acc = acc + (check ? {0} : 0);\n'.format(ret)
+        else:
+            cmp = '>' if op == 'max' else '<'
+            src += '    acc = (check && {0} {1} acc) ? {0} : acc;\n'.format(ret, cmp)
+        src += '  }\n'
+        src += '  float res = acc[{0}];\n'.format(op)
+        if self.reduce == 'mean':
+            src += '  res = res / N_LAST;\n'
+        src += '  *(out + row) = res;\n'
+        src += '}\n'
+        return src, key
+
+    def __call__(self, out=None, **tensors):
+        missing = [x for x in self.inputs if x not in tensors]
+        if missing:
+            raise ValueError("missing fused inputs: " + ', '.join(missing))
+        tensors = {x: tensors[x] for x in self.inputs}
+        shape = torch.broadcast_shapes(*[t.shape for t in tensors.values()])
+        if len(shape) == 0:
+            shape = (1, )
+        device = next(iter(tensors.values())).device
+        dtype = next(iter(tensors.values())).dtype
+        layouts = dict()
+        for name, t in tensors.items():
+            if t.dtype == torch.bool:
+                t = t.to(torch.int8)
+            layout = _layout(t.shape, shape)
+            if layout is None:
+                t, layout = t.expand(shape), 'full'
+            tensors[name] = t.contiguous()
+            layouts[name] = layout
+        # output
+        out_shape = shape[:-1] if self.reduce else shape
+        if out is None:
+            out = torch.empty(out_shape, dtype=dtype, device=device)
+        if tuple(out.shape) != tuple(out_shape) or not out.is_contiguous():
+            raise ValueError("out must be a contiguous tensor of shape " + str(tuple(out_shape)))
+        # kernel
+        src, key = self._src(layouts)
+        key = (key, tuple(layouts[x] for x in self.inputs), tuple(t.dtype for t in tensors.values()), out.dtype, device)
+        if key not in _fused._kernels:
+            defines = {'TYPE_' + x: t.dtype for x, t in tensors.items()}
+            defines['TYPE_OUT'] = out.dtype
+            configs = _fused._reduce_configs if self.reduce else _fused._configs
+            _fused._kernels[key] = triton.kernel(src, device=device, defines=defines, autotune_vals=configs,
+                                                 autotune_key=['N_LAST' if self.reduce else 'N'])
+        kernel = _fused._kernels[key]
+        numel = shape.numel()
+        n_last = shape[-1]
+        if numel == 0:
+            return out
+        args = [t.data_ptr() for t in tensors.values()] + self.consts + self.seeds
+        args += [out.data_ptr(), numel, n_last]
+        if self.reduce:
+            grid = lambda opt: [numel // n_last]
+        else:
+            grid = lambda opt: [triton.cdiv(numel, opt.TILE)]
+        kernel(*args, grid=grid)
+        return out
+
+
+def fuse(root):
+    return _fused(root)
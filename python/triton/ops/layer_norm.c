@@ -0,0 +1,230 @@
+// Row-wise layer normalization, or RMS normalization when RMS is
+// defined (no mean). The bias is only added when BIAS is defined.
+// Rows that fit in one tile (SINGLE_TILE) are read once and kept in
+// registers; wider rows are processed in a loop, with one pass over
+// the row per statistic. The per-row mean and rstd are kept for the
+// backward pass
+
+__global__ void forward(TYPE *X __noalias __readonly,
+                        TYPE *Y __noalias,
+                        TYPE *W __noalias __readonly,
+                        TYPE *B __noalias __readonly,
+                        float *Mean __noalias,
+                        float *Rstd __noalias,
+                        int N, float eps) {
+  int row = get_program_id(0);
+  TYPE *px = X + row * N;
+  TYPE *py = Y + row * N;
+#ifdef SINGLE_TILE
+  int cols[TILE] = 0 ... TILE;
+  bool check[TILE] = cols < N;
+  TYPE *p[TILE] = px + cols;
+  TYPE *pw[TILE] = W + cols;
+  float x[TILE] = check ? *p : 0;
+  float w[TILE] = *?(check)pw;
+  float mean = 0;
+#ifndef RMS
+  mean = x[+] / N;
+#endif
+  float d[TILE] = check ? x - mean : 0;
+  float d2[TILE] = d * d;
+  float rstd = 1 / sqrtf(d2[+] / N + eps);
+  *(Mean + row) = mean;
+  *(Rstd + row) = rstd;
+  float y[TILE] = d * rstd * w;
+#ifdef BIAS
+  TYPE *pb[TILE] = B + cols;
+  float b[TILE] = *?(check)pb;
+  y = y + b;
+#endif
+  TYPE *pyk[TILE] = py + cols;
+  *?(check)pyk = y;
+#else
+  // mean
+  float mean = 0;
+#ifndef RMS
+  float sum[TILE] = 0;
+  for (int k = 0; k < N; k += TILE) {
+    int cols[TILE] = k + 0 ... TILE;
+    bool check[TILE] = cols < N;
+    TYPE *p[TILE] = px + cols;
+    float x[TILE] = check ? *p : 0;
+    sum = sum + x;
+  }
+  mean = sum[+] / N;
+#endif
+  // variance, from a second pass for accuracy
+  float var[TILE] = 0;
+  for (int k = 0; k < N; k += TILE) {
+    int cols[TILE] = k + 0 ... TILE;
+    bool check[TILE] = cols < N;
+    TYPE *p[TILE] = px + cols;
+    float x[TILE] = check ? *p : 0;
+    float d[TILE] = check ? x - mean : 0;
+    var = var + d * d;
+  }
+  float rstd = 1 / sqrtf(var[+] / N + eps);
+  *(Mean + row) = mean;
+  *(Rstd + row) = rstd;
+  // normalize
+  for (int k = 0; k < N; k += TILE) {
+    int cols[TILE] = k + 0 ... TILE;
+    bool check[TILE] = cols < N;
+    TYPE *p[TILE] = px + cols;
+    TYPE *pw[TILE] = W + cols;
+    float x[TILE] = *?(check)p;
+    float w[TILE] = *?(check)pw;
+    float y[TILE] = (x - mean) * rstd * w;
+#ifdef BIAS
+    TYPE *pb[TILE] = B + cols;
+    float b[TILE] = *?(check)pb;
+    y = y + b;
+#endif
+    TYPE *pyk[TILE] = py + cols;
+    *?(check)pyk = y;
+  }
+#endif
+}
+
+// dx = (w * dy - (xhat * c1 + c2)) * rstd, with
+// c1 = mean(xhat * w * dy) and c2 = mean(w * dy) (0 for RMS)
+__global__ void backward(TYPE *DY __noalias __readonly,
+                         TYPE *X __noalias __readonly,
+                         TYPE *W __noalias __readonly,
+                         float *Mean __noalias __readonly,
+                         float *Rstd __noalias __readonly,
+                         TYPE *DX __noalias,
+                         int N) {
+  int row = get_program_id(0);
+  TYPE *px = X + row * N;
+  TYPE *pdy = DY + row * N;
+  TYPE *pdx = DX + row * N;
+  float mean = *(Mean + row);
+  float rstd = *(Rstd + row);
+#ifdef SINGLE_TILE
+  int cols[TILE] = 0 ... TILE;
+  bool check[TILE] = cols < N;
+  TYPE *p[TILE] = px + cols;
+  TYPE *pw[TILE] = W + cols;
+  TYPE *pg[TILE] = pdy + cols;
+  float x[TILE] = check ? *p : 0;
+  float w[TILE] = check ? *pw : 0;
+  float dy[TILE] = check ? *pg : 0;
+  float xhat[TILE] = (x - mean) * rstd;
+  float wdy[TILE] = w * dy;
+  float s1[TILE] = xhat * wdy;
+  float c1 = s1[+] / N;
+#ifdef RMS
+  float c2 = 0;
+#else
+  float c2 = wdy[+] / N;
+#endif
+  float dx[TILE] = (wdy - (xhat * c1 + c2)) * rstd;
+  TYPE *pdxk[TILE] = pdx + cols;
+  *?(check)pdxk = dx;
+#else
+  float s1[TILE] = 0;
+  float s2[TILE] = 0;
+  for (int k = 0; k < N; k += TILE) {
+    int cols[TILE] = k + 0 ... TILE;
+    bool check[TILE] = cols < N;
+    TYPE *p[TILE] = px + cols;
+    TYPE *pw[TILE] = W + cols;
+    TYPE *pg[TILE] = pdy + cols;
+    float x[TILE] = check ? *p : 0;
+    float w[TILE] = check ? *pw : 0;
+    float dy[TILE] = check ? *pg : 0;
+    float wdy[TILE] = w * dy;
+    s1 = s1 + (x - mean) * rstd * wdy;
+    s2 = s2 + wdy;
+  }
+  float c1 = s1[+] / N;
+#ifdef RMS
+  float c2 = 0;
+#else
+  float c2 = s2[+] / N;
+#endif
+  for (int k = 0; k < N; k += TILE) {
+    int cols[TILE] = k + 0 ... TILE;
+    bool check[TILE] = cols < N;
+    TYPE *p[TILE] = px + cols;
+    TYPE *pw[TILE] = W + cols;
+    TYPE *pg[TILE] = pdy + cols;
+    float x[TILE] = *?(check)p;
+    float w[TILE] = *?(check)pw;
+    float dy[TILE] = *?(check)pg;
+    float xhat[TILE] = (x - mean) * rstd;
+    float dx[TILE] = (w * dy - (xhat * c1 + c2)) * rstd;
+    TYPE *pdxk[TILE] = pdx + cols;
+    *?(check)pdxk = dx;
+  }
+#endif
+}
+
+// first stage of dw = sum(dy * xhat) and db = sum(dy) over the rows:
+// program (n, g) writes the partial sums of rows [g*ROWS, (g+1)*ROWS)
+// to row g of PDW and PDB
+__global__ void backward_dwdb(TYPE *DY __noalias __readonly,
+                              TYPE *X __noalias __readonly,
+                              float *Mean __noalias __readonly,
+                              float *Rstd __noalias __readonly,
+                              float *PDW __noalias,
+                              float *PDB __noalias,
+                              int M, int N, int ROWS) {
+  int pidn = get_program_id(0);
+  int pidg = get_program_id(1);
+  int cols[TN] = pidn * TN + 0 ... TN;
+  int start = pidg * ROWS;
+  int end = min(start + ROWS, M);
+  float dw[TM, TN] = 0;
+  float db[TM, TN] = 0;
+  for (int m = start; m < end; m += TM) {
+    int rows[TM] = m + 0 ... TM;
+    bool checkm[TM] = rows < end;
+    bool check[TM, TN] = checkm[:, newaxis] && cols[newaxis, :] < N;
+    int off[TM, TN] = rows[:, newaxis] * N + cols[newaxis, :];
+    TYPE *pdy[TM, TN] = DY + off;
+    TYPE *px[TM, TN] = X + off;
+    float *pmean[TM] = Mean + rows;
+    float *prstd[TM] = Rstd + rows;
+    float dy[TM, TN] = check ? *pdy : 0;
+    float x[TM, TN] = check ? *px : 0;
+    float mean[TM] = checkm ? *pmean : 0;
+    float rstd[TM] = checkm ? *prstd : 0;
+    dw = dw + dy * (x - mean[:, newaxis]) * rstd[:, newaxis];
+    db = db + dy;
+  }
+  bool checkn[TN] = cols < N;
+  float *pdw[TN] = PDW + pidg * N + cols;
+  *?(checkn)pdw = dw[+, :];
+#ifdef BIAS
+  float *pdb[TN] = PDB + pidg * N + cols;
+  *?(checkn)pdb = db[+, :];
+#endif
+}
+
+// second stage: sums the G partial rows
+__global__ void backward_dwdb_final(float *PDW __noalias __readonly,
+                                    float *PDB __noalias __readonly,
+                                    TYPE *DW __noalias,
+                                    TYPE *DB __noalias,
+                                    int G, int N) {
+  int cols[TN] = get_program_id(0) * TN + 0 ... TN;
+  bool check[TN] = cols < N;
+  float dw[TN] = 0;
+  float db[TN] = 0;
+  for (int g = 0; g < G; g++) {
+    float *pdw[TN] = PDW + g * N + cols;
+    dw = dw + (check ? *pdw : 0);
+#ifdef BIAS
+    float *pdb[TN] = PDB + g * N + cols;
+    db = db + (check ? *pdb : 0);
+#endif
+  }
+  TYPE *pw[TN] = DW + cols;
+  *?(check)pw = dw;
+#ifdef BIAS
+  TYPE *pb[TN] = DB + cols;
+  *?(check)pb = db;
+#endif
+}
@@ -0,0 +1,95 @@
+import os
+import triton
+import torch
+from .cross_entropy import next_power_of_2
+
+# tile of the row-wise kernels; rows up to that wide are kept in
+# registers, wider rows are processed in a loop
+MAX_TILE = 4096
+# tile of the weight gradient kernels
+TM, TN = 32, 64
+# maximum number of partial sums of the weight gradients
+MAX_GROUPS = 256
+
+kernels = dict()
+
+def make_kernel(device, dtype, N, rms, bias, name):
+    tile = min(next_power_of_2(N), MAX_TILE)
+    single = N <= tile
+    key = (device, dtype, tile, single, rms, bias, name)
+    if key not in kernels:
+        fname = os.path.join(os.path.dirname(__file__), "layer_norm.c")
+        src = triton.read(fname, kernel_names=[name])
+        defines = {"TYPE": dtype, "TILE": tile, "TM": TM, "TN": TN}
+        if single:
+            defines["SINGLE_TILE"] = 1
+        if rms:
+            defines["RMS"] = 1
+        if bias:
+            defines["BIAS"] = 1
+        num_warps = min(max(tile // 256, 1), 8)
+        kernels[key] = triton.kernel(src, device=device, defines=defines, num_warps=num_warps)
+    return kernels[key]
+
+class _layer_norm(torch.autograd.Function):
+    @staticmethod
+    def forward(ctx, x, weight, bias, eps, rms):
+        N = x.shape[-1]
+        assert weight.shape == (N, ), "weight is expected to be of shape (N,)"
+        assert weight.dtype == x.dtype, "weight is expected to be of the same type as x"
+        if bias is not None:
+            assert bias.shape == (N, ), "bias is expected to be of shape (N,)"
+            assert bias.dtype == x.dtype, "bias is expected to be of the same type as x"
+        device, dtype = x.device, x.dtype
+        ctx.shape = x.shape
+        x = x.contiguous().view(-1, N)
+        M = x.shape[0]
+        has_bias = bias is not None
+        y = torch.empty_like(x)
+        mean = torch.empty(M, dtype=torch.float32, device=device)
+        rstd = torch.empty(M, dtype=torch.float32, device=device)
+        kernel = make_kernel(device, dtype, N, rms, has_bias, "forward")
+        # B is not read without bias
+        kernel(x.data_ptr(), y.data_ptr(), weight.data_ptr(), (bias if has_bias else weight).data_ptr(),
+               mean.data_ptr(), rstd.data_ptr(), N, eps,
+               grid=lambda opt: [M])
+        ctx.save_for_backward(x, weight, mean, rstd)
+        ctx.rms = rms
+        ctx.has_bias = has_bias
+        return y.view(ctx.shape)
+
+    @staticmethod
+    def backward(ctx, dy):
+        x, weight, mean, rstd = ctx.saved_tensors
+        M, N = x.shape
+        device, dtype, rms, has_bias = x.device, x.dtype, ctx.rms, ctx.has_bias
+        dy = dy.contiguous().view(M, N)
+        # input gradient
+        dx = torch.empty_like(x)
+        kernel = make_kernel(device, dtype, N, rms, has_bias, "backward")
+        kernel(dy.data_ptr(), x.data_ptr(), weight.data_ptr(),
+               mean.data_ptr(), rstd.data_ptr(), dx.data_ptr(), N,
+               grid=lambda opt: [M])
+        # weight and bias gradients: G groups of rows are first reduced
+        # to partial sums, which a second kernel then adds up
+        G = min(M, MAX_GROUPS)
+        rows = triton.cdiv(M, G)
+        G = triton.cdiv(M, rows)
+        pdw = torch.empty(G, N, dtype=torch.float32, device=device)
+        pdb = torch.empty(G, N, dtype=torch.float32, device=device) if has_bias else pdw
+        kernel = make_kernel(device, dtype, N, rms, has_bias, "backward_dwdb")
+        kernel(dy.data_ptr(), x.data_ptr(), mean.data_ptr(), rstd.data_ptr(),
+               pdw.data_ptr(), pdb.data_ptr(), M, N, rows,
+               grid=lambda opt: [triton.cdiv(N, TN), G])
+        dw = torch.empty(N, dtype=weight.dtype, device=device)
+        db = torch.empty(N, dtype=weight.dtype, device=device) if has_bias else dw
+        kernel = make_kernel(device, dtype, N, rms, has_bias, "backward_dwdb_final")
+        kernel(pdw.data_ptr(), pdb.data_ptr(), dw.data_ptr(), db.data_ptr(), G, N,
+               grid=lambda opt: [triton.cdiv(N, TN)])
+        return dx.view(ctx.shape), dw, db if has_bias else None, None, None
+
+def layer_norm(x, weight, bias, eps=1e-5):
+    return _layer_norm.apply(x, weight, bias, eps, False)
+
+def rms_norm(x, weight, eps=1e-6):
+    return _layer_norm.apply(x, weight, None, eps, True)
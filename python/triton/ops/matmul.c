@@ -1,30 +1,28 @@
-#define STM 1
-#define STN 1
+// int8 operands accumulate in int32 and are dequantized
+// with per-row (scale_a) and per-column (scale_b) scales
+#ifndef ACC_TYPE
+#define ACC_TYPE float
+#endif
+#ifndef TYPE_C
+#define TYPE_C TYPE
+#endif
 
 __global__ void matmul(TYPE *A __noalias __readonly,
                        TYPE *B __noalias __readonly,
-                       TYPE *C __noalias,
+                       TYPE_C *C __noalias,
                        float alpha,
                        int M, int N, int K,
                        int lda, int ldb, int ldc,
-                       int *locks) {
+                       int *locks, float *workspace,
+                       float *scale_a __readonly, float *scale_b __readonly) {
   // prologue
-  int pid = get_program_id(0);
+  // tiles are visited in the order set by the runtime (options.order)
+  int pidm = get_program_id(0);
+  int pidn = get_program_id(1);
   int pidz = get_program_id(2);
   int gridm = (M + TM - 1) / TM;
   int gridn = (N + TN - 1) / TN;
-
-  // swizzle for better L2 performance
-  int width = STM * gridn;
-  int stm = pid / width;
-  int RSTM = min(gridm - stm * STM, STM);
-  int stn = (pid % width) / (RSTM * STN);
-  int RSTN = min(gridn - stn * STN, STN);
-  int laneid = pid % (RSTM * RSTN);
-  int lanem = laneid / RSTN;
-  int lanen = laneid % RSTN;
-  int pidm = stm * STM + lanem;
-  int pidn = stn * STN + lanen;
+  int pid = pidn * gridm + pidm;
   int rm[TM] = pidm * TM + 0 ... TM;
   int rn[TN] = pidn * TN + 0 ... TN;
 
@@ -46,7 +44,7 @@ __global__ void matmul(TYPE *A __noalias __readonly,
   pb += TK * STRIDE_BK;
 
   // reduction loop
-  float acc[TM, TN] = 0;
+  ACC_TYPE acc[TM, TN] = 0;
   for (int k = K; k > 0; k -= TK) {
 #if (IS_TK_DIV_K == 1)
     bool checkk[TK] = k > TK;
@@ -66,21 +64,53 @@ __global__ void matmul(TYPE *A __noalias __readonly,
     pa += TK * STRIDE_AK;
     pb += TK * STRIDE_BK;
   }
-  acc = acc * alpha;
-  TYPE c[TM, TN] = acc;
 
   // epilogue
   int rcm[TM] = pidm * TM + 0 ... TM;
   int rcn[TN] = pidn * TN + 0 ... TN;
+#if (SCALED == 1)
+  float sm[TM] = *? (rcm < M)(scale_a + rcm);
+  float sn[TN] = *? (rcn < N)(scale_b + rcn);
+  float facc[TM, TN] = acc;
+  facc = facc * alpha * sm[:, newaxis] * sn [newaxis, :];
+#else
+  float facc[TM, TN] = acc * alpha;
+#endif
+  TYPE_C c[TM, TN] = facc;
   int offc[TM, TN] = rcm[:, newaxis] * ldc + rcn [newaxis, :];
-  TYPE *pc[TM, TN] = C + offc;
+  TYPE_C *pc[TM, TN] = C + offc;
   bool checkc[TM, TN] = rcm[:, newaxis] < M && rcn [newaxis, :] < N;
 #if (SPLITK == 1)
   *? (checkc)pc = c;
+#elif (SPLITK_WORKSPACE == 1)
+  // write partial result to the workspace
+  int rwm[TM] = 0 ... TM;
+  int rwn[TN] = 0 ... TN;
+  int stridew = gridm * gridn * TM * TN;
+  int offw[TM, TN] = pid * TM * TN + rwm[:, newaxis] * TN + rwn [newaxis, :];
+  float *pw[TM, TN] = workspace + offw + pidz * stridew;
+  *pw = facc;
+  // take a ticket; the last program to arrive reduces
+  // all partial results in order of pidz
+  int *pcount = locks + pid;
+  int count = 0;
+  for (int old = atomic_cas(pcount, 0, 1); old != count; old = atomic_cas(pcount, count, count + 1))
+    count = old;
+  if (count == SPLITK - 1) {
+    pw = workspace + offw;
+    float sum[TM, TN] = 0;
+    for (int z = 0; z < SPLITK; z++) {
+      sum += *pw;
+      pw += stridew;
+    }
+    c = sum;
+    *? (checkc)pc = c;
+    atomic_xchg(pcount, 0);
+  }
 #else
   // accumulate partial result using spin-locks
   int *plock = locks + pid;
-  int *pcount = plock + get_num_programs(0);
+  int *pcount = plock + gridm * gridn;
   for (int repeat = 1; repeat == 1; repeat = atomic_cas(plock, 0, 1))
     ;
   int count = *pcount;
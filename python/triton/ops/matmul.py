@@ -15,12 +15,23 @@ class _matmul(torch.autograd.Function):
         triton.config(defines={'TM': '64', 'TN': '32', 'TK': '64', 'SPLITK': '1'}, num_warps=2),
         triton.config(defines={'TM': '32', 'TN': '64', 'TK': '64', 'SPLITK': '1'}, num_warps=2),
         triton.config(defines={'TM': '32', 'TN': '128', 'TK': '32', 'SPLITK': '2'}, num_warps=4),
-        triton.config(defines={'TM': '32', 'TN': '128', 'TK': '32', 'SPLITK': '2'}, num_warps=4),
-        triton.config(defines={'TM': '128', 'TN': '32', 'TK': '32', 'SPLITK': '4'}, num_warps=4),
+        triton.config(defines={'TM': '32', 'TN': '128', 'TK': '32', 'SPLITK': '2', 'SPLITK_WORKSPACE': '1'}, num_warps=4),
         triton.config(defines={'TM': '128', 'TN': '32', 'TK': '32', 'SPLITK': '4'}, num_warps=4),
+        triton.config(defines={'TM': '128', 'TN': '32', 'TK': '32', 'SPLITK': '4', 'SPLITK_WORKSPACE': '1'}, num_warps=4),
     ]
     _CONFIGS = _DEFAULT_CONFIGS
 
+    # Split-K synchronizes programs through atomics, which are not
+    # exercised on the host backend, so only SPLITK == 1 configs run on CPU
+    @staticmethod
+    def get_configs(device):
+        if device.type == 'cuda':
+            return _matmul._CONFIGS
+        configs = [c for c in _matmul._CONFIGS if c.defines.get('SPLITK', '1') == '1']
+        if not configs:
+            raise ValueError("no matmul config without split-K for device " + str(device))
+        return configs
+
     @staticmethod
     def largest_pow2_divisor(N):
         if N % 8 == 0:
@@ -32,16 +43,44 @@ class _matmul(torch.autograd.Function):
         return 1
 
     _locks = dict()
+    _workspaces = dict()
     _kernels = dict()
 
+    # Split-K configurations with `SPLITK_WORKSPACE` write partial
+    # tiles to a workspace that the last program of each tile reduces
+    @staticmethod
+    def get_workspace(M, N, device):
+        size = 1
+        for config in _matmul._CONFIGS:
+            defines = config.defines
+            if defines.get('SPLITK_WORKSPACE', '0') == '1':
+                TM, TN, SPLITK = int(defines['TM']), int(defines['TN']), int(defines['SPLITK'])
+                size = max(size, SPLITK * triton.cdiv(M, TM) * TM * triton.cdiv(N, TN) * TN)
+        if device not in _matmul._workspaces or size > _matmul._workspaces[device].numel():
+            _matmul._workspaces[device] = torch.empty(size, dtype=torch.float32, device=device)
+        return _matmul._workspaces[device]
+
     @staticmethod
-    def _call(a, b):
+    def _call(a, b, scale_a=None, scale_b=None):
         dtype = a.dtype
         device = a.device
+        # int8 operands are multiplied in int32 and dequantized
+        # by per-row and per-column scales in the epilogue
+        is_int8 = dtype == torch.int8
+        if is_int8 and (scale_a is None or scale_b is None):
+            raise ValueError("int8 matmul requires scale_a and scale_b")
+        c_dtype = torch.float32 if is_int8 else dtype
         # allocate output
         M, K = a.shape
         K, N = b.shape
-        c = torch.empty((M, N), dtype=dtype, device=device)
+        # the epilogue reads scale_a[rm] and scale_b[rn] as float32
+        if is_int8:
+            for name, scale, size in [('scale_a', scale_a, M), ('scale_b', scale_b, N)]:
+                if scale.dtype != torch.float32 or scale.device != device:
+                    raise ValueError(f"{name} must be a float32 tensor on {device}")
+                if scale.shape != (size, ) or not scale.is_contiguous():
+                    raise ValueError(f"{name} must be a contiguous vector of length {size}")
+        c = torch.empty((M, N), dtype=c_dtype, device=device)
         # handle non-contiguous inputs if necessary
         if a.stride(0) > 1 and a.stride(1) > 1:
             a = a.contiguous()
@@ -79,18 +118,23 @@ class _matmul(torch.autograd.Function):
                 "LDC_POW2_DIV": ldc_pow2_div,
                 "IS_TK_DIV_K": int(is_tk_div_k),
             }
+            if is_int8:
+                defines.update({"ACC_TYPE": "int", "TYPE_C": c_dtype, "SCALED": 1})
             _matmul._kernels[key] = triton.kernel(
                 _matmul.src,
                 device,
                 defines=defines,
-                autotune_vals=_matmul._CONFIGS,
+                autotune_vals=_matmul.get_configs(device),
                 autotune_key=["M", "N", "K"],
+                order='grouped',
+                group_size=8,
             )
         kernel = _matmul._kernels[key]
         # # locks for split-k
         if device not in _matmul._locks:
             _matmul._locks[device] = torch.zeros(1024 * 1024, dtype=torch.int32, device=device)
         locks = _matmul._locks[device]
+        workspace = _matmul.get_workspace(M, N, device)
         # enqueue
         alpha = 1.0
         args = [
@@ -105,18 +149,21 @@ class _matmul(torch.autograd.Function):
             ldb,
             ldc,
             locks.data_ptr(),
+            workspace.data_ptr(),
+            scale_a.data_ptr() if is_int8 else 0,
+            scale_b.data_ptr() if is_int8 else 0,
         ]
         grid = lambda opt: [
-            triton.cdiv(M, opt.TM) * triton.cdiv(N, opt.TN),
-            1,
+            triton.cdiv(M, opt.TM),
+            triton.cdiv(N, opt.TN),
             opt.SPLITK,
         ]
         kernel(*args, grid=grid)
         return c
 
     @staticmethod
-    def forward(ctx, a, b):
-        c = _matmul._call(a, b)
+    def forward(ctx, a, b, scale_a=None, scale_b=None):
+        c = _matmul._call(a, b, scale_a, scale_b)
         return c
 
 matmul = _matmul.apply
@@ -1,5 +1,6 @@
 import torch
 import os
+import time
 
 try:
     import triton._C.libtriton.cutlass as _cutlass
@@ -40,24 +41,53 @@ def allclose(x, y):
     return err < tol
 
 
-def do_bench(fn, warmup=25, rep=100, grad_to_none=None, percentiles=[0.2, 0.8]):
+class _HostEvent:
+    # mirrors the subset of torch.cuda.Event used below
+    def __init__(self):
+        self.time = None
+
+    def record(self):
+        self.time = time.perf_counter()
+
+    def elapsed_time(self, end):
+        return (end.time - self.time) * 1e3
+
+
+def _synchronize(device):
+    if device == 'cuda':
+        torch.cuda.synchronize()
+
+
+def _event(device):
+    if device == 'cuda':
+        return torch.cuda.Event(enable_timing=True)
+    return _HostEvent()
+
+
+def do_bench(fn, warmup=25, rep=100, grad_to_none=None, percentiles=[0.2, 0.8], device=None):
+    # CPU functions are expected to be synchronous (as are
+    # triton kernels launched on CPU tensors)
+    if device is None:
+        device = 'cuda' if torch.cuda.is_available() else 'cpu'
+    device = torch.device(device).type
     # Estimate the runtime of the function
     fn()
-    torch.cuda.synchronize()
-    start_event = torch.cuda.Event(enable_timing=True)
-    end_event = torch.cuda.Event(enable_timing=True)
+    _synchronize(device)
+    start_event = _event(device)
+    end_event = _event(device)
     start_event.record()
     for _ in range(5):
         fn()
     end_event.record()
-    torch.cuda.synchronize()
-    estimate_ms = start_event.elapsed_time(end_event) / 5
+    _synchronize(device)
+    estimate_ms = max(start_event.elapsed_time(end_event) / 5, 1e-3)
     # We maintain a buffer of 256 MB that we clear
     # before each kernel call to make sure that the L2
-    # doesn't contain any input data before the run
-    start_event = [torch.cuda.Event(enable_timing=True) for i in range(rep)]
-    end_event = [torch.cuda.Event(enable_timing=True) for i in range(rep)]
-    cache = torch.empty(int(256e6), dtype=torch.int8, device='cuda')
+    # (or the last-level cache on CPU) doesn't contain
+    # any input data before the run
+    start_event = [_event(device) for i in range(rep)]
+    end_event = [_event(device) for i in range(rep)]
+    cache = torch.empty(int(256e6), dtype=torch.int8, device=device)
     # Warm-up
     for _ in range(int(warmup / estimate_ms)):
         fn()
@@ -68,13 +98,13 @@ def do_bench(fn, warmup=25, rep=100, grad_to_none=None, percentiles=[0.2, 0.8]):
         # provided gradients
         if grad_to_none is not None:
             grad_to_none.grad = None
-        # we clear the L2 cache before each run
+        # we clear the cache before each run
         cache.zero_()
         # record time of `fn`
         start_event[i].record()
         fn()
         end_event[i].record()
-    torch.cuda.synchronize()
+    _synchronize(device)
     times = torch.tensor([s.elapsed_time(e) for s, e in zip(start_event, end_event)])
     percentiles = torch.quantile(times, torch.tensor(percentiles)).tolist()
     med_ms = torch.median(times).item()
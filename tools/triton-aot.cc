@@ -0,0 +1,154 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "triton/driver/backend.h"
+#include "triton/driver/context.h"
+#include "triton/driver/device.h"
+#include "triton/runtime/aot.h"
+#include "triton/tools/sys/mkdir.hpp"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Host.h"
+
+// Ahead-of-time compiler for Triton kernels.
+// usage: triton-aot [--host] [--cpu CPU] [--features FEATURES] [--name NAME]
+//                   [--config NAME:KEY=VALUE,...]... [--spec ARG=DIVISOR,...]...
+//                   <source> <output-dir>
+// --config    one launch function per config; `num_warps`, `num_stages`
+//             and `fast_math` are options, other keys are defines
+// --spec      divisors assumed for pointer/integer arguments; the
+//             unspecialized binary is always generated
+// --host      compile for the host instead of the default CUDA device
+// --cpu       CPU that host objects target (default: generic); `native`
+//             is the CPU of the machine running triton-aot
+// --features  target features of host objects, e.g. +avx2,+fma
+
+namespace drv = triton::driver;
+namespace rt = triton::runtime;
+
+namespace {
+
+void usage(const char* prog) {
+  std::fprintf(stderr, "usage: %s [--host] [--cpu CPU] [--features FEATURES] [--name NAME] "
+                       "[--config NAME:KEY=VALUE,...]... [--spec ARG=DIVISOR,...]... <source> <output-dir>\n", prog);
+  std::exit(1);
+}
+
+std::vector<std::pair<std::string, std::string>> parse_list(const std::string& str) {
+  std::vector<std::pair<std::string, std::string>> ret;
+  std::stringstream ss(str);
+  std::string item;
+  while(std::getline(ss, item, ',')){
+    size_t pos = item.find('=');
+    if(pos == std::string::npos)
+      throw std::runtime_error("expected KEY=VALUE, got " + item);
+    ret.push_back({item.substr(0, pos), item.substr(pos + 1)});
+  }
+  return ret;
+}
+
+rt::aot_config parse_config(const std::string& str, size_t idx) {
+  rt::aot_config ret;
+  ret.opt.num_warps = 4;
+  std::string list = str;
+  size_t pos = str.find(':');
+  if(pos != std::string::npos){
+    ret.name = str.substr(0, pos);
+    list = str.substr(pos + 1);
+  }
+  else
+    ret.name = "config_" + std::to_string(idx);
+  for(const auto& x: parse_list(list)){
+    if(x.first == "num_warps")
+      ret.opt.num_warps = std::stoi(x.second);
+    else if(x.first == "num_stages")
+      ret.opt.num_stages = std::stoi(x.second);
+    else if(x.first == "fast_math")
+      ret.opt.fast_math = std::stoi(x.second) != 0;
+    else
+      ret.opt.defines[x.first] = x.second;
+  }
+  return ret;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  bool host = false;
+  std::string cpu = "generic";
+  std::string features;
+  std::string name;
+  std::vector<rt::aot_config> confs;
+  std::vector<rt::aot_spec_t> specs;
+  std::vector<std::string> positional;
+  try{
+    for(int i = 1; i < argc; i++){
+      std::string arg = argv[i];
+      bool has_value = i + 1 < argc;
+      if(arg == "--host")
+        host = true;
+      else if(arg == "--cpu" && has_value)
+        cpu = argv[++i];
+      else if(arg == "--features" && has_value)
+        features = argv[++i];
+      else if(arg == "--name" && has_value)
+        name = argv[++i];
+      else if(arg == "--config" && has_value)
+        confs.push_back(parse_config(argv[++i], confs.size()));
+      else if(arg == "--spec" && has_value){
+        rt::aot_spec_t spec;
+        for(const auto& x: parse_list(argv[++i]))
+          spec[x.first] = std::stoull(x.second);
+        specs.push_back(spec);
+      }
+      else if(arg.substr(0, 2) == "--")
+        usage(argv[0]);
+      else
+        positional.push_back(arg);
+    }
+    if(positional.size() != 2)
+      usage(argv[0]);
+    std::string path = positional[0];
+    std::string out = positional[1];
+    // source
+    std::ifstream ifs(path);
+    if(!ifs)
+      throw std::runtime_error("could not open " + path);
+    std::stringstream src;
+    src << ifs.rdbuf();
+    if(name.empty()){
+      name = path.substr(path.find_last_of('/') + 1);
+      name = name.substr(0, name.find('.'));
+    }
+    if(confs.empty())
+      confs.push_back(parse_config("", 0));
+    // compile
+    std::unique_ptr<drv::device> host_device;
+    drv::device* device;
+    if(host){
+      host_device.reset(new drv::host_device());
+      device = host_device.get();
+    }
+    else
+      device = drv::backend::contexts::get_default()->device();
+    if(cpu == "native")
+      cpu = llvm::sys::getHostCPUName().str();
+    auto files = rt::aot_compile(name, src.str(), confs, specs, device, cpu, features);
+    // write
+    triton::tools::mkpath(out + "/");
+    for(const auto& x: files){
+      std::ofstream ofs(out + "/" + x.first, std::ios::binary);
+      ofs.write(x.second.data(), x.second.size());
+      if(!ofs)
+        throw std::runtime_error("could not write " + out + "/" + x.first);
+      std::printf("%s/%s\n", out.c_str(), x.first.c_str());
+    }
+  }
+  catch(const std::exception& e){
+    std::fprintf(stderr, "error: %s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -21,9 +21,6 @@ namespace src {
 
     const char *dot =
 R"(
-#define STM 8
-#define STN 8
-
 __global__ void dot(TYPE * A __noalias __readonly __aligned(16),
                     TYPE * B __noalias __readonly __aligned(16),
                     TYPE * C __noalias __aligned(16),
@@ -36,20 +33,10 @@ __global__ void dot(TYPE * A __noalias __readonly __aligned(16),
                     int ldc __multipleof(8),
                     int* locks) {
       // prologue
-      int pid = get_program_id(0);
+      // tiles are visited in the order set by opt.order
+      int pidm = get_program_id(0);
+      int pidn = get_program_id(1);
       int pidz = get_program_id(2);
-      int gridm = (M + TM - 1) / TM;
-      int gridn = (N + TN - 1) / TN;
-      int width = STM*gridn;
-      int stm = pid / width;
-      int RSTM  = min(gridm - stm*STM, STM);
-      int stn =  (pid % width) / (RSTM*STN);
-      int RSTN = min(gridn - stn*STN, STN);
-      int laneid = pid % (RSTM * RSTN);
-      int lanem = laneid / RSTN;
-      int lanen = laneid % RSTN;
-      int pidm = stm*STM + lanem;
-      int pidn = stn*STN + lanen;
       int rm[TM] = pidm * TM + 0 ... TM;
       int rn[TN] = pidn * TN + 0 ... TN;
 
@@ -94,7 +81,7 @@ __global__ void dot(TYPE * A __noalias __readonly __aligned(16),
       *?(checkc) pc = c;
 #else
       // accumulate partial result using spin-locks
-      int *plock  = locks + rid;
+      int *plock  = locks + pidn * get_num_programs(0) + pidm;
       int *pcount = plock + get_num_programs(0) * get_num_programs(1);
       for(int repeat = 1; repeat == 1; repeat = atomic_cas(plock, 0, 1));
       int count = *pcount;
@@ -170,6 +157,8 @@ float triton_dot(drv::context* context,  drv::stream* stream,
   opt.defines["TK"] = "64" ;
   opt.defines["TZ"] = "1";
   opt.num_warps = 4;
+  opt.order = rt::ORDER_GROUPED;
+  opt.group_size = 8;
   // arguments
   std::stringstream oss;
   rt::add_arg(oss, *da->cu());
@@ -189,7 +178,7 @@ float triton_dot(drv::context* context,  drv::stream* stream,
   // grid
   auto ceil = [](size_t x, size_t y) { return (x + y - 1) / y; };
   auto grid = [ceil, M, N](const rt::options_t& x) {
-    return rt::grid_t{ceil(M, x.D<int>("TM"))*
+    return rt::grid_t{ceil(M, x.D<int>("TM")),
                       ceil(N, x.D<int>("TN")),
                       (size_t)x.D<int>("TZ")};
   };